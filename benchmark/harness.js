@@ -0,0 +1,97 @@
+const withBindings = require('../lib/resolve-bindings');
+
+const sleep = (ms) => new Promise(resolve => setTimeout(resolve, ms));
+
+const address = (index) => `c0:00:00:00:${((index >> 8) & 0xff).toString(16).padStart(2, '0')}:${(index & 0xff).toString(16).padStart(2, '0')}`;
+
+// A link fast enough that noble, not the simulated radio, is what gets measured.
+const FAST_LINK = {
+  connectionInterval: 1,
+  connectionDelay: 1,
+  packetsPerConnectionEvent: 32,
+  aclNum: 32
+};
+
+const createNoble = async (virtual) => {
+  const noble = withBindings('hci', {
+    hciDriver: 'virtual',
+    bindParams: { virtual: Object.assign({}, FAST_LINK, virtual) }
+  });
+
+  await noble.waitForPoweredOnAsync();
+  return noble;
+};
+
+// Scans until every address has been seen, so noble knows the peripherals before connecting.
+const discover = async (noble, addresses) => {
+  const wanted = new Set(addresses);
+  const peripherals = new Map();
+
+  await new Promise((resolve) => {
+    const onDiscover = (peripheral) => {
+      if (wanted.has(peripheral.address) && !peripherals.has(peripheral.address)) {
+        peripherals.set(peripheral.address, peripheral);
+      }
+      if (peripherals.size === wanted.size) {
+        noble.removeListener('discover', onDiscover);
+        resolve();
+      }
+    };
+    noble.on('discover', onDiscover);
+    noble.startScanningAsync([], true);
+  });
+  await noble.stopScanningAsync();
+
+  return addresses.map(value => peripherals.get(value));
+};
+
+// The VirtualSocket behind a noble instance created by createNoble.
+const controller = (noble) => noble._bindings._hci._socket;
+
+const percentile = (sorted, p) => {
+  if (sorted.length === 0) {
+    return null;
+  }
+  return sorted[Math.min(sorted.length - 1, Math.floor(p / 100 * sorted.length))];
+};
+
+// Metrics are { value, unit, better } so results can be compared without knowing the scenario.
+const metric = (value, unit, better) => ({ value, unit, better });
+
+const distribution = (name, samples, unit) => {
+  const sorted = Float64Array.from(samples).sort();
+
+  return {
+    [`${name}P50`]: metric(percentile(sorted, 50), unit, 'lower'),
+    [`${name}P99`]: metric(percentile(sorted, 99), unit, 'lower')
+  };
+};
+
+const heapUsed = () => {
+  if (global.gc) {
+    global.gc();
+  }
+  return process.memoryUsage().heapUsed;
+};
+
+// An 8 byte high resolution send time, padded to length, for measuring latency end to end.
+const timestamped = (length) => {
+  const data = Buffer.alloc(Math.max(8, length));
+  data.writeBigUInt64LE(process.hrtime.bigint(), 0);
+  return data;
+};
+
+const latencyMs = (data) => Number(process.hrtime.bigint() - data.readBigUInt64LE(0)) / 1e6;
+
+module.exports = {
+  sleep,
+  address,
+  createNoble,
+  discover,
+  controller,
+  metric,
+  distribution,
+  heapUsed,
+  timestamped,
+  latencyMs
+};
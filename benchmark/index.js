@@ -0,0 +1,150 @@
+/* eslint-disable no-console */
+// End-to-end benchmarks against the virtual HCI controller.
+//
+//   npm run benchmark -- [--scenario scan,notify-single] [--duration 3000] [--iterations 20]
+//                        [--output results.json] [--baseline baseline.json] [--tolerance 0.1]
+//
+// Results are printed (or written to --output) as JSON. With --baseline, every metric is
+// compared against the same metric of an earlier run and the process exits with status 1
+// when one got worse by more than the tolerance, so releases can be gated on it.
+
+const fs = require('fs');
+const os = require('os');
+
+const SCENARIOS = [
+  require('./scenarios/scan'),
+  ...require('./scenarios/notify'),
+  require('./scenarios/write-without-response'),
+  require('./scenarios/connect-read'),
+  require('./scenarios/discovery')
+];
+
+// Changes smaller than this are noise for the unit, whatever the relative change.
+const SLACK = {
+  bytes: 1024 * 1024,
+  ms: 0.25
+};
+
+const parseArgs = (argv) => {
+  const args = {
+    scenarios: SCENARIOS.map(scenario => scenario.name),
+    duration: 3000,
+    iterations: 20,
+    output: null,
+    baseline: null,
+    tolerance: 0.1
+  };
+
+  for (let i = 0; i < argv.length; i++) {
+    const value = argv[i + 1];
+
+    switch (argv[i]) {
+      case '--scenario':
+        args.scenarios = value.split(',');
+        i++;
+        break;
+      case '--duration':
+        args.duration = parseInt(value, 10);
+        i++;
+        break;
+      case '--iterations':
+        args.iterations = parseInt(value, 10);
+        i++;
+        break;
+      case '--output':
+        args.output = value;
+        i++;
+        break;
+      case '--baseline':
+        args.baseline = value;
+        i++;
+        break;
+      case '--tolerance':
+        args.tolerance = parseFloat(value);
+        i++;
+        break;
+      default:
+        throw new Error(`Unknown argument: ${argv[i]}`);
+    }
+  }
+
+  return args;
+};
+
+const regressions = (results, baseline, tolerance) => {
+  const found = [];
+
+  for (const [scenario, { metrics }] of Object.entries(results.scenarios)) {
+    const previous = baseline.scenarios[scenario];
+    if (!previous) {
+      continue;
+    }
+
+    for (const [name, current] of Object.entries(metrics)) {
+      const before = previous.metrics[name];
+      if (!before || before.value === null || current.value === null) {
+        continue;
+      }
+
+      const slack = SLACK[current.unit] || 0;
+      const worse = current.better === 'higher'
+        ? current.value < before.value * (1 - tolerance) - slack
+        : current.value > before.value * (1 + tolerance) + slack;
+
+      if (worse) {
+        found.push({ scenario, metric: name, baseline: before.value, value: current.value, unit: current.unit });
+      }
+    }
+  }
+
+  return found;
+};
+
+const main = async () => {
+  const args = parseArgs(process.argv.slice(2));
+  const unknown = args.scenarios.filter(name => !SCENARIOS.some(scenario => scenario.name === name));
+  if (unknown.length) {
+    throw new Error(`Unknown scenario: ${unknown.join(', ')}`);
+  }
+
+  const results = {
+    node: process.version,
+    platform: `${os.platform()}-${os.arch()}`,
+    cpu: os.cpus()[0] && os.cpus()[0].model,
+    gcExposed: typeof global.gc === 'function',
+    timestamp: new Date().toISOString(),
+    scenarios: {}
+  };
+
+  for (const scenario of SCENARIOS.filter(candidate => args.scenarios.includes(candidate.name))) {
+    console.error(`running ${scenario.name}: ${scenario.description}`);
+    const metrics = await scenario.run(args);
+    results.scenarios[scenario.name] = { description: scenario.description, metrics };
+  }
+
+  if (args.baseline) {
+    results.regressions = regressions(results, JSON.parse(fs.readFileSync(args.baseline, 'utf8')), args.tolerance);
+  }
+
+  const json = JSON.stringify(results, null, 2);
+  if (args.output) {
+    fs.writeFileSync(args.output, json + '\n');
+  } else {
+    console.log(json);
+  }
+
+  if (results.regressions && results.regressions.length) {
+    for (const { scenario, metric, baseline, value, unit } of results.regressions) {
+      console.error(`regression: ${scenario}.${metric} ${baseline} -> ${value} ${unit}`);
+    }
+    process.exitCode = 1;
+  }
+};
+
+main().then(
+  () => process.exit(),
+  (error) => {
+    console.error(error);
+    process.exit(2);
+  }
+);
@@ -0,0 +1,47 @@
+const { address, createNoble, discover, metric, distribution, heapUsed } = require('../harness');
+
+const SERVICE_UUID = '180f';
+const CHARACTERISTIC_UUID = '2a19';
+
+module.exports = {
+  name: 'connect-read',
+  description: 'time from connectAsync to the first successful readAsync',
+
+  async run ({ iterations }) {
+    const advertisers = [{
+      address: address(0),
+      services: [{
+        uuid: SERVICE_UUID,
+        characteristics: [{ uuid: CHARACTERISTIC_UUID, properties: ['read'], value: Buffer.from([0x64]) }]
+      }]
+    }];
+    const noble = await createNoble({ advertisers });
+
+    try {
+      const [peripheral] = await discover(noble, [advertisers[0].address]);
+      const samples = [];
+      const heapBefore = heapUsed();
+
+      for (let i = 0; i < iterations; i++) {
+        const start = process.hrtime.bigint();
+
+        await peripheral.connectAsync();
+        const { characteristics } = await peripheral.discoverSomeServicesAndCharacteristicsAsync(
+          [SERVICE_UUID],
+          [CHARACTERISTIC_UUID]
+        );
+        await characteristics[0].readAsync();
+
+        samples.push(Number(process.hrtime.bigint() - start) / 1e6);
+        await peripheral.disconnectAsync();
+      }
+
+      return Object.assign(
+        distribution('connectToRead', samples, 'ms'),
+        { heapGrowth: metric(heapUsed() - heapBefore, 'bytes', 'lower') }
+      );
+    } finally {
+      noble.stop();
+    }
+  }
+};
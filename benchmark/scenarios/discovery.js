@@ -0,0 +1,59 @@
+const { address, createNoble, discover, metric, distribution, heapUsed } = require('../harness');
+
+// 13 services of 5 notifying characteristics (3 attributes each) plus a last service
+// of 3 characteristics: 13 * 16 + 10 = 218 attributes, mixing 16 and 128-bit uuids.
+const database = () => {
+  const services = [];
+
+  for (let s = 0; s < 14; s++) {
+    const uuid = s % 2 ? `0000${(0xa000 + s).toString(16)}00001000800000805f9b34fc` : (0xa000 + s).toString(16);
+    const characteristics = [];
+
+    for (let c = 0; c < (s < 13 ? 5 : 3); c++) {
+      characteristics.push({
+        uuid: (0xb000 + s * 16 + c).toString(16),
+        properties: ['read', 'notify'],
+        value: Buffer.from([c])
+      });
+    }
+    services.push({ uuid, characteristics });
+  }
+
+  return services;
+};
+
+module.exports = {
+  name: 'discovery',
+  description: 'full service, characteristic and descriptor discovery of a 200+ attribute database',
+
+  async run ({ iterations }) {
+    const advertisers = [{ address: address(0), services: database() }];
+    const noble = await createNoble({ advertisers });
+
+    try {
+      const [peripheral] = await discover(noble, [advertisers[0].address]);
+      const samples = [];
+      const heapBefore = heapUsed();
+
+      for (let i = 0; i < iterations; i++) {
+        await peripheral.connectAsync();
+        const start = process.hrtime.bigint();
+
+        const { characteristics } = await peripheral.discoverAllServicesAndCharacteristicsAsync();
+        for (const characteristic of characteristics) {
+          await characteristic.discoverDescriptorsAsync();
+        }
+
+        samples.push(Number(process.hrtime.bigint() - start) / 1e6);
+        await peripheral.disconnectAsync();
+      }
+
+      return Object.assign(
+        distribution('discovery', samples, 'ms'),
+        { heapGrowth: metric(heapUsed() - heapBefore, 'bytes', 'lower') }
+      );
+    } finally {
+      noble.stop();
+    }
+  }
+};
@@ -0,0 +1,79 @@
+const {
+  address,
+  createNoble,
+  discover,
+  controller,
+  metric,
+  distribution,
+  heapUsed,
+  timestamped,
+  latencyMs,
+  sleep
+} = require('../harness');
+
+const SERVICE_UUID = 'fff0';
+const CHARACTERISTIC_UUID = 'fff1';
+// Notifications offered per connection per millisecond tick.
+const OFFERED_PER_TICK = 16;
+
+const notify = (name, connections) => ({
+  name,
+  description: `notification throughput and latency over ${connections} connection${connections > 1 ? 's' : ''}`,
+
+  async run ({ duration }) {
+    const advertisers = Array.from({ length: connections }, (_, i) => ({
+      address: address(i),
+      services: [{
+        uuid: SERVICE_UUID,
+        characteristics: [{ uuid: CHARACTERISTIC_UUID, properties: ['notify'] }]
+      }]
+    }));
+    const noble = await createNoble({ advertisers });
+    const socket = controller(noble);
+
+    try {
+      const latencies = [];
+      const peripherals = await discover(noble, advertisers.map(advertiser => advertiser.address));
+
+      for (const peripheral of peripherals) {
+        await peripheral.connectAsync();
+        const { characteristics } = await peripheral.discoverSomeServicesAndCharacteristicsAsync(
+          [SERVICE_UUID],
+          [CHARACTERISTIC_UUID]
+        );
+        characteristics[0].on('data', data => latencies.push(latencyMs(data)));
+        await characteristics[0].subscribeAsync();
+      }
+
+      const heapBefore = heapUsed();
+      const start = process.hrtime.bigint();
+      const deadline = Date.now() + duration;
+
+      while (Date.now() < deadline) {
+        for (const peripheral of peripherals) {
+          for (let i = 0; i < OFFERED_PER_TICK; i++) {
+            socket.notify(peripheral.address, CHARACTERISTIC_UUID, timestamped(20));
+          }
+        }
+        await sleep(1);
+      }
+      // Let the last connection events drain.
+      await sleep(50);
+
+      const seconds = Number(process.hrtime.bigint() - start) / 1e9;
+
+      return Object.assign(
+        { notificationsPerSec: metric(latencies.length / seconds, 'notifications/s', 'higher') },
+        distribution('latency', latencies, 'ms'),
+        { heapGrowth: metric(heapUsed() - heapBefore, 'bytes', 'lower') }
+      );
+    } finally {
+      noble.stop();
+    }
+  }
+});
+
+module.exports = [
+  notify('notify-single', 1),
+  notify('notify-many', 8)
+];
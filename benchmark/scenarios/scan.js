@@ -0,0 +1,39 @@
+const { address, createNoble, metric, heapUsed, sleep } = require('../harness');
+
+const ADVERTISERS = 500;
+
+module.exports = {
+  name: 'scan',
+  description: `discover events per second from ${ADVERTISERS} advertisers with scan responses`,
+
+  async run ({ duration }) {
+    const advertisers = Array.from({ length: ADVERTISERS }, (_, i) => ({
+      address: address(i),
+      serviceUuids: ['180f'],
+      scanResponse: Buffer.concat([Buffer.from([0x0c, 0x09]), Buffer.from(`sensor-${String(i).padStart(4, '0')}`)]),
+      interval: 20
+    }));
+    const noble = await createNoble({ advertisers });
+
+    try {
+      let events = 0;
+      noble.on('discover', () => events++);
+
+      const heapBefore = heapUsed();
+      const start = process.hrtime.bigint();
+
+      await noble.startScanningAsync([], true);
+      await sleep(duration);
+      await noble.stopScanningAsync();
+
+      const seconds = Number(process.hrtime.bigint() - start) / 1e9;
+
+      return {
+        discoverPerSec: metric(events / seconds, 'events/s', 'higher'),
+        heapGrowth: metric(heapUsed() - heapBefore, 'bytes', 'lower')
+      };
+    } finally {
+      noble.stop();
+    }
+  }
+};
@@ -0,0 +1,61 @@
+const { address, createNoble, discover, metric, heapUsed, sleep } = require('../harness');
+
+const SERVICE_UUID = 'fff0';
+const CHARACTERISTIC_UUID = 'fff2';
+// Writes noble may have queued but not yet handed to the controller.
+const MAX_QUEUED = 64;
+
+module.exports = {
+  name: 'write-without-response',
+  description: 'bytes per second written without response at the negotiated mtu',
+
+  async run ({ duration }) {
+    let received = 0;
+    const advertisers = [{
+      address: address(0),
+      services: [{
+        uuid: SERVICE_UUID,
+        characteristics: [{
+          uuid: CHARACTERISTIC_UUID,
+          properties: ['writeWithoutResponse'],
+          onWrite: data => { received += data.length; }
+        }]
+      }]
+    }];
+    const noble = await createNoble({ advertisers });
+
+    try {
+      const [peripheral] = await discover(noble, [advertisers[0].address]);
+      await peripheral.connectAsync();
+      const { characteristics } = await peripheral.discoverSomeServicesAndCharacteristicsAsync(
+        [SERVICE_UUID],
+        [CHARACTERISTIC_UUID]
+      );
+      // Give the mtu exchange time to settle so every write fills one ATT packet.
+      await sleep(20);
+
+      const hci = noble._bindings._hci;
+      const data = Buffer.alloc((peripheral.mtu || 23) - 3, 0x5a);
+      const heapBefore = heapUsed();
+      const start = process.hrtime.bigint();
+      const deadline = Date.now() + duration;
+
+      while (Date.now() < deadline) {
+        if (hci._aclScheduler.length >= MAX_QUEUED) {
+          await new Promise(resolve => setImmediate(resolve));
+          continue;
+        }
+        await characteristics[0].writeAsync(data, true);
+      }
+
+      const seconds = Number(process.hrtime.bigint() - start) / 1e9;
+
+      return {
+        bytesPerSec: metric(received / seconds, 'bytes/s', 'higher'),
+        heapGrowth: metric(heapUsed() - heapBefore, 'bytes', 'lower')
+      };
+    } finally {
+      noble.stop();
+    }
+  }
+};
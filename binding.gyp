@@ -16,6 +16,11 @@
             'lib/win/binding.gyp:binding',
           ],
         }],
+        ['OS=="linux"', {
+          'dependencies': [
+            'lib/linux/binding.gyp:binding',
+          ],
+        }],
       ],
     },
   ],
@@ -0,0 +1,21 @@
+// Owns an HCI adapter and shares it with other processes, which attach to it with
+// withBindings('hci', { broker: true }) or NOBLE_HCI_BROKER=1.
+//
+//   node examples/hci-broker.js [socket path]
+const Broker = require('../lib/hci-socket/broker');
+
+// Takes the usual HCI options; the adapter is NOBLE_HCI_DEVICE_ID, as for noble itself.
+const broker = new Broker({ path: process.argv[2] });
+
+broker.on('listening', () => console.log('noble HCI broker listening'));
+broker.on('error', (error) => {
+  console.error(error.message);
+  process.exit(1);
+});
+
+broker.start();
+
+process.on('SIGINT', () => {
+  broker.stop();
+  process.exit(0);
+});
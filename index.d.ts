@@ -63,6 +63,84 @@ declare module '@stoprocent/noble' {
         timeout?: number;
     }
 
+    export interface ScanAcceptListEntry {
+        address: string;
+        /** Default is 'public' */
+        addressType?: PeripheralAddressType;
+    }
+
+    export interface ScanAcceptListResult {
+        /** Where advertisers not on the list are dropped; 'off' for an empty list */
+        mode: 'controller' | 'host' | 'off';
+        size: number;
+        /** Entries the controller's Filter Accept List holds; null until a list is set */
+        capacity: number | null;
+    }
+
+    export interface ScanProfile {
+        /** Given to custom profiles; a profile named in scanProfiles takes its key */
+        name?: string;
+        /** Send scan requests, to get scan responses. Default is true */
+        active?: boolean;
+        /** In units of 0.625 ms. Default is 0x0012 */
+        interval?: number;
+        /** In units of 0.625 ms, at most the interval. Default is 0x0012 */
+        window?: number;
+        /** LE Coded is only used where the controller supports it. Default is both */
+        phys?: Array<'1m' | 'coded'>;
+        /** Default is as passed to startScanning */
+        allowDuplicates?: boolean;
+        /** Default is the duplicatesRefresh option */
+        duplicatesRefresh?: number;
+    }
+
+    export interface ScanStats {
+        /** Name of the scan profile in use, null without one */
+        profile: string | null;
+        /** Share of the scan interval spent scanning, 0 to 1 */
+        duty: number;
+        /** Milliseconds scanning was enabled */
+        scanTime: number;
+        /** Milliseconds of it the controller was listening, by the duty cycle */
+        scanOnTime: number;
+        /** With several adapters, each adapter's own figures */
+        adapters?: ScanStats[];
+    }
+
+    export interface PeriodicSyncOptions {
+        /** Default is the SID the advertiser was heard on */
+        sid?: number;
+        /** Periodic events the controller may skip. Default is 0 */
+        skip?: number;
+        /** Milliseconds without a periodic advertisement before the sync is lost. Default is 10000 */
+        timeout?: number;
+        /** Milliseconds to find the periodic train. Default is 10000 */
+        establishTimeout?: number;
+    }
+
+    export class PeriodicSync extends EventEmitter {
+        readonly peripheralId: string;
+        readonly sid: number;
+        readonly phy: number;
+        /** Periodic advertising interval, in milliseconds */
+        readonly interval: number;
+        readonly state: 'established' | 'terminated' | 'lost';
+
+        terminate(callback?: () => void): void;
+        terminateAsync(): Promise<void>;
+        toString(): string;
+
+        on(event: "data", listener: (data: Buffer, rssi: number, txPower: number, truncated: boolean) => void): this;
+        on(event: "lost", listener: (reason: string) => void): this;
+        on(event: string, listener: Function): this;
+
+        once(event: "data", listener: (data: Buffer, rssi: number, txPower: number, truncated: boolean) => void): this;
+        once(event: "lost", listener: (reason: string) => void): this;
+        once(event: string, listener: Function): this;
+    }
+
+    export type ScanProfileName = 'default' | 'passive' | 'lowLatency' | 'lowPower' | string;
+
     export class Noble extends EventEmitter {
     
         constructor(bindings: any);
@@ -76,6 +154,10 @@ declare module '@stoprocent/noble' {
         discoverAsync(): AsyncGenerator<Peripheral, void, unknown>;
         connectAsync(idOrAddress: PeripheralIdOrAddress, options?: ConnectOptions): Promise<Peripheral>;
         pairAsync(idOrAddress: PeripheralIdOrAddress, kind?: DevicePairingKinds, protectionLevel?: DevicePairingProtectionLevel): Promise<void>;
+        setScanAcceptListAsync(devices: ScanAcceptListEntry[]): Promise<ScanAcceptListResult>;
+        setScanProfileAsync(profile: ScanProfileName | ScanProfile): Promise<string>;
+        getScanStatsAsync(): Promise<ScanStats>;
+        createPeriodicSyncAsync(idOrAddress: PeripheralIdOrAddress, options?: PeriodicSyncOptions): Promise<PeriodicSync>;
 
         startScanning(serviceUUIDs?: string[], allowDuplicates?: boolean, callback?: (error?: Error) => void): void;
         stopScanning(callback?: () => void): void;
@@ -84,6 +166,11 @@ declare module '@stoprocent/noble' {
         reset(): void;
         stop(): void;
         setAddress(address: string): void;
+        setScanAcceptList(devices: ScanAcceptListEntry[], callback?: (error: Error | null, result?: ScanAcceptListResult) => void): void;
+        setScanProfile(profile: ScanProfileName | ScanProfile, callback?: (error: Error | null, name?: string) => void): void;
+        getScanStats(callback?: (error: Error | null, stats?: ScanStats) => void): void;
+        createPeriodicSync(idOrAddress: PeripheralIdOrAddress, options?: PeriodicSyncOptions, callback?: (error: Error | null, sync?: PeriodicSync) => void): void;
+        terminatePeriodicSync(idOrAddress: PeripheralIdOrAddress): void;
 
      /**
       * Pair with a peripheral. `kind` defaults to
@@ -135,6 +222,11 @@ declare module '@stoprocent/noble' {
         manufacturerData: Buffer;
         serviceUuids: string[];
         serviceSolicitationUuids: string[];
+        /**
+         * HCI only: true while the extended advertising data was cut short,
+         * by the controller or past 1650 octets. Unset unless it ever was
+         */
+        truncated?: boolean;
     }
 
     export class Peripheral extends EventEmitter {
@@ -143,6 +235,11 @@ declare module '@stoprocent/noble' {
         readonly addressType: PeripheralAddressType;
         readonly connectable: boolean;
         readonly advertisement: PeripheralAdvertisement;
+        /**
+         * False when the last discovery repeated the advertising data already
+         * seen, so only rssi changed. Always true on bindings that cannot tell
+         */
+        readonly advertisementChanged: boolean;
         readonly rssi: number;
         readonly mtu: number | null;
         readonly services: Service[];
@@ -293,8 +390,27 @@ declare module '@stoprocent/noble' {
 
     export interface BaseBindingsOptions {}
 
+    /** Bytes, as a hex string, an array of octets or a Buffer */
+    export type ScanFilterBytes = string | number[] | Uint8Array;
+
+    /** Every key given must match; all and any combine nested filters */
+    export interface ScanFilter {
+        /** Minimum RSSI */
+        rssi?: number;
+        addressType?: PeripheralAddressType | PeripheralAddressType[];
+        address?: string | string[];
+        /** Prefix of the shortened or complete local name */
+        localName?: string;
+        /** 16, 32 or 128-bit service data UUIDs, any of which may match */
+        serviceData?: string | string[];
+        /** Prefix of the data after the company id, compared under mask when given */
+        manufacturerData?: { companyId?: number, prefix?: ScanFilterBytes, mask?: ScanFilterBytes };
+        all?: ScanFilter[];
+        any?: ScanFilter[];
+    }
+
     export interface HciBindingsOptions extends BaseBindingsOptions {
-        /** Driver Type ('default' | 'uart' | 'usb' | 'native') */
+        /** Driver Type ('default' | 'uart' | 'usb' | 'native' | 'linux' | 'replay' | 'virtual') */
         hciDriver?: import('@stoprocent/bluetooth-hci-socket').DriverType;
         /** Bind Params (for USB and UART Hci Drivers only) */
         bindParams?: import('@stoprocent/bluetooth-hci-socket').BindParams;
@@ -307,6 +423,129 @@ declare module '@stoprocent/noble' {
          * channel. The selected adapter must be down before binding.
          */
         userChannel?: boolean;
+        /**
+         * Hold HCI commands until the controller grants a command credit, as
+         * the kernel does for raw sockets. Defaults to on for the user channel
+         * and off otherwise.
+         */
+        commandFlowControl?: boolean;
+        /** Milliseconds to wait for a command's Command Complete/Status, Default is 2000 */
+        commandTimeout?: number;
+        /**
+         * Largest incoming L2CAP PDU, in bytes, that is reassembled; longer or
+         * malformed fragment sequences are dropped. Default is 4096
+         */
+        maxSduLength?: number;
+        /**
+         * Let advertising reports through only while scanning, and connection
+         * events only while a connection exists or is being made. On the user
+         * channel the controller's LE event mask is narrowed; on a raw socket,
+         * where the adapter is shared, only this socket's kernel filter is.
+         * Default is true, or false when NOBLE_HCI_STATIC_EVENT_FILTER is set
+         */
+        adaptiveEventFilter?: boolean;
+        /**
+         * Most devices remembered while scanning, to merge their scan
+         * responses and advertisements; the least recently heard is forgotten
+         * first. Default is 4096
+         */
+        discoveryCacheSize?: number;
+        /**
+         * Milliseconds after which a device not heard again is forgotten.
+         * Default is 300000 (5 minutes)
+         */
+        discoveryCacheTtl?: number;
+        /**
+         * Drop advertising reports from devices that do not match, checked on
+         * the raw report before it is parsed. A device that matched once is
+         * reported as usual, scan responses included
+         */
+        scanFilter?: ScanFilter;
+        /**
+         * Hold each scannable advertisement for up to this many milliseconds
+         * for its scan response, and report the two as one discovery. Off by
+         * default
+         */
+        scanResponseWindow?: number;
+        /**
+         * Report each device again about every this many milliseconds while
+         * scanning without duplicates, so RSSI stays fresh. Off by default
+         */
+        duplicatesRefresh?: number;
+        /** Scan with this profile until another is set. Default is 'default' */
+        scanProfile?: ScanProfileName | ScanProfile;
+        /** Profiles to set by name, in addition to the built-in ones */
+        scanProfiles?: { [name: string]: ScanProfile };
+        /**
+         * Narrow the scan window while advertising reports or event loop lag
+         * exceed their budget, and widen it again while discovery is slow.
+         * true uses the defaults. Off by default
+         */
+        scanScheduler?: boolean | {
+            /** Milliseconds between adjustments. Default is 1000 */
+            period?: number;
+            /** Reports per second. Default is 1000 */
+            maxReportRate?: number;
+            /** Milliseconds. Default is 50 */
+            maxLag?: number;
+            /** Milliseconds without a new device. Default is 10000 */
+            slowDiscovery?: number;
+            /** Default is 0.05 */
+            minDuty?: number;
+            /** Default is 1 */
+            maxDuty?: number;
+        };
+        /**
+         * Most periodic advertising syncs that exist at once, established or
+         * not. Default is 4
+         */
+        maxPeriodicSyncs?: number;
+        /**
+         * Shorten the time to poweredOn: independent controller reads are sent
+         * together, and the capabilities read are cached on disk, keyed by
+         * BD_ADDR and firmware version, so later starts can skip those reads.
+         * Default is false, or true when NOBLE_HCI_FAST_START is set
+         */
+        fastStart?: boolean;
+        /**
+         * Run the HCI stack (socket, GAP and GATT) in a worker thread, so it
+         * never waits behind application code on the main event loop. Events
+         * reach the main thread in batches. Options must be cloneable: no
+         * functions. Default is false, or true when NOBLE_HCI_WORKER is set
+         */
+        worker?: boolean;
+        /**
+         * Use several adapters as one: each entry is a device id, or options
+         * for that adapter merged over these. All of them scan; each new
+         * connection goes to the least loaded adapter that heard the
+         * peripheral. Default is NOBLE_HCI_DEVICE_IDS (e.g. "0,1") when set
+         */
+        adapters?: Array<number | HciBindingsOptions>;
+        /**
+         * With adapters, how long in milliseconds a discovery is held so that
+         * copies heard by other adapters merge into it. Default is 10
+         */
+        mergeWindow?: number;
+        /**
+         * Use an adapter owned by a broker process (lib/hci-socket/broker)
+         * instead of opening one: true for its default socket, in
+         * $XDG_RUNTIME_DIR or in a directory of the user's own in the temp
+         * directory, or the path of its Unix socket. Default is
+         * NOBLE_HCI_BROKER when set
+         */
+        broker?: boolean | string;
+        /**
+         * Capability cache file used by fastStart, or false to keep nothing on
+         * disk. Default is noble/hci-capabilities.json in $XDG_CACHE_HOME
+         * or ~/.cache
+         */
+        capabilityCache?: string | false;
+        /**
+         * With fastStart, skip HCI_Reset when the previous run stopped with no
+         * scan or connection running on the same controller and firmware.
+         * Default is false
+         */
+        skipReset?: boolean;
         /**
          * Offer LE Coded PHY as an acceptable PHY for connections, for
          * long-range links. Off by default: Coded PHY trades throughput for
@@ -315,6 +554,16 @@ declare module '@stoprocent/noble' {
          * scanning.
          */
         codedPhy?: boolean;
+        /**
+         * Capture every HCI packet to this file in btsnoop format (readable by
+         * Wireshark and btmon). Off by default; costs nothing when unset.
+         */
+        btsnoop?: string;
+        /**
+         * Keep only the most recent packets, up to this many megabytes, and
+         * write them out when noble stops. Unlimited by default.
+         */
+        btsnoopMaxSize?: number;
     }
 
     export interface MacBindingsOptions extends BaseBindingsOptions {}
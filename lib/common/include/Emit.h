@@ -1,6 +1,7 @@
 #pragma once
 
 #include <napi.h>
+#include <cstdint>
 #include <vector>
 #include <string>
 
@@ -32,6 +33,13 @@ public:
     void WriteValue(const std::string& uuid, const std::string& serviceUuid, const std::string& characteristicUuid, const std::string& descriptorUuid, const std::string& error = "");
     void ReadHandle(const std::string& uuid, int descriptorHandle, const Data& data, const std::string& error = "");
     void WriteHandle(const std::string& uuid, int descriptorHandle, const std::string& error = "");
+    // HCI transport (Linux)
+    void Packet(const Data& packet);
+    void AdvertisingReport(int type, uint64_t address, AddressType addressType, int rssi, const Data& eir);
+    void ExtendedAdvertisingReport(int type, uint64_t address, AddressType addressType, int txPower, int rssi, const Data& eir, int sid, int periodicInterval);
+    void AclData(int handle, int cid, const Data& data);
+    void AclDataDropped(int handle, const std::string& reason);
+    void SocketError(const std::string& message, const std::string& code);
     // clang-format on
 protected:
     std::shared_ptr<ThreadSafeCallback> mCallback;
@@ -331,3 +331,63 @@ void Emit::WriteHandle(const std::string& uuid, int descriptorHandle, const std:
         args = { _s("handleWrite"), _u(uuid), _n(descriptorHandle), error.empty() ? env.Null() : _e(error) };
     });
 }
+
+void Emit::Packet(const Data& packet)
+{
+    mCallback->call([packet](Napi::Env env, std::vector<napi_value>& args) {
+        // emit('data', packet);
+        args = { _s("data"), toBuffer(env, packet) };
+    });
+}
+
+void Emit::AdvertisingReport(int type, uint64_t address, AddressType addressType, int rssi, const Data& eir)
+{
+    mCallback->call([type, address, addressType, rssi, eir](Napi::Env env, std::vector<napi_value>& args) {
+        // emit('advertisingReport', type, address, addressType, rssi, eir);
+        args = { _s("advertisingReport"), _n(type), _n(static_cast<double>(address)), toAddressType(env, addressType), _n(rssi), toBuffer(env, eir) };
+    });
+}
+
+void Emit::ExtendedAdvertisingReport(int type, uint64_t address, AddressType addressType, int txPower, int rssi, const Data& eir, int sid, int periodicInterval)
+{
+    mCallback->call([type, address, addressType, txPower, rssi, eir, sid, periodicInterval](Napi::Env env, std::vector<napi_value>& args) {
+        // emit('extendedAdvertisingReport', type, address, addressType, txPower, rssi, eir, sid, periodicInterval);
+        args = { 
+            _s("extendedAdvertisingReport"), 
+            _n(type), 
+            _n(static_cast<double>(address)), 
+            toAddressType(env, addressType), 
+            _n(txPower), 
+            _n(rssi), 
+            toBuffer(env, eir),
+            _n(sid),
+            _n(periodicInterval)
+        };
+    });
+}
+
+void Emit::AclData(int handle, int cid, const Data& data)
+{
+    mCallback->call([handle, cid, data](Napi::Env env, std::vector<napi_value>& args) {
+        // emit('aclData', handle, cid, data);
+        args = { _s("aclData"), _n(handle), _n(cid), toBuffer(env, data) };
+    });
+}
+
+void Emit::AclDataDropped(int handle, const std::string& reason)
+{
+    mCallback->call([handle, reason](Napi::Env env, std::vector<napi_value>& args) {
+        // emit('aclDataDropped', handle, reason);
+        args = { _s("aclDataDropped"), _n(handle), _s(reason) };
+    });
+}
+
+void Emit::SocketError(const std::string& message, const std::string& code)
+{
+    mCallback->call([message, code](Napi::Env env, std::vector<napi_value>& args) {
+        // emit('error', error) with error.code as in Node's system errors
+        auto error = Napi::Error::New(env, message);
+        error.Set("code", _s(code));
+        args = { _s("error"), error.Value() };
+    });
+}
@@ -0,0 +1,147 @@
+const ATT_CID = 0x0004;
+const SIGNALING_CID = 0x0005;
+const SMP_CID = 0x0006;
+
+const ATT_OP_HANDLE_NOTIFY = 0x1b;
+const ATT_OP_WRITE_CMD = 0x52;
+const ATT_OP_SIGNED_WRITE_CMD = 0xd2;
+
+// Lanes, served strictly in this order
+const PRIORITY_HIGH = 0;
+const PRIORITY_BULK = 1;
+
+// ATT requests, responses and confirmations each hold up a transaction on the link, and
+// signaling and SMP have timeouts of their own, so they go ahead of unacknowledged data.
+const priorityOf = function (cid, data) {
+  if (cid === SIGNALING_CID || cid === SMP_CID) {
+    return PRIORITY_HIGH;
+  }
+  if (cid !== ATT_CID || data.length === 0) {
+    return PRIORITY_BULK;
+  }
+
+  const opcode = data.readUInt8(0);
+  return opcode === ATT_OP_WRITE_CMD || opcode === ATT_OP_SIGNED_WRITE_CMD || opcode === ATT_OP_HANDLE_NOTIFY
+    ? PRIORITY_BULK
+    : PRIORITY_HIGH;
+};
+
+/**
+ * Orders outgoing ACL packets: a queue per connection handle, served round-robin, one
+ * packet per turn, with the high priority lane of every connection ahead of any bulk data.
+ * Controller buffer credits are accounted by Hci; this only decides which packet goes next.
+ */
+const AclScheduler = function () {
+  this._links = new Map();
+  this._rings = [[], []]; // per lane, the links waiting for their turn
+  this.length = 0;
+};
+
+AclScheduler.PRIORITY_HIGH = PRIORITY_HIGH;
+AclScheduler.PRIORITY_BULK = PRIORITY_BULK;
+AclScheduler.priorityOf = priorityOf;
+
+// Queues the fragments of one L2CAP PDU, which are sent back to back on their link.
+AclScheduler.prototype.push = function (handle, packets, priority = PRIORITY_BULK) {
+  let link = this._links.get(handle);
+  if (link === undefined) {
+    link = {
+      handle,
+      lanes: [[], []],
+      pdu: null,
+      index: 0,
+      lane: PRIORITY_BULK,
+      waiting: [false, false],
+      removed: false,
+      length: 0
+    };
+    this._links.set(handle, link);
+  }
+
+  link.lanes[priority].push(packets);
+  link.length += packets.length;
+  this.length += packets.length;
+  this.schedule(link);
+};
+
+AclScheduler.prototype.shift = function () {
+  for (let lane = 0; lane < this._rings.length; lane++) {
+    const ring = this._rings[lane];
+
+    while (ring.length > 0) {
+      const link = ring.shift();
+      link.waiting[lane] = false;
+
+      // Entries are dropped lazily: the link went away, or it already waits in another lane.
+      if (link.removed || this.laneOf(link) !== lane) {
+        continue;
+      }
+
+      if (link.pdu === null) {
+        link.pdu = link.lanes[lane].shift();
+        link.index = 0;
+        link.lane = lane;
+      }
+
+      const packet = link.pdu[link.index++];
+      if (link.index === link.pdu.length) {
+        link.pdu = null;
+      }
+      link.length--;
+      this.length--;
+
+      this.schedule(link);
+      return { handle: link.handle, packet };
+    }
+  }
+
+  return null;
+};
+
+AclScheduler.prototype.remove = function (handle) {
+  const link = this._links.get(handle);
+  if (link === undefined) {
+    return;
+  }
+
+  this.length -= link.length;
+  link.removed = true;
+  this._links.delete(handle);
+};
+
+AclScheduler.prototype.clear = function () {
+  this._links.forEach(link => { link.removed = true; });
+  this._links.clear();
+  this._rings = [[], []];
+  this.length = 0;
+};
+
+AclScheduler.prototype.queued = function (handle) {
+  const link = this._links.get(handle);
+  return link === undefined ? 0 : link.length;
+};
+
+// A PDU that has started must finish before its link sends anything else, or the peer
+// would see a new start fragment in the middle of a PDU.
+AclScheduler.prototype.laneOf = function (link) {
+  if (link.pdu !== null) {
+    return link.lane;
+  }
+  if (link.lanes[PRIORITY_HIGH].length > 0) {
+    return PRIORITY_HIGH;
+  }
+  if (link.lanes[PRIORITY_BULK].length > 0) {
+    return PRIORITY_BULK;
+  }
+  return -1;
+};
+
+AclScheduler.prototype.schedule = function (link) {
+  const lane = this.laneOf(link);
+  if (lane !== -1 && !link.waiting[lane]) {
+    link.waiting[lane] = true;
+    this._rings[lane].push(link);
+  }
+};
+
+module.exports = AclScheduler;
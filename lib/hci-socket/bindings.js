@@ -59,13 +59,17 @@ NobleBindings.prototype.start = function () {
   this._hci.on('aclDataPkt', this.onAclDataPkt.bind(this));
 
   // Initialize the gap
-  this._gap = new Gap(this._hci);
+  this._gap = new Gap(this._hci, this._options);
 
   // Register event listeners for the gap
   this._gap.on('scanParametersSet', this.onScanParametersSet.bind(this));
   this._gap.on('scanStart', this.onScanStart.bind(this));
   this._gap.on('scanStop', this.onScanStop.bind(this));
   this._gap.on('discover', this.onDiscover.bind(this));
+  this._gap.on('discoveryEvict', this.onDiscoveryEvict.bind(this));
+  this._gap.on('periodicSyncEstablished', this.onPeriodicSyncEstablished.bind(this));
+  this._gap.on('periodicAdvertisingReport', this.onPeriodicAdvertisingReport.bind(this));
+  this._gap.on('periodicSyncLost', this.onPeriodicSyncLost.bind(this));
 
   // Initialize the hci
   this._hci.init();
@@ -76,6 +80,7 @@ NobleBindings.prototype.stop = function () {
   process.removeListener('SIGINT', this._sigIntHandler);
 
   this.stopScanning();
+  this._gap.terminatePeriodicSyncs();
   for (const handle in this._aclStreams) {
     this._hci.disconnect(handle);
   }
@@ -90,6 +95,34 @@ NobleBindings.prototype.setAddress = function (address) {
   this._hci.setAddress(address);
 };
 
+NobleBindings.prototype.setScanProfile = function (profile) {
+  let name;
+  try {
+    name = this._gap.setScanProfile(profile);
+  } catch (error) {
+    this.emit('scanProfileSet', error);
+    return;
+  }
+  this.emit('scanProfileSet', null, name);
+};
+
+// Scan time and duty cycle, from the process the stack runs in
+NobleBindings.prototype.getScanStats = function () {
+  return this._gap.getScanStats();
+};
+
+// The same, answered with scanStatsRead, so it also reaches Noble across a worker thread
+NobleBindings.prototype.readScanStats = function () {
+  this.emit('scanStatsRead', null, this.getScanStats());
+};
+
+NobleBindings.prototype.setScanAcceptList = function (devices) {
+  this._gap.setAcceptList(devices).then(
+    result => this.emit('scanAcceptListSet', null, result),
+    error => this.emit('scanAcceptListSet', error)
+  );
+};
+
 NobleBindings.prototype.startScanning = function (
   serviceUuids,
   allowDuplicates
@@ -113,6 +146,19 @@ NobleBindings.prototype.stopScanning = function () {
   }
 };
 
+NobleBindings.prototype.createPeriodicSync = function (peripheralUuid, options = {}) {
+  if (this._state !== 'poweredOn') {
+    const state = this._state || 'unknown';
+    this.emit('periodicSyncEstablished', peripheralUuid, new Error(`Cannot create a periodic sync while adapter state is ${state} (not poweredOn)`));
+    return;
+  }
+  this._gap.createPeriodicSync(peripheralUuid, options);
+};
+
+NobleBindings.prototype.terminatePeriodicSync = function (peripheralUuid) {
+  this._gap.terminatePeriodicSync(peripheralUuid);
+};
+
 NobleBindings.prototype.connect = function (peripheralUuid, parameters = {}) {
   if (this._state !== 'poweredOn') {
     const state = this._state || 'unknown';
@@ -182,6 +228,10 @@ NobleBindings.prototype.updateRssi = function (peripheralUuid) {
   this._hci.readRssi(this._handles[peripheralUuid]);
 };
 
+NobleBindings.prototype.freeAclBuffers = function () {
+  return this._hci.freeAclBuffers();
+};
+
 NobleBindings.prototype.onSigInt = function () {
   const sigIntListeners = process.listeners('SIGINT');
 
@@ -207,6 +257,9 @@ NobleBindings.prototype.onStateChange = function (state) {
       this.onDisconnComplete(handle, 0x03); // Hardware Failure
     }
 
+    // The controller keeps no syncs through a power cycle
+    this._gap.dropPeriodicSyncs(state);
+
     this._connectionQueue = [];
     this._pendingConnectionUuid = null;
     this._pendingConnectionAddress = null;
@@ -257,6 +310,30 @@ NobleBindings.prototype.onScanStop = function () {
   this.processConnectionQueue();
 };
 
+NobleBindings.prototype.onPeriodicSyncEstablished = function (peripheralUuid, error, info) {
+  this.emit('periodicSyncEstablished', peripheralUuid, error, info);
+};
+
+NobleBindings.prototype.onPeriodicAdvertisingReport = function (peripheralUuid, data, rssi, txPower, truncated) {
+  this.emit('periodicAdvertisingReport', peripheralUuid, data, rssi, txPower, truncated);
+};
+
+NobleBindings.prototype.onPeriodicSyncLost = function (peripheralUuid, reason) {
+  this.emit('periodicSyncLost', peripheralUuid, reason);
+};
+
+// Gap forgot the device, so its address goes too unless a link or a connection attempt still
+// needs it. Passed on for Noble and for a pool, which forget the peripheral in turn.
+NobleBindings.prototype.onDiscoveryEvict = function (address, uuid, reason) {
+  if (this._handles[uuid] === undefined && !this._connectionQueue.some(connection => connection.id === uuid)) {
+    delete this._addresses[uuid];
+    delete this._addresseTypes[uuid];
+    delete this._connectable[uuid];
+    delete this.scannable[uuid];
+  }
+  this.emit('discoveryEvict', uuid, reason);
+};
+
 NobleBindings.prototype.onDiscover = function (
   status,
   address,
@@ -264,7 +341,9 @@ NobleBindings.prototype.onDiscover = function (
   connectable,
   advertisement,
   rssi,
-  scannable
+  scannable,
+  uuid,
+  changed
 ) {
   if (this._scanServiceUuids === undefined) {
     return;
@@ -294,7 +373,10 @@ NobleBindings.prototype.onDiscover = function (
   }
 
   if (hasScanServiceUuids) {
-    const uuid = this.addressToId(address);
+    // Gap passes the id it made when it first saw the device
+    if (uuid === undefined) {
+      uuid = this.addressToId(address);
+    }
     this._addresses[uuid] = address;
     this._addresseTypes[uuid] = addressType;
     this._connectable[uuid] = connectable;
@@ -308,7 +390,8 @@ NobleBindings.prototype.onDiscover = function (
       connectable,
       advertisement,
       rssi,
-      scannable
+      scannable,
+      changed !== false
     );
   }
 };
@@ -0,0 +1,131 @@
+const debug = require('debug')('hci-broker-client');
+
+const { EventEmitter } = require('events');
+const net = require('net');
+
+const { pack, unpack } = require('./worker-messages');
+const { checkOwner, defaultPath, frame, FrameReader } = require('./broker-protocol');
+
+// What Noble calls on its bindings; the broker answers with events.
+const METHODS = [
+  'setScanParameters',
+  'setAddress',
+  'setScanAcceptList',
+  'setScanProfile',
+  'readScanStats',
+  'startScanning',
+  'stopScanning',
+  'connect',
+  'disconnect',
+  'cancelConnect',
+  'createPeriodicSync',
+  'terminatePeriodicSync',
+  'updateRssi',
+  'addService',
+  'discoverServices',
+  'discoverIncludedServices',
+  'addCharacteristics',
+  'discoverCharacteristics',
+  'read',
+  'write',
+  'broadcast',
+  'notify',
+  'discoverDescriptors',
+  'readValue',
+  'writeValue',
+  'readHandle',
+  'writeHandle'
+];
+
+/**
+ * Bindings for an adapter owned by another process running Broker. Calls go to the broker over
+ * its Unix socket, and it sends back the events meant for this client: discoveries matching its
+ * scan, and the events of the peripherals it connected to.
+ */
+const BrokerBindings = function (options) {
+  this._path = typeof options.broker === 'string' ? options.broker : defaultPath();
+  this._socket = null;
+  this._connected = false;
+  this._reader = new FrameReader();
+};
+
+Object.setPrototypeOf(BrokerBindings.prototype, EventEmitter.prototype);
+
+BrokerBindings.prototype.start = function () {
+  // Calls and events would go through whoever owns the socket.
+  try {
+    checkOwner(this._path);
+  } catch (error) {
+    debug(`not attaching - ${error.message}`);
+    process.nextTick(() => this.emit('stateChange', 'unsupported'));
+    return;
+  }
+
+  this._socket = net.createConnection(this._path);
+
+  this._socket.on('connect', this.onConnect.bind(this));
+  this._socket.on('data', this.onData.bind(this));
+  this._socket.on('error', this.onError.bind(this));
+  this._socket.on('close', this.onClose.bind(this));
+};
+
+// The broker releases whatever this client held: its scan, its links and subscriptions.
+BrokerBindings.prototype.stop = function () {
+  if (this._socket === null) {
+    return;
+  }
+
+  this._socket.end();
+  this._socket = null;
+};
+
+BrokerBindings.prototype.call = function (method, args) {
+  if (!this._connected) {
+    debug(`${method} ignored - not attached`);
+    return;
+  }
+
+  this._socket.write(frame(pack([method, args])));
+};
+
+for (const method of METHODS) {
+  BrokerBindings.prototype[method] = function (...args) {
+    this.call(method, args);
+  };
+}
+
+BrokerBindings.prototype.onConnect = function () {
+  debug(`attached to ${this._path}`);
+  this._connected = true;
+};
+
+BrokerBindings.prototype.onData = function (data) {
+  for (const message of this._reader.push(data)) {
+    for (const [event, args] of unpack(message)) {
+      this.emit(event, ...args);
+    }
+  }
+};
+
+BrokerBindings.prototype.onError = function (error) {
+  debug(`socket error: ${error.message}`);
+};
+
+BrokerBindings.prototype.onClose = function () {
+  const wasConnected = this._connected;
+  this._connected = false;
+
+  if (this._socket === null) {
+    return;
+  }
+  this._socket = null;
+
+  // Without a broker there is no adapter to speak of.
+  this.emit('stateChange', wasConnected ? 'poweredOff' : 'unsupported');
+};
+
+BrokerBindings.prototype.addressToId = function (address) {
+  return address.replace(/:/g, '').toLowerCase();
+};
+
+module.exports = BrokerBindings;
@@ -0,0 +1,115 @@
+// Frames on the broker's Unix socket. Each carries one message as packed by worker-messages:
+// the 32-bit lengths of its JSON part and of its buffer part, then the two parts. Unlike
+// plain JSON, undefined arguments stay undefined rather than becoming null.
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const HEADER_LENGTH = 8;
+// Far above any call or batch of events; a peer announcing more is not speaking this protocol
+const MAX_FRAME_LENGTH = 16 * 1024 * 1024;
+const UNDEFINED = '__nobleUndefined';
+
+const replacer = (key, value) => value === undefined ? { [UNDEFINED]: true } : value;
+const reviver = (key, value) => value !== null && typeof value === 'object' && value[UNDEFINED] === true ? undefined : value;
+
+// Per user, so no other account can take the path first: in the user's runtime directory,
+// or else in a directory of the user's own in the temp directory.
+const defaultPath = function () {
+  if (process.env.XDG_RUNTIME_DIR) {
+    return path.join(process.env.XDG_RUNTIME_DIR, 'noble-hci.sock');
+  }
+  return path.join(os.tmpdir(), `noble-${os.userInfo().uid}`, 'hci.sock');
+};
+
+// Throws when the socket, or the directory it lives in, belongs to another user. Root is
+// trusted, so a broker running as root can serve other users on a path they pass.
+const checkOwner = function (socketPath) {
+  if (typeof process.getuid !== 'function') {
+    return; // no file owners to go by
+  }
+
+  for (const file of [path.dirname(socketPath), socketPath]) {
+    let stats;
+    try {
+      stats = fs.lstatSync(file);
+    } catch (error) {
+      if (error.code === 'ENOENT') {
+        continue;
+      }
+      throw error;
+    }
+    if (stats.uid !== process.getuid() && stats.uid !== 0) {
+      throw new Error(`${file} belongs to another user`);
+    }
+  }
+};
+
+const frame = function ({ values, buffer }) {
+  const json = Buffer.from(JSON.stringify(values, replacer));
+  const header = Buffer.alloc(HEADER_LENGTH);
+  header.writeUInt32LE(json.length, 0);
+  header.writeUInt32LE(buffer.byteLength, 4);
+
+  return Buffer.concat([header, json, Buffer.from(buffer)]);
+};
+
+// Socket reads split and join frames arbitrarily; chunks are only joined once a frame is whole.
+const FrameReader = function () {
+  this._chunks = [];
+  this._length = 0;
+};
+
+FrameReader.prototype.push = function (data) {
+  const messages = [];
+
+  this._chunks.push(data);
+  this._length += data.length;
+
+  while (this._length >= HEADER_LENGTH) {
+    if (this._chunks[0].length < HEADER_LENGTH) {
+      this.join();
+    }
+
+    const head = this._chunks[0];
+    const jsonLength = head.readUInt32LE(0);
+    const end = HEADER_LENGTH + jsonLength + head.readUInt32LE(4);
+    if (end > HEADER_LENGTH + MAX_FRAME_LENGTH) {
+      throw new Error(`frame of ${end - HEADER_LENGTH} bytes is too long`);
+    }
+    if (this._length < end) {
+      break;
+    }
+    if (head.length < end) {
+      this.join();
+    }
+
+    const data = this._chunks[0];
+    const start = data.byteOffset + HEADER_LENGTH + jsonLength;
+    messages.push({
+      values: JSON.parse(data.toString('utf8', HEADER_LENGTH, HEADER_LENGTH + jsonLength), reviver),
+      buffer: data.buffer.slice(start, data.byteOffset + end)
+    });
+
+    if (data.length === end) {
+      this._chunks.shift();
+    } else {
+      this._chunks[0] = data.subarray(end);
+    }
+    this._length -= end;
+  }
+
+  return messages;
+};
+
+FrameReader.prototype.join = function () {
+  this._chunks = [Buffer.concat(this._chunks, this._length)];
+};
+
+module.exports = {
+  checkOwner,
+  defaultPath,
+  frame,
+  FrameReader
+};
@@ -0,0 +1,686 @@
+const debug = require('debug')('hci-broker');
+
+const { EventEmitter } = require('events');
+const fs = require('fs');
+const net = require('net');
+const path = require('path');
+
+const NobleBindings = require('./bindings');
+const PoolBindings = require('./pool-bindings');
+const { pack, unpack } = require('./worker-messages');
+const { checkOwner, defaultPath, frame, FrameReader } = require('./broker-protocol');
+
+const DEFAULT_SCAN_PARAMETERS = [0x0012, 0x0012];
+
+// Calls answered by exactly one event, which goes back to the client that made the call,
+// with how many leading arguments the call and its answer share. A discovery answered to
+// every sharer would replace the attributes the others are waiting on.
+const REPLIES = {
+  discoverServices: ['servicesDiscover', 1],
+  discoverIncludedServices: ['includedServicesDiscover', 2],
+  discoverCharacteristics: ['characteristicsDiscover', 2],
+  discoverDescriptors: ['descriptorsDiscover', 3],
+  updateRssi: ['rssiUpdate', 1],
+  read: ['read', 3],
+  write: ['write', 3],
+  broadcast: ['broadcast', 3],
+  notify: ['notify', 3],
+  readValue: ['valueRead', 4],
+  writeValue: ['valueWrite', 4],
+  readHandle: ['handleRead', 2],
+  writeHandle: ['handleWrite', 2]
+};
+
+const REPLY_EVENTS = new Map(Object.values(REPLIES));
+
+// Other calls a client may make for a peripheral it shares
+const PERIPHERAL_METHODS = [
+  'addService',
+  'addCharacteristics',
+  ...Object.keys(REPLIES).filter(method => method !== 'notify')
+];
+
+// Events every sharer of the peripheral receives
+const SHARED_EVENTS = [
+  'servicesDiscovered',
+  'characteristicsDiscovered',
+  'handleNotify'
+];
+
+const matchesServices = function (serviceUuids, advertisement) {
+  if (serviceUuids.length === 0) {
+    return true;
+  }
+
+  const advertised = (advertisement.serviceUuids || [])
+    .concat((advertisement.serviceData || []).map(data => data.uuid));
+  return advertised.some(uuid => serviceUuids.includes(uuid));
+};
+
+/**
+ * Owns one adapter (or a pool of them) and shares it with BrokerBindings clients in other
+ * processes over a Unix socket. The adapter scans while any client does, with the union of
+ * their settings; each client only receives the discoveries matching its own service filter.
+ * Links are shared: a client connecting to a peripheral that is already connected attaches to
+ * the link, which is closed when its last client lets go.
+ */
+const Broker = function (options = {}) {
+  const { path: socketPath, ...bindingsOptions } = options;
+
+  this._path = socketPath || defaultPath();
+  this._bindings = bindingsOptions.adapters ? new PoolBindings(bindingsOptions) : new NobleBindings(bindingsOptions);
+  this._server = null;
+  this._clients = new Set();
+
+  this._state = null;
+  this._address = null;
+
+  this._scanning = false; // as last reported by the adapter
+  this._scanBusy = false; // a start or stop is in flight
+  this._scanAllowDuplicates = false;
+  this._scanStartWaiters = new Set();
+  this._scanParameters = DEFAULT_SCAN_PARAMETERS;
+  this._scanParametersWaiters = new Set();
+
+  this._peripherals = new Map(); // uuid -> { clients, connected, mtu }
+  this._subscriptions = new Map(); // uuid -> characteristic key -> clients receiving notifications
+  this._replies = new Map(); // uuid -> reply key -> clients waiting, oldest first
+};
+
+Object.setPrototypeOf(Broker.prototype, EventEmitter.prototype);
+
+Broker.prototype.start = function () {
+  const bindings = this._bindings;
+
+  try {
+    fs.mkdirSync(path.dirname(this._path), { recursive: true, mode: 0o700 });
+    checkOwner(this._path);
+  } catch (error) {
+    this.emit('error', error);
+    return;
+  }
+
+  bindings.on('stateChange', this.onStateChange.bind(this));
+  bindings.on('addressChange', this.onAddressChange.bind(this));
+  bindings.on('scanParametersSet', this.onScanParametersSet.bind(this));
+  bindings.on('scanStart', this.onScanStart.bind(this));
+  bindings.on('scanStop', this.onScanStop.bind(this));
+  bindings.on('discover', this.onDiscover.bind(this));
+  bindings.on('discoveryEvict', this.onDiscoveryEvict.bind(this));
+  bindings.on('connect', this.onConnect.bind(this));
+  bindings.on('disconnect', this.onDisconnect.bind(this));
+  bindings.on('onMtu', this.onMtu.bind(this));
+  for (const event of SHARED_EVENTS) {
+    bindings.on(event, (peripheralUuid, ...args) => this.sendToSharers(peripheralUuid, event, [peripheralUuid, ...args]));
+  }
+  for (const event of REPLY_EVENTS.keys()) {
+    if (event !== 'notify' && event !== 'read') {
+      bindings.on(event, (...args) => this.onReply(event, args));
+    }
+  }
+  bindings.on('read', this.onRead.bind(this));
+  bindings.on('notify', this.onNotify.bind(this));
+
+  bindings.start();
+
+  this._server = net.createServer(this.onClientConnect.bind(this));
+  this._server.on('error', this.onServerError.bind(this));
+  this._server.on('listening', () => {
+    debug(`listening on ${this._path}`);
+    this.emit('listening');
+  });
+  this._server.listen(this._path);
+};
+
+Broker.prototype.stop = function () {
+  if (this._server !== null) {
+    this._server.close();
+    this._server = null;
+    fs.rmSync(this._path, { force: true });
+  }
+
+  for (const client of this._clients) {
+    client.socket.destroy();
+  }
+  this._clients.clear();
+
+  this._bindings.stop();
+};
+
+// A socket file left behind by a broker that is gone is replaced; a live one is not, nor is
+// anything that is not a socket of this user's.
+Broker.prototype.onServerError = function (error) {
+  if (error.code !== 'EADDRINUSE') {
+    this.emit('error', error);
+    return;
+  }
+
+  try {
+    checkOwner(this._path);
+    if (!fs.lstatSync(this._path).isSocket()) {
+      throw new Error(`${this._path} is not a socket`);
+    }
+  } catch (checkError) {
+    this.emit('error', checkError);
+    return;
+  }
+
+  const probe = net.createConnection(this._path);
+  probe.on('connect', () => {
+    probe.destroy();
+    this.emit('error', error);
+  });
+  probe.on('error', () => {
+    debug(`removing stale socket ${this._path}`);
+    fs.rmSync(this._path, { force: true });
+    this._server.listen(this._path);
+  });
+};
+
+Broker.prototype.onClientConnect = function (socket) {
+  const client = {
+    socket,
+    reader: new FrameReader(),
+    batch: [],
+    scan: null, // { serviceUuids, allowDuplicates } while scanning
+    scanParameters: null
+  };
+  this._clients.add(client);
+  debug(`client attached, ${this._clients.size} in total`);
+
+  socket.on('data', this.onClientData.bind(this, client));
+  socket.on('error', error => debug(`client error: ${error.message}`));
+  socket.on('close', this.onClientClose.bind(this, client));
+
+  if (this._state !== null) {
+    this.send(client, 'stateChange', [this._state]);
+  }
+  if (this._address !== null) {
+    this.send(client, 'addressChange', [this._address]);
+  }
+};
+
+Broker.prototype.onClientData = function (client, data) {
+  let messages;
+  try {
+    messages = client.reader.push(data);
+  } catch (error) {
+    debug(`dropping client - malformed frame: ${error.message}`);
+    client.socket.destroy();
+    return;
+  }
+
+  for (const message of messages) {
+    const [method, args] = unpack(message);
+    this.onCall(client, method, args);
+  }
+};
+
+Broker.prototype.onClientClose = function (client) {
+  if (!this._clients.delete(client)) {
+    return;
+  }
+  debug(`client detached, ${this._clients.size} left`);
+
+  client.scan = null;
+  client.scanParameters = null;
+  this._scanStartWaiters.delete(client);
+  this._scanParametersWaiters.delete(client);
+
+  // Answers still owed to it are dropped rather than handed to the next client in line.
+  for (const replies of this._replies.values()) {
+    for (const waiting of replies.values()) {
+      waiting.forEach((waiter, index) => {
+        if (waiter === client) {
+          waiting[index] = null;
+        }
+      });
+    }
+  }
+
+  for (const [peripheralUuid, subscriptions] of this._subscriptions) {
+    for (const [key, clients] of subscriptions) {
+      if (clients.delete(client) && clients.size === 0) {
+        subscriptions.delete(key);
+        this._bindings.notify(peripheralUuid, ...key.split('/'), false);
+      }
+    }
+  }
+
+  for (const [peripheralUuid, peripheral] of this._peripherals) {
+    if (peripheral.clients.delete(client)) {
+      this.release(peripheralUuid, peripheral);
+    }
+  }
+
+  this.updateScan();
+  this.updateScanParameters();
+};
+
+Broker.prototype.onCall = function (client, method, args) {
+  switch (method) {
+    case 'setScanParameters':
+      client.scanParameters = [args[0], args[1]];
+      this._scanParametersWaiters.add(client);
+      this.updateScanParameters();
+      break;
+    case 'startScanning':
+      client.scan = { serviceUuids: args[0] || [], allowDuplicates: Boolean(args[1]) };
+      this._scanStartWaiters.add(client);
+      this.updateScan();
+      break;
+    case 'stopScanning':
+      client.scan = null;
+      this._scanStartWaiters.delete(client);
+      this.send(client, 'scanStop', []);
+      this.updateScan();
+      break;
+    case 'connect':
+      this.connect(client, args[0], args[1]);
+      break;
+    case 'cancelConnect':
+      this.cancelConnect(client, args[0]);
+      break;
+    case 'disconnect':
+      this.disconnect(client, args[0]);
+      break;
+    case 'notify':
+      this.notify(client, ...args);
+      break;
+    case 'setAddress':
+      debug('setAddress ignored - the adapter is shared');
+      break;
+    case 'setScanProfile':
+      // The broker picks the scan parameters from every client's request
+      this.send(client, 'scanProfileSet', [new Error('The scan profile cannot be set on a shared adapter')]);
+      break;
+    case 'readScanStats':
+      // Those of the shared adapter, which scans for every client
+      this.send(client, 'scanStatsRead', [null, this._bindings.getScanStats()]);
+      break;
+    case 'setScanAcceptList':
+      // One client's list would hide everyone else's advertisers
+      this.send(client, 'scanAcceptListSet', [new Error('The scan accept list cannot be set on a shared adapter')]);
+      break;
+    case 'createPeriodicSync':
+      // The controller's few syncs would go to whichever client asked first
+      this.send(client, 'periodicSyncEstablished', [args[0], new Error('Periodic syncs cannot be created on a shared adapter')]);
+      break;
+    case 'terminatePeriodicSync':
+      debug('terminatePeriodicSync ignored - the adapter is shared');
+      break;
+    default:
+      if (!PERIPHERAL_METHODS.includes(method)) {
+        debug(`${method} ignored - unknown call`);
+      } else if (this.isSharer(client, args[0])) {
+        if (REPLIES[method] !== undefined) {
+          this.expectReply(client, method, args);
+        }
+        this._bindings[method](...args);
+      }
+  }
+};
+
+// The adapter scans while any client does and no connection is being made.
+Broker.prototype.updateScan = function () {
+  if (this._scanBusy) {
+    return;
+  }
+
+  const scanning = [...this._clients].filter(client => client.scan !== null);
+  const connecting = [...this._peripherals.values()].some(peripheral => !peripheral.connected);
+  const wanted = scanning.length > 0 && this._state === 'poweredOn' && !connecting;
+  const allowDuplicates = scanning.some(client => client.scan.allowDuplicates);
+  const outdated = allowDuplicates !== this._scanAllowDuplicates || this.scanParametersChanged();
+
+  if (this._scanning && (!wanted || outdated)) {
+    // Settings are changed with scanning off; it starts again once it has stopped.
+    this._scanBusy = true;
+    this._bindings.stopScanning();
+  } else if (!this._scanning && wanted) {
+    this._scanBusy = true;
+    this._scanAllowDuplicates = allowDuplicates;
+    this._scanParameters = this.arbitrateScanParameters();
+    this._bindings.setScanParameters(...this._scanParameters);
+    this._bindings.startScanning([], allowDuplicates);
+  } else if (this._scanning) {
+    for (const client of this._scanStartWaiters) {
+      this.send(client, 'scanStart', [!allowDuplicates]);
+    }
+    this._scanStartWaiters.clear();
+  }
+};
+
+// The most thorough request wins: the highest duty cycle, then the shortest interval.
+Broker.prototype.arbitrateScanParameters = function () {
+  let best = null;
+
+  for (const client of this._clients) {
+    const parameters = client.scanParameters;
+    if (parameters === null) {
+      continue;
+    }
+
+    const duty = parameters[1] / parameters[0];
+    const bestDuty = best === null ? -1 : best[1] / best[0];
+    if (duty > bestDuty || (duty === bestDuty && parameters[0] < best[0])) {
+      best = parameters;
+    }
+  }
+
+  return best || DEFAULT_SCAN_PARAMETERS;
+};
+
+Broker.prototype.scanParametersChanged = function () {
+  const parameters = this.arbitrateScanParameters();
+  return parameters[0] !== this._scanParameters[0] || parameters[1] !== this._scanParameters[1];
+};
+
+Broker.prototype.updateScanParameters = function () {
+  if (!this.scanParametersChanged()) {
+    this.onScanParametersSet();
+  } else if (this._scanning || this._scanBusy) {
+    // Applied by the restart
+    this.updateScan();
+  } else if (this._state === 'poweredOn') {
+    this._scanParameters = this.arbitrateScanParameters();
+    this._bindings.setScanParameters(...this._scanParameters);
+  } else {
+    this.onScanParametersSet();
+  }
+};
+
+Broker.prototype.connect = function (client, peripheralUuid, parameters) {
+  const peripheral = this._peripherals.get(peripheralUuid);
+
+  if (peripheral === undefined) {
+    // The adapter stops scanning for the attempt itself, and resumes once it is over.
+    this._peripherals.set(peripheralUuid, { clients: new Set([client]), connected: false, mtu: null });
+    this._bindings.connect(peripheralUuid, parameters);
+  } else if (!peripheral.clients.has(client)) {
+    peripheral.clients.add(client);
+    if (peripheral.connected) {
+      this.send(client, 'connect', [peripheralUuid, null]);
+      if (peripheral.mtu !== null) {
+        this.send(client, 'onMtu', [peripheralUuid, peripheral.mtu]);
+      }
+    }
+  }
+};
+
+Broker.prototype.cancelConnect = function (client, peripheralUuid) {
+  const peripheral = this._peripherals.get(peripheralUuid);
+
+  if (peripheral !== undefined && !peripheral.connected && peripheral.clients.delete(client)) {
+    this.release(peripheralUuid, peripheral);
+  }
+};
+
+Broker.prototype.disconnect = function (client, peripheralUuid) {
+  const peripheral = this._peripherals.get(peripheralUuid);
+  if (peripheral === undefined || !peripheral.clients.has(client)) {
+    return;
+  }
+
+  if (peripheral.clients.size === 1) {
+    // The last one hears the real disconnect.
+    this._bindings.disconnect(peripheralUuid);
+    return;
+  }
+
+  peripheral.clients.delete(client);
+  this.send(client, 'disconnect', [peripheralUuid, 0x16]); // connection terminated by local host
+};
+
+// Ends an attempt or a link nobody shares anymore.
+Broker.prototype.release = function (peripheralUuid, peripheral) {
+  if (peripheral.clients.size > 0) {
+    return;
+  }
+
+  if (peripheral.connected) {
+    this._bindings.disconnect(peripheralUuid);
+  } else {
+    this._peripherals.delete(peripheralUuid);
+    this._bindings.cancelConnect(peripheralUuid);
+    this.updateScan();
+  }
+};
+
+// Notifications are enabled while any sharer wants them.
+Broker.prototype.notify = function (client, peripheralUuid, serviceUuid, characteristicUuid, notify) {
+  if (!this.isSharer(client, peripheralUuid)) {
+    return;
+  }
+
+  let subscriptions = this._subscriptions.get(peripheralUuid);
+  if (subscriptions === undefined) {
+    subscriptions = new Map();
+    this._subscriptions.set(peripheralUuid, subscriptions);
+  }
+
+  const key = `${serviceUuid}/${characteristicUuid}`;
+  const clients = subscriptions.get(key) || new Set();
+  const wasEnabled = clients.size > 0;
+
+  if (notify) {
+    clients.add(client);
+    subscriptions.set(key, clients);
+  } else {
+    clients.delete(client);
+    if (clients.size === 0) {
+      subscriptions.delete(key);
+    }
+  }
+
+  if (wasEnabled === clients.size > 0) {
+    this.send(client, 'notify', [peripheralUuid, serviceUuid, characteristicUuid, Boolean(notify)]);
+    return;
+  }
+
+  this.expectReply(client, 'notify', [peripheralUuid, serviceUuid, characteristicUuid]);
+  this._bindings.notify(peripheralUuid, serviceUuid, characteristicUuid, notify);
+};
+
+Broker.prototype.isSharer = function (client, peripheralUuid) {
+  const peripheral = this._peripherals.get(peripheralUuid);
+
+  if (peripheral === undefined || !peripheral.clients.has(client)) {
+    debug(`call for ${peripheralUuid} ignored - not connected by this client`);
+    return false;
+  }
+  return true;
+};
+
+Broker.prototype.expectReply = function (client, method, args) {
+  const [event, length] = REPLIES[method];
+  const key = [event, ...args.slice(1, length)].join('/');
+
+  let replies = this._replies.get(args[0]);
+  if (replies === undefined) {
+    replies = new Map();
+    this._replies.set(args[0], replies);
+  }
+
+  const waiting = replies.get(key);
+  if (waiting === undefined) {
+    replies.set(key, [client]);
+  } else {
+    waiting.push(client);
+  }
+};
+
+// Answers come in the order the calls went out, so the oldest waiter gets it.
+Broker.prototype.onReply = function (event, args) {
+  const replies = this._replies.get(args[0]);
+  const key = [event, ...args.slice(1, REPLY_EVENTS.get(event))].join('/');
+  const waiting = replies !== undefined ? replies.get(key) : undefined;
+
+  if (waiting === undefined) {
+    if (event !== 'notify') {
+      this.sendToSharers(args[0], event, args);
+    }
+    return;
+  }
+
+  const client = waiting.shift();
+  if (waiting.length === 0) {
+    replies.delete(key);
+  }
+  if (client !== null) {
+    this.send(client, event, args);
+  }
+};
+
+Broker.prototype.onRead = function (peripheralUuid, serviceUuid, characteristicUuid, data, isNotification) {
+  if (!isNotification) {
+    this.onReply('read', [peripheralUuid, serviceUuid, characteristicUuid, data, isNotification]);
+    return;
+  }
+
+  const subscriptions = this._subscriptions.get(peripheralUuid);
+  const clients = subscriptions !== undefined ? subscriptions.get(`${serviceUuid}/${characteristicUuid}`) : undefined;
+  if (clients !== undefined) {
+    for (const client of clients) {
+      this.send(client, 'read', [peripheralUuid, serviceUuid, characteristicUuid, data, true]);
+    }
+  }
+};
+
+Broker.prototype.onNotify = function (peripheralUuid, serviceUuid, characteristicUuid, state) {
+  this.onReply('notify', [peripheralUuid, serviceUuid, characteristicUuid, state]);
+};
+
+Broker.prototype.onStateChange = function (state) {
+  this._state = state;
+
+  if (state !== 'poweredOn') {
+    // Clients start over from their own stateChange.
+    this._scanning = false;
+    this._scanBusy = false;
+    this._scanStartWaiters.clear();
+    for (const client of this._clients) {
+      client.scan = null;
+    }
+    for (const [peripheralUuid, peripheral] of this._peripherals) {
+      if (!peripheral.connected) {
+        this._peripherals.delete(peripheralUuid);
+      }
+    }
+  }
+
+  this.broadcast('stateChange', [state]);
+  this.updateScanParameters();
+};
+
+Broker.prototype.onAddressChange = function (address) {
+  this._address = address;
+  this.broadcast('addressChange', [address]);
+};
+
+Broker.prototype.onScanParametersSet = function () {
+  for (const client of this._scanParametersWaiters) {
+    this.send(client, 'scanParametersSet', []);
+  }
+  this._scanParametersWaiters.clear();
+};
+
+Broker.prototype.onScanStart = function () {
+  this._scanning = true;
+  this._scanBusy = false;
+  this.updateScan();
+};
+
+// Also reported when the adapter stops on its own to make a connection; it resumes after.
+Broker.prototype.onScanStop = function () {
+  this._scanning = false;
+  this._scanBusy = false;
+  this.updateScan();
+};
+
+Broker.prototype.onDiscover = function (peripheralUuid, address, addressType, connectable, advertisement, rssi, scannable, changed) {
+  const args = [peripheralUuid, address, addressType, connectable, advertisement, rssi, scannable, changed];
+
+  for (const client of this._clients) {
+    if (client.scan !== null && matchesServices(client.scan.serviceUuids, advertisement)) {
+      this.send(client, 'discover', args);
+    }
+  }
+};
+
+// Every client may have been sent the peripheral, so every client may forget it.
+Broker.prototype.onDiscoveryEvict = function (peripheralUuid, reason) {
+  for (const client of this._clients) {
+    this.send(client, 'discoveryEvict', [peripheralUuid, reason]);
+  }
+};
+
+Broker.prototype.onConnect = function (peripheralUuid, error) {
+  const peripheral = this._peripherals.get(peripheralUuid);
+
+  if (peripheral !== undefined) {
+    this.sendToSharers(peripheralUuid, 'connect', [peripheralUuid, error]);
+    if (error) {
+      this._peripherals.delete(peripheralUuid);
+    } else {
+      peripheral.connected = true;
+      // Everyone cancelled while it was being made.
+      this.release(peripheralUuid, peripheral);
+    }
+  } else if (!error) {
+    this._bindings.disconnect(peripheralUuid);
+  }
+
+  this.updateScan();
+};
+
+Broker.prototype.onDisconnect = function (peripheralUuid, reason) {
+  this.sendToSharers(peripheralUuid, 'disconnect', [peripheralUuid, reason]);
+
+  this._peripherals.delete(peripheralUuid);
+  this._subscriptions.delete(peripheralUuid);
+  this._replies.delete(peripheralUuid);
+  this.updateScan();
+};
+
+Broker.prototype.onMtu = function (peripheralUuid, mtu) {
+  const peripheral = this._peripherals.get(peripheralUuid);
+  if (peripheral !== undefined) {
+    peripheral.mtu = mtu;
+  }
+
+  this.sendToSharers(peripheralUuid, 'onMtu', [peripheralUuid, mtu]);
+};
+
+Broker.prototype.sendToSharers = function (peripheralUuid, event, args) {
+  const peripheral = this._peripherals.get(peripheralUuid);
+  if (peripheral === undefined) {
+    return;
+  }
+
+  for (const client of peripheral.clients) {
+    this.send(client, event, args);
+  }
+};
+
+Broker.prototype.broadcast = function (event, args) {
+  for (const client of this._clients) {
+    this.send(client, event, args);
+  }
+};
+
+// Everything for a client in one turn of the event loop goes out as one frame.
+Broker.prototype.send = function (client, event, args) {
+  if (client.batch.length === 0) {
+    setImmediate(() => {
+      const batch = client.batch;
+      client.batch = [];
+      if (this._clients.has(client)) {
+        client.socket.write(frame(pack(batch)));
+      }
+    });
+  }
+  client.batch.push([event, args]);
+};
+
+module.exports = Broker;
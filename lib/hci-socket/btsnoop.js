@@ -0,0 +1,192 @@
+const debug = require('debug')('btsnoop');
+
+const fs = require('fs');
+
+// https://fte.com/webhelpii/hsu/Content/Technical_Information/BT_Snoop_File_Format.htm
+const BTSNOOP_MAGIC = Buffer.from('6274736e6f6f7000', 'hex'); // "btsnoop\0"
+const BTSNOOP_VERSION = 1;
+const BTSNOOP_DATALINK_HCI = 1001; // Unencapsulated HCI: the packet type is implied by the flags
+const BTSNOOP_DATALINK_H4 = 1002; // HCI UART (H4): the packet type octet is part of the record
+
+const BTSNOOP_HEADER_LENGTH = 16;
+const BTSNOOP_RECORD_HEADER_LENGTH = 24;
+
+const BTSNOOP_FLAG_RECEIVED = 0x01;
+const BTSNOOP_FLAG_COMMAND_EVENT = 0x02;
+
+// Microseconds between 0000-01-01 and the unix epoch
+const BTSNOOP_EPOCH_DELTA = 0x00dcddb30f2f8000n;
+
+const HCI_COMMAND_PKT = 0x01;
+const HCI_ACLDATA_PKT = 0x02;
+const HCI_EVENT_PKT = 0x04;
+
+const FLUSH_THRESHOLD = 64 * 1024;
+const FLUSH_INTERVAL = 1000;
+
+const Btsnoop = function (path, maxSize) {
+  this._path = path;
+  this._maxSize = maxSize > 0 ? maxSize : 0;
+
+  this._records = [];
+  this._recordsStart = 0;
+  this._recordsLength = 0;
+  this._fd = null;
+  this._flushTimer = null;
+};
+
+Btsnoop.header = function () {
+  const header = Buffer.alloc(BTSNOOP_HEADER_LENGTH);
+
+  BTSNOOP_MAGIC.copy(header, 0);
+  header.writeUInt32BE(BTSNOOP_VERSION, 8);
+  header.writeUInt32BE(BTSNOOP_DATALINK_H4, 12);
+
+  return header;
+};
+
+// Parses a btsnoop capture into { received, timestamp, packet } records, where timestamp is in
+// microseconds since the unix epoch and packet always starts with the H4 packet type octet.
+Btsnoop.parse = function (data) {
+  if (data.length < BTSNOOP_HEADER_LENGTH || !data.slice(0, 8).equals(BTSNOOP_MAGIC)) {
+    throw new Error('Not a btsnoop capture');
+  }
+
+  const datalink = data.readUInt32BE(12);
+  if (datalink !== BTSNOOP_DATALINK_H4 && datalink !== BTSNOOP_DATALINK_HCI) {
+    throw new Error(`Unsupported btsnoop datalink: ${datalink}`);
+  }
+
+  const records = [];
+  let offset = BTSNOOP_HEADER_LENGTH;
+
+  while (offset + BTSNOOP_RECORD_HEADER_LENGTH <= data.length) {
+    const includedLength = data.readUInt32BE(offset + 4);
+    const flags = data.readUInt32BE(offset + 8);
+    const timestamp = Number(data.readBigUInt64BE(offset + 16) - BTSNOOP_EPOCH_DELTA);
+    const start = offset + BTSNOOP_RECORD_HEADER_LENGTH;
+
+    if (start + includedLength > data.length) {
+      debug(`capture truncated after ${records.length} records`);
+      break;
+    }
+
+    const received = (flags & BTSNOOP_FLAG_RECEIVED) !== 0;
+    let packet = data.slice(start, start + includedLength);
+
+    if (datalink === BTSNOOP_DATALINK_HCI) {
+      const type = flags & BTSNOOP_FLAG_COMMAND_EVENT
+        ? (received ? HCI_EVENT_PKT : HCI_COMMAND_PKT)
+        : HCI_ACLDATA_PKT;
+      packet = Buffer.concat([Buffer.from([type]), packet]);
+    }
+
+    records.push({ received, timestamp, packet });
+    offset = start + includedLength;
+  }
+
+  return records;
+};
+
+Btsnoop.prototype.open = function () {
+  if (this._fd !== null) {
+    return;
+  }
+
+  this._fd = fs.openSync(this._path, 'w');
+  fs.writeSync(this._fd, Btsnoop.header());
+
+  // The ring buffer only reaches the disk on flush/close, so it needs no timer.
+  if (!this._maxSize) {
+    this._flushTimer = setInterval(() => this.flush(), FLUSH_INTERVAL);
+    this._flushTimer.unref();
+  }
+
+  debug(`capturing to ${this._path}${this._maxSize ? ` (last ${this._maxSize} bytes)` : ''}`);
+};
+
+Btsnoop.prototype.write = function (packet, received) {
+  if (this._fd === null) {
+    return;
+  }
+
+  const type = packet[0];
+  const record = Buffer.allocUnsafe(BTSNOOP_RECORD_HEADER_LENGTH + packet.length);
+  let flags = received ? BTSNOOP_FLAG_RECEIVED : 0;
+
+  if (type === HCI_COMMAND_PKT || type === HCI_EVENT_PKT) {
+    flags |= BTSNOOP_FLAG_COMMAND_EVENT;
+  }
+
+  record.writeUInt32BE(packet.length, 0); // original length
+  record.writeUInt32BE(packet.length, 4); // included length
+  record.writeUInt32BE(flags, 8);
+  record.writeUInt32BE(0, 12); // cumulative drops
+  record.writeBigUInt64BE(BigInt(Date.now()) * 1000n + BTSNOOP_EPOCH_DELTA, 16);
+  packet.copy(record, BTSNOOP_RECORD_HEADER_LENGTH);
+
+  this._records.push(record);
+  this._recordsLength += record.length;
+
+  if (this._maxSize) {
+    // Drop the oldest records until the ring fits again; the record just written always stays.
+    while (this._recordsLength > this._maxSize && this._records.length - this._recordsStart > 1) {
+      this._recordsLength -= this._records[this._recordsStart].length;
+      this._records[this._recordsStart++] = undefined;
+    }
+    // Compact lazily so dropping stays O(1) per record.
+    if (this._recordsStart > 1024 && this._recordsStart * 2 > this._records.length) {
+      this._records = this._records.slice(this._recordsStart);
+      this._recordsStart = 0;
+    }
+  } else if (this._recordsLength >= FLUSH_THRESHOLD) {
+    this.flush();
+  }
+};
+
+Btsnoop.prototype.flush = function () {
+  if (this._fd === null) {
+    return;
+  }
+
+  if (this._maxSize) {
+    // Rewrite the whole file so it always holds exactly the current ring.
+    fs.ftruncateSync(this._fd, BTSNOOP_HEADER_LENGTH);
+    const ring = Buffer.concat(this._records.slice(this._recordsStart), this._recordsLength);
+    fs.writeSync(this._fd, ring, 0, ring.length, BTSNOOP_HEADER_LENGTH);
+    return;
+  }
+
+  if (this._recordsLength === 0) {
+    return;
+  }
+
+  fs.writeSync(this._fd, Buffer.concat(this._records, this._recordsLength));
+  this._records = [];
+  this._recordsLength = 0;
+};
+
+Btsnoop.prototype.close = function () {
+  if (this._fd === null) {
+    return;
+  }
+
+  if (this._flushTimer !== null) {
+    clearInterval(this._flushTimer);
+    this._flushTimer = null;
+  }
+
+  try {
+    this.flush();
+  } catch (error) {
+    debug(`flush failed: ${error.message}`);
+  }
+
+  fs.closeSync(this._fd);
+  this._fd = null;
+  this._records = [];
+  this._recordsStart = 0;
+  this._recordsLength = 0;
+};
+
+module.exports = Btsnoop;
@@ -0,0 +1,103 @@
+const debug = require('debug')('hci-capability-cache');
+
+const crypto = require('crypto');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const CACHE_FORMAT = 1;
+
+// Per user rather than in the shared temp directory, so no other account can plant entries.
+const defaultFile = () => path.join(process.env.XDG_CACHE_HOME || path.join(os.homedir(), '.cache'), 'noble', 'hci-capabilities.json');
+
+const isObject = (value) => value !== null && typeof value === 'object';
+const isCount = (value) => Number.isInteger(value) && value > 0 && value <= 0xffff;
+const own = (object, key) => Object.prototype.hasOwnProperty.call(object, key) ? object[key] : undefined;
+
+// Fast start hands these straight to the controller state, so a file that does not hold
+// what fastStart wrote is not trusted.
+const isValidEntry = function (key, entry) {
+  return isObject(entry) &&
+    entry.key === key &&
+    typeof entry.leFeatures === 'string' && /^[0-9a-f]{16}$/.test(entry.leFeatures) &&
+    isObject(entry.aclBuffers) && isCount(entry.aclBuffers.length) && isCount(entry.aclBuffers.num) &&
+    (entry.maxDataLength === null ||
+      (isObject(entry.maxDataLength) && isCount(entry.maxDataLength.txOctets) && isCount(entry.maxDataLength.txTime))) &&
+    typeof entry.clean === 'boolean';
+};
+
+/**
+ * Controller capabilities remembered across runs, so a restart can skip the reads that only
+ * depend on the controller. Entries are keyed by BD_ADDR and the Read Local Version return
+ * parameters, so replacing the adapter or updating its firmware never reuses stale values.
+ * Every device id also remembers the entry it used last, which is the one a restart expects.
+ */
+const CapabilityCache = function (file) {
+  this._file = file || defaultFile();
+  this._data = null;
+};
+
+CapabilityCache.key = function (address, localVersion) {
+  return `${address}/${localVersion.toString('hex')}`;
+};
+
+CapabilityCache.prototype.load = function () {
+  if (this._data !== null) {
+    return this._data;
+  }
+
+  this._data = { format: CACHE_FORMAT, entries: {}, devices: {} };
+  try {
+    const data = JSON.parse(fs.readFileSync(this._file, 'utf8'));
+    if (isObject(data) && data.format === CACHE_FORMAT && isObject(data.entries) && isObject(data.devices)) {
+      for (const key of Object.keys(data.entries)) {
+        if (!isValidEntry(key, data.entries[key])) {
+          debug(`ignoring malformed entry ${key} in ${this._file}`);
+          delete data.entries[key];
+        }
+      }
+      this._data = data;
+    }
+  } catch (error) {
+    if (error.code !== 'ENOENT') {
+      debug(`ignoring unreadable cache ${this._file}: ${error.message}`);
+    }
+  }
+  return this._data;
+};
+
+// The entry this device used last, or null.
+CapabilityCache.prototype.expected = function (deviceId) {
+  const data = this.load();
+  const key = own(data.devices, deviceId);
+  return (typeof key === 'string' && own(data.entries, key)) || null;
+};
+
+CapabilityCache.prototype.get = function (key) {
+  return own(this.load().entries, key) || null;
+};
+
+CapabilityCache.prototype.set = function (deviceId, entry) {
+  const data = this.load();
+  data.entries[entry.key] = entry;
+  data.devices[deviceId] = entry.key;
+  this.save();
+};
+
+// Written to a temporary file first, so a crash never leaves half a cache behind. The
+// temporary file has an unguessable name and is created exclusively, never through a link.
+CapabilityCache.prototype.save = function () {
+  const temporary = `${this._file}.${process.pid}.${crypto.randomBytes(6).toString('hex')}.tmp`;
+  try {
+    fs.mkdirSync(path.dirname(this._file), { recursive: true, mode: 0o700 });
+    fs.writeFileSync(temporary, JSON.stringify(this._data), { flag: 'wx', mode: 0o600 });
+    fs.renameSync(temporary, this._file);
+  } catch (error) {
+    debug(`could not write ${this._file}: ${error.message}`);
+    try {
+      fs.unlinkSync(temporary);
+    } catch (ignored) {}
+  }
+};
+
+module.exports = CapabilityCache;
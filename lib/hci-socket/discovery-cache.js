@@ -0,0 +1,76 @@
+const DEFAULT_MAX_SIZE = 4096;
+const DEFAULT_TTL = 5 * 60 * 1000; // ms
+
+const REASON_SIZE = 'size';
+const REASON_TTL = 'ttl';
+
+/**
+ * Gap's table of devices seen while scanning, bounded in entries and in idle time.
+ * Entries are kept in a Map in the order they were last seen, so the least recently
+ * seen one is always first: it is the one evicted when the table is full, and the
+ * only one to look at when checking for idle entries.
+ */
+const DiscoveryCache = function (options = {}, onEvict = null) {
+  this.maxSize = options.maxSize > 0 ? options.maxSize : DEFAULT_MAX_SIZE;
+  this.ttl = options.ttl > 0 ? options.ttl : DEFAULT_TTL;
+  this._now = options.now || Date.now;
+  this._onEvict = onEvict;
+  this._entries = new Map(); // key -> { value, lastSeen }
+  this.evictions = 0;
+  this.expirations = 0;
+};
+
+DiscoveryCache.REASON_SIZE = REASON_SIZE;
+DiscoveryCache.REASON_TTL = REASON_TTL;
+
+Object.defineProperty(DiscoveryCache.prototype, 'size', {
+  get () {
+    return this._entries.size;
+  }
+});
+
+// Entries idle for longer than the ttl are dropped here, before they can be merged into.
+DiscoveryCache.prototype.get = function (key) {
+  this.expire();
+
+  const entry = this._entries.get(key);
+  return entry !== undefined ? entry.value : undefined;
+};
+
+DiscoveryCache.prototype.set = function (key, value) {
+  // Deleting first moves the key to the end of the Map's order
+  this._entries.delete(key);
+  this._entries.set(key, { value, lastSeen: this._now() });
+
+  while (this._entries.size > this.maxSize) {
+    this.evictions++;
+    this._evictFirst(REASON_SIZE);
+  }
+  return this;
+};
+
+DiscoveryCache.prototype.expire = function () {
+  if (this._entries.size === 0 || this.ttl === Infinity) {
+    return;
+  }
+
+  const before = this._now() - this.ttl;
+  for (const entry of this._entries.values()) {
+    if (entry.lastSeen >= before) {
+      break;
+    }
+    this.expirations++;
+    this._evictFirst(REASON_TTL);
+  }
+};
+
+DiscoveryCache.prototype._evictFirst = function (reason) {
+  const [key, entry] = this._entries.entries().next().value;
+  this._entries.delete(key);
+
+  if (this._onEvict !== null) {
+    this._onEvict(key, entry.value, reason);
+  }
+};
+
+module.exports = DiscoveryCache;
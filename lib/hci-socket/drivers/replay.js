@@ -0,0 +1,227 @@
+const debug = require('debug')('hci-replay');
+
+const { EventEmitter } = require('events');
+const fs = require('fs');
+
+const Btsnoop = require('../btsnoop');
+
+// How long playback waits for the host to write a recorded packet before giving up on it.
+const DEFAULT_STALL_TIMEOUT = 1000;
+// Host writes that never match a recorded packet are only kept this long.
+const MAX_PENDING_WRITES = 32;
+
+/**
+ * HCI socket driver that plays a btsnoop capture back into Hci.
+ *
+ * Packets the controller sent are emitted as 'data' in recorded order, either
+ * paced like the original capture or as fast as the event loop allows. Packets
+ * the host sent are treated as expectations: playback holds at each one until
+ * Hci writes a matching packet (or the stall timeout passes), which keeps
+ * replies causally behind the commands that caused them. Every deviation is
+ * counted in `stats` and reported as a 'mismatch' event.
+ *
+ * Selected with `hciDriver: 'replay'` and configured through
+ * `bindParams: { replay: { path, timing, speed, stallTimeout } }`.
+ */
+const ReplaySocket = function () {
+  this._records = [];
+  this._position = 0;
+  this._pendingWrites = [];
+
+  this._timing = 'fast';
+  this._speed = 1;
+  this._stallTimeout = DEFAULT_STALL_TIMEOUT;
+
+  this._isStarted = false;
+  this._timer = null;
+  this._timerIsImmediate = false;
+  this._waitingForWrite = false;
+  this._isDue = false;
+  this._lastTimestamp = null;
+
+  this.stats = {
+    received: 0,
+    matched: 0,
+    missed: 0,
+    unexpected: 0
+  };
+};
+
+Object.setPrototypeOf(ReplaySocket.prototype, EventEmitter.prototype);
+
+ReplaySocket.prototype.load = function (params) {
+  const replay = (params && params.replay) || {};
+
+  let records = replay.records;
+  if (!records) {
+    const data = replay.data || (replay.path && fs.readFileSync(replay.path));
+    if (!data) {
+      throw new Error('The replay driver needs bindParams.replay.path');
+    }
+    records = Btsnoop.parse(data);
+  }
+
+  this._records = records;
+  this._timing = replay.timing === 'original' ? 'original' : 'fast';
+  this._speed = replay.speed > 0 ? replay.speed : 1;
+  this._stallTimeout = replay.stallTimeout != null ? replay.stallTimeout : DEFAULT_STALL_TIMEOUT;
+
+  debug(`loaded ${records.length} records, timing = ${this._timing}`);
+};
+
+ReplaySocket.prototype.bindRaw = function (deviceId, params) {
+  this.load(params);
+};
+
+ReplaySocket.prototype.bindUser = function (deviceId, params) {
+  this.load(params);
+};
+
+ReplaySocket.prototype.start = function () {
+  if (this._isStarted) {
+    return;
+  }
+
+  this._isStarted = true;
+  this._schedule(0);
+};
+
+ReplaySocket.prototype.stop = function () {
+  this._isStarted = false;
+  this._waitingForWrite = false;
+  this._clearTimer();
+};
+
+ReplaySocket.prototype.isDevUp = function () {
+  return true;
+};
+
+ReplaySocket.prototype.setFilter = function (filter) {
+  // Recorded traffic has already been filtered by the capturing host.
+};
+
+ReplaySocket.prototype.isFinished = function () {
+  return this._position >= this._records.length;
+};
+
+ReplaySocket.prototype.write = function (data) {
+  if (this.isFinished()) {
+    this._unexpected(data);
+    return;
+  }
+
+  this._pendingWrites.push(data);
+  if (this._pendingWrites.length > MAX_PENDING_WRITES) {
+    this._unexpected(this._pendingWrites.shift());
+  }
+
+  if (this._waitingForWrite) {
+    this._waitingForWrite = false;
+    this._schedule(0);
+  }
+};
+
+ReplaySocket.prototype._clearTimer = function () {
+  if (this._timer !== null) {
+    if (this._timerIsImmediate) {
+      clearImmediate(this._timer);
+    } else {
+      clearTimeout(this._timer);
+    }
+    this._timer = null;
+  }
+};
+
+ReplaySocket.prototype._schedule = function (delay) {
+  this._clearTimer();
+
+  // Always yield, so Hci can react to one packet before it sees the next.
+  this._timerIsImmediate = delay <= 0;
+  this._timer = this._timerIsImmediate
+    ? setImmediate(() => this._step())
+    : setTimeout(() => this._step(), delay);
+};
+
+ReplaySocket.prototype._step = function () {
+  this._timer = null;
+
+  while (this._isStarted && !this.isFinished()) {
+    const record = this._records[this._position];
+
+    if (record.received) {
+      const delay = this._delayFor(record);
+      if (delay > 0 && !this._isDue) {
+        this._isDue = true;
+        this._schedule(delay);
+        return;
+      }
+
+      this._isDue = false;
+      this._position++;
+      this._lastTimestamp = record.timestamp;
+      this.stats.received++;
+      this.emit('data', record.packet);
+
+      // Let the host process the packet before the next one.
+      this._schedule(0);
+      return;
+    }
+
+    const index = this._pendingWrites.findIndex((data) => data.equals(record.packet));
+    if (index === -1) {
+      if (this._waitingForWrite) {
+        // The stall timeout fired: the host never wrote this packet.
+        this._waitingForWrite = false;
+        this._missed(record.packet);
+        this._position++;
+        continue;
+      }
+
+      this._waitingForWrite = true;
+      this._timerIsImmediate = false;
+      this._timer = setTimeout(() => this._step(), this._stallTimeout);
+      return;
+    }
+
+    // Writes queued ahead of the match were never recorded at this point.
+    for (const data of this._pendingWrites.splice(0, index + 1).slice(0, index)) {
+      this._unexpected(data);
+    }
+    this._waitingForWrite = false;
+    this.stats.matched++;
+    this._position++;
+  }
+
+  if (this._isStarted && this.isFinished()) {
+    for (const data of this._pendingWrites.splice(0)) {
+      this._unexpected(data);
+    }
+    debug(`replay finished: ${JSON.stringify(this.stats)}`);
+    this.emit('end', this.stats);
+  }
+};
+
+ReplaySocket.prototype._delayFor = function (record) {
+  if (this._timing !== 'original' || this._lastTimestamp === null) {
+    return 0;
+  }
+  return (record.timestamp - this._lastTimestamp) / 1000 / this._speed;
+};
+
+ReplaySocket.prototype._missed = function (expected) {
+  this.stats.missed++;
+  if (debug.enabled) {
+    debug(`missed write: ${expected.toString('hex')}`);
+  }
+  this.emit('mismatch', expected, null);
+};
+
+ReplaySocket.prototype._unexpected = function (actual) {
+  this.stats.unexpected++;
+  if (debug.enabled) {
+    debug(`unexpected write: ${actual.toString('hex')}`);
+  }
+  this.emit('mismatch', null, actual);
+};
+
+module.exports = ReplaySocket;
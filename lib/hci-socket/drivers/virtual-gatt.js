@@ -0,0 +1,374 @@
+const ATT_OP_ERROR = 0x01;
+const ATT_OP_MTU_REQ = 0x02;
+const ATT_OP_MTU_RESP = 0x03;
+const ATT_OP_FIND_INFO_REQ = 0x04;
+const ATT_OP_FIND_INFO_RESP = 0x05;
+const ATT_OP_READ_BY_TYPE_REQ = 0x08;
+const ATT_OP_READ_BY_TYPE_RESP = 0x09;
+const ATT_OP_READ_REQ = 0x0a;
+const ATT_OP_READ_RESP = 0x0b;
+const ATT_OP_READ_BLOB_REQ = 0x0c;
+const ATT_OP_READ_BLOB_RESP = 0x0d;
+const ATT_OP_READ_BY_GROUP_REQ = 0x10;
+const ATT_OP_READ_BY_GROUP_RESP = 0x11;
+const ATT_OP_WRITE_REQ = 0x12;
+const ATT_OP_WRITE_RESP = 0x13;
+const ATT_OP_PREPARE_WRITE_REQ = 0x16;
+const ATT_OP_PREPARE_WRITE_RESP = 0x17;
+const ATT_OP_EXECUTE_WRITE_REQ = 0x18;
+const ATT_OP_EXECUTE_WRITE_RESP = 0x19;
+const ATT_OP_HANDLE_NOTIFY = 0x1b;
+const ATT_OP_HANDLE_IND = 0x1d;
+const ATT_OP_HANDLE_CNF = 0x1e;
+const ATT_OP_WRITE_CMD = 0x52;
+
+const ATT_ECODE_INVALID_HANDLE = 0x01;
+const ATT_ECODE_READ_NOT_PERM = 0x02;
+const ATT_ECODE_WRITE_NOT_PERM = 0x03;
+const ATT_ECODE_REQ_NOT_SUPP = 0x06;
+const ATT_ECODE_INVALID_OFFSET = 0x07;
+const ATT_ECODE_ATTR_NOT_FOUND = 0x0a;
+const ATT_ECODE_UNSUPP_GRP_TYPE = 0x10;
+
+const GATT_PRIM_SVC_UUID = '2800';
+const GATT_INCLUDE_UUID = '2802';
+const GATT_CHARAC_UUID = '2803';
+const GATT_CLIENT_CHARAC_CFG_UUID = '2902';
+
+const PROPERTIES = {
+  broadcast: 0x01,
+  read: 0x02,
+  writeWithoutResponse: 0x04,
+  write: 0x08,
+  notify: 0x10,
+  indicate: 0x20
+};
+
+const uuidToBuffer = function (uuid) {
+  return Buffer.from(uuid.replace(/-/g, ''), 'hex').reverse();
+};
+
+const uuidFromBuffer = function (buffer) {
+  return Buffer.from(buffer).reverse().toString('hex');
+};
+
+/**
+ * ATT server for one virtual peripheral. Services are described as
+ *
+ *   [{ uuid, characteristics: [{ uuid, properties, value, descriptors: [{ uuid, value }] }] }]
+ *
+ * where properties are noble's names ('read', 'write', 'notify', ...) and a
+ * value may be a Buffer or a function returning one, so notifications can
+ * carry fresh data. An optional onWrite(data, withoutResponse) is called for
+ * every write. Handles are assigned in declaration order from 0x0001.
+ */
+const VirtualGatt = function (services, mtu) {
+  this._mtu = 23;
+  this._serverMtu = mtu || 247;
+  this._attributes = [];
+  this._preparedWrites = [];
+
+  this._build(services || []);
+};
+
+VirtualGatt.prototype._add = function (attribute) {
+  attribute.handle = this._attributes.length + 1;
+  this._attributes.push(attribute);
+  return attribute;
+};
+
+VirtualGatt.prototype._build = function (services) {
+  for (const service of services) {
+    const declaration = this._add({ type: GATT_PRIM_SVC_UUID, value: uuidToBuffer(service.uuid) });
+
+    for (const characteristic of service.characteristics || []) {
+      const properties = (characteristic.properties || ['read'])
+        .reduce((mask, name) => mask | (PROPERTIES[name] || 0), 0);
+      const characteristicDeclaration = this._add({ type: GATT_CHARAC_UUID, properties });
+      const value = this._add({
+        type: characteristic.uuid,
+        uuid: characteristic.uuid,
+        properties,
+        value: characteristic.value || Buffer.alloc(0),
+        onWrite: characteristic.onWrite
+      });
+
+      characteristicDeclaration.value = Buffer.concat([
+        Buffer.from([properties, value.handle & 0xff, value.handle >> 8]),
+        uuidToBuffer(characteristic.uuid)
+      ]);
+
+      if (properties & (PROPERTIES.notify | PROPERTIES.indicate)) {
+        value.cccd = this._add({ type: GATT_CLIENT_CHARAC_CFG_UUID, value: Buffer.from([0x00, 0x00]), writable: true });
+      }
+
+      for (const descriptor of characteristic.descriptors || []) {
+        this._add({ type: descriptor.uuid, value: descriptor.value || Buffer.alloc(0), writable: true });
+      }
+    }
+
+    declaration.endHandle = this._attributes.length;
+  }
+};
+
+VirtualGatt.prototype.attribute = function (handle) {
+  return this._attributes[handle - 1];
+};
+
+VirtualGatt.prototype.characteristic = function (uuid) {
+  return this._attributes.find((attribute) => attribute.uuid === uuid);
+};
+
+// Value handles of characteristics the client enabled notifications or indications for.
+VirtualGatt.prototype.subscriptions = function () {
+  return this._attributes.filter((attribute) => attribute.cccd && attribute.cccd.value.readUInt16LE(0) !== 0);
+};
+
+VirtualGatt.prototype.notification = function (valueHandle, data) {
+  const attribute = this.attribute(valueHandle);
+  const indicate = attribute.cccd && (attribute.cccd.value[0] & 0x02) !== 0;
+  const value = data || this._read(attribute);
+  const pdu = Buffer.alloc(3 + Math.min(value.length, this._mtu - 3));
+
+  pdu.writeUInt8(indicate ? ATT_OP_HANDLE_IND : ATT_OP_HANDLE_NOTIFY, 0);
+  pdu.writeUInt16LE(valueHandle, 1);
+  value.copy(pdu, 3);
+
+  return pdu;
+};
+
+VirtualGatt.prototype._read = function (attribute) {
+  return typeof attribute.value === 'function' ? attribute.value() : attribute.value;
+};
+
+VirtualGatt.prototype._error = function (opcode, handle, code) {
+  const pdu = Buffer.alloc(5);
+
+  pdu.writeUInt8(ATT_OP_ERROR, 0);
+  pdu.writeUInt8(opcode, 1);
+  pdu.writeUInt16LE(handle, 2);
+  pdu.writeUInt8(code, 4);
+
+  return pdu;
+};
+
+// Returns the response PDU for a request, or null for PDUs that take no response.
+VirtualGatt.prototype.handleRequest = function (request) {
+  const opcode = request[0];
+
+  switch (opcode) {
+    case ATT_OP_MTU_REQ: {
+      this._mtu = Math.max(23, Math.min(request.readUInt16LE(1), this._serverMtu));
+      const response = Buffer.alloc(3);
+      response.writeUInt8(ATT_OP_MTU_RESP, 0);
+      response.writeUInt16LE(this._serverMtu, 1);
+      return response;
+    }
+    case ATT_OP_READ_BY_GROUP_REQ:
+      return this._readByGroup(request);
+    case ATT_OP_READ_BY_TYPE_REQ:
+      return this._readByType(request);
+    case ATT_OP_FIND_INFO_REQ:
+      return this._findInfo(request);
+    case ATT_OP_READ_REQ:
+    case ATT_OP_READ_BLOB_REQ:
+      return this._readValue(request);
+    case ATT_OP_WRITE_REQ:
+    case ATT_OP_WRITE_CMD:
+      return this._write(request);
+    case ATT_OP_PREPARE_WRITE_REQ:
+      return this._prepareWrite(request);
+    case ATT_OP_EXECUTE_WRITE_REQ:
+      return this._executeWrite(request);
+    case ATT_OP_HANDLE_CNF:
+    case ATT_OP_MTU_RESP:
+      return null;
+    default:
+      // Commands (bit 6 set) never get a response, not even an error.
+      return opcode & 0x40 ? null : this._error(opcode, 0x0000, ATT_ECODE_REQ_NOT_SUPP);
+  }
+};
+
+VirtualGatt.prototype._range = function (request) {
+  return {
+    start: request.readUInt16LE(1),
+    end: Math.min(request.readUInt16LE(3), this._attributes.length)
+  };
+};
+
+VirtualGatt.prototype._readByGroup = function (request) {
+  const { start, end } = this._range(request);
+  const type = uuidFromBuffer(request.slice(5));
+
+  if (type !== GATT_PRIM_SVC_UUID) {
+    return this._error(request[0], start, ATT_ECODE_UNSUPP_GRP_TYPE);
+  }
+
+  const entries = [];
+  let entryLength = 0;
+
+  for (let handle = start; handle <= end; handle++) {
+    const attribute = this.attribute(handle);
+    if (attribute.type !== GATT_PRIM_SVC_UUID) {
+      continue;
+    }
+
+    const length = 4 + attribute.value.length;
+    if (entryLength && (length !== entryLength || 2 + (entries.length + 1) * length > this._mtu)) {
+      break;
+    }
+
+    entryLength = length;
+    const entry = Buffer.alloc(length);
+    entry.writeUInt16LE(attribute.handle, 0);
+    entry.writeUInt16LE(attribute.endHandle, 2);
+    attribute.value.copy(entry, 4);
+    entries.push(entry);
+  }
+
+  if (!entries.length) {
+    return this._error(request[0], start, ATT_ECODE_ATTR_NOT_FOUND);
+  }
+
+  return Buffer.concat([Buffer.from([ATT_OP_READ_BY_GROUP_RESP, entryLength]), ...entries]);
+};
+
+VirtualGatt.prototype._readByType = function (request) {
+  const { start, end } = this._range(request);
+  const type = uuidFromBuffer(request.slice(5));
+  const entries = [];
+  let entryLength = 0;
+
+  if (type === GATT_INCLUDE_UUID) {
+    return this._error(request[0], start, ATT_ECODE_ATTR_NOT_FOUND);
+  }
+
+  for (let handle = start; handle <= end; handle++) {
+    const attribute = this.attribute(handle);
+    if (attribute.type !== type) {
+      continue;
+    }
+
+    const value = this._read(attribute);
+    const length = 2 + Math.min(value.length, this._mtu - 4);
+    if (entryLength && (length !== entryLength || 2 + (entries.length + 1) * length > this._mtu)) {
+      break;
+    }
+
+    entryLength = length;
+    const entry = Buffer.alloc(length);
+    entry.writeUInt16LE(attribute.handle, 0);
+    value.copy(entry, 2);
+    entries.push(entry);
+  }
+
+  if (!entries.length) {
+    return this._error(request[0], start, ATT_ECODE_ATTR_NOT_FOUND);
+  }
+
+  return Buffer.concat([Buffer.from([ATT_OP_READ_BY_TYPE_RESP, entryLength]), ...entries]);
+};
+
+VirtualGatt.prototype._findInfo = function (request) {
+  const { start, end } = this._range(request);
+  const entries = [];
+  let format = 0;
+
+  for (let handle = start; handle <= end; handle++) {
+    const uuid = uuidToBuffer(this.attribute(handle).type);
+    const entryFormat = uuid.length === 2 ? 0x01 : 0x02;
+
+    if (format && (entryFormat !== format || 2 + (entries.length + 1) * (2 + uuid.length) > this._mtu)) {
+      break;
+    }
+
+    format = entryFormat;
+    const entry = Buffer.alloc(2 + uuid.length);
+    entry.writeUInt16LE(handle, 0);
+    uuid.copy(entry, 2);
+    entries.push(entry);
+  }
+
+  if (!entries.length) {
+    return this._error(request[0], start, ATT_ECODE_ATTR_NOT_FOUND);
+  }
+
+  return Buffer.concat([Buffer.from([ATT_OP_FIND_INFO_RESP, format]), ...entries]);
+};
+
+VirtualGatt.prototype._readValue = function (request) {
+  const handle = request.readUInt16LE(1);
+  const offset = request[0] === ATT_OP_READ_BLOB_REQ ? request.readUInt16LE(3) : 0;
+  const attribute = this.attribute(handle);
+
+  if (!attribute) {
+    return this._error(request[0], handle, ATT_ECODE_INVALID_HANDLE);
+  }
+  if (attribute.properties !== undefined && !(attribute.properties & PROPERTIES.read)) {
+    return this._error(request[0], handle, ATT_ECODE_READ_NOT_PERM);
+  }
+
+  const value = this._read(attribute);
+  if (offset > value.length) {
+    return this._error(request[0], handle, ATT_ECODE_INVALID_OFFSET);
+  }
+
+  const opcode = request[0] === ATT_OP_READ_BLOB_REQ ? ATT_OP_READ_BLOB_RESP : ATT_OP_READ_RESP;
+  return Buffer.concat([Buffer.from([opcode]), value.slice(offset, offset + this._mtu - 1)]);
+};
+
+VirtualGatt.prototype._canWrite = function (attribute) {
+  return attribute.writable ||
+    (attribute.properties & (PROPERTIES.write | PROPERTIES.writeWithoutResponse)) !== 0;
+};
+
+VirtualGatt.prototype._write = function (request) {
+  const withoutResponse = request[0] === ATT_OP_WRITE_CMD;
+  const handle = request.readUInt16LE(1);
+  const attribute = this.attribute(handle);
+
+  if (!attribute || !this._canWrite(attribute)) {
+    if (withoutResponse) {
+      return null;
+    }
+    return this._error(request[0], handle, attribute ? ATT_ECODE_WRITE_NOT_PERM : ATT_ECODE_INVALID_HANDLE);
+  }
+
+  attribute.value = Buffer.from(request.slice(3));
+  if (attribute.onWrite) {
+    attribute.onWrite(attribute.value, withoutResponse);
+  }
+
+  return withoutResponse ? null : Buffer.from([ATT_OP_WRITE_RESP]);
+};
+
+VirtualGatt.prototype._prepareWrite = function (request) {
+  const handle = request.readUInt16LE(1);
+  const attribute = this.attribute(handle);
+
+  if (!attribute || !this._canWrite(attribute)) {
+    return this._error(request[0], handle, attribute ? ATT_ECODE_WRITE_NOT_PERM : ATT_ECODE_INVALID_HANDLE);
+  }
+
+  this._preparedWrites.push({ attribute, offset: request.readUInt16LE(3), data: Buffer.from(request.slice(5)) });
+
+  const response = Buffer.from(request);
+  response[0] = ATT_OP_PREPARE_WRITE_RESP;
+  return response;
+};
+
+VirtualGatt.prototype._executeWrite = function (request) {
+  if (request[1] === 0x01) {
+    for (const { attribute, offset, data } of this._preparedWrites) {
+      const value = Buffer.alloc(Math.max(this._read(attribute).length, offset + data.length));
+      this._read(attribute).copy(value);
+      data.copy(value, offset);
+      attribute.value = value;
+    }
+  }
+  this._preparedWrites = [];
+
+  return Buffer.from([ATT_OP_EXECUTE_WRITE_RESP]);
+};
+
+module.exports = VirtualGatt;
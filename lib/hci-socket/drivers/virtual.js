@@ -0,0 +1,1075 @@
+const debug = require('debug')('hci-virtual');
+
+const { EventEmitter } = require('events');
+
+const VirtualGatt = require('./virtual-gatt');
+
+const HCI_COMMAND_PKT = 0x01;
+const HCI_ACLDATA_PKT = 0x02;
+const HCI_EVENT_PKT = 0x04;
+
+const ACL_START_NO_FLUSH = 0x00;
+const ACL_CONT = 0x01;
+const ACL_START = 0x02;
+
+const EVT_DISCONN_COMPLETE = 0x05;
+const EVT_ENCRYPT_CHANGE = 0x08;
+const EVT_CMD_COMPLETE = 0x0e;
+const EVT_CMD_STATUS = 0x0f;
+const EVT_NUMBER_OF_COMPLETED_PACKETS = 0x13;
+const EVT_LE_META_EVENT = 0x3e;
+
+const EVT_LE_CONN_COMPLETE = 0x01;
+const EVT_LE_ADVERTISING_REPORT = 0x02;
+const EVT_LE_CONN_UPDATE_COMPLETE = 0x03;
+const EVT_LE_ENHANCED_CONN_COMPLETE = 0x0a;
+const EVT_LE_EXTENDED_ADVERTISING_REPORT = 0x0d;
+const EVT_LE_PERIODIC_SYNC_ESTABLISHED = 0x0e;
+const EVT_LE_PERIODIC_ADVERTISING_REPORT = 0x0f;
+const EVT_LE_PERIODIC_SYNC_LOST = 0x10;
+
+const DISCONNECT_CMD = 0x0406;
+const SET_EVENT_MASK_CMD = 0x0c01;
+const RESET_CMD = 0x0c03;
+const READ_LE_HOST_SUPPORTED_CMD = 0x0c6c;
+const WRITE_LE_HOST_SUPPORTED_CMD = 0x0c6d;
+const READ_LOCAL_VERSION_CMD = 0x1001;
+const READ_SUPPORTED_COMMANDS_CMD = 0x1002;
+const READ_BUFFER_SIZE_CMD = 0x1005;
+const READ_BD_ADDR_CMD = 0x1009;
+const READ_RSSI_CMD = 0x1405;
+const LE_SET_EVENT_MASK_CMD = 0x2001;
+const LE_READ_BUFFER_SIZE_CMD = 0x2002;
+const LE_READ_LOCAL_SUPPORTED_FEATURES = 0x2003;
+const LE_SET_SCAN_PARAMETERS_CMD = 0x200b;
+const LE_SET_SCAN_ENABLE_CMD = 0x200c;
+const LE_CREATE_CONN_CMD = 0x200d;
+const LE_CANCEL_CONN_CMD = 0x200e;
+const LE_READ_FILTER_ACCEPT_LIST_SIZE_CMD = 0x200f;
+const LE_CLEAR_FILTER_ACCEPT_LIST_CMD = 0x2010;
+const LE_ADD_DEVICE_TO_FILTER_ACCEPT_LIST_CMD = 0x2011;
+const LE_REMOVE_DEVICE_FROM_FILTER_ACCEPT_LIST_CMD = 0x2012;
+const LE_CONN_UPDATE_CMD = 0x2013;
+const LE_START_ENCRYPTION_CMD = 0x2019;
+const LE_SET_DATA_LENGTH_CMD = 0x2022;
+const LE_READ_MAX_DATA_LENGTH_CMD = 0x202f;
+const LE_SET_DEFAULT_PHY_CMD = 0x2031;
+const LE_SET_EXTENDED_SCAN_PARAMETERS_CMD = 0x2041;
+const LE_SET_EXTENDED_SCAN_ENABLE_CMD = 0x2042;
+const LE_CREATE_EXTENDED_CONN_CMD = 0x2043;
+const LE_PERIODIC_ADVERTISING_CREATE_SYNC_CMD = 0x2044;
+const LE_PERIODIC_ADVERTISING_CREATE_SYNC_CANCEL_CMD = 0x2045;
+const LE_PERIODIC_ADVERTISING_TERMINATE_SYNC_CMD = 0x2046;
+
+const HCI_SUCCESS = 0x00;
+const HCI_UNKNOWN_COMMAND = 0x01;
+const HCI_UNKNOWN_CONNECTION_ID = 0x02;
+const HCI_MEMORY_CAPACITY_EXCEEDED = 0x07;
+const HCI_COMMAND_DISALLOWED = 0x0c;
+const HCI_OE_LOCAL_HOST_TERMINATED = 0x16;
+const HCI_UNKNOWN_ADVERTISING_IDENTIFIER = 0x42;
+const HCI_OPERATION_CANCELLED_BY_HOST = 0x44;
+
+const ATT_CID = 0x0004;
+const SIGNALING_CID = 0x0005;
+const SMP_CID = 0x0006;
+
+const SMP_PAIRING_FAILED = 0x05;
+const SMP_PAIRING_NOT_SUPPORTED = 0x05;
+
+const ADV_IND = 0x00;
+const ADV_NONCONN_IND = 0x03;
+const SCAN_RSP = 0x04;
+
+const EXT_ADV_CONNECTABLE = 0x0001;
+const EXT_ADV_SCANNABLE = 0x0002;
+const EXT_ADV_SCAN_RESPONSE = 0x0008;
+const EXT_ADV_LEGACY = 0x0010;
+const EXT_ADV_DATA_INCOMPLETE_MORE = 0x0020;
+
+// Largest advertising data an extended report carries before the controller chains it.
+const EXT_ADV_MAX_FRAGMENT = 229;
+const LEGACY_ADV_MAX_DATA = 31;
+// Largest periodic advertising data a periodic report carries.
+const PERIODIC_ADV_MAX_FRAGMENT = 247;
+
+const SCAN_TICK = 10;
+
+const DEFAULTS = {
+  address: '00:00:5e:00:53:00',
+  hciVersion: 0x0b,
+  manufacturer: 0x05f1,
+  extended: false,
+  dataLengthExtension: true,
+  codedPhy: false,
+  aclLength: 251,
+  aclNum: 8,
+  mtu: 247,
+  connectionInterval: 7.5,
+  connectionDelay: 10,
+  packetsPerConnectionEvent: 4,
+  advertisingInterval: 100,
+  rssi: -60,
+  acceptListSize: 16,
+  maxPeriodicSyncs: 4
+};
+
+const addressToBuffer = function (address) {
+  return Buffer.from(address.split(':').reverse().join(''), 'hex');
+};
+
+const toBuffer = function (value) {
+  if (value === undefined || value === null) {
+    return null;
+  }
+  return Buffer.isBuffer(value) ? value : Buffer.from(value, 'hex');
+};
+
+// Builds advertising data from the same field names noble reports in peripheral.advertisement.
+const buildEir = function ({ localName, serviceUuids, manufacturerData, serviceData, txPowerLevel }) {
+  const fields = [Buffer.from([0x02, 0x01, 0x06])];
+  const field = (type, data) => fields.push(Buffer.concat([Buffer.from([data.length + 1, type]), data]));
+  const uuid = (value) => Buffer.from(value.replace(/-/g, ''), 'hex').reverse();
+
+  if (serviceUuids && serviceUuids.length) {
+    const uuids = serviceUuids.map(uuid);
+    const short = uuids.filter((value) => value.length === 2);
+    const long = uuids.filter((value) => value.length === 16);
+    if (short.length) field(0x03, Buffer.concat(short));
+    if (long.length) field(0x07, Buffer.concat(long));
+  }
+  if (localName) {
+    field(0x09, Buffer.from(localName));
+  }
+  if (txPowerLevel !== undefined) {
+    field(0x0a, Buffer.from([txPowerLevel & 0xff]));
+  }
+  for (const { uuid: serviceUuid, data } of serviceData || []) {
+    field(serviceUuid.length === 4 ? 0x16 : 0x21, Buffer.concat([uuid(serviceUuid), data]));
+  }
+  if (manufacturerData) {
+    field(0xff, manufacturerData);
+  }
+
+  return Buffer.concat(fields);
+};
+
+/**
+ * HCI socket driver that emulates an LE controller and the peripherals around it.
+ *
+ * Commands get the Command Complete / Command Status replies a real controller
+ * would send, so Hci runs its normal init sequence. While scanning, every
+ * configured advertiser is reported once per advertising interval; connectable
+ * ones accept connections and serve their GATT database over ATT. ACL traffic
+ * is paced by the connection interval: each connection event acknowledges at
+ * most packetsPerConnectionEvent host packets with Number Of Completed Packets
+ * and delivers as many queued peripheral packets, so flow control and
+ * throughput behave like they do over the air. Advertisers with a periodic
+ * train can be synced to while scanning; a sync then reports their periodic
+ * data once per periodic interval, scanning or not.
+ *
+ * Selected with `hciDriver: 'virtual'` and configured through
+ * `bindParams: { virtual: { advertisers, connectionInterval, aclLength, ... } }`.
+ */
+const VirtualSocket = function () {
+  this._config = Object.assign({}, DEFAULTS);
+  this._advertisers = [];
+
+  this._isStarted = false;
+  this._deliveries = [];
+  this._deliveryTimer = null;
+
+  this._scan = null;
+  this._scanActive = false;
+  this._scanFilterPolicy = 0x00;
+  this._acceptList = new Set(); // address type and address, as sent in the commands
+  this._scanTimer = null;
+  this._pendingConnect = null;
+  this._connections = new Map();
+  this._nextHandle = 0x0040;
+  this._pendingSync = null;
+  this._syncs = new Map(); // by sync handle
+  this._nextSyncHandle = 0x0000;
+
+  this.stats = {
+    commands: 0,
+    events: 0,
+    aclIn: 0,
+    aclOut: 0,
+    advertisingReports: 0
+  };
+};
+
+Object.setPrototypeOf(VirtualSocket.prototype, EventEmitter.prototype);
+
+VirtualSocket.eir = buildEir;
+
+VirtualSocket.prototype.configure = function (params) {
+  const config = Object.assign({}, DEFAULTS, (params && params.virtual) || {});
+  let advertisers = config.advertisers || [];
+
+  // A number asks for that many anonymous, connectable advertisers.
+  if (typeof advertisers === 'number') {
+    advertisers = Array.from({ length: advertisers }, (_, i) => ({
+      localName: `virtual-${i}`,
+      services: config.services
+    }));
+  }
+
+  this._config = config;
+  this._advertisers = advertisers.map((advertiser, index) => this._createAdvertiser(advertiser, index));
+
+  debug(`configured ${this._advertisers.length} advertisers, connection interval = ${config.connectionInterval} ms`);
+};
+
+VirtualSocket.prototype._createAdvertiser = function (options, index) {
+  const config = this._config;
+  const address = (options.address ||
+    `c0:00:00:${((index >> 16) & 0xff).toString(16).padStart(2, '0')}:` +
+    `${((index >> 8) & 0xff).toString(16).padStart(2, '0')}:${(index & 0xff).toString(16).padStart(2, '0')}`
+  ).toLowerCase();
+  const advertisement = toBuffer(options.advertisement) || buildEir(options);
+  const extended = Boolean(options.extended) || Boolean(options.periodic) || advertisement.length > LEGACY_ADV_MAX_DATA;
+
+  const addressBuffer = addressToBuffer(address);
+  const addressType = options.addressType === 'public' ? 0x00 : 0x01;
+
+  return {
+    address,
+    addressBuffer,
+    addressType,
+    acceptListEntry: Buffer.concat([Buffer.from([addressType]), addressBuffer]).toString('hex'),
+    advertisement,
+    scanResponse: toBuffer(options.scanResponse),
+    connectable: options.connectable !== false,
+    extended,
+    sid: options.sid || 0,
+    txPower: options.txPower !== undefined ? options.txPower : 0x7f,
+    rssi: options.rssi !== undefined ? options.rssi : config.rssi,
+    interval: options.interval || config.advertisingInterval,
+    // Spread the first reports over one interval rather than bursting them all at once.
+    offset: (index * 7) % (options.interval || config.advertisingInterval),
+    services: options.services || [],
+    notifyInterval: options.notifyInterval || 0,
+    // { interval, data }: a periodic advertising train, on the advertiser's SID
+    periodic: options.periodic
+      ? { interval: options.periodic.interval || config.advertisingInterval, data: toBuffer(options.periodic.data) || Buffer.alloc(0) }
+      : null,
+    nextAt: 0
+  };
+};
+
+VirtualSocket.prototype.bindRaw = function (deviceId, params) {
+  this.configure(params);
+};
+
+VirtualSocket.prototype.bindUser = function (deviceId, params) {
+  this.configure(params);
+};
+
+VirtualSocket.prototype.start = function () {
+  this._isStarted = true;
+};
+
+VirtualSocket.prototype.stop = function () {
+  this._isStarted = false;
+  this._stopScan();
+  this._dropConnections();
+  this._dropSyncs();
+
+  if (this._deliveryTimer !== null) {
+    clearImmediate(this._deliveryTimer);
+    this._deliveryTimer = null;
+  }
+  this._deliveries = [];
+};
+
+VirtualSocket.prototype.isDevUp = function () {
+  return true;
+};
+
+VirtualSocket.prototype.setFilter = function (filter) {
+  // Nothing is sent that Hci did not ask for.
+};
+
+VirtualSocket.prototype.write = function (data) {
+  const type = data[0];
+
+  if (type === HCI_COMMAND_PKT) {
+    this.stats.commands++;
+    this._onCommand(data.readUInt16LE(1), data.slice(4, 4 + data[3]));
+  } else if (type === HCI_ACLDATA_PKT) {
+    this.stats.aclIn++;
+    this._onAclData(data);
+  }
+};
+
+// Takes a batch of packets in one call, as a stream transport would.
+VirtualSocket.prototype.writev = function (packets) {
+  packets.forEach(packet => this.write(packet));
+};
+
+// Sends a notification (or indication) from a peripheral, as if its firmware
+// produced a new value. Returns false while nobody is subscribed to it.
+VirtualSocket.prototype.notify = function (address, characteristicUuid, data) {
+  for (const connection of this._connections.values()) {
+    if (connection.advertiser.address !== address.toLowerCase()) {
+      continue;
+    }
+
+    const characteristic = connection.gatt.characteristic(characteristicUuid);
+    if (!characteristic || !characteristic.cccd || characteristic.cccd.value.readUInt16LE(0) === 0) {
+      return false;
+    }
+
+    this._sendL2cap(connection, ATT_CID, connection.gatt.notification(characteristic.handle, data));
+    return true;
+  }
+
+  return false;
+};
+
+// Ends an advertiser's periodic train, as if it went out of range: its syncs are lost.
+VirtualSocket.prototype.stopPeriodicAdvertising = function (address) {
+  const advertiser = this._advertisers.find(candidate => candidate.address === address.toLowerCase());
+  if (!advertiser || !advertiser.periodic) {
+    return false;
+  }
+
+  advertiser.periodic = null;
+  for (const sync of [...this._syncs.values()]) {
+    if (sync.advertiser === advertiser) {
+      this._closeSync(sync);
+
+      const params = Buffer.alloc(2);
+      params.writeUInt16LE(sync.handle, 0);
+      this._leEvent(EVT_LE_PERIODIC_SYNC_LOST, params);
+    }
+  }
+  return true;
+};
+
+// Events are delivered from the event loop, never from inside write(), like a real socket.
+VirtualSocket.prototype._emitPacket = function (packet) {
+  this._deliveries.push(packet);
+
+  if (this._deliveryTimer === null) {
+    this._deliveryTimer = setImmediate(() => {
+      this._deliveryTimer = null;
+
+      const events = this._deliveries;
+      this._deliveries = [];
+      for (const event of events) {
+        if (!this._isStarted) {
+          return;
+        }
+        this.stats.events++;
+        this.emit('data', event);
+      }
+    });
+  }
+};
+
+VirtualSocket.prototype._event = function (code, params) {
+  const packet = Buffer.alloc(3 + params.length);
+
+  packet.writeUInt8(HCI_EVENT_PKT, 0);
+  packet.writeUInt8(code, 1);
+  packet.writeUInt8(params.length, 2);
+  params.copy(packet, 3);
+
+  this._emitPacket(packet);
+};
+
+VirtualSocket.prototype._leEvent = function (subEvent, params) {
+  this._event(EVT_LE_META_EVENT, Buffer.concat([Buffer.from([subEvent]), params]));
+};
+
+VirtualSocket.prototype._commandComplete = function (opcode, status, result) {
+  const params = Buffer.alloc(4 + (result ? result.length : 0));
+
+  params.writeUInt8(1, 0); // num hci command packets
+  params.writeUInt16LE(opcode, 1);
+  params.writeUInt8(status, 3);
+  if (result) {
+    result.copy(params, 4);
+  }
+
+  this._event(EVT_CMD_COMPLETE, params);
+};
+
+VirtualSocket.prototype._commandStatus = function (opcode, status) {
+  const params = Buffer.alloc(4);
+
+  params.writeUInt8(status, 0);
+  params.writeUInt8(1, 1); // num hci command packets
+  params.writeUInt16LE(opcode, 2);
+
+  this._event(EVT_CMD_STATUS, params);
+};
+
+VirtualSocket.prototype._onCommand = function (opcode, params) {
+  const config = this._config;
+
+  switch (opcode) {
+    case RESET_CMD:
+      this._stopScan();
+      this._dropConnections();
+      this._pendingConnect = null;
+      this._dropSyncs();
+      this._scanFilterPolicy = 0x00;
+      this._acceptList.clear();
+      this._commandComplete(opcode, HCI_SUCCESS);
+      break;
+    case SET_EVENT_MASK_CMD:
+    case LE_SET_EVENT_MASK_CMD:
+    case WRITE_LE_HOST_SUPPORTED_CMD:
+    case LE_SET_DEFAULT_PHY_CMD:
+      this._commandComplete(opcode, HCI_SUCCESS);
+      break;
+    case READ_LE_HOST_SUPPORTED_CMD:
+      this._commandComplete(opcode, HCI_SUCCESS, Buffer.from([0x01, 0x00]));
+      break;
+    case READ_LOCAL_VERSION_CMD: {
+      const result = Buffer.alloc(8);
+      result.writeUInt8(config.hciVersion, 0);
+      result.writeUInt16LE(0x0000, 1); // hci revision
+      result.writeUInt8(config.hciVersion, 3); // lmp version
+      result.writeUInt16LE(config.manufacturer, 4);
+      result.writeUInt16LE(0x0000, 6); // lmp subversion
+      this._commandComplete(opcode, HCI_SUCCESS, result);
+      break;
+    }
+    case READ_SUPPORTED_COMMANDS_CMD: {
+      const result = Buffer.alloc(64, 0xff);
+      if (!config.extended) {
+        result[37] &= ~0x30; // LE Set Extended Scan Parameters / Enable
+      }
+      this._commandComplete(opcode, HCI_SUCCESS, result);
+      break;
+    }
+    case READ_BUFFER_SIZE_CMD: {
+      const result = Buffer.alloc(7);
+      result.writeUInt16LE(config.aclLength, 0);
+      result.writeUInt8(0, 2); // sco length
+      result.writeUInt16LE(config.aclNum, 3);
+      result.writeUInt16LE(0, 5); // sco num
+      this._commandComplete(opcode, HCI_SUCCESS, result);
+      break;
+    }
+    case READ_BD_ADDR_CMD:
+      this._commandComplete(opcode, HCI_SUCCESS, addressToBuffer(config.address));
+      break;
+    case LE_READ_BUFFER_SIZE_CMD: {
+      const result = Buffer.alloc(3);
+      result.writeUInt16LE(config.aclLength, 0);
+      result.writeUInt8(config.aclNum, 2);
+      this._commandComplete(opcode, HCI_SUCCESS, result);
+      break;
+    }
+    case LE_READ_LOCAL_SUPPORTED_FEATURES: {
+      const result = Buffer.alloc(8);
+      if (config.dataLengthExtension) result[0] |= 1 << 5;
+      if (config.codedPhy) result[1] |= 1 << 3;
+      if (config.extended) result[1] |= 1 << 4;
+      this._commandComplete(opcode, HCI_SUCCESS, result);
+      break;
+    }
+    case LE_READ_MAX_DATA_LENGTH_CMD: {
+      const result = Buffer.alloc(8);
+      result.writeUInt16LE(0x00fb, 0);
+      result.writeUInt16LE(0x0848, 2);
+      result.writeUInt16LE(0x00fb, 4);
+      result.writeUInt16LE(0x0848, 6);
+      this._commandComplete(opcode, HCI_SUCCESS, result);
+      break;
+    }
+    case LE_SET_DATA_LENGTH_CMD:
+      this._commandComplete(opcode, HCI_SUCCESS, params.slice(0, 2));
+      break;
+    case LE_SET_SCAN_PARAMETERS_CMD:
+      this._scanActive = params[0] === 0x01;
+      this._scanFilterPolicy = params[6];
+      this._commandComplete(opcode, HCI_SUCCESS);
+      break;
+    case LE_SET_EXTENDED_SCAN_PARAMETERS_CMD:
+      this._scanActive = params[3] === 0x01;
+      this._scanFilterPolicy = params[1];
+      this._commandComplete(opcode, HCI_SUCCESS);
+      break;
+    case LE_SET_SCAN_ENABLE_CMD:
+    case LE_SET_EXTENDED_SCAN_ENABLE_CMD:
+      if (params[0] === 0x01) {
+        // Filter_Duplicates 0x02 empties the filter every Period, in units of 1.28 s
+        const resetPeriod = opcode === LE_SET_EXTENDED_SCAN_ENABLE_CMD && params[1] === 0x02
+          ? params.readUInt16LE(4) * 1280
+          : 0;
+        this._startScan(opcode === LE_SET_EXTENDED_SCAN_ENABLE_CMD, params[1] !== 0x00, resetPeriod);
+      } else {
+        this._stopScan();
+      }
+      this._commandComplete(opcode, HCI_SUCCESS);
+      break;
+    case LE_READ_FILTER_ACCEPT_LIST_SIZE_CMD:
+      this._commandComplete(opcode, HCI_SUCCESS, Buffer.from([config.acceptListSize]));
+      break;
+    case LE_CLEAR_FILTER_ACCEPT_LIST_CMD:
+    case LE_ADD_DEVICE_TO_FILTER_ACCEPT_LIST_CMD:
+    case LE_REMOVE_DEVICE_FROM_FILTER_ACCEPT_LIST_CMD:
+      this._commandComplete(opcode, this._updateAcceptList(opcode, params));
+      break;
+    case LE_CREATE_CONN_CMD:
+    case LE_CREATE_EXTENDED_CONN_CMD:
+      this._createConnection(opcode, params);
+      break;
+    case LE_CANCEL_CONN_CMD:
+      this._cancelConnection();
+      break;
+    case DISCONNECT_CMD:
+      this._disconnect(params.readUInt16LE(0));
+      break;
+    case LE_CONN_UPDATE_CMD:
+      this._updateConnection(params);
+      break;
+    case LE_PERIODIC_ADVERTISING_CREATE_SYNC_CMD:
+      this._createSync(params);
+      break;
+    case LE_PERIODIC_ADVERTISING_CREATE_SYNC_CANCEL_CMD:
+      this._cancelSync();
+      break;
+    case LE_PERIODIC_ADVERTISING_TERMINATE_SYNC_CMD:
+      this._terminateSync(params.readUInt16LE(0));
+      break;
+    case LE_START_ENCRYPTION_CMD:
+      this._startEncryption(params.readUInt16LE(0));
+      break;
+    case READ_RSSI_CMD: {
+      const handle = params.readUInt16LE(0);
+      const connection = this._connections.get(handle);
+      const result = Buffer.alloc(3);
+      result.writeUInt16LE(handle, 0);
+      result.writeInt8(connection ? connection.advertiser.rssi : 0, 2);
+      this._commandComplete(opcode, connection ? HCI_SUCCESS : HCI_UNKNOWN_CONNECTION_ID, result);
+      break;
+    }
+    default:
+      debug(`unknown command 0x${opcode.toString(16)}`);
+      this._commandComplete(opcode, HCI_UNKNOWN_COMMAND);
+      break;
+  }
+};
+
+// Scanning
+
+VirtualSocket.prototype._updateAcceptList = function (opcode, params) {
+  // Not while a scan filters on it
+  if (this._scan !== null && this._scanFilterPolicy === 0x01) {
+    return HCI_COMMAND_DISALLOWED;
+  }
+
+  if (opcode === LE_CLEAR_FILTER_ACCEPT_LIST_CMD) {
+    this._acceptList.clear();
+    return HCI_SUCCESS;
+  }
+
+  const entry = params.subarray(0, 7).toString('hex');
+  if (opcode === LE_REMOVE_DEVICE_FROM_FILTER_ACCEPT_LIST_CMD) {
+    this._acceptList.delete(entry);
+  } else if (!this._acceptList.has(entry)) {
+    if (this._acceptList.size >= this._config.acceptListSize) {
+      return HCI_MEMORY_CAPACITY_EXCEEDED;
+    }
+    this._acceptList.add(entry);
+  }
+  return HCI_SUCCESS;
+};
+
+VirtualSocket.prototype._startScan = function (extended, filterDuplicates, resetPeriod = 0) {
+  this._stopScan();
+
+  const now = Date.now();
+  for (const advertiser of this._advertisers) {
+    advertiser.nextAt = now + advertiser.offset;
+  }
+
+  this._scan = { extended, filterDuplicates, resetPeriod, resetAt: now + resetPeriod, reported: new Set() };
+  this._scanTimer = setInterval(() => this._scanTick(), SCAN_TICK);
+};
+
+VirtualSocket.prototype._stopScan = function () {
+  if (this._scanTimer !== null) {
+    clearInterval(this._scanTimer);
+    this._scanTimer = null;
+  }
+  this._scan = null;
+};
+
+VirtualSocket.prototype._scanTick = function () {
+  const now = Date.now();
+
+  if (this._scan.resetPeriod > 0 && now >= this._scan.resetAt) {
+    this._scan.reported.clear();
+    this._scan.resetAt += this._scan.resetPeriod;
+  }
+
+  for (const advertiser of this._advertisers) {
+    if (advertiser.nextAt > now) {
+      continue;
+    }
+    // Skip missed intervals rather than bursting after a stalled event loop.
+    advertiser.nextAt += Math.max(1, Math.ceil((now - advertiser.nextAt + 1) / advertiser.interval)) * advertiser.interval;
+
+    // A pending sync finds its train through the advertisement, whatever the scan reports
+    if (this._pendingSync !== null && this._scan.extended && this._matchesSync(advertiser)) {
+      this._establishSync(advertiser);
+    }
+
+    if (this._scanFilterPolicy === 0x01 && !this._acceptList.has(advertiser.acceptListEntry)) {
+      continue;
+    }
+
+    if (this._scan.filterDuplicates) {
+      if (this._scan.reported.has(advertiser)) {
+        continue;
+      }
+      this._scan.reported.add(advertiser);
+    }
+
+    this._report(advertiser, false);
+    if (this._scanActive && advertiser.scanResponse) {
+      this._report(advertiser, true);
+    }
+  }
+};
+
+VirtualSocket.prototype._report = function (advertiser, scanResponse) {
+  const data = scanResponse ? advertiser.scanResponse : advertiser.advertisement;
+
+  if (!this._scan.extended) {
+    // Legacy scanning never sees extended-only advertisers.
+    if (advertiser.extended) {
+      return;
+    }
+    this.stats.advertisingReports++;
+
+    const report = Buffer.alloc(11 + data.length);
+    report.writeUInt8(1, 0); // num reports
+    report.writeUInt8(scanResponse ? SCAN_RSP : (advertiser.connectable ? ADV_IND : ADV_NONCONN_IND), 1);
+    report.writeUInt8(advertiser.addressType, 2);
+    advertiser.addressBuffer.copy(report, 3);
+    report.writeUInt8(data.length, 9);
+    data.copy(report, 10);
+    report.writeInt8(advertiser.rssi, 10 + data.length);
+
+    this._leEvent(EVT_LE_ADVERTISING_REPORT, report);
+    return;
+  }
+
+  this.stats.advertisingReports++;
+
+  let type = advertiser.connectable ? EXT_ADV_CONNECTABLE : 0;
+  if (advertiser.scanResponse) type |= EXT_ADV_SCANNABLE;
+  if (scanResponse) type |= EXT_ADV_SCAN_RESPONSE;
+  if (!advertiser.extended) type |= EXT_ADV_LEGACY;
+
+  // Long advertising data arrives as a chain of reports, all but the last flagged incomplete.
+  let offset = 0;
+  do {
+    const fragment = data.slice(offset, offset + EXT_ADV_MAX_FRAGMENT);
+    offset += fragment.length;
+
+    const report = Buffer.alloc(25 + fragment.length);
+    report.writeUInt8(1, 0); // num reports
+    report.writeUInt16LE(type | (offset < data.length ? EXT_ADV_DATA_INCOMPLETE_MORE : 0), 1);
+    report.writeUInt8(advertiser.addressType, 3);
+    advertiser.addressBuffer.copy(report, 4);
+    report.writeUInt8(0x01, 10); // primary phy: LE 1M
+    report.writeUInt8(advertiser.extended ? 0x01 : 0x00, 11); // secondary phy
+    report.writeUInt8(advertiser.extended ? advertiser.sid : 0xff, 12);
+    report.writeUInt8(advertiser.txPower, 13);
+    report.writeInt8(advertiser.rssi, 14);
+    report.writeUInt16LE(advertiser.periodic ? Math.round(advertiser.periodic.interval / 1.25) : 0x0000, 15); // periodic advertising interval
+    report.writeUInt8(0x00, 17); // direct address type
+    report.writeUInt8(fragment.length, 24);
+    fragment.copy(report, 25);
+
+    this._leEvent(EVT_LE_EXTENDED_ADVERTISING_REPORT, report);
+  } while (offset < data.length);
+};
+
+// Periodic advertising syncs
+
+VirtualSocket.prototype._createSync = function (params) {
+  if (this._pendingSync !== null) {
+    this._commandStatus(LE_PERIODIC_ADVERTISING_CREATE_SYNC_CMD, HCI_COMMAND_DISALLOWED);
+    return;
+  }
+  if (this._syncs.size >= this._config.maxPeriodicSyncs) {
+    this._commandStatus(LE_PERIODIC_ADVERTISING_CREATE_SYNC_CMD, HCI_MEMORY_CAPACITY_EXCEEDED);
+    return;
+  }
+
+  this._commandStatus(LE_PERIODIC_ADVERTISING_CREATE_SYNC_CMD, HCI_SUCCESS);
+  this._pendingSync = {
+    sid: params[1],
+    addressType: params[2],
+    address: Buffer.from(params.subarray(3, 9)),
+    skip: params.readUInt16LE(9)
+  };
+};
+
+VirtualSocket.prototype._matchesSync = function (advertiser) {
+  const pending = this._pendingSync;
+  return advertiser.periodic !== null &&
+    advertiser.sid === pending.sid &&
+    advertiser.addressType === pending.addressType &&
+    advertiser.addressBuffer.equals(pending.address);
+};
+
+VirtualSocket.prototype._establishSync = function (advertiser) {
+  const handle = this._nextSyncHandle;
+  this._nextSyncHandle = this._nextSyncHandle >= 0x0eff ? 0x0000 : this._nextSyncHandle + 1;
+
+  // Skipped events are not reported, so the train is reported once every skip + 1 intervals
+  const every = advertiser.periodic.interval * (this._pendingSync.skip + 1);
+  const sync = { handle, advertiser, timer: null };
+  sync.timer = setInterval(() => this._periodicReport(sync), every);
+  this._syncs.set(handle, sync);
+  this._pendingSync = null;
+
+  debug(`periodic sync ${handle} with ${advertiser.address}`);
+
+  const params = Buffer.alloc(15);
+  params.writeUInt8(HCI_SUCCESS, 0);
+  params.writeUInt16LE(handle, 1);
+  params.writeUInt8(advertiser.sid, 3);
+  params.writeUInt8(advertiser.addressType, 4);
+  advertiser.addressBuffer.copy(params, 5);
+  params.writeUInt8(0x01, 11); // phy: LE 1M
+  params.writeUInt16LE(Math.round(advertiser.periodic.interval / 1.25), 12);
+  params.writeUInt8(0x00, 14); // clock accuracy
+  this._leEvent(EVT_LE_PERIODIC_SYNC_ESTABLISHED, params);
+};
+
+VirtualSocket.prototype._cancelSync = function () {
+  const pending = this._pendingSync;
+
+  if (pending === null) {
+    this._commandComplete(LE_PERIODIC_ADVERTISING_CREATE_SYNC_CANCEL_CMD, HCI_COMMAND_DISALLOWED);
+    return;
+  }
+
+  this._pendingSync = null;
+  this._commandComplete(LE_PERIODIC_ADVERTISING_CREATE_SYNC_CANCEL_CMD, HCI_SUCCESS);
+
+  const params = Buffer.alloc(15);
+  params.writeUInt8(HCI_OPERATION_CANCELLED_BY_HOST, 0);
+  this._leEvent(EVT_LE_PERIODIC_SYNC_ESTABLISHED, params);
+};
+
+VirtualSocket.prototype._terminateSync = function (handle) {
+  const sync = this._syncs.get(handle);
+
+  if (sync) {
+    this._closeSync(sync);
+  }
+  this._commandComplete(LE_PERIODIC_ADVERTISING_TERMINATE_SYNC_CMD, sync ? HCI_SUCCESS : HCI_UNKNOWN_ADVERTISING_IDENTIFIER);
+};
+
+VirtualSocket.prototype._closeSync = function (sync) {
+  clearInterval(sync.timer);
+  this._syncs.delete(sync.handle);
+};
+
+VirtualSocket.prototype._dropSyncs = function () {
+  this._pendingSync = null;
+  for (const sync of [...this._syncs.values()]) {
+    this._closeSync(sync);
+  }
+};
+
+// Long periodic data arrives as a chain of reports too, all but the last with data status 1.
+VirtualSocket.prototype._periodicReport = function (sync) {
+  const { advertiser } = sync;
+  const data = advertiser.periodic.data;
+
+  let offset = 0;
+  do {
+    const fragment = data.slice(offset, offset + PERIODIC_ADV_MAX_FRAGMENT);
+    offset += fragment.length;
+
+    const params = Buffer.alloc(7 + fragment.length);
+    params.writeUInt16LE(sync.handle, 0);
+    params.writeUInt8(advertiser.txPower, 2);
+    params.writeInt8(advertiser.rssi, 3);
+    params.writeUInt8(0xff, 4); // CTE type: no Constant Tone Extension
+    params.writeUInt8(offset < data.length ? 0x01 : 0x00, 5); // data status
+    params.writeUInt8(fragment.length, 6);
+    fragment.copy(params, 7);
+
+    this._leEvent(EVT_LE_PERIODIC_ADVERTISING_REPORT, params);
+  } while (offset < data.length);
+};
+
+// Connections
+
+VirtualSocket.prototype._createConnection = function (opcode, params) {
+  if (this._pendingConnect !== null) {
+    this._commandStatus(opcode, HCI_COMMAND_DISALLOWED);
+    return;
+  }
+
+  const extended = opcode === LE_CREATE_EXTENDED_CONN_CMD;
+  const peerAddress = extended ? params.slice(3, 9) : params.slice(6, 12);
+  const advertiser = this._advertisers.find((candidate) => candidate.addressBuffer.equals(peerAddress));
+
+  this._commandStatus(opcode, HCI_SUCCESS);
+
+  // A peer that never advertises connectably leaves the attempt pending until it is cancelled.
+  const pending = { extended, peerAddress, timer: null };
+  if (advertiser && advertiser.connectable) {
+    pending.timer = setTimeout(() => {
+      this._pendingConnect = null;
+      this._connectionComplete(this._openConnection(advertiser), extended);
+    }, this._config.connectionDelay);
+  }
+  this._pendingConnect = pending;
+};
+
+VirtualSocket.prototype._cancelConnection = function () {
+  const pending = this._pendingConnect;
+
+  if (pending === null) {
+    this._commandComplete(LE_CANCEL_CONN_CMD, HCI_COMMAND_DISALLOWED);
+    return;
+  }
+
+  clearTimeout(pending.timer);
+  this._pendingConnect = null;
+  this._commandComplete(LE_CANCEL_CONN_CMD, HCI_SUCCESS);
+
+  const params = Buffer.alloc(pending.extended ? 31 : 19);
+  params.writeUInt8(0x02, 0); // status: unknown connection identifier
+  this._leEvent(pending.extended ? EVT_LE_ENHANCED_CONN_COMPLETE : EVT_LE_CONN_COMPLETE, params);
+};
+
+VirtualSocket.prototype._openConnection = function (advertiser) {
+  const handle = this._nextHandle;
+  this._nextHandle = this._nextHandle >= 0x0eff ? 0x0040 : this._nextHandle + 1;
+
+  const connection = {
+    handle,
+    advertiser,
+    gatt: new VirtualGatt(advertiser.services, this._config.mtu),
+    interval: this._config.connectionInterval,
+    // L2CAP frame being reassembled from host ACL fragments.
+    rx: null,
+    // Host packets waiting to be acknowledged by a connection event.
+    unacknowledged: 0,
+    // Peripheral ACL fragments waiting for a connection event.
+    outbox: [],
+    lastNotifyAt: 0,
+    timer: null
+  };
+
+  connection.timer = setInterval(() => this._connectionEvent(connection), connection.interval);
+  this._connections.set(handle, connection);
+
+  debug(`connected ${advertiser.address} as handle ${handle}`);
+
+  return connection;
+};
+
+VirtualSocket.prototype._connectionComplete = function (connection, extended) {
+  const { advertiser } = connection;
+  const params = Buffer.alloc(extended ? 31 : 19);
+  let offset = 0;
+
+  params.writeUInt8(HCI_SUCCESS, offset++);
+  params.writeUInt16LE(connection.handle, offset); offset += 2;
+  params.writeUInt8(0x00, offset++); // role: central
+  params.writeUInt8(advertiser.addressType, offset++);
+  advertiser.addressBuffer.copy(params, offset); offset += 6;
+  if (extended) {
+    offset += 12; // local / peer resolvable private addresses
+  }
+  params.writeUInt16LE(Math.round(connection.interval / 1.25), offset); offset += 2;
+  params.writeUInt16LE(0x0000, offset); offset += 2; // latency
+  params.writeUInt16LE(0x002a, offset); offset += 2; // supervision timeout
+  params.writeUInt8(0x00, offset); // clock accuracy
+
+  this._leEvent(extended ? EVT_LE_ENHANCED_CONN_COMPLETE : EVT_LE_CONN_COMPLETE, params);
+};
+
+VirtualSocket.prototype._closeConnection = function (connection) {
+  clearInterval(connection.timer);
+  this._connections.delete(connection.handle);
+};
+
+VirtualSocket.prototype._dropConnections = function () {
+  if (this._pendingConnect !== null) {
+    clearTimeout(this._pendingConnect.timer);
+    this._pendingConnect = null;
+  }
+  for (const connection of this._connections.values()) {
+    this._closeConnection(connection);
+  }
+};
+
+VirtualSocket.prototype._disconnect = function (handle) {
+  const connection = this._connections.get(handle);
+
+  this._commandStatus(DISCONNECT_CMD, connection ? HCI_SUCCESS : HCI_UNKNOWN_CONNECTION_ID);
+  if (!connection) {
+    return;
+  }
+
+  this._closeConnection(connection);
+
+  const params = Buffer.alloc(4);
+  params.writeUInt8(HCI_SUCCESS, 0);
+  params.writeUInt16LE(handle, 1);
+  params.writeUInt8(HCI_OE_LOCAL_HOST_TERMINATED, 3);
+  this._event(EVT_DISCONN_COMPLETE, params);
+};
+
+VirtualSocket.prototype._updateConnection = function (params) {
+  const handle = params.readUInt16LE(0);
+  const connection = this._connections.get(handle);
+
+  this._commandStatus(LE_CONN_UPDATE_CMD, connection ? HCI_SUCCESS : HCI_UNKNOWN_CONNECTION_ID);
+  if (!connection) {
+    return;
+  }
+
+  // Take the longest interval the host allows, like a peripheral saving power would.
+  connection.interval = params.readUInt16LE(4) * 1.25;
+  clearInterval(connection.timer);
+  connection.timer = setInterval(() => this._connectionEvent(connection), connection.interval);
+
+  const update = Buffer.alloc(9);
+  update.writeUInt8(HCI_SUCCESS, 0);
+  update.writeUInt16LE(handle, 1);
+  update.writeUInt16LE(params.readUInt16LE(4), 3); // interval
+  update.writeUInt16LE(params.readUInt16LE(6), 5); // latency
+  update.writeUInt16LE(params.readUInt16LE(8), 7); // supervision timeout
+  this._leEvent(EVT_LE_CONN_UPDATE_COMPLETE, update);
+};
+
+VirtualSocket.prototype._startEncryption = function (handle) {
+  const connection = this._connections.get(handle);
+
+  this._commandStatus(LE_START_ENCRYPTION_CMD, connection ? HCI_SUCCESS : HCI_UNKNOWN_CONNECTION_ID);
+  if (!connection) {
+    return;
+  }
+
+  const params = Buffer.alloc(4);
+  params.writeUInt8(HCI_SUCCESS, 0);
+  params.writeUInt16LE(handle, 1);
+  params.writeUInt8(0x01, 3); // encryption on
+  this._event(EVT_ENCRYPT_CHANGE, params);
+};
+
+// ACL data
+
+VirtualSocket.prototype._onAclData = function (data) {
+  const handle = data.readUInt16LE(1) & 0x0fff;
+  const flags = data.readUInt16LE(1) >> 12;
+  const connection = this._connections.get(handle);
+
+  if (!connection) {
+    debug(`acl data for unknown handle ${handle}`);
+    return;
+  }
+
+  connection.unacknowledged++;
+
+  const payload = data.slice(5, 5 + data.readUInt16LE(3));
+  if (flags === ACL_START || flags === ACL_START_NO_FLUSH) {
+    connection.rx = {
+      length: payload.readUInt16LE(0),
+      cid: payload.readUInt16LE(2),
+      fragments: [payload.slice(4)],
+      received: payload.length - 4
+    };
+  } else if (flags === ACL_CONT && connection.rx !== null) {
+    connection.rx.fragments.push(payload);
+    connection.rx.received += payload.length;
+  } else {
+    return;
+  }
+
+  const rx = connection.rx;
+  if (rx.received >= rx.length) {
+    connection.rx = null;
+    this._onL2cap(connection, rx.cid, Buffer.concat(rx.fragments, rx.received).slice(0, rx.length));
+  }
+};
+
+VirtualSocket.prototype._onL2cap = function (connection, cid, pdu) {
+  if (cid === ATT_CID) {
+    const response = connection.gatt.handleRequest(pdu);
+    if (response !== null) {
+      this._sendL2cap(connection, ATT_CID, response);
+    }
+  } else if (cid === SMP_CID) {
+    this._sendL2cap(connection, SMP_CID, Buffer.from([SMP_PAIRING_FAILED, SMP_PAIRING_NOT_SUPPORTED]));
+  } else if (cid !== SIGNALING_CID) {
+    debug(`ignoring l2cap cid ${cid}`);
+  }
+};
+
+VirtualSocket.prototype._sendL2cap = function (connection, cid, pdu) {
+  const frame = Buffer.alloc(4 + pdu.length);
+  frame.writeUInt16LE(pdu.length, 0);
+  frame.writeUInt16LE(cid, 2);
+  pdu.copy(frame, 4);
+
+  const aclLength = this._config.aclLength;
+  for (let offset = 0; offset < frame.length; offset += aclLength) {
+    const fragment = frame.slice(offset, offset + aclLength);
+    const packet = Buffer.alloc(5 + fragment.length);
+
+    packet.writeUInt8(HCI_ACLDATA_PKT, 0);
+    packet.writeUInt16LE(connection.handle | ((offset === 0 ? ACL_START : ACL_CONT) << 12), 1);
+    packet.writeUInt16LE(fragment.length, 3);
+    fragment.copy(packet, 5);
+
+    connection.outbox.push(packet);
+  }
+};
+
+VirtualSocket.prototype._connectionEvent = function (connection) {
+  const perEvent = this._config.packetsPerConnectionEvent;
+  const { advertiser } = connection;
+
+  // Sensors drop samples rather than queueing them while the link is saturated.
+  if (advertiser.notifyInterval > 0 && connection.outbox.length < perEvent) {
+    const now = Date.now();
+    if (now - connection.lastNotifyAt >= advertiser.notifyInterval) {
+      connection.lastNotifyAt = now;
+      for (const characteristic of connection.gatt.subscriptions()) {
+        this._sendL2cap(connection, ATT_CID, connection.gatt.notification(characteristic.handle));
+      }
+    }
+  }
+
+  const completed = Math.min(connection.unacknowledged, perEvent);
+  if (completed > 0) {
+    connection.unacknowledged -= completed;
+
+    const params = Buffer.alloc(5);
+    params.writeUInt8(1, 0); // num handles
+    params.writeUInt16LE(connection.handle, 1);
+    params.writeUInt16LE(completed, 3);
+    this._event(EVT_NUMBER_OF_COMPLETED_PACKETS, params);
+  }
+
+  for (const packet of connection.outbox.splice(0, perEvent)) {
+    this.stats.aclOut++;
+    this._emitPacket(packet);
+  }
+};
+
+module.exports = VirtualSocket;
@@ -3,8 +3,17 @@ const debug = require('debug')('gap');
 const { EventEmitter } = require('events');
 const os = require('os');
 
+const DiscoveryCache = require('./discovery-cache');
+const ReportReassembly = require('./report-reassembly');
+const compileScanFilter = require('./scan-filter');
+const resolveScanProfile = require('./scan-profiles');
+const ScanScheduler = require('./scan-scheduler');
+const { addressString, uuidAt } = require('./hci-events');
+
 const isChip = os.platform() === 'linux' && os.release().indexOf('-ntc') !== -1;
 
+const LE_META_EVENT_TYPE_ADV_IND = 0x0;
+const LE_META_EVENT_TYPE_ADV_SCAN_IND = 0x2;
 const LE_META_EVENT_TYPE_CONNECTABLE = 0x3;
 const LE_META_EVENT_TYPE_SCAN_RESPONSE = 0x4;
 const LE_META_EVENT_TYPE_SCANNABLE = 0x6;
@@ -12,14 +21,90 @@ const LE_META_EVENT_TYPE_SCANNABLE = 0x6;
 const LE_META_EXTENDED_EVENT_TYPE_CONNECTABLE_MASK = 0x1;
 const LE_META_EXTENDED_EVENT_TYPE_SCANNABLE_MASK = 0x2;
 const LE_META_EXTENDED_EVENT_TYPE_SCAN_RESPONSE_MASK = 0x8;
-const LE_META_EXTENDED_EVENT_TYPE_INCOMPLETE_MASK = 0x20;
+const LE_META_EXTENDED_EVENT_TYPE_DATA_STATUS_MASK = 0x60;
+
+const HCI_MEMORY_CAPACITY_EXCEEDED = 0x07;
+const HCI_SUCCESS = 0x00;
+
+// SID of extended advertisements that have no Advertising Data Info
+const SID_NONE = 0xff;
+
+const DEFAULT_MAX_PERIODIC_SYNCS = 4;
+const DEFAULT_PERIODIC_SYNC_TIMEOUT = 10000; // ms without a periodic report before the sync is lost
+const DEFAULT_PERIODIC_SYNC_ESTABLISH_TIMEOUT = 10000; // ms to find the train while scanning
+
+// What Hci.setScanParameters uses when given nothing, in units of 0.625 ms
+const DEFAULT_SCAN_INTERVAL = 0x0012;
+const DEFAULT_SCAN_WINDOW = 0x0012;
+const MIN_SCAN_WINDOW = 0x0004;
 
-const Gap = function (hci) {
+const ACCEPT_LIST_OFF = 'off';
+const ACCEPT_LIST_CONTROLLER = 'controller';
+const ACCEPT_LIST_HOST = 'host';
+
+const Gap = function (hci, options = {}) {
   this._hci = hci;
 
   this._scanState = null;
   this._scanFilterDuplicates = null;
-  this._discoveries = {};
+  this._scanAllowDuplicates = false; // as startScanning was asked
+  this._scanParameters = [];
+  this._discoveries = new DiscoveryCache( // by 48-bit address
+    { maxSize: options.discoveryCacheSize, ttl: options.discoveryCacheTtl },
+    this.onDiscoveryEvict.bind(this)
+  );
+  this._scanFilter = compileScanFilter(options.scanFilter);
+  this._scanFilterRejected = 0;
+
+  // Long extended advertising data arrives in a chain of reports; only whole data is parsed
+  this._reportReassembly = new ReportReassembly();
+
+  // Devices to scan for, filtered by the controller while they fit its Filter Accept List,
+  // and here otherwise
+  this._acceptListMode = ACCEPT_LIST_OFF;
+  this._acceptListCapacity = null; // read from the controller when first needed
+  this._hostAcceptList = null; // 48-bit address -> address type, in host mode
+  this._acceptListRejected = 0;
+
+  // With a scan response window, scannable advertisements are held until their scan
+  // response comes in or the window ends, and reported once, merged.
+  this._scanResponseWindow = options.scanResponseWindow > 0 ? options.scanResponseWindow : 0;
+  this._heldDiscoveries = new Map(); // by 48-bit address, in the order they are due
+  this._heldTimer = null;
+
+  // With a duplicates refresh, a scan that filters duplicates reports each device again that
+  // often, so its RSSI stays fresh without every advertisement reaching the host
+  this._duplicatesRefresh = options.duplicatesRefresh > 0 ? options.duplicatesRefresh : 0;
+  this._duplicatesRefreshTimer = null;
+
+  // Named sets of scan settings. Without one, scanning is done as it always was.
+  this._scanProfiles = options.scanProfiles || {};
+  this._scanProfile = null;
+
+  // With a scheduler, the scan window follows the load while scanning
+  this._scanScheduler = options.scanScheduler
+    ? new ScanScheduler(options.scanScheduler === true ? {} : options.scanScheduler)
+    : null;
+  this._scheduledWindow = null;
+  this._schedulerTimer = null;
+  this._schedulerDue = 0;
+
+  // Periodic advertising syncs, by peripheral id. The controller establishes one at a time,
+  // so the others wait their turn; once established, a sync needs no scanning.
+  this._maxPeriodicSyncs = options.maxPeriodicSyncs > 0 ? options.maxPeriodicSyncs : DEFAULT_MAX_PERIODIC_SYNCS;
+  this._periodicSyncs = new Map();
+  this._periodicSyncHandles = new Map(); // sync handle -> sync, once established
+  this._periodicSyncQueue = [];
+  this._pendingPeriodicSync = null;
+  this._periodicSyncTimer = null;
+  // Periodic data arrives in chains of reports too, keyed here by sync handle
+  this._periodicReassembly = new ReportReassembly();
+
+  // Time spent scanning, and the part of it the controller was listening
+  this._scanSince = null;
+  this._scanSinceDuty = 0;
+  this._scanTime = 0;
+  this._scanOnTime = 0;
 
   this._hci.on('error', this.onHciError.bind(this));
   this._hci.on('leScanParametersSet', this.onHciLeScanParametersSet.bind(this));
@@ -31,38 +116,537 @@ const Gap = function (hci) {
   );
 
   this._hci.on('leScanEnableSetCmd', this.onLeScanEnableSetCmd.bind(this));
+  this._hci.on('lePeriodicSyncEstablished', this.onHciLePeriodicSyncEstablished.bind(this));
+  this._hci.on('lePeriodicAdvertisingReport', this.onHciLePeriodicAdvertisingReport.bind(this));
+  this._hci.on('lePeriodicSyncLost', this.onHciLePeriodicSyncLost.bind(this));
+
+  if (options.scanProfile !== undefined) {
+    this.setScanProfile(options.scanProfile);
+  }
 };
 
 Object.setPrototypeOf(Gap.prototype, EventEmitter.prototype);
 
 Gap.prototype.setScanParameters = function (interval, window) {
+  // Kept for every later start, which sets them again
+  this._scanParameters = [interval, window];
   this._hci.setScanParameters(interval, window);
 };
 
+// Reports from devices not seen yet are dropped unless they match, before anything is parsed.
+// A device that matched once is handled as usual until it is evicted, so its scan responses
+// and later advertisements are merged even where they lack what the filter looks for.
+Gap.prototype.setScanFilter = function (filter) {
+  this._scanFilter = compileScanFilter(filter);
+};
+
+const acceptListEntry = function (device) {
+  const hex = device !== null && typeof device === 'object' && typeof device.address === 'string'
+    ? device.address.replace(/[:-]/g, '')
+    : '';
+  if (!/^[0-9a-f]{12}$/i.test(hex)) {
+    throw new Error(`Invalid accept list entry: address ${device && device.address} is not a BD_ADDR`);
+  }
+  const addressType = device.addressType !== undefined ? device.addressType : 'public';
+  if (addressType !== 'public' && addressType !== 'random') {
+    throw new Error('Invalid accept list entry: addressType must be public or random');
+  }
+  const value = parseInt(hex, 16);
+  return { value, address: addressString(value), addressType };
+};
+
+/**
+ * Scans only for the given devices ({ address, addressType }), or for everyone again with none.
+ * While they fit the controller's Filter Accept List, it is loaded with them and used as the
+ * scan filter policy, so other advertisers never reach the host. A larger list, or one the
+ * controller has no room for, is checked here on every report instead. A running scan is
+ * stopped while the controller's list changes and started again with the new policy.
+ * Resolves with { mode, size, capacity }, mode being 'controller', 'host' or 'off'.
+ */
+Gap.prototype.setAcceptList = async function (devices) {
+  const entries = [...new Map((devices || []).map(acceptListEntry).map(entry =>
+    [`${entry.addressType}/${entry.address}`, entry])).values()];
+
+  if (entries.length > 0 && this._acceptListCapacity === null) {
+    this._acceptListCapacity = await this._hci.readAcceptListSize();
+    debug(`filter accept list capacity ${this._acceptListCapacity}`);
+  }
+
+  let mode = ACCEPT_LIST_OFF;
+  if (entries.length > 0) {
+    mode = entries.length <= this._acceptListCapacity ? ACCEPT_LIST_CONTROLLER : ACCEPT_LIST_HOST;
+  }
+
+  try {
+    await this.applyAcceptList(mode, entries);
+  } catch (error) {
+    // Other users of the controller may hold part of its list
+    if (mode !== ACCEPT_LIST_CONTROLLER || error.status !== HCI_MEMORY_CAPACITY_EXCEEDED) {
+      throw error;
+    }
+    debug('filter accept list full, filtering on the host');
+    mode = ACCEPT_LIST_HOST;
+    await this.applyAcceptList(mode, entries);
+  }
+
+  return { mode, size: entries.length, capacity: this._acceptListCapacity };
+};
+
+Gap.prototype.applyAcceptList = function (mode, entries) {
+  const controllerChanges = mode === ACCEPT_LIST_CONTROLLER || this._acceptListMode === ACCEPT_LIST_CONTROLLER;
+  const scanning = this._scanState === 'starting' || this._scanState === 'started';
+
+  this._acceptListMode = mode;
+  this._hostAcceptList = mode === ACCEPT_LIST_HOST
+    ? new Map(entries.map(entry => [entry.value, entry.addressType]))
+    : null;
+
+  if (!controllerChanges) {
+    return Promise.resolve();
+  }
+
+  // The controller refuses to change a list in use, so scanning stops around it. Commands
+  // are sent in order, so nothing here needs to wait for the one before.
+  if (scanning) {
+    this._hci.setScanEnabled(false, true);
+  }
+  const loaded = this._hci.loadAcceptList(mode === ACCEPT_LIST_CONTROLLER ? entries : []);
+  this._hci.setScanFilterPolicy(mode === ACCEPT_LIST_CONTROLLER);
+  if (scanning) {
+    this._hci.setScanParameters(...this.scanParameters());
+    this.enableScanning();
+  }
+  return loaded;
+};
+
+/**
+ * Switches to a scan profile, given by name or in full, and returns its name. A running scan
+ * takes it at once: a new duplicate policy alone is applied without stopping the scan, and
+ * anything else with scanning disabled only while the controller takes the new parameters.
+ */
+Gap.prototype.setScanProfile = function (profile) {
+  const next = resolveScanProfile(profile, this._scanProfiles);
+  const previous = this._scanProfile !== null ? this._scanProfile : resolveScanProfile('default');
+  const previousParameters = this.scanParameters();
+  const previousRefresh = this.duplicatesRefresh();
+
+  this._scanProfile = next;
+  this._scanParameters = [next.interval, next.window];
+  this._scheduledWindow = null;
+  this._hci.setScanType(next.active);
+  this._hci.setScanPhys(next.phys);
+
+  if (this._scanState !== 'starting' && this._scanState !== 'started') {
+    return next.name;
+  }
+
+  const [interval = DEFAULT_SCAN_INTERVAL, window = DEFAULT_SCAN_WINDOW] = previousParameters;
+  const filterDuplicates = !(next.allowDuplicates !== undefined ? next.allowDuplicates : this._scanAllowDuplicates);
+
+  if (
+    next.active !== previous.active ||
+    next.phys.join() !== previous.phys.join() ||
+    next.interval !== interval ||
+    next.window !== window
+  ) {
+    this._scanFilterDuplicates = filterDuplicates;
+    this.restartScanning();
+  } else if (filterDuplicates !== this._scanFilterDuplicates || this.duplicatesRefresh() !== previousRefresh) {
+    // Enabling a running scan again changes only its duplicate filtering
+    this._scanFilterDuplicates = filterDuplicates;
+    this.enableScanning();
+  }
+
+  if (this._schedulerTimer !== null) {
+    this._scanScheduler.reset(this.scanDuty());
+  }
+  return next.name;
+};
+
+// The parameters scanning uses: as set, with the window the scheduler picked
+Gap.prototype.scanParameters = function () {
+  if (this._scheduledWindow === null) {
+    return this._scanParameters;
+  }
+  const [interval = DEFAULT_SCAN_INTERVAL] = this._scanParameters;
+  return [interval, this._scheduledWindow];
+};
+
+Gap.prototype.scanDuty = function () {
+  const [interval = DEFAULT_SCAN_INTERVAL, window = DEFAULT_SCAN_WINDOW] = this.scanParameters();
+  return Math.min(window / interval, 1);
+};
+
+Gap.prototype.duplicatesRefresh = function () {
+  const profile = this._scanProfile;
+  return profile !== null && profile.duplicatesRefresh !== undefined ? profile.duplicatesRefresh : this._duplicatesRefresh;
+};
+
+// Only an active scan sends scan requests, so only then can a scan response follow
+Gap.prototype.isScanActive = function () {
+  return this._scanProfile === null || this._scanProfile.active;
+};
+
 Gap.prototype.startScanning = function (allowDuplicates) {
+  const profile = this._scanProfile;
+
   this._scanState = 'starting';
-  this._scanFilterDuplicates = !allowDuplicates;
+  this._scanAllowDuplicates = Boolean(allowDuplicates);
+  this._scanFilterDuplicates = profile !== null && profile.allowDuplicates !== undefined
+    ? !profile.allowDuplicates
+    : !allowDuplicates;
+  this._scheduledWindow = null;
 
   // Always set scan parameters before scanning
   // https://www.bluetooth.org/docman/handlers/downloaddoc.ashx?doc_id=229737
   // p106 - p107
   this._hci.setScanEnabled(false, true);
-  this._hci.setScanParameters();
+  this._hci.setScanParameters(...this.scanParameters());
 
   if (isChip) {
     // work around for Next Thing Co. C.H.I.P, always allow duplicates, to get scan response
     this._scanFilterDuplicates = false;
   }
 
-  this._hci.setScanEnabled(true, this._scanFilterDuplicates);
+  this.enableScanning();
+};
+
+// Scanning takes new parameters only while disabled. Commands are sent in order, so it is off
+// only for as long as the controller takes to answer the three.
+Gap.prototype.restartScanning = function () {
+  this._hci.setScanEnabled(false, true);
+  this._hci.setScanParameters(...this.scanParameters());
+  this.enableScanning();
+
+  if (this._scanSince !== null) {
+    this.accountScanTime(true);
+  }
+};
+
+Gap.prototype.enableScanning = function () {
+  const duplicatesRefresh = this._scanFilterDuplicates ? this.duplicatesRefresh() : 0;
+
+  this.stopDuplicatesRefresh();
+  this._hci.setScanEnabled(true, this._scanFilterDuplicates, duplicatesRefresh);
+
+  // Controllers without the periodic reset empty their duplicate filter when scanning is
+  // enabled again
+  if (duplicatesRefresh > 0 && !this._hci.canRefreshScanDuplicates(duplicatesRefresh)) {
+    this._duplicatesRefreshTimer = setInterval(this.onDuplicatesRefreshTimer.bind(this), duplicatesRefresh);
+  }
+};
+
+Gap.prototype.onDuplicatesRefreshTimer = function () {
+  if (this._scanState !== 'started') {
+    return;
+  }
+
+  this._hci.refreshScanDuplicates();
+};
+
+Gap.prototype.stopDuplicatesRefresh = function () {
+  if (this._duplicatesRefreshTimer !== null) {
+    clearInterval(this._duplicatesRefreshTimer);
+    this._duplicatesRefreshTimer = null;
+  }
 };
 
 Gap.prototype.stopScanning = function () {
   this._scanState = 'stopping';
 
+  this.stopDuplicatesRefresh();
+  this.stopScanScheduler();
+  this._reportReassembly.clear();
   this._hci.setScanEnabled(false, true);
 };
 
+Gap.prototype.startScanScheduler = function () {
+  const period = this._scanScheduler.period;
+
+  this._scanScheduler.reset(this.scanDuty());
+  this._schedulerDue = Date.now() + period;
+  this._schedulerTimer = setTimeout(this.onScanSchedulerTimer.bind(this), period);
+};
+
+// How late the timer fires is how far the event loop runs behind.
+Gap.prototype.onScanSchedulerTimer = function () {
+  const now = Date.now();
+  const period = this._scanScheduler.period;
+  const lag = Math.max(now - this._schedulerDue, 0);
+  const duty = this._scanScheduler.update(period + lag, lag);
+
+  this._schedulerDue = now + period;
+  this._schedulerTimer = setTimeout(this.onScanSchedulerTimer.bind(this), period);
+
+  const [interval = DEFAULT_SCAN_INTERVAL, window = DEFAULT_SCAN_WINDOW] = this.scanParameters();
+  const scheduledWindow = Math.min(Math.max(Math.round(interval * duty), MIN_SCAN_WINDOW), interval);
+  if (scheduledWindow !== window) {
+    debug(`scan duty cycle ${duty} - window ${scheduledWindow}`);
+    this._scheduledWindow = scheduledWindow;
+    this.restartScanning();
+  }
+};
+
+Gap.prototype.stopScanScheduler = function () {
+  if (this._schedulerTimer !== null) {
+    clearTimeout(this._schedulerTimer);
+    this._schedulerTimer = null;
+  }
+};
+
+// Closes the running stretch of scan time, at the duty cycle it was scanned with.
+Gap.prototype.accountScanTime = function (scanning) {
+  const now = Date.now();
+
+  if (this._scanSince !== null) {
+    const elapsed = now - this._scanSince;
+    this._scanTime += elapsed;
+    this._scanOnTime += elapsed * this._scanSinceDuty;
+  }
+  this._scanSince = scanning ? now : null;
+  this._scanSinceDuty = this.scanDuty();
+};
+
+// scanOnTime is the part of scanTime the controller spent listening, by its duty cycle.
+Gap.prototype.getScanStats = function () {
+  if (this._scanSince !== null) {
+    this.accountScanTime(true);
+  }
+
+  return {
+    profile: this._scanProfile !== null ? this._scanProfile.name : null,
+    duty: this.scanDuty(),
+    scanTime: this._scanTime,
+    scanOnTime: Math.round(this._scanOnTime)
+  };
+};
+
+/**
+ * Synchronizes with the periodic advertising of a discovered extended advertiser, by its
+ * peripheral id. Scanning has to run until the sync is established: the controller finds
+ * the train through the advertiser's extended advertisements. Answers with
+ * periodicSyncEstablished, after which the advertiser's periodic data is reported as
+ * periodicAdvertisingReport events until periodicSyncLost. At most maxPeriodicSyncs are
+ * kept or waiting at once.
+ */
+Gap.prototype.createPeriodicSync = function (id, options = {}) {
+  const fail = message => this.emit('periodicSyncEstablished', id, new Error(message));
+
+  if (this._periodicSyncs.has(id)) {
+    fail(`Periodic sync with ${id} already exists`);
+    return;
+  }
+  if (this._periodicSyncs.size >= this._maxPeriodicSyncs) {
+    fail(`Periodic sync with ${id} refused: ${this._maxPeriodicSyncs} periodic syncs already exist`);
+    return;
+  }
+
+  const address = /^[0-9a-f]{12}$/i.test(id) ? parseInt(id, 16) : undefined;
+  const discovery = address !== undefined ? this._discoveries.get(address) : undefined;
+  if (discovery === undefined) {
+    fail(`Periodic sync with ${id} refused: the advertiser has not been discovered`);
+    return;
+  }
+  const sid = options.sid !== undefined ? options.sid : discovery.sid;
+  if (sid === undefined) {
+    fail(`Periodic sync with ${id} refused: the advertiser has no periodic advertising`);
+    return;
+  }
+
+  const sync = {
+    id,
+    address,
+    addressType: discovery.addressType,
+    sid,
+    skip: options.skip > 0 ? options.skip : 0,
+    timeout: options.timeout > 0 ? options.timeout : DEFAULT_PERIODIC_SYNC_TIMEOUT,
+    establishTimeout: options.establishTimeout > 0 ? options.establishTimeout : DEFAULT_PERIODIC_SYNC_ESTABLISH_TIMEOUT,
+    handle: null,
+    error: null // why a pending sync was cancelled
+  };
+  this._periodicSyncs.set(id, sync);
+  this._periodicSyncQueue.push(sync);
+  this.createNextPeriodicSync();
+};
+
+Gap.prototype.createNextPeriodicSync = function () {
+  if (this._pendingPeriodicSync !== null || this._periodicSyncQueue.length === 0) {
+    return;
+  }
+
+  const sync = this._periodicSyncQueue.shift();
+  this._pendingPeriodicSync = sync;
+  this._periodicSyncTimer = setTimeout(this.onPeriodicSyncTimer.bind(this), sync.establishTimeout);
+  this._hci.createPeriodicSync(sync.address, sync.addressType, sync.sid, sync.skip, sync.timeout);
+};
+
+// The train was not found in time; cancelling makes the controller report the sync as failed.
+Gap.prototype.onPeriodicSyncTimer = function () {
+  this._periodicSyncTimer = null;
+  this.cancelPendingPeriodicSync(new Error(`Periodic sync with ${this._pendingPeriodicSync.id} timed out`));
+};
+
+Gap.prototype.cancelPendingPeriodicSync = function (error) {
+  const sync = this._pendingPeriodicSync;
+  if (sync.error === null) {
+    sync.error = error;
+    this._hci.cancelPeriodicSync();
+  }
+};
+
+Gap.prototype.terminatePeriodicSync = function (id) {
+  const sync = this._periodicSyncs.get(id);
+  if (sync === undefined) {
+    return;
+  }
+
+  if (sync === this._pendingPeriodicSync) {
+    // Reported once the controller has given up on it
+    this.cancelPendingPeriodicSync(new Error(`Periodic sync with ${id} was terminated before it was established`));
+    return;
+  }
+
+  this._periodicSyncs.delete(id);
+  if (sync.handle === null) {
+    this._periodicSyncQueue.splice(this._periodicSyncQueue.indexOf(sync), 1);
+    this.emit('periodicSyncEstablished', id, new Error(`Periodic sync with ${id} was terminated before it was established`));
+    return;
+  }
+
+  this._periodicSyncHandles.delete(sync.handle);
+  this._periodicReassembly.drop(sync.handle);
+  this._hci.terminatePeriodicSync(sync.handle);
+  this.emit('periodicSyncLost', id, 'terminated');
+};
+
+Gap.prototype.terminatePeriodicSyncs = function () {
+  for (const id of [...this._periodicSyncs.keys()]) {
+    this.terminatePeriodicSync(id);
+  }
+};
+
+// For when the controller has dropped every sync by itself: reason is reported as the cause.
+Gap.prototype.dropPeriodicSyncs = function (reason) {
+  const syncs = [...this._periodicSyncs.values()];
+
+  this._periodicSyncs.clear();
+  this._periodicSyncHandles.clear();
+  this._periodicSyncQueue = [];
+  this._pendingPeriodicSync = null;
+  this._periodicReassembly.clear();
+  if (this._periodicSyncTimer !== null) {
+    clearTimeout(this._periodicSyncTimer);
+    this._periodicSyncTimer = null;
+  }
+
+  for (const sync of syncs) {
+    if (sync.handle !== null) {
+      this.emit('periodicSyncLost', sync.id, reason);
+    } else {
+      this.emit('periodicSyncEstablished', sync.id, new Error(`Periodic sync with ${sync.id} failed: ${reason}`));
+    }
+  }
+};
+
+Gap.prototype.onHciLePeriodicSyncEstablished = function (status, handle, address, addressType, sid, phy, interval) {
+  const sync = this._pendingPeriodicSync;
+  if (sync === null || sync.address !== address || sync.sid !== sid) {
+    return;
+  }
+
+  this._pendingPeriodicSync = null;
+  if (this._periodicSyncTimer !== null) {
+    clearTimeout(this._periodicSyncTimer);
+    this._periodicSyncTimer = null;
+  }
+
+  if (status === HCI_SUCCESS && sync.error !== null) {
+    // Established just as it was cancelled
+    this._hci.terminatePeriodicSync(handle);
+  }
+  if (status !== HCI_SUCCESS || sync.error !== null) {
+    this._periodicSyncs.delete(sync.id);
+    let error = sync.error;
+    if (error === null) {
+      error = new Error(`Periodic sync with ${sync.id} failed (status 0x${status.toString(16).padStart(2, '0')})`);
+      error.status = status;
+    }
+    this.emit('periodicSyncEstablished', sync.id, error);
+  } else {
+    debug(`periodic sync ${handle} with ${sync.id} established`);
+    sync.handle = handle;
+    this._periodicSyncHandles.set(handle, sync);
+    this.emit('periodicSyncEstablished', sync.id, null, { sid, phy, interval });
+  }
+
+  this.createNextPeriodicSync();
+};
+
+// Data status is 0 for complete, 1 for more to come and 2 for truncated: the extended report
+// data status, shifted down five bits.
+Gap.prototype.onHciLePeriodicAdvertisingReport = function (handle, txPower, rssi, dataStatus, data) {
+  const sync = this._periodicSyncHandles.get(handle);
+  if (sync === undefined) {
+    return;
+  }
+
+  data = this._periodicReassembly.push(handle, dataStatus << 5, data);
+  if (data === null) {
+    return;
+  }
+  const truncated = this._periodicReassembly.truncated;
+
+  // Handed on as it is, so copied out of the socket's buffer
+  this.emit('periodicAdvertisingReport', sync.id, Buffer.from(data), rssi, txPower, truncated);
+};
+
+Gap.prototype.onHciLePeriodicSyncLost = function (handle) {
+  const sync = this._periodicSyncHandles.get(handle);
+  if (sync === undefined) {
+    return;
+  }
+
+  debug(`periodic sync ${handle} with ${sync.id} lost`);
+  this._periodicSyncHandles.delete(handle);
+  this._periodicSyncs.delete(sync.id);
+  this._periodicReassembly.drop(handle);
+  this.emit('periodicSyncLost', sync.id, 'timeout');
+};
+
+// A device dropped from the table is reported as new when it is heard again.
+Gap.prototype.onDiscoveryEvict = function (address, discovery, reason) {
+  debug(`discovery ${discovery.address} evicted (${reason})`);
+
+  this._heldDiscoveries.delete(address);
+
+  this.emit('discoveryEvict', discovery.address, discovery.id, reason);
+};
+
+Gap.prototype.getDiscoveryCacheStats = function () {
+  return {
+    size: this._discoveries.size,
+    maxSize: this._discoveries.maxSize,
+    ttl: this._discoveries.ttl,
+    evictions: this._discoveries.evictions,
+    expirations: this._discoveries.expirations
+  };
+};
+
+Gap.prototype.getReportReassemblyStats = function () {
+  return {
+    pending: this._reportReassembly.size,
+    joined: this._reportReassembly.joined,
+    dropped: this._reportReassembly.dropped
+  };
+};
+
+Gap.prototype.getScanFilterStats = function () {
+  return {
+    rejected: this._scanFilterRejected,
+    acceptListRejected: this._acceptListRejected
+  };
+};
+
 Gap.prototype.onHciError = function (error) {
   console.warn(error); // TODO: Better error handling
 };
@@ -83,10 +667,17 @@ Gap.prototype.onHciLeScanEnableSet = function (status) {
   if (this._scanState === 'starting') {
     this._scanState = 'started';
 
+    this.accountScanTime(true);
+    if (this._scanScheduler !== null && this._schedulerTimer === null) {
+      this.startScanScheduler();
+    }
     this.emit('scanStart', this._scanFilterDuplicates);
   } else if (this._scanState === 'stopping') {
     this._scanState = 'stopped';
 
+    this.accountScanTime(false);
+    this.stopScanScheduler();
+    this.releaseHeldDiscoveries(Infinity);
     this.emit('scanStop');
   }
 };
@@ -114,6 +705,12 @@ Gap.prototype.onLeScanEnableSetCmd = function (enable, filterDuplicates) {
   }
 };
 
+// With duplicates allowed, most reports repeat the last one of their type byte for byte.
+// Those only refresh the RSSI; the advertisement stays as it was parsed.
+const isSameEir = function (previousEir, eir) {
+  return previousEir !== undefined && previousEir.length === eir.length && previousEir.equals(eir);
+};
+
 Gap.prototype.onHciLeAdvertisingReport = function (
   status,
   type,
@@ -122,64 +719,83 @@ Gap.prototype.onHciLeAdvertisingReport = function (
   eir,
   rssi
 ) {
-  const previouslyDiscovered = !!this._discoveries[address];
+  if (this._hostAcceptList !== null && this._hostAcceptList.get(address) !== addressType) {
+    this._acceptListRejected++;
+    return;
+  }
 
-  let discoveryCount = previouslyDiscovered
-    ? this._discoveries[address].count
-    : 0;
-  let hasScanResponse = previouslyDiscovered
-    ? this._discoveries[address].hasScanResponse
-    : false;
+  const previous = this._discoveries.get(address);
+  const previouslyDiscovered = previous !== undefined;
 
-  if (type === LE_META_EVENT_TYPE_SCAN_RESPONSE) {
-    hasScanResponse = true;
+  if (!previouslyDiscovered && this._scanFilter !== null && !this._scanFilter(eir, address, addressType, rssi)) {
+    this._scanFilterRejected++;
+    return;
   }
 
-  discoveryCount++;
+  if (this._scanScheduler !== null) {
+    this._scanScheduler.onReport(!previouslyDiscovered);
+  }
 
-  const advertisement = this.parseServices(
-    address,
-    eir,
-    previouslyDiscovered,
-    type
-  );
+  const changed = !previouslyDiscovered || !isSameEir(previous.eirs[type], eir);
+
+  const advertisement = changed
+    ? this.parseServices(previous, eir, type)
+    : previous.advertisement;
 
-  if (process.env.DEBUG === 'gap') {
+  if (changed && process.env.DEBUG === 'gap') {
     debug(`advertisement = ${JSON.stringify(advertisement, null, 0)}`);
   }
 
   const connectable =
     type === LE_META_EVENT_TYPE_SCAN_RESPONSE && previouslyDiscovered
-      ? this._discoveries[address].connectable
+      ? previous.connectable
       : type !== LE_META_EVENT_TYPE_CONNECTABLE;
   const scannable = type === LE_META_EVENT_TYPE_SCANNABLE;
 
-  this._discoveries[address] = {
+  const discovery = this.updateDiscovery(
+    previous,
     address,
     addressType,
     connectable,
     advertisement,
     rssi,
-    count: discoveryCount,
-    hasScanResponse
-  };
+    type === LE_META_EVENT_TYPE_SCAN_RESPONSE
+  );
+  if (changed) {
+    discovery.eirs[type] = Buffer.from(eir);
+  }
+
+  if (this._scanResponseWindow > 0) {
+    this.combineDiscovery(
+      status,
+      address,
+      discovery,
+      scannable,
+      changed,
+      type === LE_META_EVENT_TYPE_SCAN_RESPONSE,
+      this.isScanActive() && (type === LE_META_EVENT_TYPE_ADV_IND || type === LE_META_EVENT_TYPE_ADV_SCAN_IND)
+    );
+    return;
+  }
 
   // only report after a scan response event or if non-connectable or more than one discovery without a scan response, so more data can be collected
   if (
     type === LE_META_EVENT_TYPE_SCAN_RESPONSE ||
     !connectable ||
-    (discoveryCount > 1 && !hasScanResponse) ||
+    (discovery.count > 1 && !discovery.hasScanResponse) ||
     process.env.NOBLE_REPORT_ALL_HCI_EVENTS
   ) {
     this.emit(
       'discover',
       status,
-      address,
+      discovery.address,
       addressType,
       connectable,
       advertisement,
       rssi,
-      scannable
+      scannable,
+      discovery.id,
+      changed
     );
   }
 };
@@ -191,82 +807,241 @@ Gap.prototype.onHciLeExtendedAdvertisingReport = function (
   addressType,
   txpower,
   rssi,
-  eir
+  eir,
+  sid,
+  periodicInterval
 ) {
-  const previouslyDiscovered = !!this._discoveries[address];
+  if (this._hostAcceptList !== null && this._hostAcceptList.get(address) !== addressType) {
+    this._acceptListRejected++;
+    return;
+  }
+
+  eir = this._reportReassembly.push(ReportReassembly.key(address, sid), type, eir);
+  if (eir === null) {
+    return;
+  }
+  const truncated = this._reportReassembly.truncated;
+  type &= ~LE_META_EXTENDED_EVENT_TYPE_DATA_STATUS_MASK;
 
-  let discoveryCount = previouslyDiscovered
-    ? this._discoveries[address].count
-    : 0;
-  let hasScanResponse = previouslyDiscovered
-    ? this._discoveries[address].hasScanResponse
-    : false;
+  const previous = this._discoveries.get(address);
+  const previouslyDiscovered = previous !== undefined;
+
+  if (!previouslyDiscovered && this._scanFilter !== null && !this._scanFilter(eir, address, addressType, rssi)) {
+    this._scanFilterRejected++;
+    return;
+  }
 
-  if (type & LE_META_EXTENDED_EVENT_TYPE_SCAN_RESPONSE_MASK) {
-    hasScanResponse = true;
+  if (this._scanScheduler !== null) {
+    this._scanScheduler.onReport(!previouslyDiscovered);
   }
 
-  discoveryCount++;
+  const changed = !previouslyDiscovered || !isSameEir(previous.eirs[type], eir);
 
-  const advertisement = this.parseServices(
-    address,
-    eir,
-    previouslyDiscovered,
-    type,
-    txpower
-  );
+  const advertisement = changed
+    ? this.parseServices(previous, eir, type, txpower)
+    : previous.advertisement;
+
+  // Only set where data was ever cut short, so other advertisements keep their shape
+  if (changed && (truncated || advertisement.truncated)) {
+    advertisement.truncated = truncated;
+  }
 
-  if (process.env.DEBUG === 'gap') {
+  if (changed && process.env.DEBUG === 'gap') {
     debug(`advertisement = ${JSON.stringify(advertisement, null, 0)}`);
   }
 
   const connectable =
     type & 0x8 && previouslyDiscovered
-      ? this._discoveries[address].connectable
+      ? previous.connectable
       : type & LE_META_EXTENDED_EVENT_TYPE_CONNECTABLE_MASK;
   const scannable = type & LE_META_EXTENDED_EVENT_TYPE_SCANNABLE_MASK ? 1 : 0;
-  const incomplete = type & LE_META_EXTENDED_EVENT_TYPE_INCOMPLETE_MASK ? 1 : 0;
 
-  this._discoveries[address] = {
+  const discovery = this.updateDiscovery(
+    previous,
     address,
     addressType,
     connectable,
     advertisement,
     rssi,
-    count: discoveryCount,
-    hasScanResponse
-  };
+    Boolean(type & LE_META_EXTENDED_EVENT_TYPE_SCAN_RESPONSE_MASK)
+  );
+  if (changed) {
+    discovery.eirs[type] = Buffer.from(eir);
+  }
+  // What a periodic sync with the advertiser needs, from the reports that carry it
+  if (periodicInterval > 0 && sid !== SID_NONE) {
+    discovery.sid = sid;
+    discovery.periodicInterval = periodicInterval;
+  }
+
+  if (this._scanResponseWindow > 0) {
+    const isScanResponse = Boolean(type & LE_META_EXTENDED_EVENT_TYPE_SCAN_RESPONSE_MASK);
+    this.combineDiscovery(
+      status,
+      address,
+      discovery,
+      scannable,
+      changed,
+      isScanResponse,
+      this.isScanActive() && Boolean(scannable) && !isScanResponse
+    );
+    return;
+  }
 
   // only report after a scan response event or if non-connectable or more than one discovery without a scan response, so more data can be collected
   if (
     type & LE_META_EXTENDED_EVENT_TYPE_SCAN_RESPONSE_MASK ||
-    (!connectable && !incomplete) ||
-    (discoveryCount > 1 && !hasScanResponse) ||
+    !connectable ||
+    (discovery.count > 1 && !discovery.hasScanResponse) ||
     process.env.NOBLE_REPORT_ALL_HCI_EVENTS
   ) {
     this.emit(
       'discover',
       status,
-      address,
+      discovery.address,
       addressType,
       connectable,
       advertisement,
       rssi,
-      scannable
+      scannable,
+      discovery.id,
+      changed
     );
   }
 };
 
-Gap.prototype.parseServices = function (
+// A report that may be followed by more for the same advertisement is held, unless one is
+// held already. A scan response, or any report that completes the advertisement, reports
+// the held one with everything merged into it; the window ending reports it as it is.
+Gap.prototype.combineDiscovery = function (
+  status,
+  address,
+  discovery,
+  scannable,
+  changed,
+  isScanResponse,
+  isFollowed
+) {
+  const held = this._heldDiscoveries.get(address);
+
+  if (held !== undefined) {
+    held.status = status;
+    held.scannable = held.scannable || scannable;
+    held.changed = held.changed || changed;
+
+    if (isScanResponse || !isFollowed) {
+      this._heldDiscoveries.delete(address);
+      this.emitDiscover(held.status, held.discovery, held.scannable, held.changed);
+    }
+    return;
+  }
+
+  if (isFollowed && !isScanResponse) {
+    this._heldDiscoveries.set(address, {
+      status,
+      discovery,
+      scannable,
+      changed,
+      due: Date.now() + this._scanResponseWindow
+    });
+    if (this._heldTimer === null) {
+      this._heldTimer = setTimeout(this.onHeldTimer.bind(this), this._scanResponseWindow);
+    }
+    return;
+  }
+
+  this.emitDiscover(status, discovery, scannable, changed);
+};
+
+Gap.prototype.onHeldTimer = function () {
+  this._heldTimer = null;
+  this.releaseHeldDiscoveries(Date.now());
+
+  // Every hold lasts the same window, so the first one left is the next one due
+  const next = this._heldDiscoveries.values().next();
+  if (!next.done) {
+    this._heldTimer = setTimeout(this.onHeldTimer.bind(this), Math.max(next.value.due - Date.now(), 0));
+  }
+};
+
+Gap.prototype.releaseHeldDiscoveries = function (now) {
+  for (const [address, held] of this._heldDiscoveries) {
+    if (held.due > now) {
+      break;
+    }
+    this._heldDiscoveries.delete(address);
+    this.emitDiscover(held.status, held.discovery, held.scannable, held.changed);
+  }
+
+  if (this._heldDiscoveries.size === 0 && this._heldTimer !== null) {
+    clearTimeout(this._heldTimer);
+    this._heldTimer = null;
+  }
+};
+
+Gap.prototype.emitDiscover = function (status, discovery, scannable, changed) {
+  this.emit(
+    'discover',
+    status,
+    discovery.address,
+    discovery.addressType,
+    discovery.connectable,
+    discovery.advertisement,
+    discovery.rssi,
+    scannable,
+    discovery.id,
+    changed
+  );
+};
+
+// Updates a known device's entry in place, or makes one for a new device. Its address
+// strings are made once, when the device is first seen, rather than for every report.
+Gap.prototype.updateDiscovery = function (
+  previous,
   address,
+  addressType,
+  connectable,
+  advertisement,
+  rssi,
+  isScanResponse
+) {
+  let discovery = previous;
+
+  if (discovery !== undefined) {
+    discovery.addressType = addressType;
+    discovery.connectable = connectable;
+    discovery.advertisement = advertisement;
+    discovery.rssi = rssi;
+    discovery.count++;
+    discovery.hasScanResponse = discovery.hasScanResponse || isScanResponse;
+  } else {
+    discovery = {
+      address: addressString(address),
+      id: addressString(address, ''),
+      addressType,
+      connectable,
+      advertisement,
+      rssi,
+      count: 1,
+      hasScanResponse: isScanResponse,
+      eirs: {} // by report type, a copy of the last eir parsed
+    };
+  }
+
+  // Moves it to the back of the eviction order
+  this._discoveries.set(address, discovery);
+  return discovery;
+};
+
+Gap.prototype.parseServices = function (
+  previous,
   eir,
-  previouslyDiscovered,
   leMetaEventType,
   txpower
 ) {
   let i = 0;
-  const advertisement = previouslyDiscovered
-    ? this._discoveries[address].advertisement
+  const advertisement = previous !== undefined
+    ? previous.advertisement
     : {
         localName: undefined,
         txPowerLevel: txpower,
@@ -307,12 +1082,7 @@ Gap.prototype.parseServices = function (
       case 0x06: // Incomplete List of 128-bit Service Class UUIDs
       case 0x07: // Complete List of 128-bit Service Class UUIDs
         for (let j = 0; j < bytes.length - 15; j += 16) {
-          const serviceUuid = bytes
-            .slice(j, j + 16)
-            .toString('hex')
-            .match(/.{1,2}/g)
-            .reverse()
-            .join('');
+          const serviceUuid = uuidAt(bytes, j, 16);
           if (advertisement.serviceUuids.indexOf(serviceUuid) === -1) {
             advertisement.serviceUuids.push(serviceUuid);
           }
@@ -345,12 +1115,7 @@ Gap.prototype.parseServices = function (
 
       case 0x15: // List of 128 bit solicitation UUIDs
         for (let j = 0; j < bytes.length - 15; j += 16) {
-          const serviceSolicitationUuid = bytes
-            .slice(j, j + 16)
-            .toString('hex')
-            .match(/.{1,2}/g)
-            .reverse()
-            .join('');
+          const serviceSolicitationUuid = uuidAt(bytes, j, 16);
           if (
             advertisement.serviceSolicitationUuids.indexOf(
               serviceSolicitationUuid
@@ -383,12 +1148,7 @@ Gap.prototype.parseServices = function (
             break;
           }
 
-          const serviceUuid = bytes
-            .slice(0, uuidLength)
-            .toString('hex')
-            .match(/.{1,2}/g)
-            .reverse()
-            .join('');
+          const serviceUuid = uuidAt(bytes, 0, uuidLength);
 
           // Find existing service data index
           const existingIndex = advertisement.serviceData.findIndex(
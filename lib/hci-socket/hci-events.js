@@ -0,0 +1,110 @@
+// Views over received HCI event buffers. A view holds the buffer and an offset, and each
+// field is decoded when it is read, so fields nobody asks for are never decoded or copied.
+
+const HEX = Array.from({ length: 256 }, (_, octet) => octet.toString(16).padStart(2, '0'));
+
+// A BD_ADDR is sent least significant octet first; its string form is the other way round.
+const addressAt = function (buffer, offset) {
+  return HEX[buffer[offset + 5]] + ':' +
+    HEX[buffer[offset + 4]] + ':' +
+    HEX[buffer[offset + 3]] + ':' +
+    HEX[buffer[offset + 2]] + ':' +
+    HEX[buffer[offset + 1]] + ':' +
+    HEX[buffer[offset]];
+};
+
+// The same BD_ADDR as a 48-bit integer. Numbers up to 2^53 are exact, so it is a cheap Map key;
+// addressString() makes the string form only where one is needed.
+const addressValueAt = function (buffer, offset) {
+  return buffer.readUIntLE(offset, 6);
+};
+
+const addressString = function (value, separator = ':') {
+  const high = Math.floor(value / 0x100000000);
+  const low = value >>> 0;
+  return HEX[high >>> 8] + separator +
+    HEX[high & 0xff] + separator +
+    HEX[low >>> 24] + separator +
+    HEX[(low >>> 16) & 0xff] + separator +
+    HEX[(low >>> 8) & 0xff] + separator +
+    HEX[low & 0xff];
+};
+
+// UUIDs in EIR data are little endian too: the hex form of length octets, last octet first.
+const uuidAt = function (buffer, offset, length) {
+  let uuid = '';
+  for (let i = offset + length - 1; i >= offset; i--) {
+    uuid += HEX[buffer[i]];
+  }
+  return uuid;
+};
+
+const addressTypeAt = function (buffer, offset) {
+  return buffer[offset] === 0x01 ? 'random' : 'public';
+};
+
+// One report of an LE Advertising Report subevent; offset is where the report starts.
+const AdvertisingReport = function (buffer, offset) {
+  this.buffer = buffer;
+  this.offset = offset;
+};
+
+AdvertisingReport.HEADER_LENGTH = 9;
+
+Object.defineProperties(AdvertisingReport.prototype, {
+  type: { get () { return this.buffer[this.offset]; } },
+  addressType: { get () { return addressTypeAt(this.buffer, this.offset + 1); } },
+  address: { get () { return addressAt(this.buffer, this.offset + 2); } },
+  addressValue: { get () { return addressValueAt(this.buffer, this.offset + 2); } },
+  eirLength: { get () { return this.buffer[this.offset + 8]; } },
+  eir: { get () { return this.buffer.subarray(this.offset + 9, this.offset + 9 + this.eirLength); } },
+  rssi: { get () { return this.buffer.readInt8(this.offset + 9 + this.eirLength); } },
+  // Octets taken by this report, trailing rssi included
+  length: { get () { return AdvertisingReport.HEADER_LENGTH + this.eirLength + 1; } }
+});
+
+AdvertisingReport.prototype.isComplete = function () {
+  const remaining = this.buffer.length - this.offset;
+  return remaining > AdvertisingReport.HEADER_LENGTH && remaining >= this.length;
+};
+
+// One report of an LE Extended Advertising Report subevent.
+const ExtendedAdvertisingReport = function (buffer, offset) {
+  this.buffer = buffer;
+  this.offset = offset;
+};
+
+ExtendedAdvertisingReport.HEADER_LENGTH = 24;
+
+Object.defineProperties(ExtendedAdvertisingReport.prototype, {
+  type: { get () { return this.buffer.readUInt16LE(this.offset); } },
+  addressType: { get () { return addressTypeAt(this.buffer, this.offset + 2); } },
+  address: { get () { return addressAt(this.buffer, this.offset + 3); } },
+  addressValue: { get () { return addressValueAt(this.buffer, this.offset + 3); } },
+  primaryPhy: { get () { return this.buffer[this.offset + 9]; } },
+  secondaryPhy: { get () { return this.buffer[this.offset + 10]; } },
+  sid: { get () { return this.buffer[this.offset + 11]; } },
+  txPower: { get () { return this.buffer[this.offset + 12]; } },
+  rssi: { get () { return this.buffer.readInt8(this.offset + 13); } },
+  periodicAdvInterval: { get () { return this.buffer.readUInt16LE(this.offset + 14); } },
+  directAddressType: { get () { return addressTypeAt(this.buffer, this.offset + 16); } },
+  directAddress: { get () { return addressAt(this.buffer, this.offset + 17); } },
+  eirLength: { get () { return this.buffer[this.offset + 23]; } },
+  eir: {
+    get () {
+      const start = this.offset + ExtendedAdvertisingReport.HEADER_LENGTH;
+      return this.buffer.subarray(start, start + this.eirLength);
+    }
+  },
+  length: { get () { return ExtendedAdvertisingReport.HEADER_LENGTH + this.eirLength; } }
+});
+
+module.exports = {
+  addressAt,
+  addressValueAt,
+  addressString,
+  addressTypeAt,
+  uuidAt,
+  AdvertisingReport,
+  ExtendedAdvertisingReport
+};
@@ -4,6 +4,10 @@ const { EventEmitter } = require('events');
 
 const { loadDriver } = require('@stoprocent/bluetooth-hci-socket');
 const vendorSpecific = require('./vs');
+const Btsnoop = require('./btsnoop');
+const AclScheduler = require('./acl-scheduler');
+const CapabilityCache = require('./capability-cache');
+const { addressAt, AdvertisingReport, ExtendedAdvertisingReport } = require('./hci-events');
 
 const HCI_COMMAND_PKT = 0x01;
 const HCI_ACLDATA_PKT = 0x02;
@@ -24,9 +28,23 @@ const EVT_LE_CONN_COMPLETE = 0x01;
 const EVT_LE_ADVERTISING_REPORT = 0x02;
 const EVT_LE_ENHANCED_CONN_COMPLETE = 0x0a;
 const EVT_LE_EXTENDED_ADVERTISING_REPORT = 0x0d;
+const EVT_LE_PERIODIC_SYNC_ESTABLISHED = 0x0e;
+const EVT_LE_PERIODIC_ADVERTISING_REPORT = 0x0f;
+const EVT_LE_PERIODIC_SYNC_LOST = 0x10;
 const EVT_LE_CONN_UPDATE_COMPLETE = 0x03;
 const EVT_LE_DATA_LENGTH_CHANGE = 0x07;
 
+// LE event mask bits (subevent code - 1), grouped by what needs them. Connection Complete
+// stays on so an attempt can always finish; the other groups follow scanning, connections
+// and periodic syncs.
+const LE_EVENTS_BASE = 0x0001; // Connection Complete
+const LE_EVENTS_BASE_EXTENDED = 0x0300; // Generate DHKey Complete, Enhanced Connection Complete
+const LE_EVENTS_SCAN = 0x0002; // Advertising Report
+const LE_EVENTS_SCAN_EXTENDED = 0x1400; // Directed and Extended Advertising Reports
+const LE_EVENTS_PERIODIC = 0xe000; // Periodic Sync Established, Periodic Advertising Report, Periodic Sync Lost
+const LE_EVENTS_LINK = 0x005c; // Connection Update, Remote Features, LTK Request, Data Length Change
+const LE_EVENTS_LINK_EXTENDED = 0x0800; // PHY Update
+
 const OGF_LINK_CTL = 0x01;
 const OCF_DISCONNECT = 0x0006;
 
@@ -55,10 +73,17 @@ const OCF_LE_SET_EXTENDED_SCAN_ENABLE = 0x0042;
 const OCF_LE_SET_DATA_LENGTH = 0x0022;
 const OCF_LE_READ_MAX_DATA_LENGTH = 0x002f;
 const OCF_LE_SET_SCAN_PARAMETERS = 0x000b;
+const OCF_LE_READ_FILTER_ACCEPT_LIST_SIZE = 0x000f;
+const OCF_LE_CLEAR_FILTER_ACCEPT_LIST = 0x0010;
+const OCF_LE_ADD_DEVICE_TO_FILTER_ACCEPT_LIST = 0x0011;
+const OCF_LE_REMOVE_DEVICE_FROM_FILTER_ACCEPT_LIST = 0x0012;
 const OCF_LE_SET_SCAN_ENABLE = 0x000c;
 const OCF_LE_CREATE_CONN = 0x000d;
 const OCF_LE_CREATE_EXTENDED_CONN = 0x0043;
 const OCF_LE_CANCEL_CONN = 0x000e;
+const OCF_LE_PERIODIC_ADVERTISING_CREATE_SYNC = 0x0044;
+const OCF_LE_PERIODIC_ADVERTISING_CREATE_SYNC_CANCEL = 0x0045;
+const OCF_LE_PERIODIC_ADVERTISING_TERMINATE_SYNC = 0x0046;
 const OCF_LE_CONN_UPDATE = 0x0013;
 const OCF_LE_START_ENCRYPTION = 0x0019;
 const DISCONNECT_CMD = OCF_DISCONNECT | (OGF_LINK_CTL << 10);
@@ -90,11 +115,25 @@ const LE_SET_EXTENDED_SCAN_ENABLE_CMD =
 const LE_SET_SCAN_PARAMETERS_CMD =
   OCF_LE_SET_SCAN_PARAMETERS | (OGF_LE_CTL << 10);
 const LE_SET_SCAN_ENABLE_CMD = OCF_LE_SET_SCAN_ENABLE | (OGF_LE_CTL << 10);
+const LE_READ_FILTER_ACCEPT_LIST_SIZE_CMD =
+  OCF_LE_READ_FILTER_ACCEPT_LIST_SIZE | (OGF_LE_CTL << 10);
+const LE_CLEAR_FILTER_ACCEPT_LIST_CMD =
+  OCF_LE_CLEAR_FILTER_ACCEPT_LIST | (OGF_LE_CTL << 10);
+const LE_ADD_DEVICE_TO_FILTER_ACCEPT_LIST_CMD =
+  OCF_LE_ADD_DEVICE_TO_FILTER_ACCEPT_LIST | (OGF_LE_CTL << 10);
+const LE_REMOVE_DEVICE_FROM_FILTER_ACCEPT_LIST_CMD =
+  OCF_LE_REMOVE_DEVICE_FROM_FILTER_ACCEPT_LIST | (OGF_LE_CTL << 10);
 const LE_CREATE_CONN_CMD = OCF_LE_CREATE_CONN | (OGF_LE_CTL << 10);
 const LE_CREATE_EXTENDED_CONN_CMD =
   OCF_LE_CREATE_EXTENDED_CONN | (OGF_LE_CTL << 10);
 const LE_CONN_UPDATE_CMD = OCF_LE_CONN_UPDATE | (OGF_LE_CTL << 10);
 const LE_CANCEL_CONN_CMD = OCF_LE_CANCEL_CONN | (OGF_LE_CTL << 10);
+const LE_PERIODIC_ADVERTISING_CREATE_SYNC_CMD =
+  OCF_LE_PERIODIC_ADVERTISING_CREATE_SYNC | (OGF_LE_CTL << 10);
+const LE_PERIODIC_ADVERTISING_CREATE_SYNC_CANCEL_CMD =
+  OCF_LE_PERIODIC_ADVERTISING_CREATE_SYNC_CANCEL | (OGF_LE_CTL << 10);
+const LE_PERIODIC_ADVERTISING_TERMINATE_SYNC_CMD =
+  OCF_LE_PERIODIC_ADVERTISING_TERMINATE_SYNC | (OGF_LE_CTL << 10);
 const LE_START_ENCRYPTION_CMD = OCF_LE_START_ENCRYPTION | (OGF_LE_CTL << 10);
 
 // Core Spec Vol 6 Part B 2.4: every LE controller supports at least a 27 octet payload
@@ -107,13 +146,157 @@ const LE_MIN_TX_TIME = 0x0148;
 const LE_MAX_TX_TIME = 0x4290;
 const HCI_OE_USER_ENDED_CONNECTION = 0x13;
 
+// LE Set Extended Scan Enable: Filter_Duplicates 0x02 resets the filter every Period, in
+// units of 1.28 s, of which the controller scans for Duration, in units of 10 ms.
+const SCAN_DUPLICATES_RESET_EACH_PERIOD = 0x02;
+const SCAN_PERIOD_UNIT = 1280; // ms
+const SCAN_DURATION_UNIT = 10; // ms
+
+// Scanning filter policy: every advertiser, or only those on the Filter Accept List
+const SCAN_FILTER_POLICY_ALL = 0x00;
+const SCAN_FILTER_POLICY_ACCEPT_LIST = 0x01;
+
+// LE Periodic Advertising Create Sync: Skip is in periodic advertising events, Sync_Timeout
+// in units of 10 ms
+const PERIODIC_SYNC_MAX_SKIP = 0x01f3;
+const PERIODIC_SYNC_TIMEOUT_UNIT = 10; // ms
+const PERIODIC_SYNC_MIN_TIMEOUT = 0x000a;
+const PERIODIC_SYNC_MAX_TIMEOUT = 0x4000;
+
 const STATUS_MAPPER = require('./hci-status');
 
+// Same as the kernel's HCI_CMD_TIMEOUT
+const DEFAULT_COMMAND_TIMEOUT = 2000;
+
+// Well above the largest ATT MTU (517) and signaling MTU noble uses
+const DEFAULT_MAX_SDU_LENGTH = 4096;
+
+// Command packets come from the pooled allocator; every builder writes each parameter octet.
+const commandPacket = function (opcode, length) {
+  const cmd = Buffer.allocUnsafe(4 + length);
+
+  // header
+  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
+  cmd.writeUInt16LE(opcode, 1);
+
+  // length
+  cmd.writeUInt8(length, 3);
+
+  return cmd;
+};
+
+// Parameterless commands never change, so each one is built once and reused.
+const parameterlessCommands = new Map();
+const parameterlessCommand = function (opcode) {
+  let cmd = parameterlessCommands.get(opcode);
+  if (cmd === undefined) {
+    cmd = commandPacket(opcode, 0);
+    parameterlessCommands.set(opcode, cmd);
+  }
+  return cmd;
+};
+
+// Splits one L2CAP PDU into ACL packets of at most aclLength octets of payload. All of them
+// are views into a single allocation, with headers written in place and data copied once.
+const fragmentAcl = function (handle, cid, data, aclLength) {
+  const l2capLength = 4 /* l2cap header */ + data.length;
+  const count = Math.ceil(l2capLength / aclLength);
+  const buffer = Buffer.allocUnsafe(l2capLength + count * 5 /* acl header */);
+  const packets = new Array(count);
+
+  let offset = 0;
+  let copied = 0;
+  for (let i = 0; i < count; i++) {
+    const length = Math.min(aclLength, l2capLength - i * aclLength);
+    const end = offset + 5 + length;
+    let body = offset + 5;
+
+    // acl header
+    buffer.writeUInt8(HCI_ACLDATA_PKT, offset);
+    buffer.writeUInt16LE(handle | ((i === 0 ? ACL_START_NO_FLUSH : ACL_CONT) << 12), offset + 1);
+    buffer.writeUInt16LE(length, offset + 3);
+
+    if (i === 0) {
+      // l2cap header
+      buffer.writeUInt16LE(data.length, body);
+      buffer.writeUInt16LE(cid, body + 2);
+      body += 4;
+    }
+
+    copied += data.copy(buffer, body, copied, copied + end - body);
+    packets[i] = buffer.subarray(offset, end);
+    offset = end;
+  }
+
+  return packets;
+};
+
+// Drivers implemented in this package; anything else is resolved by bluetooth-hci-socket.
+const loadHciDriver = function (driverType) {
+  switch (driverType) {
+    case 'replay':
+      return require('./drivers/replay');
+    case 'virtual':
+      return require('./drivers/virtual');
+    case 'linux':
+      return require('../linux/bindings');
+    default:
+      return loadDriver(driverType || 'default');
+  }
+};
+
+// Dispatch tables: handler method names by packet type, HCI event code, LE subevent code and
+// completed command opcode. Names rather than functions, so handlers can be replaced per instance.
+const PACKET_HANDLERS = {
+  [HCI_COMMAND_PKT]: 'onCommandPacket',
+  [HCI_ACLDATA_PKT]: 'onAclDataPacket',
+  [HCI_EVENT_PKT]: 'onEventPacket'
+};
+
+const EVENT_HANDLERS = {
+  [EVT_DISCONN_COMPLETE]: 'onDisconnComplete',
+  [EVT_ENCRYPT_CHANGE]: 'onEncryptChange',
+  [EVT_CMD_COMPLETE]: 'onCmdComplete',
+  [EVT_CMD_STATUS]: 'onCmdStatus',
+  [EVT_NUMBER_OF_COMPLETED_PACKETS]: 'onNumberOfCompletedPackets',
+  [EVT_LE_META_EVENT]: 'onLeMetaEvent'
+};
+
+const LE_META_HANDLERS = {
+  [EVT_LE_CONN_COMPLETE]: 'processLeConnComplete',
+  [EVT_LE_ADVERTISING_REPORT]: 'processLeAdvertisingReport',
+  [EVT_LE_CONN_UPDATE_COMPLETE]: 'processLeConnUpdateComplete',
+  [EVT_LE_DATA_LENGTH_CHANGE]: 'processLeDataLengthChange',
+  [EVT_LE_ENHANCED_CONN_COMPLETE]: 'processLeEnhancedConnComplete',
+  [EVT_LE_EXTENDED_ADVERTISING_REPORT]: 'processLeExtendedAdvertisingReport',
+  [EVT_LE_PERIODIC_SYNC_ESTABLISHED]: 'processLePeriodicSyncEstablished',
+  [EVT_LE_PERIODIC_ADVERTISING_REPORT]: 'processLePeriodicAdvertisingReport',
+  [EVT_LE_PERIODIC_SYNC_LOST]: 'processLePeriodicSyncLost'
+};
+
+const CMD_COMPLETE_HANDLERS = new Map([
+  [RESET_CMD, 'afterReset'],
+  [LE_READ_LOCAL_SUPPORTED_FEATURES, 'processLeReadLocalSupportedFeatures'],
+  [LE_SET_DATA_LENGTH_CMD, 'processLeSetDataLength'],
+  [LE_READ_MAX_DATA_LENGTH_CMD, 'processLeReadMaxDataLength'],
+  [READ_LE_HOST_SUPPORTED_CMD, 'processReadLeHostSupported'],
+  [READ_LOCAL_VERSION_CMD, 'processReadLocalVersion'],
+  [READ_SUPPORTED_COMMANDS_CMD, 'processReadSupportedCommands'],
+  [READ_BD_ADDR_CMD, 'processReadBdAddr'],
+  [LE_SET_SCAN_PARAMETERS_CMD, 'processLeSetScanParameters'],
+  [LE_SET_EXTENDED_SCAN_PARAMETERS_CMD, 'processLeSetScanParameters'],
+  [LE_SET_SCAN_ENABLE_CMD, 'processLeSetScanEnable'],
+  [LE_SET_EXTENDED_SCAN_ENABLE_CMD, 'processLeSetScanEnable'],
+  [READ_RSSI_CMD, 'processReadRssi'],
+  [LE_READ_BUFFER_SIZE_CMD, 'processLeReadBufferSize'],
+  [READ_BUFFER_SIZE_CMD, 'processReadBufferSize']
+]);
+
 const Hci = function (options) {
   options = options || {};
   this._manufacturer = null;
   
-  const BluetoothHciSocket = loadDriver(options.hciDriver || 'default');
+  const BluetoothHciSocket = loadHciDriver(options.hciDriver);
   this._socket = new BluetoothHciSocket();
   
   this._isStarted = false;
@@ -129,7 +312,22 @@ const Hci = function (options) {
   this._maxDataLength = null;
   this._state = null;
   this._bindParams = 'bindParams' in options ? options.bindParams : undefined;
-  this._handleBuffers = {};
+  this._handleBuffers = new Map();
+  this._adaptiveEventFilter = options.adaptiveEventFilter != null
+    ? Boolean(options.adaptiveEventFilter)
+    : !process.env.NOBLE_HCI_STATIC_EVENT_FILTER;
+  this._scanEnabled = false;
+  this._leEventsSuppressed = 0; // LE event mask bits nobody needs right now
+  this._leEventMask = null; // as last written, null until init writes it
+  this._socketFilter = null;
+  this._eventFilterStats = { updates: 0, suppressed: 0, suppressedSinceUpdate: 0 };
+  this._maxSduLength = options.maxSduLength > 0 ? options.maxSduLength : DEFAULT_MAX_SDU_LENGTH;
+  this._scanFilterPolicy = SCAN_FILTER_POLICY_ALL;
+  this._scanActive = true;
+  this._scanPhys = ['1m', 'coded']; // LE Coded only where the controller has it
+  this._acceptList = new Map(); // what the controller's Filter Accept List holds, by type/address
+  // Until HCI_Reset or a clear, the list may hold entries of a previous run (reset skipped)
+  this._acceptListStale = true;
   this._aclBuffers = undefined;
   this._resolveAclBuffers = undefined;
 
@@ -156,8 +354,11 @@ const Hci = function (options) {
   }.bind(this);
 
   this._aclConnections = new Map();
-  this._aclQueue = [];
+  this._aclScheduler = new AclScheduler();
+  this._aclPending = 0; // packets in the controller's buffers, across all connections
   this._pendingLeConn = null;
+  this._pendingPeriodicSync = null; // { address, sid } while a Create Sync is outstanding
+  this._periodicSyncs = new Set(); // sync handles
 
   this._deviceId = options.deviceId != null
     ? parseInt(options.deviceId, 10)
@@ -169,6 +370,40 @@ const Hci = function (options) {
     ? options.userChannel
     : Boolean(process.env.HCI_CHANNEL_USER);
 
+  // Commands wait in _commandQueue for a Num_HCI_Command_Packets credit, then in
+  // _pendingCommands (by opcode, oldest first) for their Command Complete or Status.
+  this._commandFlowControl = options.commandFlowControl != null ? Boolean(options.commandFlowControl) : null;
+  this._commandTimeout = options.commandTimeout > 0 ? options.commandTimeout : DEFAULT_COMMAND_TIMEOUT;
+  this._commandCredits = 1;
+  this._commandQueue = [];
+  this._pendingCommands = new Map();
+  this._commandWatchdog = null;
+
+  // Fast start pipelines the bring-up reads and takes what it can from the capability cache.
+  this._fastStart = options.fastStart != null
+    ? Boolean(options.fastStart)
+    : Boolean(process.env.NOBLE_HCI_FAST_START);
+  this._skipReset = options.skipReset != null
+    ? Boolean(options.skipReset)
+    : Boolean(process.env.NOBLE_HCI_SKIP_RESET);
+  const capabilityCachePath = options.capabilityCache != null
+    ? options.capabilityCache
+    : process.env.NOBLE_HCI_CAPABILITY_CACHE;
+  this._capabilityCache = this._fastStart && capabilityCachePath !== false
+    ? new CapabilityCache(capabilityCachePath)
+    : null;
+  this._capabilities = null; // cache entry of the running controller, once fast start is done
+  this._fastStarting = false;
+
+  const btsnoopPath = options.btsnoop || process.env.NOBLE_HCI_BTSNOOP;
+  const btsnoopMaxSize = options.btsnoopMaxSize != null
+    ? options.btsnoopMaxSize
+    : parseFloat(process.env.NOBLE_HCI_BTSNOOP_MAX_SIZE) || 0;
+  // Stays null when capture is off, so the hot paths pay a single comparison.
+  this._btsnoop = btsnoopPath
+    ? new Btsnoop(btsnoopPath, Math.floor(btsnoopMaxSize * 1024 * 1024))
+    : null;
+
   this.on('stateChange', this.onStateChange.bind(this));
 };
 
@@ -180,11 +415,178 @@ Hci.prototype.isUserChannel = function () {
   return this._userChannel;
 };
 
+// The kernel meters commands on raw sockets; on the user channel nothing does unless Hci does.
+Hci.prototype.isCommandFlowControlled = function () {
+  return this._commandFlowControl !== null ? this._commandFlowControl : Boolean(this._userChannel);
+};
+
+/**
+ * Queues a command packet and writes it as soon as the controller has a command credit.
+ * The promise resolves with the return parameters of its Command Complete (or with nothing
+ * for a successful Command Status) and rejects on an error status, on timeout, or on stop().
+ * A command that can be written straight away throws synchronously if the write fails.
+ */
+Hci.prototype.sendCommand = function (packet) {
+  const command = {
+    opcode: packet.readUInt16LE(1),
+    packet,
+    deadline: 0,
+    resolve: null,
+    reject: null
+  };
+  const promise = new Promise((resolve, reject) => {
+    command.resolve = resolve;
+    command.reject = reject;
+  });
+  // Most callers fire and forget; they learn the outcome from the events Hci emits.
+  promise.catch(() => {});
+
+  if (this.isCommandFlowControlled() && (this._commandCredits <= 0 || this._commandQueue.length > 0)) {
+    debug(`command 0x${command.opcode.toString(16)} queued - ${this._commandQueue.length} ahead`);
+    this._commandQueue.push(command);
+  } else {
+    this.writeCommand(command);
+  }
+
+  return promise;
+};
+
+Hci.prototype.writeCommand = function (command) {
+  const flowControlled = this.isCommandFlowControlled();
+  let pending = this._pendingCommands.get(command.opcode);
+
+  if (pending === undefined) {
+    pending = [];
+    this._pendingCommands.set(command.opcode, pending);
+  }
+  pending.push(command);
+  command.deadline = Date.now() + this._commandTimeout;
+
+  if (flowControlled) {
+    this._commandCredits--;
+  }
+
+  try {
+    this.writePacket(command.packet);
+  } catch (error) {
+    pending.splice(pending.indexOf(command), 1);
+    if (flowControlled) {
+      this._commandCredits++;
+    }
+    command.reject(error);
+    throw error;
+  }
+
+  // Raw sockets too: the kernel may time a command out without any event we would see.
+  if (this._commandWatchdog === null) {
+    this.armCommandWatchdog(this._commandTimeout);
+  }
+};
+
+Hci.prototype.flushCommands = function () {
+  while (this._commandQueue.length > 0 && this._commandCredits > 0) {
+    const command = this._commandQueue.shift();
+    try {
+      this.writeCommand(command);
+    } catch (error) {
+      // Already rejected; the rest of the queue still goes out.
+      debug(`command 0x${command.opcode.toString(16)} write failed: ${error.message}`);
+    }
+  }
+};
+
+Hci.prototype.completeCommand = function (opcode, credits, status, result) {
+  this._commandCredits = credits;
+
+  const pending = this._pendingCommands.get(opcode);
+  if (pending !== undefined) {
+    const command = pending.shift();
+    if (pending.length === 0) {
+      this._pendingCommands.delete(opcode);
+    }
+
+    if (status === 0) {
+      command.resolve(result);
+    } else {
+      const error = new Error(STATUS_MAPPER[status] || 'HCI Error: Unknown');
+      error.opcode = opcode;
+      error.status = status;
+      command.reject(error);
+    }
+  }
+
+  this.expireCommands(Date.now());
+  this.flushCommands();
+};
+
+Hci.prototype.expireCommands = function (now) {
+  let expired = 0;
+
+  for (const [opcode, pending] of this._pendingCommands) {
+    while (pending.length > 0 && pending[0].deadline <= now) {
+      const error = new Error(`HCI command 0x${opcode.toString(16).padStart(4, '0')} timed out`);
+      error.opcode = opcode;
+      pending.shift().reject(error);
+      expired++;
+    }
+    if (pending.length === 0) {
+      this._pendingCommands.delete(opcode);
+    }
+  }
+
+  // Like the kernel, assume the controller lost the command and can take another.
+  if (expired > 0 && this._commandCredits <= 0) {
+    debug(`${expired} command(s) timed out - restoring a command credit`);
+    this._commandCredits = 1;
+  }
+};
+
+Hci.prototype.armCommandWatchdog = function (delay) {
+  this._commandWatchdog = setTimeout(() => {
+    this._commandWatchdog = null;
+
+    const now = Date.now();
+    this.expireCommands(now);
+    this.flushCommands();
+
+    let next = Infinity;
+    for (const pending of this._pendingCommands.values()) {
+      next = Math.min(next, pending[0].deadline);
+    }
+    if (next !== Infinity) {
+      this.armCommandWatchdog(Math.max(0, next - now));
+    }
+  }, delay);
+
+  if (this._commandWatchdog.unref) {
+    this._commandWatchdog.unref();
+  }
+};
+
 Hci.prototype.init = function (options) {
+  if (this._btsnoop !== null) {
+    try {
+      this._btsnoop.open();
+    } catch (error) {
+      debug(`btsnoop open error: ${error.message}`);
+      this._btsnoop = null;
+    }
+  }
+
   this._socket.on('data', this.onSocketData.bind(this));
   this._socket.on('error', this.onSocketError.bind(this));
   this._socket.on('state', this.pollIsDevUp.bind(this));
 
+  // Drivers that decode in native code hand over advertising reports and whole L2CAP PDUs.
+  // A capture needs every packet as it came in, so they decode nothing while one runs.
+  if (typeof this._socket.setDecoding === 'function') {
+    this._socket.setDecoding(this._btsnoop === null, this._maxSduLength);
+    this._socket.on('advertisingReport', this.onDecodedAdvertisingReport.bind(this));
+    this._socket.on('extendedAdvertisingReport', this.onDecodedExtendedAdvertisingReport.bind(this));
+    this._socket.on('aclData', this.onDecodedAclData.bind(this));
+    this._socket.on('aclDataDropped', this.dropAclData.bind(this));
+  }
+
   try {
     // Bind first (either user channel or raw)
     if (this._userChannel) {
@@ -199,12 +601,19 @@ Hci.prototype.init = function (options) {
     // Start and reset (common to both paths)
     this._socket.start();
 
-    if (this._userChannel) {
-      // No kernel command flow control on the user channel: nothing serialises this behind HCI_Reset
-      this.once('reset', () => this.readLeSupportedFeatures());
-    }
+    if (this._fastStart) {
+      // A raw socket has to wait for the adapter to be up; pollIsDevUp starts it then.
+      if (this._userChannel) {
+        this.fastStart();
+      }
+    } else {
+      if (this._userChannel) {
+        // No kernel command flow control on the user channel: nothing serialises this behind HCI_Reset
+        this.once('reset', () => this.readLeSupportedFeatures());
+      }
 
-    this.reset();
+      this.reset();
+    }
     this._isStarted = true;
 
     if (!this._userChannel) {
@@ -227,8 +636,12 @@ Hci.prototype.pollIsDevUp = function () {
         this.init();
       } else {
         this.setSocketFilter();
-        this.readLeSupportedFeatures();
-        // Subsequent calls moved to processCmdCompleteEvent for LE_READ_LOCAL_SUPPORTED_FEATURES
+        if (this._fastStart) {
+          this.fastStart();
+        } else {
+          this.readLeSupportedFeatures();
+          // Subsequent calls moved to processCmdCompleteEvent for LE_READ_LOCAL_SUPPORTED_FEATURES
+        }
       }
     } else {
       this.emit('stateChange', 'poweredOff');
@@ -244,15 +657,92 @@ Hci.prototype.pollIsDevUp = function () {
   }
 };
 
-Hci.prototype.setCodedPhySupport = function () {
-  const cmd = Buffer.alloc(7);
+/**
+ * Brings the controller up in as few round trips as it can. Reads that do not depend on each
+ * other go out together under command credits. When BD_ADDR and firmware match the capability
+ * cache, the cached entry stands in for the feature, buffer size and data length reads, and
+ * HCI_Reset itself is skipped with skipReset if the previous run left the controller idle.
+ */
+Hci.prototype.fastStart = async function () {
+  const deviceId = this._deviceId !== undefined ? this._deviceId : 0;
+  const expected = this._capabilityCache !== null ? this._capabilityCache.expected(deviceId) : null;
+
+  this._fastStarting = true;
+  try {
+    if (this._skipReset && expected !== null && expected.clean) {
+      debug('fast start - the controller was left idle, skipping reset');
+    } else {
+      await this.reset();
+    }
 
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(OCF_SET_PHY | (OGF_LE_CTL << 10), 1);
+    // With no entry to expect, the capability reads go out along with the identity reads.
+    const identity = [this.readLocalVersion(), this.readBdAddr()];
+    const capabilities = expected === null ? this.readLeCapabilities() : null;
+    const [localVersion] = await Promise.all(identity);
+    if (localVersion.readUInt8(0) < 0x06) {
+      return; // reported unsupported by processReadLocalVersion
+    }
 
-  // length
-  cmd.writeUInt8(0x03, 3);
+    const key = CapabilityCache.key(this.address, localVersion);
+    const cached = this._capabilityCache !== null ? this._capabilityCache.get(key) : null;
+    let leFeatures;
+    if (capabilities !== null) {
+      leFeatures = await capabilities;
+    } else if (cached !== null) {
+      debug(`fast start - using cached capabilities of ${key}`);
+      leFeatures = cached.leFeatures;
+      this.processLeReadLocalSupportedFeatures(0, Buffer.from(leFeatures, 'hex'));
+      this.setAclBuffers(cached.aclBuffers.length, cached.aclBuffers.num);
+      this._maxDataLength = cached.maxDataLength;
+    } else {
+      leFeatures = await this.readLeCapabilities();
+    }
+
+    if (this._codedPhy && this._supportsCodedPhy) {
+      this.setCodedPhySupport();
+    }
+    this.setEventMask();
+    this.setLeEventMask();
+    this.writeLeHostSupported();
+    this.setScanEnabled(false, true);
+    // Its Command Complete reports poweredOn; every read above has completed by then.
+    await this.setScanParameters();
+
+    this._capabilities = {
+      key,
+      leFeatures,
+      aclBuffers: { length: this._aclBuffers.length, num: this._aclBuffers.num },
+      maxDataLength: this._maxDataLength,
+      clean: false
+    };
+    if (this._capabilityCache !== null) {
+      this._capabilityCache.set(deviceId, this._capabilities);
+    }
+  } catch (error) {
+    debug(`fast start failed, falling back to a full read - ${error.message}`);
+    this._fastStarting = false;
+    this.readLeSupportedFeatures();
+  } finally {
+    this._fastStarting = false;
+  }
+};
+
+// The reads that only depend on the controller; resolves with the LE features as hex.
+Hci.prototype.readLeCapabilities = async function () {
+  // A zero LE buffer size makes processLeReadBufferSize ask for the BR/EDR one as well.
+  const [leFeatures] = await Promise.all([this.readLeSupportedFeatures(), this.readLeBufferSize()]);
+
+  if (this._supportsDataLengthExtension) {
+    await this.readLeMaxDataLength();
+  } else {
+    this._maxDataLength = null;
+  }
+
+  return leFeatures.toString('hex');
+};
+
+Hci.prototype.setCodedPhySupport = function () {
+  const cmd = commandPacket(OCF_SET_PHY | (OGF_LE_CTL << 10), 0x03);
 
   // data
   cmd.writeUInt8(0x00, 4); // all phy prefs
@@ -260,7 +750,7 @@ Hci.prototype.setCodedPhySupport = function () {
   cmd.writeUInt8(0x05, 6); // rx phy: 0x01 - LE 1M, 0x03 - LE 1M + LE 2M, 0x05 - LE 1M + LE CODED, 0x07 -  LE 1M + LE 2M +  LE CODED
 
   debug(`set all phys supporting - writing: ${cmd.toString('hex')}`);
-  this._socket.write(cmd);
+  return this.sendCommand(cmd);
 };
 
 Hci.prototype.setAddress = function (address) {
@@ -269,13 +759,14 @@ Hci.prototype.setAddress = function (address) {
 
   if (addrCmd !== null && Buffer.isBuffer(addrCmd)) {
     // Make Command Buffer
-    const cmd = Buffer.alloc(1 + addrCmd.byteLength);
+    const cmd = Buffer.allocUnsafe(1 + addrCmd.byteLength);
     cmd.writeUInt8(HCI_COMMAND_PKT, 0);
     addrCmd.copy(cmd, 1);
 
     debug(`set address - writing: ${cmd.toString('hex')}`);
-    this._socket.write(cmd);
+    const written = this.sendCommand(cmd);
     this.readBdAddr();
+    return written;
   }
 };
 
@@ -289,7 +780,9 @@ Hci.prototype.setSocketFilter = function () {
     (1 << EVT_CMD_COMPLETE) |
     (1 << EVT_CMD_STATUS) |
     (1 << EVT_NUMBER_OF_COMPLETED_PACKETS);
-  const eventMask2 = 1 << (EVT_LE_META_EVENT - 32);
+  // Only LE meta events are worth dropping in the kernel: every other event we take is rare.
+  const leIdle = (~this._leEventsSuppressed & (LE_EVENTS_SCAN | LE_EVENTS_LINK | LE_EVENTS_PERIODIC)) === 0;
+  const eventMask2 = leIdle ? 0 : 1 << (EVT_LE_META_EVENT - 32);
   const opcode = 0;
 
   filter.writeUInt32LE(typeMask, 0);
@@ -299,23 +792,16 @@ Hci.prototype.setSocketFilter = function () {
 
   debug(`setting filter to: ${filter.toString('hex')}`);
   this._socket.setFilter(filter);
+  this._socketFilter = filter;
 };
 
 Hci.prototype.setEventMask = function () {
-  const cmd = Buffer.alloc(12);
-  const eventMask = Buffer.from('fffffbff07f8bf3d', 'hex');
+  const cmd = commandPacket(SET_EVENT_MASK_CMD, 0x08);
 
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(SET_EVENT_MASK_CMD, 1);
-
-  // length
-  cmd.writeUInt8(eventMask.length, 3);
-
-  eventMask.copy(cmd, 4);
+  cmd.write('fffffbff07f8bf3d', 4, 'hex');
 
   debug(`set event mask - writing: ${cmd.toString('hex')}`);
-  this._socket.write(cmd);
+  return this.sendCommand(cmd);
 };
 
 Hci.prototype.reset = function () {
@@ -324,21 +810,27 @@ Hci.prototype.reset = function () {
     this.afterReset();
     return;
   }
+  // A reset would end every periodic sync, and the advertisers may take long to find again
+  if (this._periodicSyncs.size > 0 || this._pendingPeriodicSync !== null) {
+    debug(`reset - refusing while ${this._periodicSyncs.size} periodic sync(s) are active`);
+    this.afterReset();
+    return;
+  }
 
-  const cmd = Buffer.alloc(4);
-
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(RESET_CMD, 1);
-
-  // length
-  cmd.writeUInt8(0x00, 3);
+  const cmd = parameterlessCommand(RESET_CMD);
+  this._acceptListStale = false;
 
   debug(`reset - writing: ${cmd.toString('hex')}`);
-  this._socket.write(cmd);
+  return this.sendCommand(cmd);
 };
 
 Hci.prototype.afterReset = function () {
+  // Fast start configures the controller itself once it knows the capabilities.
+  if (this._fastStarting) {
+    this.emit('reset');
+    return;
+  }
+
   // HCI_Reset clears the default PHY, so it has to be rewritten here. Support stays false
   // until the first LE_READ_LOCAL_SUPPORTED_FEATURES reply, so the initial reset writes nothing.
   if (this._codedPhy && this._supportsCodedPhy) {
@@ -346,14 +838,38 @@ Hci.prototype.afterReset = function () {
   }
   this.setEventMask();
   this.setLeEventMask();
-  this.readLocalVersion();
-  this.readBdAddr();
+  // HCI_Reset empties the Filter Accept List too
+  if (this._acceptList.size > 0) {
+    const devices = [...this._acceptList.values()];
+    this._acceptList.clear();
+    this.loadAcceptList(devices).catch(error => debug(`restoring the filter accept list failed - ${error.message}`));
+  }
+  // A reset does not change the controller, so there is nothing new to read after the first.
+  if (this._capabilities === null) {
+    this.readLocalVersion();
+    this.readBdAddr();
+  }
   this.emit('reset');
 };
 
 Hci.prototype.stop = function () {
+  if (this._capabilities !== null) {
+    // Nothing left running on the controller, so the next start may skip HCI_Reset.
+    this._capabilities.clean = this._aclConnections.size === 0 && this._pendingLeConn === null && !this._scanEnabled &&
+      this._periodicSyncs.size === 0 && this._pendingPeriodicSync === null;
+    if (this._capabilityCache !== null) {
+      this._capabilityCache.set(this._deviceId !== undefined ? this._deviceId : 0, this._capabilities);
+    }
+    this._capabilities = null;
+  }
+
   this._socket.stop();
   this._isStarted = false;
+  this._acceptListStale = true;
+
+  if (this._btsnoop !== null) {
+    this._btsnoop.close();
+  }
 
   if (this._devUpPollTimer !== null) {
     clearTimeout(this._devUpPollTimer);
@@ -361,126 +877,156 @@ Hci.prototype.stop = function () {
   }
 
   this._aclConnections.clear();
-  this._aclQueue = [];
+  this._aclScheduler.clear();
+  this._aclPending = 0;
+  this._handleBuffers.clear();
   this._pendingLeConn = null;
+  this._pendingPeriodicSync = null;
+  this._periodicSyncs.clear();
+  this._scanEnabled = false;
+  this._leEventsSuppressed = 0;
+  this._leEventMask = null;
+  this._socketFilter = null;
+
+  if (this._commandWatchdog !== null) {
+    clearTimeout(this._commandWatchdog);
+    this._commandWatchdog = null;
+  }
+  const stopped = new Error('HCI stopped');
+  for (const pending of this._pendingCommands.values()) {
+    pending.forEach(command => command.reject(stopped));
+  }
+  this._commandQueue.forEach(command => command.reject(stopped));
+  this._pendingCommands.clear();
+  this._commandQueue = [];
+  this._commandCredits = 1;
 };
 
 Hci.prototype.readSupportedCommands = function () {
-  const cmd = Buffer.alloc(4);
-
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(READ_SUPPORTED_COMMANDS_CMD, 1);
-
-  // length
-  cmd.writeUInt8(0x0, 3);
+  const cmd = parameterlessCommand(READ_SUPPORTED_COMMANDS_CMD);
 
   debug(`read supported commands - writing: ${cmd.toString('hex')}`);
-  this._socket.write(cmd);
+  return this.sendCommand(cmd);
 };
 
 Hci.prototype.readLocalVersion = function () {
-  const cmd = Buffer.alloc(4);
-
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(READ_LOCAL_VERSION_CMD, 1);
-
-  // length
-  cmd.writeUInt8(0x0, 3);
+  const cmd = parameterlessCommand(READ_LOCAL_VERSION_CMD);
 
   debug(`read local version - writing: ${cmd.toString('hex')}`);
-  this._socket.write(cmd);
+  return this.sendCommand(cmd);
 };
 
 Hci.prototype.readBufferSize = function () {
-  const cmd = Buffer.alloc(4);
-
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(READ_BUFFER_SIZE_CMD, 1);
-
-  // length
-  cmd.writeUInt8(0x0, 3);
+  const cmd = parameterlessCommand(READ_BUFFER_SIZE_CMD);
 
   debug(`read buffer size - writing: ${cmd.toString('hex')}`);
-  this._socket.write(cmd);
+  return this.sendCommand(cmd);
 };
 
 Hci.prototype.readBdAddr = function () {
-  const cmd = Buffer.alloc(4);
-
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(READ_BD_ADDR_CMD, 1);
-
-  // length
-  cmd.writeUInt8(0x0, 3);
+  const cmd = parameterlessCommand(READ_BD_ADDR_CMD);
 
   debug(`read bd addr - writing: ${cmd.toString('hex')}`);
-  this._socket.write(cmd);
+  return this.sendCommand(cmd);
 };
 
 Hci.prototype.setLeEventMask = function () {
-  const cmd = Buffer.alloc(12);
+  const cmd = commandPacket(LE_SET_EVENT_MASK_CMD, 0x08);
   // Bit 6 is LE Data Length Change; without it the negotiated length is never reported.
-  const leEventMask = this._isExtended
-    ? Buffer.from('5fff000000000000', 'hex')
-    : Buffer.from('5f00000000000000', 'hex');
+  let mask = LE_EVENTS_BASE | LE_EVENTS_SCAN | LE_EVENTS_LINK;
+  if (this._isExtended) {
+    mask |= LE_EVENTS_BASE_EXTENDED | LE_EVENTS_SCAN_EXTENDED | LE_EVENTS_PERIODIC | LE_EVENTS_LINK_EXTENDED;
+  }
+  // On a raw socket the controller is shared with the kernel stack, so only the user
+  // channel may stop the controller from generating events.
+  if (this._userChannel) {
+    mask &= ~this._leEventsSuppressed;
+  }
+  cmd.writeUInt32LE(mask, 4);
+  cmd.writeUInt32LE(0, 8);
 
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(LE_SET_EVENT_MASK_CMD, 1);
+  debug(`set le event mask - writing: ${cmd.toString('hex')}`);
+  this._leEventMask = mask;
+  return this.sendCommand(cmd);
+};
 
-  // length
-  cmd.writeUInt8(leEventMask.length, 3);
+Hci.prototype.suppressedLeEvents = function () {
+  if (!this._adaptiveEventFilter) {
+    return 0;
+  }
 
-  leEventMask.copy(cmd, 4);
+  let suppressed = 0;
+  if (!this._scanEnabled) {
+    suppressed |= LE_EVENTS_SCAN | LE_EVENTS_SCAN_EXTENDED;
+  }
+  // A connection attempt counts: link events may follow its Connection Complete at once.
+  if (this._pendingLeConn === null && this._aclConnections.size === 0) {
+    suppressed |= LE_EVENTS_LINK | LE_EVENTS_LINK_EXTENDED;
+  }
+  if (this._pendingPeriodicSync === null && this._periodicSyncs.size === 0) {
+    suppressed |= LE_EVENTS_PERIODIC;
+  }
+  return suppressed;
+};
 
-  debug(`set le event mask - writing: ${cmd.toString('hex')}`);
-  this._socket.write(cmd);
+// Narrows or widens the socket filter and LE event mask after scanning or the set of
+// connections changed. Filters are only rewritten once init has written them.
+Hci.prototype.updateEventFilters = function () {
+  const suppressed = this.suppressedLeEvents();
+  if (suppressed === this._leEventsSuppressed) {
+    return;
+  }
+
+  const stats = this._eventFilterStats;
+  debug(`event filter update - the previous filter suppressed ${stats.suppressedSinceUpdate} events`);
+  stats.updates++;
+  stats.suppressedSinceUpdate = 0;
+  this._leEventsSuppressed = suppressed;
+
+  if (this._socketFilter !== null) {
+    this.setSocketFilter();
+  }
+  if (this._userChannel && this._leEventMask !== null) {
+    this.setLeEventMask();
+  }
 };
 
-Hci.prototype.readLeSupportedFeatures = function () {
-  const cmd = Buffer.alloc(4);
+// Neither the controller nor the kernel report what they drop: suppressed counts the LE
+// events that still reached us after their group was masked off, and were dropped undecoded.
+Hci.prototype.getEventFilterStats = function () {
+  return {
+    updates: this._eventFilterStats.updates,
+    suppressed: this._eventFilterStats.suppressed,
+    suppressedSinceUpdate: this._eventFilterStats.suppressedSinceUpdate,
+    leEventMask: this._leEventMask,
+    leEventsSuppressed: this._leEventsSuppressed
+  };
+};
 
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(LE_READ_LOCAL_SUPPORTED_FEATURES, 1);
+// ACL packets the controller can take right now, before its buffer sizes are known: none
+Hci.prototype.freeAclBuffers = function () {
+  return this._aclBuffers ? this._aclBuffers.num - this._aclPending : 0;
+};
 
-  // length
-  cmd.writeUInt8(0x0, 3);
+Hci.prototype.readLeSupportedFeatures = function () {
+  const cmd = parameterlessCommand(LE_READ_LOCAL_SUPPORTED_FEATURES);
 
   debug(`le read supported feature - writing: ${cmd.toString('hex')}`);
-  this._socket.write(cmd);
+  return this.sendCommand(cmd);
 };
 
 Hci.prototype.readLeBufferSize = function () {
-  const cmd = Buffer.alloc(4);
-
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(LE_READ_BUFFER_SIZE_CMD, 1);
-
-  // length
-  cmd.writeUInt8(0x0, 3);
+  const cmd = parameterlessCommand(LE_READ_BUFFER_SIZE_CMD);
 
   debug(`le read buffer size - writing: ${cmd.toString('hex')}`);
-  this._socket.write(cmd);
+  return this.sendCommand(cmd);
 };
 
 Hci.prototype.readLeMaxDataLength = function () {
-  const cmd = Buffer.alloc(4);
-
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(LE_READ_MAX_DATA_LENGTH_CMD, 1);
-
-  // length
-  cmd.writeUInt8(0x0, 3);
+  const cmd = parameterlessCommand(LE_READ_MAX_DATA_LENGTH_CMD);
 
   debug(`le read maximum data length - writing: ${cmd.toString('hex')}`);
-  this._socket.write(cmd);
+  return this.sendCommand(cmd);
 };
 
 Hci.prototype.setLeDataLength = function (handle) {
@@ -488,14 +1034,7 @@ Hci.prototype.setLeDataLength = function (handle) {
     return;
   }
 
-  const cmd = Buffer.alloc(10);
-
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(LE_SET_DATA_LENGTH_CMD, 1);
-
-  // length
-  cmd.writeUInt8(0x06, 3);
+  const cmd = commandPacket(LE_SET_DATA_LENGTH_CMD, 0x06);
 
   // data
   cmd.writeUInt16LE(handle, 4);
@@ -505,124 +1044,213 @@ Hci.prototype.setLeDataLength = function (handle) {
   debug(`le set data length - writing: ${cmd.toString('hex')}`);
   // A link works at the 27 octet default, so a failure here must not fail the connection.
   try {
-    this._socket.write(cmd);
+    return this.sendCommand(cmd);
   } catch (error) {
     debug(`le set data length failed - handle: ${handle}, error: ${error.message}`);
   }
 };
 
 Hci.prototype.readLeHostSupported = function () {
-  const cmd = Buffer.alloc(4);
-
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(READ_LE_HOST_SUPPORTED_CMD, 1);
-
-  // length
-  cmd.writeUInt8(0x00, 3);
+  const cmd = parameterlessCommand(READ_LE_HOST_SUPPORTED_CMD);
 
   debug(`read LE host supported - writing: ${cmd.toString('hex')}`);
-  this._socket.write(cmd);
+  return this.sendCommand(cmd);
 };
 
 Hci.prototype.writeLeHostSupported = function () {
-  const cmd = Buffer.alloc(6);
-
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(WRITE_LE_HOST_SUPPORTED_CMD, 1);
-
-  // length
-  cmd.writeUInt8(0x02, 3);
+  const cmd = commandPacket(WRITE_LE_HOST_SUPPORTED_CMD, 0x02);
 
   // data
   cmd.writeUInt8(0x01, 4); // le
   cmd.writeUInt8(0x00, 5); // simul
 
   debug(`write LE host supported - writing: ${cmd.toString('hex')}`);
-  this._socket.write(cmd);
+  return this.sendCommand(cmd);
+};
+
+// Both take effect with the next setScanParameters.
+Hci.prototype.setScanType = function (active) {
+  this._scanActive = Boolean(active);
+};
+
+Hci.prototype.setScanPhys = function (phys) {
+  this._scanPhys = phys;
 };
 
 Hci.prototype.setScanParameters = function (
   interval = 0x0012,
   window = 0x0012
 ) {
-  const useCodedPhy = this._isExtended && this._supportsCodedPhy;
-  const cmd = Buffer.alloc(this._isExtended ? (useCodedPhy ? 17 : 12) : 11);
-
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(
-    this._isExtended
-      ? LE_SET_EXTENDED_SCAN_PARAMETERS_CMD
-      : LE_SET_SCAN_PARAMETERS_CMD,
-    1
-  );
+  const scanType = this._scanActive ? 0x01 : 0x00;
+  const useCodedPhy = this._isExtended && this._supportsCodedPhy && this._scanPhys.includes('coded');
+  // LE 1M where asked for, and always where LE Coded alone was asked for but is missing
+  const use1mPhy = this._scanPhys.includes('1m') || !useCodedPhy;
+  const cmd = this._isExtended
+    ? commandPacket(LE_SET_EXTENDED_SCAN_PARAMETERS_CMD, 0x03 + (use1mPhy ? 0x05 : 0x00) + (useCodedPhy ? 0x05 : 0x00))
+    : commandPacket(LE_SET_SCAN_PARAMETERS_CMD, 0x07);
 
   if (this._isExtended) {
-    // length
-    cmd.writeUInt8(useCodedPhy ? 0x0d : 0x08, 3);
-
     // data
     cmd.writeUInt8(0x00, 4); // own address type: 0 -> public, 1 -> random
-    cmd.writeUInt8(0x00, 5); // filter: 0 -> all event types
-    cmd.writeUInt8(useCodedPhy ? 0x05 : 0x01, 6); // phy: LE 1M, plus LE Coded when supported
-    // phy 1M
-    cmd.writeUInt8(0x01, 7); // type: 0 -> passive, 1 -> active
-    cmd.writeUInt16LE(interval, 8); // interval, ms * 1.6
-    cmd.writeUInt16LE(window, 10); // window, ms * 1.6
+    cmd.writeUInt8(this._scanFilterPolicy, 5); // filter: 0 -> all advertisers, 1 -> accept list only
+    cmd.writeUInt8((use1mPhy ? 0x01 : 0x00) | (useCodedPhy ? 0x04 : 0x00), 6); // phy: LE 1M, LE Coded
+    let offset = 7;
+    if (use1mPhy) {
+      // phy 1M
+      cmd.writeUInt8(scanType, offset); // type: 0 -> passive, 1 -> active
+      cmd.writeUInt16LE(interval, offset + 1); // interval, ms * 1.6
+      cmd.writeUInt16LE(window, offset + 3); // window, ms * 1.6
+      offset += 5;
+    }
     if (useCodedPhy) {
       // phy coded
-      cmd.writeUInt8(0x01, 12); // type: 0 -> passive, 1 -> active
-      cmd.writeUInt16LE(interval, 13); // interval, ms * 1.6
-      cmd.writeUInt16LE(window, 15); // window, ms * 1.6
+      cmd.writeUInt8(scanType, offset); // type: 0 -> passive, 1 -> active
+      cmd.writeUInt16LE(interval, offset + 1); // interval, ms * 1.6
+      cmd.writeUInt16LE(window, offset + 3); // window, ms * 1.6
     }
   } else {
-    // length
-    cmd.writeUInt8(0x07, 3);
-
     // data
-    cmd.writeUInt8(0x01, 4); // type: 0 -> passive, 1 -> active
+    cmd.writeUInt8(scanType, 4); // type: 0 -> passive, 1 -> active
     cmd.writeUInt16LE(interval, 5); // interval, ms * 1.6
     cmd.writeUInt16LE(window, 7); // window, ms * 1.6
     cmd.writeUInt8(0x00, 9); // own address type: 0 -> public, 1 -> random
-    cmd.writeUInt8(0x00, 10); // filter: 0 -> all event types
+    cmd.writeUInt8(this._scanFilterPolicy, 10); // filter: 0 -> all advertisers, 1 -> accept list only
   }
 
   debug(`set scan parameters - writing: ${cmd.toString('hex')}`);
-  this._socket.write(cmd);
+  return this.sendCommand(cmd);
 };
 
-Hci.prototype.setScanEnabled = function (enabled, filterDuplicates) {
-  const cmd = Buffer.alloc(this._isExtended ? 10 : 6);
+// Whether the controller can empty its duplicate filter every duplicatesRefresh ms by itself.
+// It does so in whole scan periods, so shorter refreshes are left to the host.
+Hci.prototype.canRefreshScanDuplicates = function (duplicatesRefresh) {
+  return this._isExtended && duplicatesRefresh >= SCAN_PERIOD_UNIT;
+};
 
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(
-    this._isExtended ? LE_SET_EXTENDED_SCAN_ENABLE_CMD : LE_SET_SCAN_ENABLE_CMD,
-    1
-  );
+Hci.prototype.setScanEnabled = function (enabled, filterDuplicates, duplicatesRefresh = 0) {
+  // Written ahead of the scan enable, so reports are unmasked before the first one is sent.
+  this._scanEnabled = Boolean(enabled);
+  this.updateEventFilters();
 
-  if (this._isExtended) {
-    // length
-    cmd.writeUInt8(0x06, 3);
+  return this.writeScanEnable(enabled, filterDuplicates, duplicatesRefresh);
+};
+
+// Scanning stops and starts again, which empties the controller's duplicate filter. The
+// event filters stay as they are, so no report is masked off in between.
+Hci.prototype.refreshScanDuplicates = function () {
+  this.writeScanEnable(false, true);
+  return this.writeScanEnable(true, true);
+};
 
+Hci.prototype.writeScanEnable = function (enabled, filterDuplicates, duplicatesRefresh = 0) {
+  const cmd = this._isExtended
+    ? commandPacket(LE_SET_EXTENDED_SCAN_ENABLE_CMD, 0x06)
+    : commandPacket(LE_SET_SCAN_ENABLE_CMD, 0x02);
+
+  if (this._isExtended && filterDuplicates && this.canRefreshScanDuplicates(duplicatesRefresh)) {
+    // Scans for all of each period but the last 10 ms, the shortest gap the controller takes
+    const period = Math.min(Math.round(duplicatesRefresh / SCAN_PERIOD_UNIT), 0xffff);
+    const duration = Math.min(period * (SCAN_PERIOD_UNIT / SCAN_DURATION_UNIT) - 1, 0xffff);
+
+    // data
+    cmd.writeUInt8(enabled ? 0x01 : 0x00, 4); // enable: 0 -> disabled, 1 -> enabled
+    cmd.writeUInt8(SCAN_DUPLICATES_RESET_EACH_PERIOD, 5); // duplicates: filtered, reset every period
+    cmd.writeUInt16LE(duration, 6); // duration
+    cmd.writeUInt16LE(period, 8); // period
+  } else if (this._isExtended) {
     // data
     cmd.writeUInt8(enabled ? 0x01 : 0x00, 4); // enable: 0 -> disabled, 1 -> enabled
     cmd.writeUInt8(filterDuplicates ? 0x01 : 0x00, 5); // duplicates: 0 -> duplicates, 1 -> all
     cmd.writeUInt16LE(0x0000, 6); // duration
     cmd.writeUInt16LE(0x0000, 8); // period
   } else {
-    // length
-    cmd.writeUInt8(0x02, 3);
-
     // data
     cmd.writeUInt8(enabled ? 0x01 : 0x00, 4); // enable: 0 -> disabled, 1 -> enabled
     cmd.writeUInt8(filterDuplicates ? 0x01 : 0x00, 5); // duplicates: 0 -> duplicates, 0 -> duplicates
   }
 
   debug(`set scan enabled - writing: ${cmd.toString('hex')}`);
-  this._socket.write(cmd);
+  return this.sendCommand(cmd);
+};
+
+// Takes effect with the next setScanParameters.
+Hci.prototype.setScanFilterPolicy = function (useAcceptList) {
+  this._scanFilterPolicy = useAcceptList ? SCAN_FILTER_POLICY_ACCEPT_LIST : SCAN_FILTER_POLICY_ALL;
+};
+
+Hci.prototype.readAcceptListSize = async function () {
+  const cmd = parameterlessCommand(LE_READ_FILTER_ACCEPT_LIST_SIZE_CMD);
+
+  debug(`le read filter accept list size - writing: ${cmd.toString('hex')}`);
+  const result = await this.sendCommand(cmd);
+  return result.readUInt8(0);
+};
+
+Hci.prototype.clearAcceptList = function () {
+  const cmd = parameterlessCommand(LE_CLEAR_FILTER_ACCEPT_LIST_CMD);
+
+  this._acceptList.clear();
+  this._acceptListStale = false;
+
+  debug(`le clear filter accept list - writing: ${cmd.toString('hex')}`);
+  return this.sendCommand(cmd);
+};
+
+const acceptListCommand = function (opcode, address, addressType) {
+  const cmd = commandPacket(opcode, 0x07);
+
+  // data
+  cmd.writeUInt8(addressType === 'random' ? 0x01 : 0x00, 4); // address type
+  Buffer.from(address.split(':').reverse().join(''), 'hex').copy(cmd, 5); // address
+
+  return cmd;
+};
+
+Hci.prototype.addToAcceptList = function (address, addressType) {
+  const cmd = acceptListCommand(LE_ADD_DEVICE_TO_FILTER_ACCEPT_LIST_CMD, address, addressType);
+
+  this._acceptList.set(`${addressType}/${address}`, { address, addressType });
+
+  debug(`le add device to filter accept list - writing: ${cmd.toString('hex')}`);
+  return this.sendCommand(cmd);
+};
+
+Hci.prototype.removeFromAcceptList = function (address, addressType) {
+  const cmd = acceptListCommand(LE_REMOVE_DEVICE_FROM_FILTER_ACCEPT_LIST_CMD, address, addressType);
+
+  this._acceptList.delete(`${addressType}/${address}`);
+
+  debug(`le remove device from filter accept list - writing: ${cmd.toString('hex')}`);
+  return this.sendCommand(cmd);
+};
+
+/**
+ * Makes the controller's Filter Accept List hold exactly these devices ({ address, addressType },
+ * address in lower case). Only the difference to what it holds is sent, every command at once;
+ * the controller takes them in order. Before the first load after a start without HCI_Reset,
+ * the list is cleared, since it may still hold what an earlier run put there. The list may not
+ * change while a scan or connection attempt uses it, so callers stop those first.
+ */
+Hci.prototype.loadAcceptList = function (devices) {
+  const wanted = new Map(devices.map(device => [`${device.addressType}/${device.address}`, device]));
+  const commands = [];
+
+  if (this._acceptListStale) {
+    commands.push(this.clearAcceptList());
+  }
+
+  for (const [key, device] of this._acceptList) {
+    if (!wanted.has(key)) {
+      commands.push(this.removeFromAcceptList(device.address, device.addressType));
+    }
+  }
+  for (const [key, device] of wanted) {
+    if (!this._acceptList.has(key)) {
+      commands.push(this.addToAcceptList(device.address, device.addressType));
+    }
+  }
+
+  return Promise.all(commands);
 };
 
 // This is a mystery case for me. 
@@ -649,21 +1277,11 @@ Hci.prototype.createLeConnAfterReset = function (address, addressType, parameter
   } = parameters;
 
   const useCodedPhy = this._isExtended && this._supportsCodedPhy;
-  const cmd = Buffer.alloc(this._isExtended ? (useCodedPhy ? 46 : 30) : 29);
-
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(
-    this._isExtended
-      ? LE_CREATE_EXTENDED_CONN_CMD
-      : LE_CREATE_CONN_CMD,
-    1
-  );
+  const cmd = this._isExtended
+    ? commandPacket(LE_CREATE_EXTENDED_CONN_CMD, useCodedPhy ? 0x2a : 0x1a)
+    : commandPacket(LE_CREATE_CONN_CMD, 0x19);
 
   if (this._isExtended) {
-    // length
-    cmd.writeUInt8(useCodedPhy ? 0x2a : 0x1a, 3);
-
     // data
     cmd.writeUInt8(0x00, 4); // filter policy: white list is not used
     cmd.writeUInt8(0x00, 5); // own address type
@@ -693,9 +1311,6 @@ Hci.prototype.createLeConnAfterReset = function (address, addressType, parameter
       cmd.writeUInt16LE(0x0000, 44); // max ce length
     }
   } else {
-    // length
-    cmd.writeUInt8(0x19, 3);
-
     // data
     cmd.writeUInt16LE(0x0060, 4); // interval
     cmd.writeUInt16LE(0x0030, 6); // window
@@ -716,7 +1331,8 @@ Hci.prototype.createLeConnAfterReset = function (address, addressType, parameter
 
   debug(`create le conn - writing: ${cmd.toString('hex')}`);
   this._pendingLeConn = { address, addressType, token: attemptToken };
-  this._socket.write(cmd);
+  this.updateEventFilters();
+  return this.sendCommand(cmd);
 };
 
 Hci.prototype.connUpdateLe = function (
@@ -726,14 +1342,7 @@ Hci.prototype.connUpdateLe = function (
   latency,
   supervisionTimeout
 ) {
-  const cmd = Buffer.alloc(18);
-
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(LE_CONN_UPDATE_CMD, 1);
-
-  // length
-  cmd.writeUInt8(0x0e, 3);
+  const cmd = commandPacket(LE_CONN_UPDATE_CMD, 0x0e);
 
   // data
   cmd.writeUInt16LE(handle, 4);
@@ -745,311 +1354,348 @@ Hci.prototype.connUpdateLe = function (
   cmd.writeUInt16LE(0x0000, 16); // max ce length
 
   debug(`conn update le - writing: ${cmd.toString('hex')}`);
-  this._socket.write(cmd);
+  return this.sendCommand(cmd);
 };
 
 Hci.prototype.cancelConnect = function () {
-  const cmd = Buffer.alloc(4);
+  const cmd = parameterlessCommand(LE_CANCEL_CONN_CMD);
 
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(LE_CANCEL_CONN_CMD, 1);
+  debug('cancel le conn - writing: ' + cmd.toString('hex'));
+  return this.sendCommand(cmd);
+};
 
-  // length
-  cmd.writeUInt8(0x0, 3);
+/**
+ * Synchronizes with the periodic advertising train of an extended advertiser, given by its
+ * 48-bit address, address type and SID. The controller looks for the train while scanning
+ * and answers with LE Periodic Sync Established; from then on it reports the train without
+ * scanning, skipping up to skip events, until it has heard nothing for syncTimeout ms.
+ */
+Hci.prototype.createPeriodicSync = function (address, addressType, sid, skip = 0, syncTimeout = 10000) {
+  const cmd = commandPacket(LE_PERIODIC_ADVERTISING_CREATE_SYNC_CMD, 0x0e);
+  const timeout = Math.min(
+    Math.max(Math.round(syncTimeout / PERIODIC_SYNC_TIMEOUT_UNIT), PERIODIC_SYNC_MIN_TIMEOUT),
+    PERIODIC_SYNC_MAX_TIMEOUT
+  );
 
-  debug('cancel le conn - writing: ' + cmd.toString('hex'));
-  this._socket.write(cmd);
+  // data
+  cmd.writeUInt8(0x00, 4); // options: use the given advertiser, reporting enabled
+  cmd.writeUInt8(sid, 5); // advertising SID
+  cmd.writeUInt8(addressType === 'random' ? 0x01 : 0x00, 6); // advertiser address type
+  cmd.writeUIntLE(address, 7, 6); // advertiser address
+  cmd.writeUInt16LE(Math.min(skip, PERIODIC_SYNC_MAX_SKIP), 13); // skip
+  cmd.writeUInt16LE(timeout, 15); // sync timeout, ms / 10
+  cmd.writeUInt8(0x00, 17); // sync CTE type: any
+
+  debug(`le periodic advertising create sync - writing: ${cmd.toString('hex')}`);
+  this._pendingPeriodicSync = { address, addressType, sid };
+  this.updateEventFilters();
+  return this.sendCommand(cmd);
 };
 
-Hci.prototype.startLeEncryption = function (handle, random, diversifier, key) {
-  const cmd = Buffer.alloc(32);
+// The pending Create Sync ends with LE Periodic Sync Established, status Operation Cancelled
+Hci.prototype.cancelPeriodicSync = function () {
+  const cmd = parameterlessCommand(LE_PERIODIC_ADVERTISING_CREATE_SYNC_CANCEL_CMD);
 
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(LE_START_ENCRYPTION_CMD, 1);
+  debug(`le periodic advertising create sync cancel - writing: ${cmd.toString('hex')}`);
+  return this.sendCommand(cmd);
+};
 
-  // length
-  cmd.writeUInt8(0x1c, 3);
+Hci.prototype.terminatePeriodicSync = function (handle) {
+  const cmd = commandPacket(LE_PERIODIC_ADVERTISING_TERMINATE_SYNC_CMD, 0x02);
 
   // data
+  cmd.writeUInt16LE(handle, 4); // sync handle
+
+  debug(`le periodic advertising terminate sync - writing: ${cmd.toString('hex')}`);
+  // Nothing more is reported for it, whatever the controller answers
+  this._periodicSyncs.delete(handle);
+  this.updateEventFilters();
+  return this.sendCommand(cmd);
+};
+
+Hci.prototype.startLeEncryption = function (handle, random, diversifier, key) {
+  const cmd = commandPacket(LE_START_ENCRYPTION_CMD, 0x1c);
+
+  // data
+  cmd.fill(0x00, 4);
   cmd.writeUInt16LE(handle, 4); // handle
   random.copy(cmd, 6);
   diversifier.copy(cmd, 14);
   key.copy(cmd, 16);
 
   debug(`start le encryption - writing: ${cmd.toString('hex')}`);
-  this._socket.write(cmd);
+  return this.sendCommand(cmd);
 };
 
 Hci.prototype.disconnect = function (handle, reason) {
-  const cmd = Buffer.alloc(7);
+  const cmd = commandPacket(DISCONNECT_CMD, 0x03);
 
   reason = reason || HCI_OE_USER_ENDED_CONNECTION;
 
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(DISCONNECT_CMD, 1);
-
-  // length
-  cmd.writeUInt8(0x03, 3);
-
   // data
   cmd.writeUInt16LE(handle, 4); // handle
   cmd.writeUInt8(reason, 6); // reason
 
   debug(`disconnect - writing: ${cmd.toString('hex')}`);
-  this._socket.write(cmd);
+  return this.sendCommand(cmd);
 };
 
 Hci.prototype.readRssi = function (handle) {
-  const cmd = Buffer.alloc(6);
-
-  // header
-  cmd.writeUInt8(HCI_COMMAND_PKT, 0);
-  cmd.writeUInt16LE(READ_RSSI_CMD, 1);
-
-  // length
-  cmd.writeUInt8(0x02, 3);
+  const cmd = commandPacket(READ_RSSI_CMD, 0x02);
 
   // data
   cmd.writeUInt16LE(handle, 4); // handle
 
   debug(`read rssi - writing: ${cmd.toString('hex')}`);
-  this._socket.write(cmd);
+  return this.sendCommand(cmd);
 };
 
 Hci.prototype.writeAclDataPkt = async function (handle, cid, data) {
-  const l2capLength = 4 /* l2cap header */ + data.length;
+  const priority = AclScheduler.priorityOf(cid, data);
+  // Only the first write of a session has to wait for the buffer sizes.
+  const aclBuffers = this._aclBuffers || await this.getAclBuffers();
 
-  const aclBuffers = await this.getAclBuffers();
-  const aclLength = Math.min(l2capLength, aclBuffers.length);
+  this._aclScheduler.push(handle, fragmentAcl(handle, cid, data, aclBuffers.length), priority);
+  this.flushAcl();
+};
 
-  const minFirstLength = Math.max(aclLength + 5 /* acl header */, 9 /* prevent buffer overflow */);
-  const first = Buffer.alloc(minFirstLength);
+Hci.prototype.flushAcl = async function () {
+  if (debug.enabled) {
+    debug(`flush - pending: ${this._aclPending} queue length: ${this._aclScheduler.length}`);
+  }
 
-  // acl header
-  first.writeUInt8(HCI_ACLDATA_PKT, 0);
-  first.writeUInt16LE(handle | (ACL_START_NO_FLUSH << 12), 1);
-  first.writeUInt16LE(aclLength, 3);
+  const aclBuffers = this._aclBuffers || await this.getAclBuffers();
+  const batch = [];
+  while (this._aclScheduler.length > 0 && this._aclPending < aclBuffers.num) {
+    const { handle, packet } = this._aclScheduler.shift();
+    const connection = this._aclConnections.get(handle);
+    if (!connection) {
+      continue;
+    }
+    connection.pending++;
+    this._aclPending++;
+    if (debug.enabled) {
+      debug(`write acl data packet - writing: ${packet.toString('hex')}`);
+    }
+    batch.push(packet);
+  }
 
-  // l2cap header
-  first.writeUInt16LE(data.length, 5);
-  first.writeUInt16LE(cid, 7);
+  this.writePackets(batch);
+};
 
-  data.copy(first, 9);
-  data = data.slice(first.length - 9);
+Hci.prototype.writePacket = function (packet) {
+  if (this._btsnoop !== null) {
+    this._btsnoop.write(packet, false);
+  }
+  this._socket.write(packet);
+};
 
-  debug(`push to acl queue: ${first.toString('hex')}`);
-  this._aclQueue.push({ handle, packet: first });
+// Drivers with a writev() take a batch in one call; the rest get a write() per packet.
+Hci.prototype.writePackets = function (packets) {
+  if (packets.length < 2 || typeof this._socket.writev !== 'function') {
+    packets.forEach(packet => this.writePacket(packet));
+    return;
+  }
 
-  while (data.length > 0) {
-    const fragAclLength = Math.min(data.length, aclBuffers.length);
-    const frag = Buffer.alloc(fragAclLength + 5 /* acl header */);
-    // acl header
-    frag.writeUInt8(HCI_ACLDATA_PKT, 0);
-    frag.writeUInt16LE(handle | (ACL_CONT << 12), 1);
-    frag.writeUInt16LE(fragAclLength, 3);
+  if (this._btsnoop !== null) {
+    packets.forEach(packet => this._btsnoop.write(packet, false));
+  }
+  this._socket.writev(packets);
+};
 
-    data.copy(frag, 5);
-    data = data.slice(frag.length - 5);
+Hci.prototype.onSocketData = function (data) {
+  if (this._btsnoop !== null) {
+    this._btsnoop.write(data, true);
+  }
 
-    debug(`push fragment to acl queue: ${frag.toString('hex')}`);
-    this._aclQueue.push({ handle, packet: frag });
+  if (debug.enabled) {
+    debug(`onSocketData: ${data.toString('hex')}`);
   }
 
-  this.flushAcl();
+  const handler = PACKET_HANDLERS[data[0]];
+  if (handler !== undefined) {
+    this[handler](data);
+  }
 };
 
-Hci.prototype.flushAcl = async function () {
-  const pendingPackets = () => {
-    let totalPending = 0;
-    for (const { pending } of this._aclConnections.values()) {
-      totalPending += pending;
-    }
-    return totalPending;
-  };
+Hci.prototype.onEventPacket = function (data) {
+  const handler = EVENT_HANDLERS[data[1]];
+  if (handler !== undefined) {
+    this[handler](data);
+  }
+};
 
-  debug(
-    `flush - pending: ${pendingPackets()} queue length: ${
-      this._aclQueue.length
-    }`
-  );
+Hci.prototype.onAclDataPacket = function (data) {
+  const flags = data.readUInt16LE(1) >> 12;
+  const handle = data.readUInt16LE(1) & 0x0fff;
 
-  const aclBuffers = await this.getAclBuffers();
-  while (this._aclQueue.length > 0 && pendingPackets() < aclBuffers.num) {
-    const { handle, packet } = this._aclQueue.shift();
-    const connection = this._aclConnections.get(handle);
-    if (!connection) {
-      continue;
-    }
-    connection.pending++;
-    debug(`write acl data packet - writing: ${packet.toString('hex')}`);
-    this._socket.write(packet);
-  }
+  this.processAclData(handle, flags, data);
 };
 
-Hci.prototype.onSocketData = function (data) {
-  debug(`onSocketData: ${data.toString('hex')}`);
+// Commands show up here when another process on a raw socket sends them.
+Hci.prototype.onCommandPacket = function (data) {
+  const cmd = data.readUInt16LE(1);
 
-  const eventType = data.readUInt8(0);
-  let handle;
-  let cmd;
-  let status;
+  if (debug.enabled) {
+    debug(`\t\tcmd = ${cmd}`);
+    debug(`\t\tdata len = ${data.readUInt8(3)}`);
+  }
 
-  debug(`\tevent type = ${eventType}`);
+  if (
+    cmd === LE_SET_SCAN_ENABLE_CMD ||
+    cmd === LE_SET_EXTENDED_SCAN_ENABLE_CMD
+  ) {
+    const enable = data.readUInt8(4) === 0x1;
+    const filterDuplicates = data.readUInt8(5) === 0x1;
 
-  if (HCI_EVENT_PKT === eventType) {
-    const subEventType = data.readUInt8(1);
+    debug('\t\t\tLE enable scan command');
+    debug(`\t\t\tenable scanning = ${enable}`);
+    debug(`\t\t\tfilter duplicates = ${filterDuplicates}`);
 
-    debug(`\tsub event type = ${subEventType}`);
+    // Another user of the adapter started or stopped a scan; its reports are ours too.
+    this._scanEnabled = enable;
+    this.updateEventFilters();
 
-    if (subEventType === EVT_DISCONN_COMPLETE) {
-      handle = data.readUInt16LE(4);
-      const reason = data.readUInt8(6);
+    this.emit('leScanEnableSetCmd', enable, filterDuplicates);
+  }
+};
 
-      debug(`\t\thandle = ${handle}`);
-      debug(`\t\treason = ${reason}`);
+Hci.prototype.onDisconnComplete = function (data) {
+  const handle = data.readUInt16LE(4);
+  const reason = data.readUInt8(6);
 
-      this._aclQueue = this._aclQueue.filter((acl) => acl.handle !== handle);
-      this._aclConnections.delete(handle);
-      this.flushAcl();
+  if (debug.enabled) {
+    debug(`\t\thandle = ${handle}`);
+    debug(`\t\treason = ${reason}`);
+  }
 
-      this.emit('disconnComplete', handle, reason);
-    } else if (subEventType === EVT_ENCRYPT_CHANGE) {
-      handle = data.readUInt16LE(4);
-      const encrypt = data.readUInt8(6);
+  // The controller frees the buffers of a connection that is gone.
+  const connection = this._aclConnections.get(handle);
+  if (connection) {
+    this._aclPending -= connection.pending;
+  }
+  this._aclScheduler.remove(handle);
+  this._aclConnections.delete(handle);
+  this._handleBuffers.delete(handle);
+  this.flushAcl();
+  this.updateEventFilters();
 
-      debug(`\t\thandle = ${handle}`);
-      debug(`\t\tencrypt = ${encrypt}`);
+  this.emit('disconnComplete', handle, reason);
+};
 
-      this.emit('encryptChange', handle, encrypt);
-    } else if (subEventType === EVT_CMD_COMPLETE) {
-      cmd = data.readUInt16LE(4);
-      status = data.readUInt8(6);
-      const result = data.slice(7);
+Hci.prototype.onEncryptChange = function (data) {
+  const handle = data.readUInt16LE(4);
+  const encrypt = data.readUInt8(6);
 
-      debug(`\t\tcmd = ${cmd}`);
-      debug(`\t\tstatus = ${status}`);
-      debug(`\t\tresult = ${result.toString('hex')}`);
+  if (debug.enabled) {
+    debug(`\t\thandle = ${handle}`);
+    debug(`\t\tencrypt = ${encrypt}`);
+  }
 
-      this.processCmdCompleteEvent(cmd, status, result);
-    } else if (subEventType === EVT_CMD_STATUS) {
-      status = data.readUInt8(3);
-      cmd = data.readUInt16LE(5);
+  this.emit('encryptChange', handle, encrypt);
+};
 
-      debug(`\t\tstatus = ${status}`);
-      debug(`\t\tcmd = ${cmd}`);
+Hci.prototype.onCmdComplete = function (data) {
+  const cmd = data.readUInt16LE(4);
+  const status = data.readUInt8(6);
+  const result = data.subarray(7);
 
-      this.processCmdStatusEvent(cmd, status);
-    } else if (subEventType === EVT_LE_META_EVENT) {
-      const leMetaEventLength = data.readUInt8(2);
-      const leMetaEventType = data.readUInt8(3);
-      const leMetaEventNumReports = data.readUInt8(4);
-      const leMetaEventData = data.slice(5);
+  if (debug.enabled) {
+    debug(`\t\tcmd = ${cmd}`);
+    debug(`\t\tstatus = ${status}`);
+    debug(`\t\tresult = ${result.toString('hex')}`);
+  }
 
-      debug(`\t\tLE meta event type = ${leMetaEventType}`);
-      debug(`\t\tLE meta event data length = ${leMetaEventLength}`);
-      debug(`\t\tLE meta event num reports = ${leMetaEventNumReports}`);
-      debug(`\t\tLE meta event data = ${leMetaEventData.toString('hex')}`);
+  this.completeCommand(cmd, data.readUInt8(3), status, result);
+  this.processCmdCompleteEvent(cmd, status, result);
+};
 
-      this.processLeMetaEvent(
-        leMetaEventType,
-        leMetaEventNumReports,
-        leMetaEventData
-      );
-    } else if (subEventType === EVT_NUMBER_OF_COMPLETED_PACKETS) {
-      const handles = data.readUInt8(3);
-      for (let h = 0; h < handles; h++) {
-        const handle = data.readUInt16LE(4 + h * 4);
-        const pkts = data.readUInt16LE(6 + h * 4);
-        debug(`\thandle = ${handle}`);
-        debug(`\t\tcompleted = ${pkts}`);
-
-        if (!this._aclConnections.has(handle)) {
-          debug('\t\tclosed');
-          continue;
-        }
+Hci.prototype.onCmdStatus = function (data) {
+  const status = data.readUInt8(3);
+  const cmd = data.readUInt16LE(5);
 
-        const connection = this._aclConnections.get(handle);
+  if (debug.enabled) {
+    debug(`\t\tstatus = ${status}`);
+    debug(`\t\tcmd = ${cmd}`);
+  }
 
-        connection.pending -= pkts;
+  this.completeCommand(cmd, data.readUInt8(4), status);
+  this.processCmdStatusEvent(cmd, status);
+};
 
-        if (connection.pending < 0) {
-          connection.pending = 0;
-        }
-      }
-      this.flushAcl();
-    }
-  } else if (HCI_ACLDATA_PKT === eventType) {
-    const flags = data.readUInt16LE(1) >> 12;
-    handle = data.readUInt16LE(1) & 0x0fff;
+Hci.prototype.onLeMetaEvent = function (data) {
+  const leMetaEventType = data.readUInt8(3);
+  const leMetaEventNumReports = data.readUInt8(4);
+  const leMetaEventData = data.subarray(5);
 
-    if (ACL_START === flags) {
-      const cid = data.readUInt16LE(7);
+  if (this.isLeEventSuppressed(leMetaEventType)) {
+    return;
+  }
 
-      const length = data.readUInt16LE(5);
-      const pktData = data.slice(9);
+  if (debug.enabled) {
+    debug(`\t\tLE meta event type = ${leMetaEventType}`);
+    debug(`\t\tLE meta event data length = ${data.readUInt8(2)}`);
+    debug(`\t\tLE meta event num reports = ${leMetaEventNumReports}`);
+    debug(`\t\tLE meta event data = ${leMetaEventData.toString('hex')}`);
+  }
 
-      debug(`\t\tcid = ${cid}`);
+  this.processLeMetaEvent(
+    leMetaEventType,
+    leMetaEventNumReports,
+    leMetaEventData
+  );
+};
 
-      if (length === pktData.length) {
-        debug(`\t\thandle = ${handle}`);
-        debug(`\t\tdata = ${pktData.toString('hex')}`);
+// Sent before the filters narrowed, or generated for another user of a shared adapter.
+Hci.prototype.isLeEventSuppressed = function (leMetaEventType) {
+  if ((this._leEventsSuppressed & (1 << (leMetaEventType - 1))) === 0) {
+    return false;
+  }
+  this._eventFilterStats.suppressed++;
+  this._eventFilterStats.suppressedSinceUpdate++;
+  return true;
+};
 
-        this.emit('aclDataPkt', handle, cid, pktData);
-      } else {
-        this._handleBuffers[handle] = {
-          length,
-          cid,
-          data: pktData
-        };
-      }
-    } else if (ACL_CONT === flags) {
-      if (!this._handleBuffers[handle] || !this._handleBuffers[handle].data) {
-        return;
-      }
+Hci.prototype.onDecodedAdvertisingReport = function (type, address, addressType, rssi, eir) {
+  if (this.isLeEventSuppressed(EVT_LE_ADVERTISING_REPORT)) {
+    return;
+  }
+  this.emit('leAdvertisingReport', 0, type, address, addressType, eir, rssi);
+};
 
-      this._handleBuffers[handle].data = Buffer.concat([
-        this._handleBuffers[handle].data,
-        data.slice(5)
-      ]);
-
-      if (
-        this._handleBuffers[handle].data.length ===
-        this._handleBuffers[handle].length
-      ) {
-        this.emit(
-          'aclDataPkt',
-          handle,
-          this._handleBuffers[handle].cid,
-          this._handleBuffers[handle].data
-        );
-
-        delete this._handleBuffers[handle];
-      }
-    }
-  } else if (HCI_COMMAND_PKT === eventType) {
-    cmd = data.readUInt16LE(1);
-    const len = data.readUInt8(3);
+Hci.prototype.onDecodedExtendedAdvertisingReport = function (type, address, addressType, txPower, rssi, eir, sid, periodicInterval) {
+  if (this.isLeEventSuppressed(EVT_LE_EXTENDED_ADVERTISING_REPORT)) {
+    return;
+  }
+  this.emit('leExtendedAdvertisingReport', 0, type, address, addressType, txPower, rssi, eir, sid, periodicInterval * 1.25);
+};
 
-    debug(`\t\tcmd = ${cmd}`);
-    debug(`\t\tdata len = ${len}`);
+Hci.prototype.onDecodedAclData = function (handle, cid, data) {
+  this.emit('aclDataPkt', handle, cid, data);
+};
 
-    if (
-      cmd === LE_SET_SCAN_ENABLE_CMD ||
-      cmd === LE_SET_EXTENDED_SCAN_ENABLE_CMD
-    ) {
-      const enable = data.readUInt8(4) === 0x1;
-      const filterDuplicates = data.readUInt8(5) === 0x1;
+Hci.prototype.onNumberOfCompletedPackets = function (data) {
+  const handles = data.readUInt8(3);
+  for (let h = 0; h < handles; h++) {
+    const handle = data.readUInt16LE(4 + h * 4);
+    const pkts = data.readUInt16LE(6 + h * 4);
+    const connection = this._aclConnections.get(handle);
 
-      debug('\t\t\tLE enable scan command');
-      debug(`\t\t\tenable scanning = ${enable}`);
-      debug(`\t\t\tfilter duplicates = ${filterDuplicates}`);
+    if (debug.enabled) {
+      debug(`\thandle = ${handle}`);
+      debug(`\t\tcompleted = ${pkts}${connection ? '' : ' (closed)'}`);
+    }
 
-      this.emit('leScanEnableSetCmd', enable, filterDuplicates);
+    if (connection === undefined) {
+      continue;
     }
+
+    const completed = Math.min(pkts, connection.pending);
+
+    connection.pending -= completed;
+    this._aclPending -= completed;
   }
+  this.flushAcl();
 };
 
 Hci.prototype.onSocketError = function (error) {
@@ -1067,198 +1713,284 @@ Hci.prototype.onSocketError = function (error) {
   }
 };
 
-Hci.prototype.processCmdCompleteEvent = function (cmd, status, result) {
-  if (cmd === RESET_CMD) {
-    this.afterReset();
-  } else if (cmd === LE_READ_LOCAL_SUPPORTED_FEATURES) {
-    if (status === 0) {
-      if (!this._extendedModeConfigured) {
-        // Auto-detect from the LE Extended Advertising feature bit (12).
-        this._isExtended = (result[1] & (1 << 4)) !== 0;
-      }
-      // LE Coded PHY feature bit (11).
-      this._supportsCodedPhy = (result[1] & (1 << 3)) !== 0;
-      // LE Data Packet Length Extension feature bit (5).
-      this._supportsDataLengthExtension = (result[0] & (1 << 5)) !== 0;
-      this.emit('leFeatures', result);
-    } else {
-      debug(`le read local supported features failed - status: ${status}`);
+// Reassembles L2CAP PDUs into a buffer of their full length, allocated from the start fragment.
+Hci.prototype.processAclData = function (handle, flags, data) {
+  if (ACL_START === flags) {
+    const previous = this._handleBuffers.get(handle);
+    if (previous !== undefined && !previous.discard) {
+      this.dropAclData(handle, 'incomplete pdu');
     }
+    this._handleBuffers.delete(handle);
 
-    if (this._codedPhy && this._supportsCodedPhy) {
-      this.setCodedPhySupport();
+    if (data.length < 9) {
+      this.dropAclData(handle, 'short start fragment');
+      return;
     }
 
-    if (this._supportsDataLengthExtension) {
-      this.readLeMaxDataLength();
-    } else {
-      this._maxDataLength = null;
-    }
+    const length = data.readUInt16LE(5);
+    const cid = data.readUInt16LE(7);
+    const pktData = data.subarray(9);
 
-    this.setEventMask();
-    this.setLeEventMask();
-    this.readLocalVersion();
-    this.writeLeHostSupported();
-    this.readLeHostSupported();
-    this.readLeBufferSize();
-    this.readBdAddr();
-  } else if (cmd === LE_SET_DATA_LENGTH_CMD) {
-    if (status !== 0) {
-      debug(`le set data length failed - status: ${status}`);
+    debug(`\t\tcid = ${cid}`);
+
+    if (length === pktData.length) {
+      if (debug.enabled) {
+        debug(`\t\thandle = ${handle}`);
+        debug(`\t\tdata = ${pktData.toString('hex')}`);
+      }
+
+      this.emit('aclDataPkt', handle, cid, pktData);
+    } else if (length > this._maxSduLength || pktData.length > length) {
+      this.dropAclData(handle, `pdu length ${length}`);
+      // Swallow its continuations too, rather than reporting each one.
+      this._handleBuffers.set(handle, { discard: true });
+    } else {
+      const buffer = {
+        length,
+        cid,
+        data: Buffer.allocUnsafe(length),
+        offset: pktData.length
+      };
+      pktData.copy(buffer.data, 0);
+      this._handleBuffers.set(handle, buffer);
     }
-  } else if (cmd === LE_READ_MAX_DATA_LENGTH_CMD) {
-    if (status !== 0 || result.length < 8) {
-      debug(`le read maximum data length failed or returned a short result - status: ${status}, length: ${result.length}`);
+  } else if (ACL_CONT === flags) {
+    const buffer = this._handleBuffers.get(handle);
+    if (buffer === undefined) {
+      this.dropAclData(handle, 'continuation without start');
       return;
     }
-
-    const txOctets = result.readUInt16LE(0);
-    const txTime = result.readUInt16LE(2);
-    const rxOctets = result.readUInt16LE(4);
-    const rxTime = result.readUInt16LE(6);
-
-    debug(`\t\t\tsupported max tx octets = ${txOctets}`);
-    debug(`\t\t\tsupported max tx time = ${txTime}`);
-    debug(`\t\t\tsupported max rx octets = ${rxOctets}`);
-    debug(`\t\t\tsupported max rx time = ${rxTime}`);
-
-    if (txOctets < LE_MIN_TX_OCTETS || txTime < LE_MIN_TX_TIME) {
-      debug(`le read maximum data length returned values below the spec minimum - octets: ${txOctets}, time: ${txTime}`);
-      this._maxDataLength = null;
+    if (buffer.discard) {
       return;
     }
 
-    this._maxDataLength = {
-      txOctets: Math.min(txOctets, LE_MAX_TX_OCTETS),
-      txTime: Math.min(txTime, LE_MAX_TX_TIME)
-    };
-  } else if (cmd === READ_LE_HOST_SUPPORTED_CMD && status === 0) {
-    const le = result.readUInt8(0);
-    const simul = result.readUInt8(1);
-
-    debug(`\t\t\tle = ${le}`);
-    debug(`\t\t\tsimul = ${simul}`);
-  } else if (cmd === READ_LOCAL_VERSION_CMD) {
-    if (status !== 0 || result.length < 8) {
-      debug(`read local version failed or returned a short result - status: ${status}, length: ${result.length}`);
+    const fragment = data.subarray(5);
+    if (buffer.offset + fragment.length > buffer.length) {
+      this.dropAclData(handle, 'pdu overrun');
       return;
     }
 
-    const hciVer = result.readUInt8(0);
-    const hciRev = result.readUInt16LE(1);
-    const lmpVer = result.readInt8(3);
-    const manufacturer = result.readUInt16LE(4);
-    const lmpSubVer = result.readUInt16LE(6);
-
-    if (hciVer < 0x06) {
-      this.emit('stateChange', 'unsupported');
-    } else if (this._state !== 'poweredOn') {
-      this.setScanEnabled(false, true);
-      this.setScanParameters();
+    buffer.offset += fragment.copy(buffer.data, buffer.offset);
+
+    if (buffer.offset === buffer.length) {
+      this._handleBuffers.delete(handle);
+      this.emit('aclDataPkt', handle, buffer.cid, buffer.data);
     }
+  }
+};
 
-    // Update manufacturer
-    this._manufacturer = manufacturer;
+Hci.prototype.dropAclData = function (handle, reason) {
+  debug(`dropping acl data - handle: ${handle}, reason: ${reason}`);
+  this._handleBuffers.delete(handle);
+  this.emit('aclDataDropped', handle, reason);
+};
 
-    this.emit(
-      'readLocalVersion',
-      hciVer,
-      hciRev,
-      lmpVer,
-      manufacturer,
-      lmpSubVer
-    );
-  } else if (cmd === READ_SUPPORTED_COMMANDS_CMD) {
-    if (status !== 0 || result.length < 38) {
-      debug(`read supported commands failed or returned a short result - status: ${status}, length: ${result.length}`);
-      return;
+Hci.prototype.processCmdCompleteEvent = function (cmd, status, result) {
+  const handler = CMD_COMPLETE_HANDLERS.get(cmd);
+  if (handler !== undefined) {
+    this[handler](status, result);
+  }
+};
+
+Hci.prototype.processLeReadLocalSupportedFeatures = function (status, result) {
+  if (status === 0) {
+    if (!this._extendedModeConfigured) {
+      // Auto-detect from the LE Extended Advertising feature bit (12).
+      this._isExtended = (result[1] & (1 << 4)) !== 0;
     }
+    // LE Coded PHY feature bit (11).
+    this._supportsCodedPhy = (result[1] & (1 << 3)) !== 0;
+    // LE Data Packet Length Extension feature bit (5).
+    this._supportsDataLengthExtension = (result[0] & (1 << 5)) !== 0;
+    this.emit('leFeatures', result);
+  } else {
+    debug(`le read local supported features failed - status: ${status}`);
+  }
 
-    const extendedScanParameters = result.readUInt8(37) & 0x10; // LE Set Extended Scan Parameters (Octet 37 - Bit 5)
-    const extendedScan = result.readUInt8(37) & 0x20; // LE Set Extended Scan Enable (Octet 37 - Bit 6)
+  // Fast start issues the rest itself
+  if (this._fastStarting) {
+    return;
+  }
 
-    debug(
-      `Extended advertising features: parameters = ${
-        extendedScanParameters ? 'true' : 'false'
-      }, num = ${extendedScan ? 'true' : 'false'}`
-    );
+  if (this._codedPhy && this._supportsCodedPhy) {
+    this.setCodedPhySupport();
+  }
 
-  } else if (cmd === READ_BD_ADDR_CMD) {
-    if (status !== 0 || result.length < 6) {
-      debug(`read bd addr failed or returned a short result - status: ${status}, length: ${result.length}`);
-      return;
-    }
+  if (this._supportsDataLengthExtension) {
+    this.readLeMaxDataLength();
+  } else {
+    this._maxDataLength = null;
+  }
 
-    this.addressType = 'public';
-    this.address = result
-      .toString('hex')
-      .match(/.{1,2}/g)
-      .reverse()
-      .join(':');
+  this.setEventMask();
+  this.setLeEventMask();
+  this.readLocalVersion();
+  this.writeLeHostSupported();
+  this.readLeHostSupported();
+  this.readLeBufferSize();
+  this.readBdAddr();
+};
 
-    debug(`address = ${this.address}`);
+Hci.prototype.processLeSetDataLength = function (status) {
+  if (status !== 0) {
+    debug(`le set data length failed - status: ${status}`);
+  }
+};
 
-    this.emit('addressChange', this.address);
-  } else if (
-    cmd === LE_SET_SCAN_PARAMETERS_CMD ||
-    cmd === LE_SET_EXTENDED_SCAN_PARAMETERS_CMD
-  ) {
-    this.emit('stateChange', 'poweredOn');
+Hci.prototype.processLeReadMaxDataLength = function (status, result) {
+  if (status !== 0 || result.length < 8) {
+    debug(`le read maximum data length failed or returned a short result - status: ${status}, length: ${result.length}`);
+    return;
+  }
 
-    this.emit('leScanParametersSet');
-  } else if (
-    cmd === LE_SET_SCAN_ENABLE_CMD ||
-    cmd === LE_SET_EXTENDED_SCAN_ENABLE_CMD
-  ) {
-    this.emit('leScanEnableSet', status);
-  } else if (cmd === READ_RSSI_CMD) {
-    const handle = result.readUInt16LE(0);
-    const rssi = result.readInt8(2);
+  const txOctets = result.readUInt16LE(0);
+  const txTime = result.readUInt16LE(2);
+  const rxOctets = result.readUInt16LE(4);
+  const rxTime = result.readUInt16LE(6);
 
-    debug(`\t\t\thandle = ${handle}`);
-    debug(`\t\t\trssi = ${rssi}`);
-
-    this.emit('rssiRead', handle, rssi);
-  } else if (cmd === LE_READ_BUFFER_SIZE_CMD) {
-    const aclLength = status === 0 ? result.readUInt16LE(0) : 0;
-    const aclNum = status === 0 ? result.readUInt8(2) : 0;
-
-    /* Spec Vol 4 Part E.7.8
-    /* No dedicated LE Buffer exists. Use the HCI_Read_Buffer_Size command. */
-    if (aclLength === 0 || aclNum === 0) {
-      debug(`using br/edr buffer size - le status: ${status}`);
-      this.readBufferSize();
-    } else {
-      debug(`le buffer size: length = ${aclLength}, num = ${aclNum}`);
-      this.setAclBuffers(aclLength, aclNum);
-    }
-  } else if (cmd === READ_BUFFER_SIZE_CMD) {
-    const aclLength = status === 0 ? result.readUInt16LE(0) : 0;
-    const aclNum = status === 0 ? result.readUInt16LE(3) : 0;
+  debug(`\t\t\tsupported max tx octets = ${txOctets}`);
+  debug(`\t\t\tsupported max tx time = ${txTime}`);
+  debug(`\t\t\tsupported max rx octets = ${rxOctets}`);
+  debug(`\t\t\tsupported max rx time = ${rxTime}`);
 
-    if (aclLength === 0 || aclNum === 0) {
-      debug(`no usable buffer size reported - falling back to le minimum - status: ${status}`);
-      this.setAclBuffers(LE_MIN_ACL_LENGTH, 1);
-    } else {
-      debug(`buffer size: length = ${aclLength}, num = ${aclNum}`);
-      this.setAclBuffers(aclLength, aclNum);
-    }
+  if (txOctets < LE_MIN_TX_OCTETS || txTime < LE_MIN_TX_TIME) {
+    debug(`le read maximum data length returned values below the spec minimum - octets: ${txOctets}, time: ${txTime}`);
+    this._maxDataLength = null;
+    return;
+  }
+
+  this._maxDataLength = {
+    txOctets: Math.min(txOctets, LE_MAX_TX_OCTETS),
+    txTime: Math.min(txTime, LE_MAX_TX_TIME)
+  };
+};
+
+Hci.prototype.processReadLeHostSupported = function (status, result) {
+  if (status !== 0) {
+    return;
+  }
+
+  const le = result.readUInt8(0);
+  const simul = result.readUInt8(1);
+
+  debug(`\t\t\tle = ${le}`);
+  debug(`\t\t\tsimul = ${simul}`);
+};
+
+Hci.prototype.processReadLocalVersion = function (status, result) {
+  if (status !== 0 || result.length < 8) {
+    debug(`read local version failed or returned a short result - status: ${status}, length: ${result.length}`);
+    return;
+  }
+
+  const hciVer = result.readUInt8(0);
+  const hciRev = result.readUInt16LE(1);
+  const lmpVer = result.readInt8(3);
+  const manufacturer = result.readUInt16LE(4);
+  const lmpSubVer = result.readUInt16LE(6);
+
+  if (hciVer < 0x06) {
+    this.emit('stateChange', 'unsupported');
+  } else if (this._state !== 'poweredOn' && !this._fastStarting) {
+    this.setScanEnabled(false, true);
+    this.setScanParameters();
+  }
+
+  // Update manufacturer
+  this._manufacturer = manufacturer;
+
+  this.emit(
+    'readLocalVersion',
+    hciVer,
+    hciRev,
+    lmpVer,
+    manufacturer,
+    lmpSubVer
+  );
+};
+
+Hci.prototype.processReadSupportedCommands = function (status, result) {
+  if (status !== 0 || result.length < 38) {
+    debug(`read supported commands failed or returned a short result - status: ${status}, length: ${result.length}`);
+    return;
+  }
+
+  const extendedScanParameters = result.readUInt8(37) & 0x10; // LE Set Extended Scan Parameters (Octet 37 - Bit 5)
+  const extendedScan = result.readUInt8(37) & 0x20; // LE Set Extended Scan Enable (Octet 37 - Bit 6)
+
+  debug(
+    `Extended advertising features: parameters = ${
+      extendedScanParameters ? 'true' : 'false'
+    }, num = ${extendedScan ? 'true' : 'false'}`
+  );
+};
+
+Hci.prototype.processReadBdAddr = function (status, result) {
+  if (status !== 0 || result.length < 6) {
+    debug(`read bd addr failed or returned a short result - status: ${status}, length: ${result.length}`);
+    return;
+  }
+
+  this.addressType = 'public';
+  this.address = addressAt(result, 0);
+
+  debug(`address = ${this.address}`);
+
+  this.emit('addressChange', this.address);
+};
+
+Hci.prototype.processLeSetScanParameters = function () {
+  this.emit('stateChange', 'poweredOn');
+
+  this.emit('leScanParametersSet');
+};
+
+Hci.prototype.processLeSetScanEnable = function (status) {
+  this.emit('leScanEnableSet', status);
+};
+
+Hci.prototype.processReadRssi = function (status, result) {
+  const handle = result.readUInt16LE(0);
+  const rssi = result.readInt8(2);
+
+  debug(`\t\t\thandle = ${handle}`);
+  debug(`\t\t\trssi = ${rssi}`);
+
+  this.emit('rssiRead', handle, rssi);
+};
+
+Hci.prototype.processLeReadBufferSize = function (status, result) {
+  const aclLength = status === 0 ? result.readUInt16LE(0) : 0;
+  const aclNum = status === 0 ? result.readUInt8(2) : 0;
+
+  /* Spec Vol 4 Part E.7.8
+  /* No dedicated LE Buffer exists. Use the HCI_Read_Buffer_Size command. */
+  if (aclLength === 0 || aclNum === 0) {
+    debug(`using br/edr buffer size - le status: ${status}`);
+    this.readBufferSize();
+  } else {
+    debug(`le buffer size: length = ${aclLength}, num = ${aclNum}`);
+    this.setAclBuffers(aclLength, aclNum);
+  }
+};
+
+Hci.prototype.processReadBufferSize = function (status, result) {
+  const aclLength = status === 0 ? result.readUInt16LE(0) : 0;
+  const aclNum = status === 0 ? result.readUInt16LE(3) : 0;
+
+  if (aclLength === 0 || aclNum === 0) {
+    debug(`no usable buffer size reported - falling back to le minimum - status: ${status}`);
+    this.setAclBuffers(LE_MIN_ACL_LENGTH, 1);
+  } else {
+    debug(`buffer size: length = ${aclLength}, num = ${aclNum}`);
+    this.setAclBuffers(aclLength, aclNum);
   }
 };
 
 Hci.prototype.processLeMetaEvent = function (eventType, numReports, data) {
-  if (eventType === EVT_LE_CONN_COMPLETE) {
-    this.processLeConnComplete(numReports, data);
-  } else if (eventType === EVT_LE_ENHANCED_CONN_COMPLETE) {
-    this.processLeEnhancedConnComplete(numReports, data);
-  } else if (eventType === EVT_LE_ADVERTISING_REPORT) {
-    this.processLeAdvertisingReport(numReports, data);
-  } else if (eventType === EVT_LE_EXTENDED_ADVERTISING_REPORT) {
-    this.processLeExtendedAdvertisingReport(numReports, data);
-  } else if (eventType === EVT_LE_CONN_UPDATE_COMPLETE) {
-    this.processLeConnUpdateComplete(numReports, data);
-  } else if (eventType === EVT_LE_DATA_LENGTH_CHANGE) {
-    this.processLeDataLengthChange(numReports, data);
+  const handler = LE_META_HANDLERS[eventType];
+  if (handler !== undefined) {
+    this[handler](numReports, data);
   }
 };
 
@@ -1297,12 +2029,7 @@ Hci.prototype.processLeConnComplete = function (status, data) {
   const handle = data.readUInt16LE(0);
   const role = data.readUInt8(2);
   const addressType = data.readUInt8(3) === 0x01 ? 'random' : 'public';
-  const address = data
-    .slice(4, 10)
-    .toString('hex')
-    .match(/.{1,2}/g)
-    .reverse()
-    .join(':');
+  const address = addressAt(data, 4);
   const interval = data.readUInt16LE(10) * 1.25;
   const latency = data.readUInt16LE(12); // TODO: multiplier?
   const supervisionTimeout = data.readUInt16LE(14) * 10;
@@ -1332,6 +2059,7 @@ Hci.prototype.processLeConnComplete = function (status, data) {
   if (matchesPendingAttempt) {
     this._pendingLeConn = null;
   }
+  this.updateEventFilters();
 
   const eventArguments = [
     status,
@@ -1362,24 +2090,9 @@ Hci.prototype.processLeEnhancedConnComplete = function (status, data) {
   const handle = data.readUInt16LE(0);
   const role = data.readUInt8(2);
   const addressType = data.readUInt8(3) === 0x01 ? 'random' : 'public';
-  const address = data
-    .slice(4, 10)
-    .toString('hex')
-    .match(/.{1,2}/g)
-    .reverse()
-    .join(':');
-  const localResolvablePrivateAddress = data
-    .slice(10, 16)
-    .toString('hex')
-    .match(/.{1,2}/g)
-    .reverse()
-    .join(':');
-  const peerResolvablePrivateAddress = data
-    .slice(16, 22)
-    .toString('hex')
-    .match(/.{1,2}/g)
-    .reverse()
-    .join(':');
+  const address = addressAt(data, 4);
+  const localResolvablePrivateAddress = addressAt(data, 10);
+  const peerResolvablePrivateAddress = addressAt(data, 16);
   const interval = data.readUInt16LE(22) * 1.25;
   const latency = data.readUInt16LE(24); // TODO: multiplier?
   const supervisionTimeout = data.readUInt16LE(26) * 10;
@@ -1416,6 +2129,7 @@ Hci.prototype.processLeEnhancedConnComplete = function (status, data) {
   if (matchesPendingAttempt) {
     this._pendingLeConn = null;
   }
+  this.updateEventFilters();
 
   const eventArguments = [
     status,
@@ -1436,128 +2150,181 @@ Hci.prototype.processLeEnhancedConnComplete = function (status, data) {
 };
 
 Hci.prototype.processLeAdvertisingReport = function (numReports, data) {
-  try {
-    for (let i = 0; i < numReports; i++) {
-      const type = data.readUInt8(0);
-      const addressType = data.readUInt8(1) === 0x01 ? 'random' : 'public';
-      const address = data
-        .slice(2, 8)
-        .toString('hex')
-        .match(/.{1,2}/g)
-        .reverse()
-        .join(':');
-      const eirLength = data.readUInt8(8);
-      const eir = data.slice(9, eirLength + 9);
-      const rssi = data.readInt8(eirLength + 9);
-
-      debug(`\t\t\ttype = ${type}`);
-      debug(`\t\t\taddress = ${address}`);
-      debug(`\t\t\taddress type = ${addressType}`);
-      debug(`\t\t\teir = ${eir.toString('hex')}`);
-      debug(`\t\t\trssi = ${rssi}`);
+  // Reports arrive by the thousand while scanning; skip decoding when nobody listens.
+  if (this.listenerCount('leAdvertisingReport') === 0 && !debug.enabled) {
+    return;
+  }
 
-      this.emit(
-        'leAdvertisingReport',
-        0,
-        type,
-        address,
-        addressType,
-        eir,
-        rssi
+  const report = new AdvertisingReport(data, 0);
+  for (let i = 0; i < numReports; i++) {
+    if (!report.isComplete()) {
+      console.warn(
+        `processLeAdvertisingReport: Caught illegal packet (report ${i} overruns ${data.length} octets)`
       );
+      return;
+    }
+
+    const address = report.addressValue;
+    const addressType = report.addressType;
+    const eir = report.eir;
+    const rssi = report.rssi;
 
-      data = data.slice(eirLength + 10);
+    if (debug.enabled) {
+      debug(`\t\t\ttype = ${report.type}`);
+      debug(`\t\t\taddress = ${report.address}`);
+      debug(`\t\t\taddress type = ${addressType}`);
+      debug(`\t\t\teir = ${eir.toString('hex')}`);
+      debug(`\t\t\trssi = ${rssi}`);
     }
-  } catch (e) {
-    console.warn(
-      `processLeAdvertisingReport: Caught illegal packet (buffer overflow): ${e}`
+
+    this.emit(
+      'leAdvertisingReport',
+      0,
+      report.type,
+      address,
+      addressType,
+      eir,
+      rssi
     );
+
+    report.offset += report.length;
   }
 };
 
 Hci.prototype.processLeExtendedAdvertisingReport = function (numReports, data) {
-  for (let i = 0; i < numReports; i++) {
-    let type;
-    let address;
-    let addressType;
-    let txpower;
-    let rssi;
-    let eir;
-    let eirLength;
-
-    try {
-      if (data.length < 24) {
-        console.warn(
-          `processLeExtendedAdvertisingReport: Caught illegal packet (too short: ${data.length} < 24)`
-        );
-        break;
-      }
-      type = data.readUInt16LE(0);
-      addressType = data.readUInt8(2) === 0x01 ? 'random' : 'public';
-      address = data
-        .slice(3, 9)
-        .toString('hex')
-        .match(/.{1,2}/g)
-        .reverse()
-        .join(':');
-      const primaryPHY = data.readUInt8(9);
-      const secondaryPHY = data.readUInt8(10);
-      const sid = data.readUInt8(11);
-      txpower = data.readUInt8(12);
-      rssi = data.readInt8(13);
-      const periodicAdvInterval = data.readUInt16LE(14);
-      const directAddressType =
-        data.readUInt8(16) === 0x01 ? 'random' : 'public';
-      const directAddress = data
-        .slice(17, 23)
-        .toString('hex')
-        .match(/.{1,2}/g)
-        .reverse()
-        .join(':');
-      eirLength = data.readUInt8(23);
-      if (data.length < 24 + eirLength) {
-        console.warn(
-          `processLeExtendedAdvertisingReport: Caught illegal packet (eir length ${eirLength} exceeds remaining ${data.length - 24})`
-        );
-        break;
-      }
-      eir = data.slice(24, 24 + eirLength);
+  if (this.listenerCount('leExtendedAdvertisingReport') === 0 && !debug.enabled) {
+    return;
+  }
 
-      debug(`\t\t\ttype = ${type}`);
-      debug(`\t\t\taddress = ${address}`);
-      debug(`\t\t\taddress type = ${addressType}`);
-      debug(`\t\t\tprimary phy = ${primaryPHY.toString(16)}`);
-      debug(`\t\t\tsecondary phy = ${secondaryPHY.toString(16)}`);
-      debug(`\t\t\tSID = ${sid.toString(16)}`);
-      debug(`\t\t\tTX power = ${txpower}`);
-      debug(`\t\t\tRSSI = ${rssi}`);
-      debug(
-        `\t\t\tperiodic advertising interval = ${periodicAdvInterval} msec`
+  const report = new ExtendedAdvertisingReport(data, 0);
+  for (let i = 0; i < numReports; i++) {
+    const remaining = data.length - report.offset;
+    if (remaining < ExtendedAdvertisingReport.HEADER_LENGTH) {
+      console.warn(
+        `processLeExtendedAdvertisingReport: Caught illegal packet (too short: ${remaining} < 24)`
       );
-      debug(`\t\t\tdirect address type = ${directAddressType}`);
-      debug(`\t\t\tdirect address = ${directAddress}`);
-      debug(`\t\t\teir length = ${eirLength}`);
-      debug(`\t\t\teir = ${eir.toString('hex')}`);
-    } catch (e) {
+      break;
+    }
+    if (remaining < report.length) {
       console.warn(
-        `processLeExtendedAdvertisingReport: Caught illegal packet (buffer overflow): ${e}`
+        `processLeExtendedAdvertisingReport: Caught illegal packet (eir length ${report.eirLength} exceeds remaining ${remaining - 24})`
       );
       break;
     }
 
+    const address = report.addressValue;
+    const addressType = report.addressType;
+    const eir = report.eir;
+
+    if (debug.enabled) {
+      debug(`\t\t\ttype = ${report.type}`);
+      debug(`\t\t\taddress = ${report.address}`);
+      debug(`\t\t\taddress type = ${addressType}`);
+      debug(`\t\t\tprimary phy = ${report.primaryPhy.toString(16)}`);
+      debug(`\t\t\tsecondary phy = ${report.secondaryPhy.toString(16)}`);
+      debug(`\t\t\tSID = ${report.sid.toString(16)}`);
+      debug(`\t\t\tTX power = ${report.txPower}`);
+      debug(`\t\t\tRSSI = ${report.rssi}`);
+      debug(`\t\t\tperiodic advertising interval = ${report.periodicAdvInterval * 1.25} msec`);
+      debug(`\t\t\tdirect address type = ${report.directAddressType}`);
+      debug(`\t\t\tdirect address = ${report.directAddress}`);
+      debug(`\t\t\teir length = ${report.eirLength}`);
+      debug(`\t\t\teir = ${eir.toString('hex')}`);
+    }
+
     this.emit(
       'leExtendedAdvertisingReport',
       0,
-      type,
+      report.type,
       address,
       addressType,
-      txpower,
-      rssi,
-      eir
+      report.txPower,
+      report.rssi,
+      eir,
+      report.sid,
+      report.periodicAdvInterval * 1.25
     );
 
-    data = data.slice(eirLength + 24);
+    report.offset += report.length;
+  }
+};
+
+Hci.prototype.processLePeriodicSyncEstablished = function (status, data) {
+  if (data.length < 14) {
+    debug(`processLePeriodicSyncEstablished: ignoring illegal packet (too short: ${data.length} < 14)`);
+    return;
+  }
+
+  const handle = data.readUInt16LE(0);
+  const sid = data.readUInt8(2);
+  const address = data.readUIntLE(4, 6);
+  const phy = data.readUInt8(10);
+  const interval = data.readUInt16LE(11) * 1.25;
+
+  debug(`\t\t\tstatus = ${status}`);
+  debug(`\t\t\thandle = ${handle}`);
+  debug(`\t\t\tSID = ${sid}`);
+  debug(`\t\t\tphy = ${phy}`);
+  debug(`\t\t\tinterval = ${interval}`);
+
+  // Only a sync this instance asked for is tracked; on a raw socket others may sync too.
+  // A failure, a cancelled sync among them, need not name the advertiser.
+  const pending = this._pendingPeriodicSync;
+  if (pending === null || (status === 0 && (pending.address !== address || pending.sid !== sid))) {
+    return;
+  }
+  this._pendingPeriodicSync = null;
+  if (status === 0) {
+    this._periodicSyncs.add(handle);
+  }
+  this.updateEventFilters();
+
+  this.emit('lePeriodicSyncEstablished', status, handle, pending.address, pending.addressType, pending.sid, phy, interval);
+};
+
+// As with Data Length Change, the first parameter octet is the low byte of the sync handle.
+Hci.prototype.processLePeriodicAdvertisingReport = function (handleLowByte, data) {
+  if (data.length < 6 || data.length < 6 + data.readUInt8(5)) {
+    debug(`processLePeriodicAdvertisingReport: ignoring illegal packet (length ${data.length})`);
+    return;
+  }
+
+  const handle = handleLowByte | (data.readUInt8(0) << 8);
+  if (!this._periodicSyncs.has(handle)) {
+    return;
+  }
+
+  const txPower = data.readInt8(1);
+  const rssi = data.readInt8(2);
+  const dataStatus = data.readUInt8(4);
+  const eir = data.subarray(6, 6 + data.readUInt8(5));
+
+  if (debug.enabled) {
+    debug(`\t\t\thandle = ${handle}`);
+    debug(`\t\t\tTX power = ${txPower}`);
+    debug(`\t\t\tRSSI = ${rssi}`);
+    debug(`\t\t\tdata status = ${dataStatus}`);
+    debug(`\t\t\tdata = ${eir.toString('hex')}`);
   }
+
+  this.emit('lePeriodicAdvertisingReport', handle, txPower, rssi, dataStatus, eir);
+};
+
+Hci.prototype.processLePeriodicSyncLost = function (handleLowByte, data) {
+  if (data.length < 1) {
+    debug('processLePeriodicSyncLost: ignoring illegal packet (too short: 0 < 1)');
+    return;
+  }
+
+  const handle = handleLowByte | (data.readUInt8(0) << 8);
+  if (!this._periodicSyncs.delete(handle)) {
+    return;
+  }
+  this.updateEventFilters();
+
+  debug(`\t\t\thandle = ${handle}`);
+
+  this.emit('lePeriodicSyncLost', handle);
 };
 
 Hci.prototype.processLeConnUpdateComplete = function (status, data) {
@@ -1586,6 +2353,7 @@ Hci.prototype.processCmdStatusEvent = function (cmd, status) {
     if (status !== 0) {
       const pendingLeConn = this._pendingLeConn;
       this._pendingLeConn = null;
+      this.updateEventFilters();
       // No LE Connection Complete follows a failed Command Status. Carry the
       // identity and private token recorded when this instance wrote the command;
       // bindings will ignore failures that have no matching local attempt.
@@ -1605,6 +2373,14 @@ Hci.prototype.processCmdStatusEvent = function (cmd, status) {
       }
       this.emit('leConnComplete', ...eventArguments);
     }
+  } else if (cmd === LE_PERIODIC_ADVERTISING_CREATE_SYNC_CMD) {
+    if (status !== 0 && this._pendingPeriodicSync !== null) {
+      // Nothing follows a failed Command Status either, so report the sync as failed here
+      const { address, addressType, sid } = this._pendingPeriodicSync;
+      this._pendingPeriodicSync = null;
+      this.updateEventFilters();
+      this.emit('lePeriodicSyncEstablished', status, undefined, address, addressType, sid, undefined, undefined);
+    }
   }
 };
 
@@ -1612,8 +2388,12 @@ Hci.prototype.onStateChange = function (state) {
   // If we are powered on and we are powered off, clean up
   if (this._state === 'poweredOn' && state === 'poweredOff') {
     this._aclConnections.clear();
-    this._aclQueue = [];
+    this._aclScheduler.clear();
+    this._aclPending = 0;
     this._pendingLeConn = null;
+    this._pendingPeriodicSync = null;
+    this._periodicSyncs.clear();
+    this._scanEnabled = false;
   }
   this._state = state;
 };
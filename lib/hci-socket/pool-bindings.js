@@ -0,0 +1,512 @@
+const debug = require('debug')('hci-pool');
+
+const { EventEmitter } = require('events');
+
+const NobleBindings = require('./bindings');
+
+// Several adapters usually hear the same advertisement within a few milliseconds.
+const DEFAULT_MERGE_WINDOW = 10;
+
+// Calls for one peripheral, which go to the adapter holding its link
+const ROUTED_METHODS = [
+  'disconnect',
+  'updateRssi',
+  'addService',
+  'discoverServices',
+  'discoverIncludedServices',
+  'addCharacteristics',
+  'discoverCharacteristics',
+  'read',
+  'write',
+  'broadcast',
+  'notify',
+  'discoverDescriptors',
+  'readValue',
+  'writeValue',
+  'readHandle',
+  'writeHandle'
+];
+
+// Events of one peripheral, passed on as they are
+const FORWARDED_EVENTS = [
+  'rssiUpdate',
+  'servicesDiscover',
+  'servicesDiscovered',
+  'includedServicesDiscover',
+  'characteristicsDiscover',
+  'characteristicsDiscovered',
+  'read',
+  'write',
+  'broadcast',
+  'notify',
+  'descriptorsDiscover',
+  'valueRead',
+  'valueWrite',
+  'handleRead',
+  'handleWrite',
+  'handleNotify',
+  'onMtu',
+  'periodicAdvertisingReport'
+];
+
+/**
+ * One binding over several HCI adapters. Every adapter scans, and their discoveries are merged
+ * into one stream, keeping the strongest copy heard within the merge window. A new connection
+ * goes to the adapter with the fewest links, then the most free ACL buffers, then the best
+ * RSSI for the peripheral; everything else for that peripheral is sent to the same adapter.
+ * A periodic sync goes to the adapter that hears the advertiser best.
+ */
+const PoolBindings = function (options) {
+  const { adapters, mergeWindow, ...shared } = options;
+
+  this._adapters = adapters.map(adapter => new NobleBindings(
+    typeof adapter === 'object' ? { ...shared, ...adapter } : { ...shared, deviceId: adapter }
+  ));
+  this._mergeWindow = mergeWindow != null ? mergeWindow : DEFAULT_MERGE_WINDOW;
+
+  this._state = null;
+  this._states = this._adapters.map(() => null);
+  this._isScanning = false;
+  this._scanning = this._adapters.map(() => false);
+  this._scanStopRequested = false;
+  this._scanParametersPending = 0;
+  this._scanAcceptListPending = 0;
+  this._scanProfilePending = 0;
+  this._scanProfileError = null;
+  this._scanAcceptListResult = null;
+
+  this._owners = new Map(); // peripheral uuid -> { index, connected }
+  this._links = this._adapters.map(() => 0); // links and attempts per adapter
+  this._syncOwners = new Map(); // peripheral uuid -> index of the adapter with its periodic sync
+  this._sightings = new Map(); // peripheral uuid -> last RSSI heard by each adapter still knowing it
+  this._discoveries = new Map(); // held for the merge window, by peripheral uuid
+  this._mergeTimer = null;
+};
+
+Object.setPrototypeOf(PoolBindings.prototype, EventEmitter.prototype);
+
+PoolBindings.prototype.start = function () {
+  this._adapters.forEach((adapter, index) => {
+    adapter.on('stateChange', this.onStateChange.bind(this, index));
+    adapter.on('addressChange', this.onAddressChange.bind(this, index));
+    adapter.on('scanParametersSet', this.onScanParametersSet.bind(this, index));
+    adapter.on('scanAcceptListSet', this.onScanAcceptListSet.bind(this, index));
+    adapter.on('scanProfileSet', this.onScanProfileSet.bind(this, index));
+    adapter.on('scanStart', this.onScanStart.bind(this, index));
+    adapter.on('scanStop', this.onScanStop.bind(this, index));
+    adapter.on('discover', this.onDiscover.bind(this, index));
+    adapter.on('discoveryEvict', this.onDiscoveryEvict.bind(this, index));
+    adapter.on('connect', this.onConnect.bind(this, index));
+    adapter.on('disconnect', this.onDisconnect.bind(this, index));
+    adapter.on('periodicSyncEstablished', this.onPeriodicSyncEstablished.bind(this, index));
+    adapter.on('periodicSyncLost', this.onPeriodicSyncLost.bind(this, index));
+    for (const event of FORWARDED_EVENTS) {
+      adapter.on(event, (...args) => this.emit(event, ...args));
+    }
+
+    adapter.start();
+  });
+};
+
+PoolBindings.prototype.stop = function () {
+  if (this._mergeTimer !== null) {
+    clearTimeout(this._mergeTimer);
+    this._mergeTimer = null;
+  }
+  this._discoveries.clear();
+  this._sightings.clear();
+
+  this._adapters.forEach(adapter => adapter.stop());
+};
+
+PoolBindings.prototype.setScanParameters = function (interval, window) {
+  this._scanParametersPending = this._adapters.length;
+  this._adapters.forEach(adapter => adapter.setScanParameters(interval, window));
+};
+
+PoolBindings.prototype.setScanProfile = function (profile) {
+  this._scanProfilePending = this._adapters.length;
+  this._scanProfileError = null;
+  this._adapters.forEach(adapter => adapter.setScanProfile(profile));
+};
+
+PoolBindings.prototype.setScanAcceptList = function (devices) {
+  this._scanAcceptListPending = this._adapters.length;
+  this._scanAcceptListResult = null;
+  this._adapters.forEach(adapter => adapter.setScanAcceptList(devices));
+};
+
+// Scan time summed over the adapters and their mean duty cycle, with each adapter's own figures.
+PoolBindings.prototype.getScanStats = function () {
+  const adapters = this._adapters.map(adapter => adapter.getScanStats());
+  const sum = key => adapters.reduce((total, stats) => total + stats[key], 0);
+
+  return {
+    profile: adapters.every(stats => stats.profile === adapters[0].profile) ? adapters[0].profile : null,
+    duty: sum('duty') / adapters.length,
+    scanTime: sum('scanTime'),
+    scanOnTime: sum('scanOnTime'),
+    adapters
+  };
+};
+
+PoolBindings.prototype.readScanStats = function () {
+  this.emit('scanStatsRead', null, this.getScanStats());
+};
+
+// The identity address of the pool is the first adapter's.
+PoolBindings.prototype.setAddress = function (address) {
+  this._adapters[0].setAddress(address);
+};
+
+PoolBindings.prototype.startScanning = function (serviceUuids, allowDuplicates) {
+  const wasScanning = this._isScanning;
+
+  // Adapters that stopped to make a connection start again as well.
+  this._adapters.forEach(adapter => adapter.startScanning(serviceUuids, allowDuplicates));
+
+  if (wasScanning) {
+    this.emit('scanStart');
+  }
+};
+
+PoolBindings.prototype.stopScanning = function () {
+  this._scanStopRequested = true;
+  this._adapters.forEach(adapter => adapter.stopScanning());
+};
+
+PoolBindings.prototype.connect = function (peripheralUuid, parameters = {}) {
+  const owner = this._owners.get(peripheralUuid);
+  if (owner !== undefined) {
+    this._adapters[owner.index].connect(peripheralUuid, parameters);
+    return;
+  }
+
+  const index = this.selectAdapter(peripheralUuid);
+  if (index === -1) {
+    this.emit('connect', peripheralUuid, new Error('Cannot connect while no adapter is poweredOn'));
+    return;
+  }
+
+  debug(`connect ${peripheralUuid} - adapter ${index}, ${this._links[index]} link(s)`);
+  this._owners.set(peripheralUuid, { index, connected: false });
+  this._links[index]++;
+  this._adapters[index].connect(peripheralUuid, parameters);
+};
+
+PoolBindings.prototype.cancelConnect = function (peripheralUuid) {
+  const owner = this._owners.get(peripheralUuid);
+  if (owner === undefined) {
+    return;
+  }
+
+  // A cancelled attempt ends without a connect event.
+  if (!owner.connected) {
+    this.release(peripheralUuid);
+  }
+  this._adapters[owner.index].cancelConnect(peripheralUuid);
+};
+
+PoolBindings.prototype.createPeriodicSync = function (peripheralUuid, options = {}) {
+  if (this._syncOwners.has(peripheralUuid)) {
+    this.emit('periodicSyncEstablished', peripheralUuid, new Error(`Periodic sync with ${peripheralUuid} already exists`));
+    return;
+  }
+
+  const sighting = this._sightings.get(peripheralUuid);
+  let index = -1;
+  this._states.forEach((state, candidate) => {
+    if (state === 'poweredOn' && sighting !== undefined && sighting[candidate] !== null &&
+      (index === -1 || sighting[candidate] > sighting[index])) {
+      index = candidate;
+    }
+  });
+  if (index === -1) {
+    this.emit('periodicSyncEstablished', peripheralUuid, new Error('Cannot create a periodic sync with a peripheral no poweredOn adapter has heard'));
+    return;
+  }
+
+  debug(`periodic sync ${peripheralUuid} - adapter ${index}`);
+  this._syncOwners.set(peripheralUuid, index);
+  this._adapters[index].createPeriodicSync(peripheralUuid, options);
+};
+
+PoolBindings.prototype.terminatePeriodicSync = function (peripheralUuid) {
+  const index = this._syncOwners.get(peripheralUuid);
+  if (index !== undefined) {
+    this._adapters[index].terminatePeriodicSync(peripheralUuid);
+  }
+};
+
+for (const method of ROUTED_METHODS) {
+  PoolBindings.prototype[method] = function (peripheralUuid, ...args) {
+    const owner = this._owners.get(peripheralUuid);
+
+    if (owner) {
+      this._adapters[owner.index][method](peripheralUuid, ...args);
+    } else {
+      console.warn(`noble warning: unknown peripheral ${peripheralUuid}`);
+    }
+  };
+}
+
+PoolBindings.prototype.selectAdapter = function (peripheralUuid) {
+  const sighting = this._sightings.get(peripheralUuid);
+  const poweredOn = this._adapters
+    .map((adapter, index) => index)
+    .filter(index => this._states[index] === 'poweredOn');
+  // Adapters that heard the peripheral know its address type.
+  const heard = poweredOn.filter(index => sighting !== undefined && sighting[index] !== null);
+  const candidates = heard.length > 0 ? heard : poweredOn;
+
+  let best = -1;
+  for (const index of candidates) {
+    if (best === -1 || this.compareAdapters(index, best, sighting) < 0) {
+      best = index;
+    }
+  }
+  return best;
+};
+
+PoolBindings.prototype.compareAdapters = function (a, b, sighting) {
+  if (this._links[a] !== this._links[b]) {
+    return this._links[a] - this._links[b];
+  }
+
+  const freeA = this._adapters[a].freeAclBuffers();
+  const freeB = this._adapters[b].freeAclBuffers();
+  if (freeA !== freeB) {
+    return freeB - freeA;
+  }
+
+  if (sighting !== undefined) {
+    return (sighting[b] === null ? -Infinity : sighting[b]) - (sighting[a] === null ? -Infinity : sighting[a]);
+  }
+  return 0;
+};
+
+PoolBindings.prototype.release = function (peripheralUuid) {
+  const owner = this._owners.get(peripheralUuid);
+  if (owner !== undefined) {
+    this._owners.delete(peripheralUuid);
+    this._links[owner.index]--;
+  }
+  this.forgetSighting(peripheralUuid);
+};
+
+// A sighting is kept while an adapter's Gap still knows the peripheral, or while it has a link
+// or a periodic sync here, so the table stays as bounded as the adapters' discovery caches.
+// Noble forgets the peripheral with it.
+PoolBindings.prototype.forgetSighting = function (peripheralUuid) {
+  const sighting = this._sightings.get(peripheralUuid);
+  if (sighting !== undefined && sighting.every(rssi => rssi === null) &&
+    !this._owners.has(peripheralUuid) && !this._syncOwners.has(peripheralUuid)) {
+    this._sightings.delete(peripheralUuid);
+    this.emit('discoveryEvict', peripheralUuid);
+  }
+};
+
+PoolBindings.prototype.onStateChange = function (index, state) {
+  const previousState = this._states[index];
+  this._states[index] = state;
+
+  // Links of an adapter that went away are reported by it; attempts are not.
+  if (previousState === 'poweredOn' && state !== 'poweredOn') {
+    for (const [peripheralUuid, owner] of this._owners) {
+      if (owner.index === index && !owner.connected) {
+        this.release(peripheralUuid);
+        this.emit('connect', peripheralUuid, new Error(`Adapter ${index} is ${state}`));
+      }
+    }
+    this.onScanStop(index);
+  }
+
+  // The pool is on while any adapter is.
+  const pooledState = this._states.includes('poweredOn') ? 'poweredOn' : this._states[0];
+  if (pooledState !== this._state && pooledState !== null) {
+    this._state = pooledState;
+    this.emit('stateChange', pooledState);
+  }
+};
+
+PoolBindings.prototype.onAddressChange = function (index, address) {
+  if (index === 0) {
+    this.emit('addressChange', address);
+  }
+};
+
+PoolBindings.prototype.onScanParametersSet = function () {
+  if (this._scanParametersPending > 0 && --this._scanParametersPending === 0) {
+    this.emit('scanParametersSet');
+  }
+};
+
+PoolBindings.prototype.onScanProfileSet = function (index, error, name) {
+  if (this._scanProfilePending === 0) {
+    return;
+  }
+
+  this._scanProfileError = this._scanProfileError || error;
+  if (--this._scanProfilePending === 0) {
+    if (this._scanProfileError) {
+      this.emit('scanProfileSet', this._scanProfileError);
+    } else {
+      this.emit('scanProfileSet', null, name);
+    }
+  }
+};
+
+// Reported once every adapter has its list: with the first error, or with the smallest
+// capacity and host mode if any adapter had to filter on the host.
+PoolBindings.prototype.onScanAcceptListSet = function (index, error, result) {
+  if (this._scanAcceptListPending === 0) {
+    return;
+  }
+
+  const previous = this._scanAcceptListResult;
+  if (previous instanceof Error) {
+    // The first error stands
+  } else if (error) {
+    this._scanAcceptListResult = error;
+  } else if (previous === null) {
+    this._scanAcceptListResult = result;
+  } else {
+    this._scanAcceptListResult = {
+      mode: previous.mode === 'host' ? previous.mode : result.mode,
+      size: result.size,
+      capacity: Math.min(previous.capacity, result.capacity)
+    };
+  }
+
+  if (--this._scanAcceptListPending === 0) {
+    const outcome = this._scanAcceptListResult;
+    this._scanAcceptListResult = null;
+    if (outcome instanceof Error) {
+      this.emit('scanAcceptListSet', outcome);
+    } else {
+      this.emit('scanAcceptListSet', null, outcome);
+    }
+  }
+};
+
+PoolBindings.prototype.onScanStart = function (index, filterDuplicates) {
+  this._scanning[index] = true;
+
+  if (!this._isScanning) {
+    this._isScanning = true;
+    this.emit('scanStart', filterDuplicates);
+  }
+};
+
+// The pool scans while any adapter does, for instance while another one makes a connection.
+PoolBindings.prototype.onScanStop = function (index) {
+  this._scanning[index] = false;
+
+  if (this._scanning.includes(true) || (!this._isScanning && !this._scanStopRequested)) {
+    return;
+  }
+
+  this._isScanning = false;
+  this._scanStopRequested = false;
+  this.flushDiscoveries();
+  this.emit('scanStop');
+};
+
+PoolBindings.prototype.onDiscover = function (index, peripheralUuid, address, addressType, connectable, advertisement, rssi, scannable, changed) {
+  let sighting = this._sightings.get(peripheralUuid);
+  if (sighting === undefined) {
+    sighting = this._adapters.map(() => null);
+    this._sightings.set(peripheralUuid, sighting);
+  }
+  sighting[index] = rssi;
+
+  const discovery = [peripheralUuid, address, addressType, connectable, advertisement, rssi, scannable, changed !== false];
+  if (this._mergeWindow <= 0) {
+    this.emit('discover', ...discovery);
+    return;
+  }
+
+  // On a tie the later copy wins: it may carry a scan response the earlier one did not.
+  // The merged copy is changed if any of the copies it stands for was.
+  const held = this._discoveries.get(peripheralUuid);
+  if (held === undefined || rssi >= held[5]) {
+    discovery[7] = discovery[7] || (held !== undefined && held[7]);
+    this._discoveries.set(peripheralUuid, discovery);
+  } else {
+    held[7] = held[7] || discovery[7];
+  }
+  if (this._mergeTimer === null) {
+    this._mergeTimer = setTimeout(() => {
+      this._mergeTimer = null;
+      this.flushDiscoveries();
+    }, this._mergeWindow);
+  }
+};
+
+PoolBindings.prototype.onDiscoveryEvict = function (index, peripheralUuid) {
+  const sighting = this._sightings.get(peripheralUuid);
+  if (sighting !== undefined) {
+    sighting[index] = null;
+    this.forgetSighting(peripheralUuid);
+  }
+};
+
+PoolBindings.prototype.flushDiscoveries = function () {
+  const discoveries = this._discoveries;
+  this._discoveries = new Map();
+
+  for (const discovery of discoveries.values()) {
+    this.emit('discover', ...discovery);
+  }
+};
+
+PoolBindings.prototype.onConnect = function (index, peripheralUuid, error) {
+  const owner = this._owners.get(peripheralUuid);
+
+  if (error) {
+    if (owner !== undefined && owner.index === index) {
+      this.release(peripheralUuid);
+    }
+  } else if (owner === undefined) {
+    // A link the adapter adopted without an attempt of ours
+    this._owners.set(peripheralUuid, { index, connected: true });
+    this._links[index]++;
+  } else {
+    owner.connected = true;
+  }
+
+  this.emit('connect', peripheralUuid, error);
+};
+
+PoolBindings.prototype.onDisconnect = function (index, peripheralUuid, reason) {
+  const owner = this._owners.get(peripheralUuid);
+  if (owner !== undefined && owner.index === index) {
+    this.release(peripheralUuid);
+  }
+
+  this.emit('disconnect', peripheralUuid, reason);
+};
+
+PoolBindings.prototype.onPeriodicSyncEstablished = function (index, peripheralUuid, error, info) {
+  if (error && this._syncOwners.get(peripheralUuid) === index) {
+    this._syncOwners.delete(peripheralUuid);
+    this.forgetSighting(peripheralUuid);
+  }
+
+  this.emit('periodicSyncEstablished', peripheralUuid, error, info);
+};
+
+PoolBindings.prototype.onPeriodicSyncLost = function (index, peripheralUuid, reason) {
+  if (this._syncOwners.get(peripheralUuid) === index) {
+    this._syncOwners.delete(peripheralUuid);
+    this.forgetSighting(peripheralUuid);
+  }
+
+  this.emit('periodicSyncLost', peripheralUuid, reason);
+};
+
+PoolBindings.prototype.addressToId = function (address) {
+  return address.replace(/:/g, '').toLowerCase();
+};
+
+module.exports = PoolBindings;
@@ -0,0 +1,112 @@
+// Data status, bits 5-6 of an extended advertising report's event type
+const DATA_STATUS_MASK = 0x60;
+const DATA_STATUS_COMPLETE = 0x00;
+const DATA_STATUS_MORE = 0x20; // incomplete, more data to come
+// 0x40 is incomplete and truncated, no more data to come; 0x60 is reserved
+
+// Advertising data is at most 1650 octets, whatever the number of reports it arrives in.
+const MAX_ADVERTISING_DATA_LENGTH = 1650;
+
+const DEFAULT_MAX_PENDING = 64;
+const DEFAULT_TIMEOUT = 1000; // ms from the first report of a chain to its last
+
+// SID 0xff, for reports without one, is kept apart from SIDs 0x00 to 0x0f.
+const SID_MASK = 0x1f;
+
+/**
+ * Joins the chains of extended advertising reports long advertising data arrives in, per
+ * advertiser and SID. push() takes every report and returns the whole advertising data once
+ * the last report of its chain is in, and null until then. truncated tells whether data
+ * returned is only the start of what was advertised: the controller said so, or it grew
+ * longer than maxLength. A chain whose last report does not arrive within timeout, or that
+ * is the oldest of maxPending when another starts, is dropped.
+ */
+const ReportReassembly = function (options = {}) {
+  this.maxLength = options.maxLength > 0 ? options.maxLength : MAX_ADVERTISING_DATA_LENGTH;
+  this.maxPending = options.maxPending > 0 ? options.maxPending : DEFAULT_MAX_PENDING;
+  this.timeout = options.timeout > 0 ? options.timeout : DEFAULT_TIMEOUT;
+  this._now = options.now || Date.now;
+
+  this._chains = new Map(); // by key, oldest first
+  this.truncated = false;
+
+  this.joined = 0;
+  this.dropped = 0;
+};
+
+// 48-bit addresses times 32 stay below 2^53, so the key is an exact number.
+ReportReassembly.key = function (address, sid) {
+  return address * (SID_MASK + 1) + ((sid === undefined ? 0xff : sid) & SID_MASK);
+};
+
+Object.defineProperty(ReportReassembly.prototype, 'size', {
+  get () { return this._chains.size; }
+});
+
+ReportReassembly.prototype.push = function (key, type, eir) {
+  const status = type & DATA_STATUS_MASK;
+  let chain;
+
+  if (this._chains.size > 0) {
+    this.expire();
+    chain = this._chains.get(key);
+    // A report of another kind, say a scan response, means the chain was cut short
+    if (chain !== undefined && chain.type !== (type & ~DATA_STATUS_MASK)) {
+      this.drop(key);
+      chain = undefined;
+    }
+  }
+
+  if (chain === undefined) {
+    if (status !== DATA_STATUS_MORE) {
+      this.truncated = status !== DATA_STATUS_COMPLETE;
+      return eir;
+    }
+    if (this._chains.size >= this.maxPending) {
+      this.drop(this._chains.keys().next().value);
+    }
+    chain = { type: type & ~DATA_STATUS_MASK, since: this._now(), fragments: [], length: 0, overflowed: false };
+    this._chains.set(key, chain);
+  }
+
+  // Past maxLength the rest of the chain is still taken, so it does not start another one
+  if (!chain.overflowed) {
+    const room = this.maxLength - chain.length;
+    chain.overflowed = eir.length > room;
+    // Reports are views over socket buffers, so what is kept is copied
+    const fragment = Buffer.from(eir.subarray(0, room));
+    chain.fragments.push(fragment);
+    chain.length += fragment.length;
+  }
+
+  if (status === DATA_STATUS_MORE) {
+    return null;
+  }
+
+  this._chains.delete(key);
+  this.joined++;
+  this.truncated = status !== DATA_STATUS_COMPLETE || chain.overflowed;
+  return Buffer.concat(chain.fragments, chain.length);
+};
+
+ReportReassembly.prototype.drop = function (key) {
+  this._chains.delete(key);
+  this.dropped++;
+};
+
+// Chains are kept in the order they started, so the expired ones are at the front.
+ReportReassembly.prototype.expire = function () {
+  const oldest = this._now() - this.timeout;
+  for (const [key, chain] of this._chains) {
+    if (chain.since >= oldest) {
+      break;
+    }
+    this.drop(key);
+  }
+};
+
+ReportReassembly.prototype.clear = function () {
+  this._chains.clear();
+};
+
+module.exports = ReportReassembly;
@@ -0,0 +1,206 @@
+const EIR_SHORTENED_LOCAL_NAME = 0x08;
+const EIR_COMPLETE_LOCAL_NAME = 0x09;
+const EIR_SERVICE_DATA_16 = 0x16;
+const EIR_SERVICE_DATA_32 = 0x20;
+const EIR_SERVICE_DATA_128 = 0x21;
+const EIR_MANUFACTURER_DATA = 0xff;
+
+const SERVICE_DATA_TYPES = {
+  2: EIR_SERVICE_DATA_16,
+  4: EIR_SERVICE_DATA_32,
+  16: EIR_SERVICE_DATA_128
+};
+
+const invalid = function (message) {
+  return new Error(`Invalid scan filter: ${message}`);
+};
+
+// Hex strings, arrays of octets and buffers are all accepted wherever bytes are.
+const toBytes = function (value, name) {
+  if (typeof value === 'string') {
+    if (!/^([0-9a-f]{2})*$/i.test(value)) {
+      throw invalid(`${name} is not a hex string`);
+    }
+    return Buffer.from(value, 'hex');
+  }
+  if (Array.isArray(value) || value instanceof Uint8Array) {
+    return Buffer.from(value);
+  }
+  throw invalid(`${name} must be a hex string, an array of octets or a Buffer`);
+};
+
+const toArray = function (value) {
+  return Array.isArray(value) ? value : [value];
+};
+
+// Calls match(offset, length) with the value of every field of the given types in eir,
+// until it returns true. Stops at the first malformed field, as Gap.parseServices does.
+const someField = function (eir, types, match) {
+  let i = 0;
+  while (i + 1 < eir.length) {
+    const length = eir[i];
+    if (length < 1 || i + length + 1 > eir.length) {
+      return false;
+    }
+    if (types.includes(eir[i + 1]) && match(i + 2, length - 1)) {
+      return true;
+    }
+    i += length + 1;
+  }
+  return false;
+};
+
+const startsWith = function (eir, offset, length, prefix, mask) {
+  if (length < prefix.length) {
+    return false;
+  }
+  for (let j = 0; j < prefix.length; j++) {
+    const octet = mask !== null ? eir[offset + j] & mask[j] : eir[offset + j];
+    if (octet !== prefix[j]) {
+      return false;
+    }
+  }
+  return true;
+};
+
+const compileManufacturerData = function (spec) {
+  const companyId = spec.companyId;
+  if (companyId !== undefined && !(Number.isInteger(companyId) && companyId >= 0 && companyId <= 0xffff)) {
+    throw invalid('manufacturerData.companyId must be a 16-bit integer');
+  }
+
+  // The company id is the first two octets of the field, little endian
+  let prefix = spec.prefix !== undefined ? toBytes(spec.prefix, 'manufacturerData.prefix') : Buffer.alloc(0);
+  let mask = spec.mask !== undefined ? toBytes(spec.mask, 'manufacturerData.mask') : null;
+  if (mask !== null && mask.length !== prefix.length) {
+    throw invalid('manufacturerData.mask must be as long as its prefix');
+  }
+  if (companyId !== undefined) {
+    prefix = Buffer.concat([Buffer.from([companyId & 0xff, companyId >> 8]), prefix]);
+    mask = mask !== null ? Buffer.concat([Buffer.from([0xff, 0xff]), mask]) : null;
+  }
+  if (mask !== null) {
+    prefix = prefix.map((octet, j) => octet & mask[j]);
+  }
+
+  return (eir) => someField(eir, [EIR_MANUFACTURER_DATA], (offset, length) =>
+    startsWith(eir, offset, length, prefix, mask));
+};
+
+const compileServiceData = function (spec) {
+  const uuids = toArray(spec).map(uuid => {
+    const hex = typeof uuid === 'string' ? uuid.replace(/-/g, '') : '';
+    const type = SERVICE_DATA_TYPES[hex.length / 2];
+    if (type === undefined || !/^[0-9a-f]+$/i.test(hex)) {
+      throw invalid(`serviceData ${uuid} is not a 16, 32 or 128-bit uuid`);
+    }
+    // Sent least significant octet first
+    return { type, bytes: Buffer.from(hex, 'hex').reverse() };
+  });
+  const types = [...new Set(uuids.map(uuid => uuid.type))];
+
+  return (eir) => someField(eir, types, (offset, length) => uuids.some(uuid =>
+    eir[offset - 1] === uuid.type && startsWith(eir, offset, length, uuid.bytes, null)));
+};
+
+const compileLocalName = function (spec) {
+  if (typeof spec !== 'string') {
+    throw invalid('localName must be a string');
+  }
+  const prefix = Buffer.from(spec, 'utf8');
+
+  return (eir) => someField(eir, [EIR_SHORTENED_LOCAL_NAME, EIR_COMPLETE_LOCAL_NAME], (offset, length) =>
+    startsWith(eir, offset, length, prefix, null));
+};
+
+const compileAddress = function (spec) {
+  const addresses = new Set(toArray(spec).map(address => {
+    const hex = typeof address === 'string' ? address.replace(/[:-]/g, '') : '';
+    if (!/^[0-9a-f]{12}$/i.test(hex)) {
+      throw invalid(`address ${address} is not a BD_ADDR`);
+    }
+    return parseInt(hex, 16);
+  }));
+
+  return (eir, address) => addresses.has(address);
+};
+
+const compileAddressType = function (spec) {
+  const addressTypes = toArray(spec);
+  if (!addressTypes.every(addressType => addressType === 'public' || addressType === 'random')) {
+    throw invalid('addressType must be public or random');
+  }
+
+  return (eir, address, addressType) => addressTypes.includes(addressType);
+};
+
+const compileRssi = function (spec) {
+  if (typeof spec !== 'number') {
+    throw invalid('rssi must be a number');
+  }
+
+  return (eir, address, addressType, rssi) => rssi >= spec;
+};
+
+const compileList = function (spec, name) {
+  if (!Array.isArray(spec) || spec.length === 0) {
+    throw invalid(`${name} must be a non-empty array of filters`);
+  }
+  return spec.map(compile);
+};
+
+// Every key of a filter must match. The report fields come first, as they cost the least.
+const COMPILERS = [
+  ['rssi', compileRssi],
+  ['addressType', compileAddressType],
+  ['address', compileAddress],
+  ['localName', compileLocalName],
+  ['serviceData', compileServiceData],
+  ['manufacturerData', compileManufacturerData],
+  ['all', (spec) => {
+    const matchers = compileList(spec, 'all');
+    return (eir, address, addressType, rssi) => matchers.every(match => match(eir, address, addressType, rssi));
+  }],
+  ['any', (spec) => {
+    const matchers = compileList(spec, 'any');
+    return (eir, address, addressType, rssi) => matchers.some(match => match(eir, address, addressType, rssi));
+  }]
+];
+
+const compile = function (spec) {
+  if (spec === null || typeof spec !== 'object' || Array.isArray(spec)) {
+    throw invalid('a filter must be an object');
+  }
+
+  const unknown = Object.keys(spec).find(key => !COMPILERS.some(([name]) => name === key));
+  if (unknown !== undefined) {
+    throw invalid(`unknown key ${unknown}`);
+  }
+
+  const matchers = COMPILERS
+    .filter(([name]) => spec[name] !== undefined)
+    .map(([name, compileKey]) => compileKey(spec[name]));
+
+  if (matchers.length === 1) {
+    return matchers[0];
+  }
+  return (eir, address, addressType, rssi) => {
+    for (let i = 0; i < matchers.length; i++) {
+      if (!matchers[i](eir, address, addressType, rssi)) {
+        return false;
+      }
+    }
+    return true;
+  };
+};
+
+/**
+ * Compiles a declarative scan filter into match(eir, address, addressType, rssi), which Gap
+ * runs on the raw bytes of each report before anything is parsed or allocated for it.
+ * address is the 48-bit value Hci reports. Returns null for no filter.
+ */
+const compileScanFilter = function (spec) {
+  return spec != null ? compile(spec) : null;
+};
+
+module.exports = compileScanFilter;
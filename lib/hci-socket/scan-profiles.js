@@ -0,0 +1,69 @@
+// Scan interval and window are in units of 0.625 ms, as in setScanParameters.
+const MIN_SCAN_INTERVAL = 0x0004;
+const MAX_SCAN_INTERVAL = 0x4000;
+
+const PHYS = ['1m', 'coded'];
+
+// What scanning does without a profile. LE Coded is only used where the controller has it.
+const BASE_PROFILE = {
+  active: true,
+  interval: 0x0012,
+  window: 0x0012,
+  phys: PHYS,
+  allowDuplicates: undefined, // as startScanning was asked
+  duplicatesRefresh: undefined // as the duplicatesRefresh option
+};
+
+const SCAN_PROFILES = {
+  default: {},
+  // Listens only: no scan requests, so no scan responses, and nothing sent over the air
+  passive: { active: false },
+  // Scans all the time
+  lowLatency: { interval: 0x0010, window: 0x0010 },
+  // 30 ms out of every 1.28 s
+  lowPower: { active: false, interval: 0x0800, window: 0x0030 }
+};
+
+const invalid = function (name, message) {
+  return new Error(`Invalid scan profile ${name}: ${message}`);
+};
+
+/**
+ * Resolves a scan profile, given by name or as an object, into every setting scanning takes:
+ * active, interval, window, phys, allowDuplicates and duplicatesRefresh. Names are looked up
+ * in profiles first, then in the built-in ones. Settings left out are the defaults.
+ */
+const resolveScanProfile = function (profile, profiles = {}) {
+  const has = (table, key) => Object.prototype.hasOwnProperty.call(table, key);
+
+  let name = 'custom';
+  let spec = profile;
+  if (typeof profile === 'string') {
+    name = profile;
+    spec = has(profiles, name) ? profiles[name] : (has(SCAN_PROFILES, name) ? SCAN_PROFILES[name] : undefined);
+  }
+  if (spec === null || typeof spec !== 'object' || Array.isArray(spec)) {
+    throw new Error(`Unknown scan profile ${typeof profile === 'string' ? profile : JSON.stringify(profile)}`);
+  }
+
+  const resolved = Object.assign({}, BASE_PROFILE, spec, { name: spec.name || name });
+
+  if (typeof resolved.active !== 'boolean') {
+    throw invalid(resolved.name, 'active must be true or false');
+  }
+  if (!(Number.isInteger(resolved.interval) && resolved.interval >= MIN_SCAN_INTERVAL && resolved.interval <= MAX_SCAN_INTERVAL)) {
+    throw invalid(resolved.name, 'interval must be 0x0004 to 0x4000');
+  }
+  if (!(Number.isInteger(resolved.window) && resolved.window >= MIN_SCAN_INTERVAL && resolved.window <= resolved.interval)) {
+    throw invalid(resolved.name, 'window must be 0x0004 up to the interval');
+  }
+  if (!Array.isArray(resolved.phys) || resolved.phys.length === 0 || !resolved.phys.every(phy => PHYS.includes(phy))) {
+    throw invalid(resolved.name, 'phys must list 1m, coded or both');
+  }
+
+  return Object.freeze(resolved);
+};
+
+resolveScanProfile.SCAN_PROFILES = SCAN_PROFILES;
+
+module.exports = resolveScanProfile;
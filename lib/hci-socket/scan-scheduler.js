@@ -0,0 +1,59 @@
+const DEFAULT_PERIOD = 1000; // ms between adjustments
+const DEFAULT_MAX_REPORT_RATE = 1000; // advertising reports handled per second
+const DEFAULT_MAX_LAG = 50; // ms the event loop may run behind
+const DEFAULT_SLOW_DISCOVERY = 10000; // ms without a new device
+const DEFAULT_MIN_DUTY = 0.05;
+const DEFAULT_MAX_DUTY = 1;
+
+/**
+ * Picks the scan duty cycle, window over interval, from what the last period cost and found.
+ * It halves while reports arrive faster than maxReportRate or the event loop runs more than
+ * maxLag behind. It doubles while both are within half their budget and no new device has
+ * been found for slowDiscovery. It stays within minDuty and maxDuty.
+ */
+const ScanScheduler = function (options = {}, now = Date.now) {
+  this.period = options.period > 0 ? options.period : DEFAULT_PERIOD;
+  this.maxReportRate = options.maxReportRate > 0 ? options.maxReportRate : DEFAULT_MAX_REPORT_RATE;
+  this.maxLag = options.maxLag > 0 ? options.maxLag : DEFAULT_MAX_LAG;
+  this.slowDiscovery = options.slowDiscovery > 0 ? options.slowDiscovery : DEFAULT_SLOW_DISCOVERY;
+  this.minDuty = options.minDuty > 0 ? Math.min(options.minDuty, 1) : DEFAULT_MIN_DUTY;
+  this.maxDuty = options.maxDuty > 0 ? Math.min(Math.max(options.maxDuty, this.minDuty), 1) : DEFAULT_MAX_DUTY;
+  this._now = now;
+
+  this.duty = this.maxDuty;
+  this._reports = 0;
+  this._lastDiscovery = 0;
+};
+
+ScanScheduler.prototype.reset = function (duty) {
+  this.duty = Math.min(Math.max(duty, this.minDuty), this.maxDuty);
+  this._reports = 0;
+  this._lastDiscovery = this._now();
+};
+
+ScanScheduler.prototype.onReport = function (isNewDevice) {
+  this._reports++;
+  if (isNewDevice) {
+    this._lastDiscovery = this._now();
+  }
+};
+
+// Called once per period, with the time since the last call and how late this one came.
+ScanScheduler.prototype.update = function (elapsed, lag) {
+  const reportRate = elapsed > 0 ? this._reports * 1000 / elapsed : 0;
+  this._reports = 0;
+
+  if (reportRate > this.maxReportRate || lag > this.maxLag) {
+    this.duty = Math.max(this.duty / 2, this.minDuty);
+  } else if (
+    reportRate <= this.maxReportRate / 2 &&
+    lag <= this.maxLag / 2 &&
+    this._now() - this._lastDiscovery >= this.slowDiscovery
+  ) {
+    this.duty = Math.min(this.duty * 2, this.maxDuty);
+  }
+
+  return this.duty;
+};
+
+module.exports = ScanScheduler;
@@ -0,0 +1,134 @@
+const debug = require('debug')('hci-worker');
+
+const { EventEmitter } = require('events');
+const path = require('path');
+const { Worker } = require('worker_threads');
+
+const { pack, unpack } = require('./worker-messages');
+
+// How long stop() waits for the worker to stop scanning and disconnect
+const STOP_TIMEOUT = 1000;
+
+// What Noble calls on its bindings; all of it is fire and forget, answered by events.
+const METHODS = [
+  'setScanParameters',
+  'setAddress',
+  'setScanAcceptList',
+  'setScanProfile',
+  'readScanStats',
+  'startScanning',
+  'stopScanning',
+  'connect',
+  'disconnect',
+  'cancelConnect',
+  'createPeriodicSync',
+  'terminatePeriodicSync',
+  'updateRssi',
+  'addService',
+  'discoverServices',
+  'discoverIncludedServices',
+  'addCharacteristics',
+  'discoverCharacteristics',
+  'read',
+  'write',
+  'broadcast',
+  'notify',
+  'discoverDescriptors',
+  'readValue',
+  'writeValue',
+  'readHandle',
+  'writeHandle'
+];
+
+/**
+ * The HCI bindings with Hci, Gap and Gatt running in a worker thread, so socket parsing and
+ * protocol decoding never wait behind application code on the main event loop. Calls are
+ * posted to the worker; events come back in batches, one message per turn of its loop.
+ */
+const WorkerBindings = function (options) {
+  this._options = { ...options };
+  this._worker = null;
+  this._stopped = null;
+};
+
+Object.setPrototypeOf(WorkerBindings.prototype, EventEmitter.prototype);
+
+WorkerBindings.prototype.start = function () {
+  this._sigIntHandler = this.onSigInt.bind(this);
+  this._exitHandler = this.stop.bind(this);
+  process.on('SIGINT', this._sigIntHandler);
+  process.on('exit', this._exitHandler);
+
+  const options = pack(this._options);
+  this._stopped = new Int32Array(new SharedArrayBuffer(4));
+  this._worker = new Worker(path.join(__dirname, 'worker.js'), {
+    workerData: { options, stopped: this._stopped },
+    transferList: [options.buffer]
+  });
+
+  this._worker.on('message', this.onMessage.bind(this));
+  this._worker.on('error', this.onError.bind(this));
+};
+
+WorkerBindings.prototype.stop = function () {
+  process.removeListener('exit', this._exitHandler);
+  process.removeListener('SIGINT', this._sigIntHandler);
+
+  if (this._worker === null) {
+    return;
+  }
+
+  // Blocks, so scanning is off and links are closed even when called on process exit.
+  this.call('stop', []);
+  if (Atomics.wait(this._stopped, 0, 0, STOP_TIMEOUT) === 'timed-out') {
+    debug('worker did not stop in time');
+  }
+
+  this._worker.terminate();
+  this._worker = null;
+};
+
+WorkerBindings.prototype.call = function (method, args) {
+  if (this._worker === null) {
+    debug(`${method} ignored - not started`);
+    return;
+  }
+
+  const message = pack([method, args]);
+  this._worker.postMessage(message, [message.buffer]);
+};
+
+for (const method of METHODS) {
+  WorkerBindings.prototype[method] = function (...args) {
+    this.call(method, args);
+  };
+}
+
+WorkerBindings.prototype.onMessage = function (message) {
+  for (const [event, args] of unpack(message)) {
+    this.emit(event, ...args);
+  }
+};
+
+WorkerBindings.prototype.onError = function (error) {
+  debug(`worker failed: ${error.stack || error.message}`);
+  this._worker = null;
+  this.emit('stateChange', 'unsupported');
+};
+
+WorkerBindings.prototype.onSigInt = function () {
+  const sigIntListeners = process.listeners('SIGINT');
+
+  if (sigIntListeners[sigIntListeners.length - 1] === this._sigIntHandler) {
+    // we are the last listener, so exit
+    // this will trigger onExit, and clean up
+    // eslint-disable-next-line no-process-exit
+    process.exit(1);
+  }
+};
+
+WorkerBindings.prototype.addressToId = function (address) {
+  return address.replace(/:/g, '').toLowerCase();
+};
+
+module.exports = WorkerBindings;
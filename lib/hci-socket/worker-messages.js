@@ -0,0 +1,116 @@
+// Messages between WorkerBindings and its worker thread. Buffers anywhere in a message are
+// copied into one ArrayBuffer, which is transferred instead of cloned and comes out on the
+// other side as Buffer views of it. Errors keep their name, message and own properties.
+
+const BUFFER = '__nobleBuffer';
+const ERROR = '__nobleError';
+
+// Everything NobleBindings emits that Noble listens to
+const EVENTS = [
+  'stateChange',
+  'addressChange',
+  'scanParametersSet',
+  'scanAcceptListSet',
+  'scanProfileSet',
+  'scanStatsRead',
+  'scanStart',
+  'scanStop',
+  'discover',
+  'discoveryEvict',
+  'connect',
+  'disconnect',
+  'periodicSyncEstablished',
+  'periodicAdvertisingReport',
+  'periodicSyncLost',
+  'rssiUpdate',
+  'servicesDiscover',
+  'servicesDiscovered',
+  'includedServicesDiscover',
+  'characteristicsDiscover',
+  'characteristicsDiscovered',
+  'read',
+  'write',
+  'broadcast',
+  'notify',
+  'descriptorsDiscover',
+  'valueRead',
+  'valueWrite',
+  'handleRead',
+  'handleWrite',
+  'handleNotify',
+  'onMtu'
+];
+
+const pack = function (values) {
+  const buffers = [];
+  let length = 0;
+
+  const encode = (value) => {
+    if (value === null || typeof value !== 'object') {
+      return value;
+    }
+    if (value instanceof Uint8Array) {
+      buffers.push(value);
+      length += value.length;
+      return { [BUFFER]: [length - value.length, value.length] };
+    }
+    if (value instanceof Error) {
+      return { [ERROR]: { ...encode({ ...value }), name: value.name, message: value.message } };
+    }
+    if (Array.isArray(value)) {
+      return value.map(encode);
+    }
+
+    const encoded = {};
+    for (const key of Object.keys(value)) {
+      encoded[key] = encode(value[key]);
+    }
+    return encoded;
+  };
+
+  const encoded = encode(values);
+  const buffer = new ArrayBuffer(length);
+  const bytes = new Uint8Array(buffer);
+  let offset = 0;
+  for (const source of buffers) {
+    bytes.set(source, offset);
+    offset += source.length;
+  }
+
+  return { values: encoded, buffer };
+};
+
+const unpack = function ({ values, buffer }) {
+  const decode = (value) => {
+    if (value === null || typeof value !== 'object') {
+      return value;
+    }
+    if (Array.isArray(value)) {
+      // Unlike map, also fills the holes JSON leaves for undefined arguments.
+      return Array.from(value, decode);
+    }
+    if (value[BUFFER] !== undefined) {
+      return Buffer.from(buffer, value[BUFFER][0], value[BUFFER][1]);
+    }
+    if (value[ERROR] !== undefined) {
+      const { name, message, ...properties } = decode(value[ERROR]);
+      const error = Object.assign(new Error(message), properties);
+      error.name = name;
+      return error;
+    }
+
+    const decoded = {};
+    for (const key of Object.keys(value)) {
+      decoded[key] = decode(value[key]);
+    }
+    return decoded;
+  };
+
+  return decode(values);
+};
+
+module.exports = {
+  EVENTS,
+  pack,
+  unpack
+};
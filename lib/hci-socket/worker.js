@@ -0,0 +1,49 @@
+// Entry point of the worker thread started by WorkerBindings: runs NobleBindings, or a pool of
+// them, and with it Hci, Gap and every Gatt, and hands its events to the main thread in batches.
+const { parentPort, workerData } = require('worker_threads');
+
+const { EVENTS, pack, unpack } = require('./worker-messages');
+
+const options = unpack(workerData.options);
+const Bindings = options.adapters ? require('./pool-bindings') : require('./bindings');
+const bindings = new Bindings(options);
+const stopped = workerData.stopped;
+
+let batch = [];
+
+// Everything emitted while handling one batch of socket reads goes out as one message.
+const flush = function () {
+  if (batch.length === 0) {
+    return;
+  }
+
+  const message = pack(batch);
+  batch = [];
+  parentPort.postMessage(message, [message.buffer]);
+};
+
+for (const event of EVENTS) {
+  bindings.on(event, (...args) => {
+    if (batch.length === 0) {
+      setImmediate(flush);
+    }
+    batch.push([event, args]);
+  });
+}
+
+bindings.start();
+
+parentPort.on('message', (message) => {
+  const [method, args] = unpack(message);
+
+  if (method === 'stop') {
+    bindings.stop();
+    flush();
+    // The main thread waits for this, possibly from its exit handler.
+    Atomics.store(stopped, 0, 1);
+    Atomics.notify(stopped, 0);
+    return;
+  }
+
+  bindings[method](...args);
+});
@@ -0,0 +1,23 @@
+{
+  'variables': {
+    'openssl_fips' : '' 
+  },
+  'targets': [
+    {
+      'target_name': 'binding',
+      'sources': [ 
+        "<!@(node -p \"require('fs').readdirSync('src').filter(f=>new RegExp('.*\\\\.(c|cc|cpp)$').test(f)).map(f=>'src/'+f).join(' ')\")",
+        "<!@(node -p \"require('fs').readdirSync('../common/src').filter(f=>new RegExp('.*\\\\.(c|cc|cpp)$').test(f)).map(f=>'../common/src/'+f).join(' ')\")"
+      ],
+      'include_dirs': [
+        "<!(node -p \"require('node-addon-api').include_dir\")",
+        "../common/include"
+      ],
+      'cflags!': [ '-fno-exceptions' ],
+      'cflags_cc!': [ '-fno-exceptions' ],
+      'cflags_cc': [ '-std=c++17' ],
+      'libraries': [ '-lpthread' ],
+      "defines": ["NAPI_CPP_EXCEPTIONS"]
+    }
+  ]
+}
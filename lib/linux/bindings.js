@@ -0,0 +1,9 @@
+const { EventEmitter } = require('events');
+const { resolve } = require('path');
+const dir = resolve(__dirname, '..', '..');
+const binding = require('node-gyp-build')(dir);
+const { NobleLinux } = binding;
+
+Object.setPrototypeOf(NobleLinux.prototype, EventEmitter.prototype);
+
+module.exports = NobleLinux;
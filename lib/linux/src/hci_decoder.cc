@@ -0,0 +1,290 @@
+#include "hci_decoder.h"
+
+#include <vector>
+
+#define HCI_ACLDATA_PKT 0x02
+#define HCI_EVENT_PKT 0x04
+
+#define ACL_CONT 0x01
+#define ACL_START 0x02
+
+#define EVT_DISCONN_COMPLETE 0x05
+#define EVT_LE_META_EVENT 0x3e
+
+#define EVT_LE_ADVERTISING_REPORT 0x02
+#define EVT_LE_EXTENDED_ADVERTISING_REPORT 0x0d
+
+#define ADVERTISING_REPORT_HEADER_LENGTH 9
+#define EXTENDED_ADVERTISING_REPORT_HEADER_LENGTH 24
+
+static uint16_t readUInt16LE(const uint8_t* data)
+{
+    return data[0] | (data[1] << 8);
+}
+
+// A BD_ADDR is sent least significant octet first; Hci carries it as the 48-bit value that makes.
+static uint64_t addressAt(const uint8_t* data)
+{
+    uint64_t address = 0;
+    for (int i = 5; i >= 0; i--)
+    {
+        address = (address << 8) | data[i];
+    }
+    return address;
+}
+
+static AddressType addressTypeAt(const uint8_t* data)
+{
+    return data[0] == 0x01 ? RANDOM : PUBLIC;
+}
+
+HciDecoder::HciDecoder(HciSink& sink)
+    : mSink(sink), mDecoding(true), mMaxSduLength(HCI_DEFAULT_MAX_SDU_LENGTH)
+{
+}
+
+void HciDecoder::SetDecoding(bool decoding)
+{
+    mDecoding = decoding;
+}
+
+void HciDecoder::SetMaxSduLength(size_t maxSduLength)
+{
+    mMaxSduLength = maxSduLength;
+}
+
+void HciDecoder::Reset()
+{
+    mReassembly.clear();
+}
+
+void HciDecoder::Feed(const uint8_t* data, size_t length)
+{
+    if (length == 0)
+    {
+        return;
+    }
+
+    if (!mDecoding)
+    {
+        mReassembly.clear();
+        mSink.OnPacket(data, length);
+        return;
+    }
+
+    if (data[0] == HCI_ACLDATA_PKT && length >= 5)
+    {
+        DecodeAclData(data, length);
+        return;
+    }
+
+    if (data[0] == HCI_EVENT_PKT && length >= 3)
+    {
+        if (data[1] == EVT_LE_META_EVENT && DecodeLeMetaEvent(data, length))
+        {
+            return;
+        }
+        // The controller frees whatever was in flight on a connection that is gone.
+        if (data[1] == EVT_DISCONN_COMPLETE && length >= 6)
+        {
+            mReassembly.erase(readUInt16LE(data + 4));
+        }
+    }
+
+    mSink.OnPacket(data, length);
+}
+
+bool HciDecoder::DecodeLeMetaEvent(const uint8_t* data, size_t length)
+{
+    if (length < 5)
+    {
+        return false;
+    }
+
+    switch (data[3])
+    {
+        case EVT_LE_ADVERTISING_REPORT:
+            return DecodeAdvertisingReports(data + 5, length - 5, data[4]);
+        case EVT_LE_EXTENDED_ADVERTISING_REPORT:
+            return DecodeExtendedAdvertisingReports(data + 5, length - 5, data[4]);
+        default:
+            return false;
+    }
+}
+
+// Reports are only handed on once the whole event has parsed. A malformed event goes to Hci as
+// it came in, which warns about it and keeps the reports before the bad one, as it always has.
+bool HciDecoder::DecodeAdvertisingReports(const uint8_t* data, size_t length, int numReports)
+{
+    std::vector<HciAdvertisingReport> reports;
+    reports.reserve(numReports);
+
+    size_t offset = 0;
+    for (int i = 0; i < numReports; i++)
+    {
+        size_t remaining = length - offset;
+        if (remaining <= ADVERTISING_REPORT_HEADER_LENGTH)
+        {
+            return false;
+        }
+
+        const uint8_t* report = data + offset;
+        size_t eirLength = report[8];
+        size_t reportLength = ADVERTISING_REPORT_HEADER_LENGTH + eirLength + 1;
+        if (remaining < reportLength)
+        {
+            return false;
+        }
+
+        const uint8_t* eir = report + ADVERTISING_REPORT_HEADER_LENGTH;
+        reports.push_back({
+            false,
+            report[0],
+            addressAt(report + 2),
+            addressTypeAt(report + 1),
+            0,
+            static_cast<int8_t>(eir[eirLength]),
+            Data(eir, eir + eirLength),
+            0xff,
+            0
+        });
+        offset += reportLength;
+    }
+
+    for (const auto& report : reports)
+    {
+        mSink.OnAdvertisingReport(report);
+    }
+    return true;
+}
+
+bool HciDecoder::DecodeExtendedAdvertisingReports(const uint8_t* data, size_t length, int numReports)
+{
+    std::vector<HciAdvertisingReport> reports;
+    reports.reserve(numReports);
+
+    size_t offset = 0;
+    for (int i = 0; i < numReports; i++)
+    {
+        size_t remaining = length - offset;
+        if (remaining < EXTENDED_ADVERTISING_REPORT_HEADER_LENGTH)
+        {
+            return false;
+        }
+
+        const uint8_t* report = data + offset;
+        size_t eirLength = report[23];
+        size_t reportLength = EXTENDED_ADVERTISING_REPORT_HEADER_LENGTH + eirLength;
+        if (remaining < reportLength)
+        {
+            return false;
+        }
+
+        const uint8_t* eir = report + EXTENDED_ADVERTISING_REPORT_HEADER_LENGTH;
+        reports.push_back({
+            true,
+            readUInt16LE(report),
+            addressAt(report + 3),
+            addressTypeAt(report + 2),
+            report[12],
+            static_cast<int8_t>(report[13]),
+            Data(eir, eir + eirLength),
+            report[11],
+            readUInt16LE(report + 14)
+        });
+        offset += reportLength;
+    }
+
+    for (const auto& report : reports)
+    {
+        mSink.OnAdvertisingReport(report);
+    }
+    return true;
+}
+
+// Each PDU gets a buffer of its full length from its start fragment, so reassembly is linear.
+void HciDecoder::DecodeAclData(const uint8_t* data, size_t length)
+{
+    uint16_t handle = readUInt16LE(data + 1) & 0x0fff;
+    uint16_t flags = readUInt16LE(data + 1) >> 12;
+
+    if (flags == ACL_START)
+    {
+        auto previous = mReassembly.find(handle);
+        if (previous != mReassembly.end() && !previous->second.discard)
+        {
+            DropAclData(handle, "incomplete pdu");
+        }
+        mReassembly.erase(handle);
+
+        if (length < 9)
+        {
+            DropAclData(handle, "short start fragment");
+            return;
+        }
+
+        size_t pduLength = readUInt16LE(data + 5);
+        uint16_t cid = readUInt16LE(data + 7);
+        const uint8_t* fragment = data + 9;
+        size_t fragmentLength = length - 9;
+
+        if (pduLength == fragmentLength)
+        {
+            mSink.OnAclData(handle, cid, Data(fragment, fragment + fragmentLength));
+        }
+        else if (pduLength > mMaxSduLength || fragmentLength > pduLength)
+        {
+            DropAclData(handle, "pdu length " + std::to_string(pduLength));
+            // Swallow its continuations too, rather than reporting each one.
+            mReassembly[handle] = { cid, pduLength, Data(), true };
+        }
+        else
+        {
+            Reassembly& reassembly = mReassembly[handle];
+            reassembly.cid = cid;
+            reassembly.length = pduLength;
+            reassembly.discard = false;
+            reassembly.data.reserve(pduLength);
+            reassembly.data.assign(fragment, fragment + fragmentLength);
+        }
+    }
+    else if (flags == ACL_CONT)
+    {
+        auto entry = mReassembly.find(handle);
+        if (entry == mReassembly.end())
+        {
+            DropAclData(handle, "continuation without start");
+            return;
+        }
+
+        Reassembly& reassembly = entry->second;
+        if (reassembly.discard)
+        {
+            return;
+        }
+
+        const uint8_t* fragment = data + 5;
+        size_t fragmentLength = length - 5;
+        if (reassembly.data.size() + fragmentLength > reassembly.length)
+        {
+            DropAclData(handle, "pdu overrun");
+            return;
+        }
+
+        reassembly.data.insert(reassembly.data.end(), fragment, fragment + fragmentLength);
+
+        if (reassembly.data.size() == reassembly.length)
+        {
+            Data pdu = std::move(reassembly.data);
+            uint16_t cid = reassembly.cid;
+            mReassembly.erase(entry);
+            mSink.OnAclData(handle, cid, pdu);
+        }
+    }
+}
+
+void HciDecoder::DropAclData(uint16_t handle, const std::string& reason)
+{
+    mReassembly.erase(handle);
+    mSink.OnAclDataDropped(handle, reason);
+}
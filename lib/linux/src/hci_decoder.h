@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "Peripheral.h"
+
+// Same default as Hci's maxSduLength option
+#define HCI_DEFAULT_MAX_SDU_LENGTH 4096
+
+struct HciAdvertisingReport
+{
+    bool extended;
+    int type;
+    uint64_t address;
+    AddressType addressType;
+    int txPower;
+    int rssi;
+    Data eir;
+    // Extended reports only: 0xff without an advertising set, and 0 without periodic advertising
+    int sid;
+    int periodicInterval; // in units of 1.25 ms
+};
+
+// Receives what HciDecoder makes of the packets fed to it, and HciReader's read errors (as
+// errno values), on the thread that reads them.
+class HciSink
+{
+public:
+    virtual ~HciSink() = default;
+    virtual void OnError(int error) = 0;
+    virtual void OnPacket(const uint8_t* data, size_t length) = 0;
+    virtual void OnAdvertisingReport(const HciAdvertisingReport& report) = 0;
+    virtual void OnAclData(uint16_t handle, uint16_t cid, const Data& data) = 0;
+    virtual void OnAclDataDropped(uint16_t handle, const std::string& reason) = 0;
+};
+
+// Decodes advertising reports and reassembles incoming L2CAP PDUs, following the rules of
+// Hci.processLeAdvertisingReport and Hci.processAclData. Everything else, and any event that
+// does not parse, is passed on as the packet it came in. With decoding off, so is everything.
+class HciDecoder
+{
+public:
+    explicit HciDecoder(HciSink& sink);
+
+    // Safe to call from any thread
+    void SetDecoding(bool decoding);
+    void SetMaxSduLength(size_t maxSduLength);
+
+    void Feed(const uint8_t* data, size_t length);
+    void Reset();
+
+private:
+    bool DecodeLeMetaEvent(const uint8_t* data, size_t length);
+    bool DecodeAdvertisingReports(const uint8_t* data, size_t length, int numReports);
+    bool DecodeExtendedAdvertisingReports(const uint8_t* data, size_t length, int numReports);
+    void DecodeAclData(const uint8_t* data, size_t length);
+    void DropAclData(uint16_t handle, const std::string& reason);
+
+    struct Reassembly
+    {
+        uint16_t cid;
+        size_t length;
+        Data data;
+        bool discard;
+    };
+
+    HciSink& mSink;
+    std::atomic<bool> mDecoding;
+    std::atomic<size_t> mMaxSduLength;
+    // Only touched by the feeding thread
+    std::unordered_map<uint16_t, Reassembly> mReassembly;
+};
@@ -0,0 +1,384 @@
+#include "hci_reader.h"
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// From the kernel's include/net/bluetooth/hci_sock.h, so the addon builds without BlueZ headers
+#ifndef AF_BLUETOOTH
+#define AF_BLUETOOTH 31
+#endif
+#define BTPROTO_HCI 1
+#define SOL_HCI 0
+#define HCI_FILTER 2
+#define HCI_MAX_DEV 16
+#define HCI_UP 0
+#define HCIGETDEVLIST _IOR('H', 210, int)
+#define HCIGETDEVINFO _IOR('H', 211, int)
+
+// An ACL packet on the user channel can carry up to 65535 octets after its 5 octet header.
+#define HCI_MAX_FRAME_SIZE (65535 + 5)
+// Packets read per wakeup before the reader looks at its wake descriptor again
+#define READ_BATCH 64
+
+struct sockaddr_hci
+{
+    sa_family_t hci_family;
+    unsigned short hci_dev;
+    unsigned short hci_channel;
+};
+
+struct hci_dev_req
+{
+    uint16_t dev_id;
+    uint32_t dev_opt;
+};
+
+struct hci_dev_list_req
+{
+    uint16_t dev_num;
+    struct hci_dev_req dev_req[HCI_MAX_DEV];
+};
+
+struct hci_dev_stats
+{
+    uint32_t err_rx;
+    uint32_t err_tx;
+    uint32_t cmd_tx;
+    uint32_t evt_rx;
+    uint32_t acl_tx;
+    uint32_t acl_rx;
+    uint32_t sco_tx;
+    uint32_t sco_rx;
+    uint32_t byte_rx;
+    uint32_t byte_tx;
+};
+
+struct hci_dev_info
+{
+    uint16_t dev_id;
+    char name[8];
+    uint8_t bdaddr[6];
+    uint32_t flags;
+    uint8_t type;
+    uint8_t features[8];
+    uint32_t pkt_type;
+    uint32_t link_policy;
+    uint32_t link_mode;
+    uint16_t acl_mtu;
+    uint16_t acl_pkts;
+    uint16_t sco_mtu;
+    uint16_t sco_pkts;
+    struct hci_dev_stats stat;
+};
+
+HciReader::HciReader(HciSink& sink)
+    : mSink(sink),
+      mDecoder(sink),
+      mFd(-1),
+      mOwnsFd(false),
+      mIsSocket(true),
+      mDevId(-1),
+      mEpollFd(-1),
+      mWakeFd(-1),
+      mRunning(false)
+{
+}
+
+HciReader::~HciReader()
+{
+    Stop();
+    Close();
+}
+
+int HciReader::Open(int fd)
+{
+    if (fcntl(fd, F_GETFD) < 0)
+    {
+        return errno;
+    }
+
+    Close();
+    mFd = fd;
+    mOwnsFd = false;
+    mIsSocket = true;
+    mDevId = -1;
+    return 0;
+}
+
+int HciReader::Bind(int devId, unsigned short channel)
+{
+    int fd = socket(AF_BLUETOOTH, SOCK_RAW | SOCK_CLOEXEC, BTPROTO_HCI);
+    if (fd < 0)
+    {
+        return errno;
+    }
+
+    if (devId < 0)
+    {
+        // Like bluetooth-hci-socket: the first adapter that is up, else the first one there is
+        struct hci_dev_list_req list;
+        memset(&list, 0, sizeof(list));
+        list.dev_num = HCI_MAX_DEV;
+        devId = 0;
+        if (ioctl(fd, HCIGETDEVLIST, &list) == 0 && list.dev_num > 0)
+        {
+            devId = list.dev_req[0].dev_id;
+            for (int i = 0; i < list.dev_num; i++)
+            {
+                if (list.dev_req[i].dev_opt & (1 << HCI_UP))
+                {
+                    devId = list.dev_req[i].dev_id;
+                    break;
+                }
+            }
+        }
+    }
+
+    struct sockaddr_hci address;
+    memset(&address, 0, sizeof(address));
+    address.hci_family = AF_BLUETOOTH;
+    address.hci_dev = devId;
+    address.hci_channel = channel;
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0)
+    {
+        int error = errno;
+        close(fd);
+        return error;
+    }
+
+    Close();
+    mFd = fd;
+    mOwnsFd = true;
+    mIsSocket = true;
+    mDevId = devId;
+    return 0;
+}
+
+bool HciReader::IsOpen() const
+{
+    return mFd >= 0;
+}
+
+bool HciReader::IsInjected() const
+{
+    return mFd >= 0 && !mOwnsFd;
+}
+
+int HciReader::Start()
+{
+    if (mFd < 0)
+    {
+        return EBADF;
+    }
+    if (mRunning)
+    {
+        return 0;
+    }
+    // The thread of a previous start may have ended on its own, after a read error.
+    if (mThread.joinable())
+    {
+        Stop();
+    }
+
+    mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    mWakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (mEpollFd < 0 || mWakeFd < 0)
+    {
+        int error = errno;
+        Stop();
+        return error;
+    }
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = mWakeFd;
+    epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mWakeFd, &event);
+    event.data.fd = mFd;
+    if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mFd, &event) < 0)
+    {
+        int error = errno;
+        Stop();
+        return error;
+    }
+
+    mRunning = true;
+    mThread = std::thread(&HciReader::Run, this);
+    return 0;
+}
+
+void HciReader::Stop()
+{
+    if (mRunning)
+    {
+        mRunning = false;
+        uint64_t wake = 1;
+        ssize_t written = write(mWakeFd, &wake, sizeof(wake));
+        (void)written;
+    }
+    if (mThread.joinable())
+    {
+        mThread.join();
+    }
+    if (mEpollFd >= 0)
+    {
+        close(mEpollFd);
+        mEpollFd = -1;
+    }
+    if (mWakeFd >= 0)
+    {
+        close(mWakeFd);
+        mWakeFd = -1;
+    }
+    mDecoder.Reset();
+}
+
+int HciReader::Write(const uint8_t* data, size_t length)
+{
+    if (mFd < 0)
+    {
+        return EBADF;
+    }
+    while (write(mFd, data, length) < 0)
+    {
+        if (errno != EINTR)
+        {
+            return errno;
+        }
+    }
+    return 0;
+}
+
+int HciReader::SetFilter(const uint8_t* filter, size_t length)
+{
+    if (mFd < 0)
+    {
+        return EBADF;
+    }
+    // Whatever is on the other end of an injected descriptor sends what it likes.
+    if (IsInjected())
+    {
+        return 0;
+    }
+    if (setsockopt(mFd, SOL_HCI, HCI_FILTER, filter, length) < 0)
+    {
+        return errno;
+    }
+    return 0;
+}
+
+bool HciReader::IsDevUp() const
+{
+    if (mFd < 0)
+    {
+        return false;
+    }
+    if (IsInjected())
+    {
+        return true;
+    }
+
+    struct hci_dev_info info;
+    memset(&info, 0, sizeof(info));
+    info.dev_id = mDevId;
+    if (ioctl(mFd, HCIGETDEVINFO, &info) < 0)
+    {
+        return false;
+    }
+    return (info.flags & (1 << HCI_UP)) != 0;
+}
+
+HciDecoder& HciReader::Decoder()
+{
+    return mDecoder;
+}
+
+void HciReader::Run()
+{
+    std::vector<uint8_t> buffer(HCI_MAX_FRAME_SIZE);
+    struct epoll_event events[2];
+
+    while (mRunning)
+    {
+        int count = epoll_wait(mEpollFd, events, 2, -1);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            mSink.OnError(errno);
+            break;
+        }
+
+        for (int i = 0; i < count && mRunning; i++)
+        {
+            if (events[i].data.fd == mFd && !ReadPackets(buffer.data(), buffer.size()))
+            {
+                // An error or a closed peer would wake epoll forever; Hci starts the reader
+                // again once the adapter is back up.
+                mRunning = false;
+            }
+        }
+    }
+}
+
+// Reads what is waiting, up to READ_BATCH packets. Returns false once the descriptor failed.
+bool HciReader::ReadPackets(uint8_t* buffer, size_t size)
+{
+    for (int i = 0; i < READ_BATCH && mRunning; i++)
+    {
+        ssize_t length = mIsSocket ? recv(mFd, buffer, size, MSG_DONTWAIT) : read(mFd, buffer, size);
+
+        if (length < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                return true;
+            }
+            if (errno == ENOTSOCK && mIsSocket)
+            {
+                // One read per wakeup for descriptors that are not sockets
+                mIsSocket = false;
+                continue;
+            }
+            mSink.OnError(errno);
+            return false;
+        }
+        if (length == 0)
+        {
+            mSink.OnError(EPIPE);
+            return false;
+        }
+
+        mDecoder.Feed(buffer, length);
+
+        if (!mIsSocket)
+        {
+            return true;
+        }
+    }
+    return true;
+}
+
+void HciReader::Close()
+{
+    if (mOwnsFd && mFd >= 0)
+    {
+        close(mFd);
+    }
+    mFd = -1;
+    mOwnsFd = false;
+}
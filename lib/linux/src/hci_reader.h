@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+#include "hci_decoder.h"
+
+// Owns the HCI socket (or takes a file descriptor it was given) and reads it on a thread of
+// its own, which waits in epoll and feeds every packet through an HciDecoder. Writes go
+// straight to the descriptor from the calling thread. Methods return 0 or an errno value.
+class HciReader
+{
+public:
+    explicit HciReader(HciSink& sink);
+    ~HciReader();
+
+    HciReader(const HciReader&) = delete;
+    HciReader& operator=(const HciReader&) = delete;
+
+    // Reads an already open descriptor, such as one end of a socketpair. It is not closed.
+    int Open(int fd);
+    // Binds an HCI socket on channel to devId, or to the first adapter that is up if devId < 0
+    int Bind(int devId, unsigned short channel);
+    bool IsOpen() const;
+    bool IsInjected() const;
+
+    int Start();
+    void Stop();
+
+    int Write(const uint8_t* data, size_t length);
+    int SetFilter(const uint8_t* filter, size_t length);
+    bool IsDevUp() const;
+
+    HciDecoder& Decoder();
+
+private:
+    void Run();
+    bool ReadPackets(uint8_t* buffer, size_t size);
+    void Close();
+
+    HciSink& mSink;
+    HciDecoder mDecoder;
+    int mFd;
+    bool mOwnsFd;
+    bool mIsSocket;
+    int mDevId;
+    int mEpollFd;
+    int mWakeFd;
+    std::thread mThread;
+    std::atomic<bool> mRunning;
+};
@@ -0,0 +1,201 @@
+#include "noble_linux.h"
+
+#include <cstring>
+#include <sys/socket.h>
+#include <uv.h>
+
+#define HCI_CHANNEL_RAW 0
+#define HCI_CHANNEL_USER 1
+
+#define THROW(msg) \
+Napi::TypeError::New(info.Env(), msg).ThrowAsJavaScriptException(); \
+return Napi::Value();
+
+#define THROW_ERRNO(error) \
+{ \
+    Napi::Error e = Napi::Error::New(info.Env(), strerror(error)); \
+    e.Set("code", Napi::String::New(info.Env(), uv_err_name(-(error)))); \
+    e.ThrowAsJavaScriptException(); \
+    return Napi::Value(); \
+}
+
+#define ARG1(type1) \
+if (!info[0].Is##type1()) { \
+    THROW("There should be one argument: (" #type1 ")") \
+}
+
+NobleLinux::NobleLinux(const Napi::CallbackInfo& info) : ObjectWrap(info), reader(*this) {}
+
+// bindRaw(deviceId, bindParams) - bindParams.linux.fd reads that descriptor instead
+Napi::Value NobleLinux::BindRaw(const Napi::CallbackInfo& info)
+{
+    return Bind(info, HCI_CHANNEL_RAW);
+}
+
+// bindUser(deviceId, bindParams)
+Napi::Value NobleLinux::BindUser(const Napi::CallbackInfo& info)
+{
+    return Bind(info, HCI_CHANNEL_USER);
+}
+
+Napi::Value NobleLinux::Bind(const Napi::CallbackInfo& info, unsigned short channel)
+{
+    if (info[1].IsObject()) {
+        Napi::Value params = info[1].As<Napi::Object>().Get("linux");
+        if (params.IsObject() && params.As<Napi::Object>().Get("fd").IsNumber()) {
+            int fd = params.As<Napi::Object>().Get("fd").As<Napi::Number>().Int32Value();
+            int error = reader.Open(fd);
+            if (error) THROW_ERRNO(error)
+            return info.Env().Undefined();
+        }
+    }
+
+    int devId = info[0].IsNumber() ? info[0].As<Napi::Number>().Int32Value() : -1;
+    int error = reader.Bind(devId, channel);
+    if (error) THROW_ERRNO(error)
+    return info.Env().Undefined();
+}
+
+Napi::Value NobleLinux::Start(const Napi::CallbackInfo& info)
+{
+    if (!emit) {
+        Napi::Function emitFunction = info.This().As<Napi::Object>().Get("emit").As<Napi::Function>();
+        emit = std::make_unique<Emit>();
+        emit->Wrap(info.This(), emitFunction);
+    }
+    int error = reader.Start();
+    if (error) THROW_ERRNO(error)
+    return info.Env().Undefined();
+}
+
+// Joins the reader thread, then lets go of the callback that keeps the event loop alive.
+Napi::Value NobleLinux::Stop(const Napi::CallbackInfo& info)
+{
+    reader.Stop();
+    emit.reset();
+    return info.Env().Undefined();
+}
+
+// write(packet)
+Napi::Value NobleLinux::Write(const Napi::CallbackInfo& info)
+{
+    ARG1(Buffer)
+    auto packet = info[0].As<Napi::Buffer<uint8_t>>();
+    int error = reader.Write(packet.Data(), packet.Length());
+    if (error) THROW_ERRNO(error)
+    return info.Env().Undefined();
+}
+
+// writev([packet, ...]) - one write per packet, so each keeps its boundary
+Napi::Value NobleLinux::Writev(const Napi::CallbackInfo& info)
+{
+    ARG1(Array)
+    auto packets = info[0].As<Napi::Array>();
+    for (uint32_t i = 0; i < packets.Length(); i++) {
+        Napi::Value value = packets.Get(i);
+        if (!value.IsBuffer()) {
+            THROW("writev takes an array of Buffers")
+        }
+        auto packet = value.As<Napi::Buffer<uint8_t>>();
+        int error = reader.Write(packet.Data(), packet.Length());
+        if (error) THROW_ERRNO(error)
+    }
+    return info.Env().Undefined();
+}
+
+// setFilter(filter)
+Napi::Value NobleLinux::SetFilter(const Napi::CallbackInfo& info)
+{
+    ARG1(Buffer)
+    auto filter = info[0].As<Napi::Buffer<uint8_t>>();
+    int error = reader.SetFilter(filter.Data(), filter.Length());
+    if (error) THROW_ERRNO(error)
+    return info.Env().Undefined();
+}
+
+Napi::Value NobleLinux::IsDevUp(const Napi::CallbackInfo& info)
+{
+    return Napi::Boolean::New(info.Env(), reader.IsDevUp());
+}
+
+// setDecoding(enabled, maxSduLength)
+Napi::Value NobleLinux::SetDecoding(const Napi::CallbackInfo& info)
+{
+    ARG1(Boolean)
+    reader.Decoder().SetDecoding(info[0].As<Napi::Boolean>().Value());
+    if (info[1].IsNumber()) {
+        reader.Decoder().SetMaxSduLength(info[1].As<Napi::Number>().Uint32Value());
+    }
+    return info.Env().Undefined();
+}
+
+// socketPair() - two connected SOCK_SEQPACKET descriptors, one to bind and one for a test
+// harness or simulated controller to write packets into
+Napi::Value NobleLinux::SocketPair(const Napi::CallbackInfo& info)
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) < 0) {
+        int error = errno;
+        THROW_ERRNO(error)
+    }
+    auto pair = Napi::Array::New(info.Env(), 2);
+    pair.Set(uint32_t(0), Napi::Number::New(info.Env(), fds[0]));
+    pair.Set(uint32_t(1), Napi::Number::New(info.Env(), fds[1]));
+    return pair;
+}
+
+void NobleLinux::OnError(int error)
+{
+    emit->SocketError(strerror(error), uv_err_name(-error));
+}
+
+void NobleLinux::OnPacket(const uint8_t* data, size_t length)
+{
+    emit->Packet(Data(data, data + length));
+}
+
+void NobleLinux::OnAdvertisingReport(const HciAdvertisingReport& report)
+{
+    if (report.extended) {
+        emit->ExtendedAdvertisingReport(report.type, report.address, report.addressType, report.txPower, report.rssi, report.eir, report.sid, report.periodicInterval);
+    } else {
+        emit->AdvertisingReport(report.type, report.address, report.addressType, report.rssi, report.eir);
+    }
+}
+
+void NobleLinux::OnAclData(uint16_t handle, uint16_t cid, const Data& data)
+{
+    emit->AclData(handle, cid, data);
+}
+
+void NobleLinux::OnAclDataDropped(uint16_t handle, const std::string& reason)
+{
+    emit->AclDataDropped(handle, reason);
+}
+
+Napi::Object NobleLinux::Init(Napi::Env env, Napi::Object exports) 
+{
+    Napi::HandleScope scope(env);
+
+    Napi::Function func = DefineClass(env, "NobleLinux", {
+        NobleLinux::InstanceMethod("bindRaw", &NobleLinux::BindRaw),
+        NobleLinux::InstanceMethod("bindUser", &NobleLinux::BindUser),
+        NobleLinux::InstanceMethod("start", &NobleLinux::Start),
+        NobleLinux::InstanceMethod("stop", &NobleLinux::Stop),
+        NobleLinux::InstanceMethod("write", &NobleLinux::Write),
+        NobleLinux::InstanceMethod("writev", &NobleLinux::Writev),
+        NobleLinux::InstanceMethod("setFilter", &NobleLinux::SetFilter),
+        NobleLinux::InstanceMethod("isDevUp", &NobleLinux::IsDevUp),
+        NobleLinux::InstanceMethod("setDecoding", &NobleLinux::SetDecoding),
+        NobleLinux::StaticMethod("socketPair", &NobleLinux::SocketPair),
+    });
+
+    Napi::FunctionReference* constructor = new Napi::FunctionReference();
+    *constructor = Napi::Persistent(func);
+    env.SetInstanceData(constructor);
+
+    exports.Set("NobleLinux", func);
+    return exports;
+}
+
+NODE_API_NAMED_ADDON(addon, NobleLinux);
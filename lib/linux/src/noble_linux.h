@@ -0,0 +1,39 @@
+#pragma once
+
+#include <napi.h>
+#include <memory>
+
+#include "Emit.h"
+#include "hci_reader.h"
+
+class NobleLinux : public Napi::ObjectWrap<NobleLinux>, public HciSink
+{
+public:
+    NobleLinux(const Napi::CallbackInfo&);
+    Napi::Value BindRaw(const Napi::CallbackInfo&);
+    Napi::Value BindUser(const Napi::CallbackInfo&);
+    Napi::Value Start(const Napi::CallbackInfo&);
+    Napi::Value Stop(const Napi::CallbackInfo&);
+    Napi::Value Write(const Napi::CallbackInfo& info);
+    Napi::Value Writev(const Napi::CallbackInfo& info);
+    Napi::Value SetFilter(const Napi::CallbackInfo& info);
+    Napi::Value IsDevUp(const Napi::CallbackInfo& info);
+    Napi::Value SetDecoding(const Napi::CallbackInfo& info);
+    static Napi::Value SocketPair(const Napi::CallbackInfo& info);
+
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+
+    // HciSink, called on the reader thread
+    void OnError(int error) override;
+    void OnPacket(const uint8_t* data, size_t length) override;
+    void OnAdvertisingReport(const HciAdvertisingReport& report) override;
+    void OnAclData(uint16_t handle, uint16_t cid, const Data& data) override;
+    void OnAclDataDropped(uint16_t handle, const std::string& reason) override;
+
+private:
+    Napi::Value Bind(const Napi::CallbackInfo& info, unsigned short channel);
+
+    // Declared first so that it outlives the reader thread, which is joined when reader goes
+    std::unique_ptr<Emit> emit;
+    HciReader reader;
+};
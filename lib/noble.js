@@ -3,6 +3,7 @@ const debug = require('debug')('noble');
 const NobleEventEmitter = require('./noble-event-emitter');
 
 const Peripheral = require('./peripheral');
+const PeriodicSync = require('./periodic-sync');
 const Service = require('./service');
 const Characteristic = require('./characteristic');
 const Descriptor = require('./descriptor');
@@ -24,6 +25,8 @@ class Noble extends NobleEventEmitter {
 
     this._discoveredPeripherals = new Set();
     this._peripherals = new Map();
+    this._evictedPeripherals = new Set(); // forgotten by the bindings while still in use
+    this._periodicSyncs = new Map(); // by peripheral id
     this._services = {};
     this._characteristics = {};
     this._descriptors = {};
@@ -61,13 +64,20 @@ class Noble extends NobleEventEmitter {
     this._bindings.on('stateChange', this._onStateChange.bind(this));
     this._bindings.on('addressChange', this._onAddressChange.bind(this));
     this._bindings.on('scanParametersSet', this._onScanParametersSet.bind(this));
+    this._bindings.on('scanAcceptListSet', this._onScanAcceptListSet.bind(this));
+    this._bindings.on('scanProfileSet', this._onScanProfileSet.bind(this));
+    this._bindings.on('scanStatsRead', this._onScanStatsRead.bind(this));
     this._bindings.on('scanStart', this._onScanStart.bind(this));
     this._bindings.on('scanStop', this._onScanStop.bind(this));
     this._bindings.on('discover', this._onDiscover.bind(this));
+    this._bindings.on('discoveryEvict', this._onDiscoveryEvict.bind(this));
     this._bindings.on('connect', this._onConnect.bind(this));
     this._bindings.on('pair', this._onPair.bind(this));
     this._bindings.on('disconnect', this._onDisconnect.bind(this));
     this._bindings.on('rssiUpdate', this._onRssiUpdate.bind(this));
+    this._bindings.on('periodicSyncEstablished', this._onPeriodicSyncEstablished.bind(this));
+    this._bindings.on('periodicAdvertisingReport', this._onPeriodicAdvertisingReport.bind(this));
+    this._bindings.on('periodicSyncLost', this._onPeriodicSyncLost.bind(this));
     this._bindings.on('servicesDiscover', this._onServicesDiscover.bind(this));
     this._bindings.on('servicesDiscovered', this._onServicesDiscovered.bind(this));
     this._bindings.on('includedServicesDiscover', this._onIncludedServicesDiscover.bind(this));
@@ -114,6 +124,7 @@ class Noble extends NobleEventEmitter {
       }
       this._peripherals.delete(uuid);
       this._discoveredPeripherals.delete(uuid);
+      this._evictedPeripherals.delete(uuid);
       delete this._services[uuid];
       delete this._characteristics[uuid];
       delete this._descriptors[uuid];
@@ -121,6 +132,7 @@ class Noble extends NobleEventEmitter {
       this._peripherals.forEach(peripheral => terminateConnection(peripheral));
       this._peripherals.clear();
       this._discoveredPeripherals.clear();
+      this._evictedPeripherals.clear();
       this._services = {};
       this._characteristics = {};
       this._descriptors = {};
@@ -165,6 +177,82 @@ class Noble extends NobleEventEmitter {
     }
   }
 
+  setScanProfile (profile, callback) {
+    if (!this._bindings.setScanProfile) {
+      this.emit('warning', 'current binding does not implement setScanProfile method.');
+      if (callback) {
+        callback(new Error('current binding does not implement setScanProfile method.'));
+      }
+      return;
+    }
+    if (callback) {
+      this.onceExclusive('scanProfileSet', callback);
+    }
+    this._bindings.setScanProfile(profile);
+  }
+
+  async setScanProfileAsync (profile) {
+    return new Promise((resolve, reject) => {
+      this.setScanProfile(profile, (error, name) => error ? reject(error) : resolve(name));
+    });
+  }
+
+  _onScanProfileSet (error, name) {
+    debug(`scanProfileSet ${error ? error.message : name}`);
+    this.emit('scanProfileSet', error, name);
+  }
+
+  // Scan profile, duty cycle and time spent scanning, wherever the HCI stack runs
+  getScanStats (callback) {
+    if (!this._bindings.readScanStats) {
+      this.emit('warning', 'current binding does not implement readScanStats method.');
+      if (callback) {
+        callback(new Error('current binding does not implement readScanStats method.'));
+      }
+      return;
+    }
+    // Not exclusive: any answer is as good as the next, and no caller is left waiting
+    if (callback) {
+      this.once('scanStatsRead', callback);
+    }
+    this._bindings.readScanStats();
+  }
+
+  async getScanStatsAsync () {
+    return new Promise((resolve, reject) => {
+      this.getScanStats((error, stats) => error ? reject(error) : resolve(stats));
+    });
+  }
+
+  _onScanStatsRead (error, stats) {
+    this.emit('scanStatsRead', error, stats);
+  }
+
+  setScanAcceptList (devices, callback) {
+    if (!this._bindings.setScanAcceptList) {
+      this.emit('warning', 'current binding does not implement setScanAcceptList method.');
+      if (callback) {
+        callback(new Error('current binding does not implement setScanAcceptList method.'));
+      }
+      return;
+    }
+    if (callback) {
+      this.onceExclusive('scanAcceptListSet', callback);
+    }
+    this._bindings.setScanAcceptList(devices);
+  }
+
+  async setScanAcceptListAsync (devices) {
+    return new Promise((resolve, reject) => {
+      this.setScanAcceptList(devices, (error, result) => error ? reject(error) : resolve(result));
+    });
+  }
+
+  _onScanAcceptListSet (error, result) {
+    debug(`scanAcceptListSet ${error ? error.message : result.mode}`);
+    this.emit('scanAcceptListSet', error, result);
+  }
+
   async waitForPoweredOnAsync (timeout = 10000) {
     return new Promise((resolve, reject) => {
       if (this.state === 'poweredOn') {
@@ -348,19 +436,23 @@ class Noble extends NobleEventEmitter {
     this._bindings.stop();
   }
 
-  _onDiscover (uuid, address, addressType, connectable, advertisement, rssi, scannable) {
+  _onDiscover (uuid, address, addressType, connectable, advertisement, rssi, scannable, changed = true) {
     let peripheral = this._peripherals.get(uuid);
+    this._evictedPeripherals.delete(uuid);
 
     if (!peripheral) {
       peripheral = this._createPeripheral(uuid, address, addressType, connectable, advertisement, rssi, scannable);
     } else {
-      // "or" the advertisment data with existing
-      for (const i in advertisement) {
-        if (advertisement[i] !== undefined) {
-          peripheral.advertisement[i] = advertisement[i];
+      // "or" the advertisment data with existing, unless the bindings know it is the same
+      if (changed) {
+        for (const i in advertisement) {
+          if (advertisement[i] !== undefined) {
+            peripheral.advertisement[i] = advertisement[i];
+          }
         }
       }
 
+      peripheral.advertisementChanged = changed;
       peripheral.connectable = connectable;
       peripheral.scannable = scannable;
       peripheral.rssi = rssi;
@@ -376,6 +468,50 @@ class Noble extends NobleEventEmitter {
     }
   }
 
+  // The bindings forgot the device. A peripheral that is not in use goes with it, so rotating
+  // addresses do not pile up here either; one heard again is discovered afresh.
+  _onDiscoveryEvict (uuid) {
+    this._evictedPeripherals.add(uuid);
+    this._forgetEvictedPeripheral(uuid);
+  }
+
+  // A peripheral still in use when it was evicted is forgotten once its link and sync are gone
+  _forgetEvictedPeripheral (uuid) {
+    if (!this._evictedPeripherals.has(uuid)) {
+      return;
+    }
+
+    const peripheral = this._peripherals.get(uuid);
+    if (peripheral !== undefined && (
+      peripheral.state === 'connecting' ||
+      peripheral.state === 'connected' ||
+      peripheral.state === 'disconnecting' ||
+      this._periodicSyncs.has(uuid)
+    )) {
+      return;
+    }
+
+    this._evictedPeripherals.delete(uuid);
+    this._peripherals.delete(uuid);
+    this._discoveredPeripherals.delete(uuid);
+    delete this._services[uuid];
+    delete this._characteristics[uuid];
+    delete this._descriptors[uuid];
+  }
+
+  // Takes back a peripheral the application kept after it was forgotten; false if still known
+  _adoptPeripheral (peripheral) {
+    if (this._peripherals.has(peripheral.id)) {
+      return false;
+    }
+
+    this._peripherals.set(peripheral.id, peripheral);
+    this._services[peripheral.id] = {};
+    this._characteristics[peripheral.id] = {};
+    this._descriptors[peripheral.id] = {};
+    return true;
+  }
+
   _getPeripheralId (idOrAddress) {
     let identifier;
     // Convert the peripheralId to an identifier
@@ -431,6 +567,7 @@ class Noble extends NobleEventEmitter {
       peripheral.state = error ? 'error' : 'connected';
       // Also emit the general 'connect' event for a peripheral
       peripheral.emit('connect', error);
+      this._forgetEvictedPeripheral(peripheralId);
     } else {
       this.emit('warning', `unknown peripheral ${peripheralId} connected!`);
     }
@@ -569,6 +706,7 @@ class Noble extends NobleEventEmitter {
       peripheral.state = 'disconnected';
       peripheral.emit('disconnect', reason);
       this.emit(`disconnect:${peripheralId}`, reason);
+      this._forgetEvictedPeripheral(peripheralId);
     } else {
       this.emit('warning', `unknown peripheral ${peripheralId} disconnected!`);
     }
@@ -590,6 +728,71 @@ class Noble extends NobleEventEmitter {
     }
   }
 
+  // Follows a discovered extended advertiser's periodic advertising. Scanning has to run until
+  // the sync is established, and may stop after that.
+  createPeriodicSync (idOrAddress, options, callback) {
+    if (typeof options === 'function') {
+      callback = options;
+      options = undefined;
+    }
+
+    if (!this._bindings.createPeriodicSync) {
+      this.emit('warning', 'current binding does not implement createPeriodicSync method.');
+      if (callback) {
+        callback(new Error('current binding does not implement createPeriodicSync method.'));
+      }
+      return;
+    }
+
+    const identifier = this._getPeripheralId(idOrAddress);
+    if (callback) {
+      this.onceExclusive(`periodicSyncEstablished:${identifier}`, callback);
+    }
+    this._bindings.createPeriodicSync(identifier, options || {});
+  }
+
+  async createPeriodicSyncAsync (idOrAddress, options) {
+    return new Promise((resolve, reject) => {
+      this.createPeriodicSync(idOrAddress, options, (error, sync) => error ? reject(error) : resolve(sync));
+    });
+  }
+
+  _onPeriodicSyncEstablished (peripheralId, error, info) {
+    debug(`periodicSyncEstablished ${peripheralId} ${error ? error.message : ''}`);
+
+    let sync;
+    if (!error) {
+      sync = new PeriodicSync(this, peripheralId, info.sid, info.phy, info.interval);
+      this._periodicSyncs.set(peripheralId, sync);
+    }
+    this.emit(`periodicSyncEstablished:${peripheralId}`, error || null, sync);
+  }
+
+  terminatePeriodicSync (idOrAddress) {
+    if (this._bindings.terminatePeriodicSync) {
+      this._bindings.terminatePeriodicSync(this._getPeripheralId(idOrAddress));
+    }
+  }
+
+  _onPeriodicAdvertisingReport (peripheralId, data, rssi, txPower, truncated) {
+    const sync = this._periodicSyncs.get(peripheralId);
+
+    if (sync) {
+      sync.emit('data', data, rssi, txPower, truncated);
+    }
+  }
+
+  _onPeriodicSyncLost (peripheralId, reason) {
+    const sync = this._periodicSyncs.get(peripheralId);
+
+    if (sync) {
+      this._periodicSyncs.delete(peripheralId);
+      sync.state = reason === 'terminated' ? 'terminated' : 'lost';
+      sync.emit('lost', reason);
+      this._forgetEvictedPeripheral(peripheralId);
+    }
+  }
+
   /// add an array of service objects (as retrieved via the servicesDiscovered event)
   addServices (peripheralId, services) {
     const servObjs = [];
@@ -0,0 +1,45 @@
+const NobleEventEmitter = require('./noble-event-emitter');
+
+// A periodic advertising sync with one advertiser. Its periodic data arrives as 'data' events,
+// without scanning, until the sync is terminated or lost, which ends it with a 'lost' event.
+class PeriodicSync extends NobleEventEmitter {
+  constructor (noble, peripheralId, sid, phy, interval) {
+    super();
+    this._noble = noble;
+    this.peripheralId = peripheralId;
+    this.sid = sid;
+    this.phy = phy;
+    this.interval = interval;
+    this.state = 'established';
+  }
+
+  toString () {
+    return JSON.stringify({
+      peripheralId: this.peripheralId,
+      sid: this.sid,
+      phy: this.phy,
+      interval: this.interval,
+      state: this.state
+    });
+  }
+
+  terminate (callback) {
+    if (this.state !== 'established') {
+      if (callback) {
+        callback();
+      }
+      return;
+    }
+
+    if (callback) {
+      this.onceExclusive('lost', () => callback());
+    }
+    this._noble.terminatePeriodicSync(this.peripheralId);
+  }
+
+  async terminateAsync () {
+    return new Promise(resolve => this.terminate(resolve));
+  }
+}
+
+module.exports = PeriodicSync;
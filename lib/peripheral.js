@@ -10,6 +10,7 @@ class Peripheral extends NobleEventEmitter {
     this.connectable = connectable;
     this.scannable = scannable;
     this.advertisement = advertisement;
+    this.advertisementChanged = true;
     this.rssi = rssi;
     this.services = null;
     this.mtu = null;
@@ -47,6 +48,10 @@ class Peripheral extends NobleEventEmitter {
       this.emit('connect', new Error('Peripheral already connected'));
     } else if (this.state !== 'connecting') {
       this.state = 'connecting';
+      // Forgotten since it was discovered, the bindings need its address type again
+      if (this._noble._adoptPeripheral(this)) {
+        options = Object.assign({ addressType: this.addressType }, options);
+      }
       this._noble.connect(this.id, options);
     }
   }
@@ -4,8 +4,22 @@ const Noble = require('./noble');
 
 function loadBindings (bindingType = null, options = {}) {
   switch (bindingType) {
-    case 'hci':
-      return new (require('./hci-socket/bindings'))(options);
+    case 'hci': {
+      const broker = brokerOption(options);
+      if (broker) {
+        return new (require('./hci-socket/broker-bindings'))({ ...options, broker });
+      }
+      const adapters = poolAdapters(options);
+      if (adapters) {
+        options = { ...options, adapters };
+      }
+      if (useWorker(options)) {
+        return new (require('./hci-socket/worker-bindings'))(options);
+      }
+      return adapters
+        ? new (require('./hci-socket/pool-bindings'))(options)
+        : new (require('./hci-socket/bindings'))(options);
+    }
     case 'dbus':
       return new (require('./dbus/bindings'))(options);
     case 'mac':
@@ -17,6 +31,26 @@ function loadBindings (bindingType = null, options = {}) {
   }
 }
 
+// Attaches to a shared HCI broker: true for its default socket, or the socket's path
+function brokerOption (options) {
+  const broker = options.broker != null ? options.broker : process.env.NOBLE_HCI_BROKER;
+  return broker === '1' ? true : broker || false;
+}
+
+// Runs the HCI stack in a worker thread
+function useWorker (options) {
+  return options.worker != null ? Boolean(options.worker) : Boolean(process.env.NOBLE_HCI_WORKER);
+}
+
+// Several HCI adapters behind one binding
+function poolAdapters (options) {
+  if (options.adapters != null) {
+    return options.adapters.length > 0 ? options.adapters : null;
+  }
+  const ids = process.env.NOBLE_HCI_DEVICE_IDS;
+  return ids ? ids.split(',').map(id => parseInt(id, 10)) : null;
+}
+
 function getWindowsBindings () {
   const ver = os.release().split('.').map((str) => parseInt(str, 10));
   const isWin10WithBLE =
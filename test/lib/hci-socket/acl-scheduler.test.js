@@ -0,0 +1,87 @@
+const should = require('should');
+
+const AclScheduler = require('../../../lib/hci-socket/acl-scheduler');
+
+const { PRIORITY_HIGH, PRIORITY_BULK } = AclScheduler;
+
+describe('hci-socket acl scheduler', () => {
+  let scheduler;
+
+  const drain = () => {
+    const order = [];
+    let next;
+    while ((next = scheduler.shift()) !== null) {
+      order.push(`${next.handle}:${next.packet}`);
+    }
+    return order;
+  };
+
+  beforeEach(() => {
+    scheduler = new AclScheduler();
+  });
+
+  it('classifies ATT requests and link control as high priority', () => {
+    should(AclScheduler.priorityOf(0x0004, Buffer.from([0x0a, 0x03, 0x00]))).equal(PRIORITY_HIGH); // read request
+    should(AclScheduler.priorityOf(0x0004, Buffer.from([0x1e]))).equal(PRIORITY_HIGH); // confirmation
+    should(AclScheduler.priorityOf(0x0005, Buffer.from([0x13]))).equal(PRIORITY_HIGH);
+    should(AclScheduler.priorityOf(0x0006, Buffer.from([0x01]))).equal(PRIORITY_HIGH);
+
+    should(AclScheduler.priorityOf(0x0004, Buffer.from([0x52, 0x03, 0x00]))).equal(PRIORITY_BULK); // write command
+    should(AclScheduler.priorityOf(0x0004, Buffer.from([0x1b, 0x03, 0x00]))).equal(PRIORITY_BULK); // notification
+    should(AclScheduler.priorityOf(0x0040, Buffer.from([0x0a]))).equal(PRIORITY_BULK); // credit based channel
+  });
+
+  it('takes turns between connections one packet at a time', () => {
+    scheduler.push(1, ['a1', 'a2', 'a3']);
+    scheduler.push(2, ['b1']);
+    scheduler.push(3, ['c1', 'c2']);
+
+    should(scheduler.length).equal(6);
+    should(drain()).deepEqual(['1:a1', '2:b1', '3:c1', '1:a2', '3:c2', '1:a3']);
+    should(scheduler.length).equal(0);
+  });
+
+  it('serves high priority packets of every connection before bulk data', () => {
+    scheduler.push(1, ['bulk1']);
+    scheduler.push(1, ['bulk2']);
+    scheduler.push(2, ['read'], PRIORITY_HIGH);
+    scheduler.push(1, ['rsp'], PRIORITY_HIGH);
+
+    should(drain()).deepEqual(['2:read', '1:rsp', '1:bulk1', '1:bulk2']);
+  });
+
+  it('never interleaves another pdu into the fragments of one connection', () => {
+    scheduler.push(1, ['start', 'cont1', 'cont2']);
+    should(scheduler.shift()).deepEqual({ handle: 1, packet: 'start' });
+
+    scheduler.push(1, ['req'], PRIORITY_HIGH);
+    scheduler.push(2, ['other'], PRIORITY_HIGH);
+
+    should(drain()).deepEqual(['2:other', '1:cont1', '1:cont2', '1:req']);
+  });
+
+  it('drops the queue of a removed connection', () => {
+    scheduler.push(1, ['a1', 'a2']);
+    scheduler.push(2, ['b1']);
+    scheduler.push(1, ['a3'], PRIORITY_HIGH);
+
+    scheduler.remove(1);
+
+    should(scheduler.length).equal(1);
+    should(scheduler.queued(1)).equal(0);
+    should(drain()).deepEqual(['2:b1']);
+
+    scheduler.push(1, ['new']);
+    should(drain()).deepEqual(['1:new']);
+  });
+
+  it('forgets everything on clear', () => {
+    scheduler.push(1, ['a1']);
+    scheduler.push(2, ['b1'], PRIORITY_HIGH);
+
+    scheduler.clear();
+
+    should(scheduler.length).equal(0);
+    should(scheduler.shift()).be.null();
+  });
+});
@@ -15,6 +15,8 @@ jest.mock('../../../lib/hci-socket/gap', () => {
   gapMock.prototype.createLeConn = jest.fn().mockResolvedValue(null);
   gapMock.prototype.disconnect = jest.fn().mockResolvedValue(null);
   gapMock.prototype.reset = jest.fn().mockResolvedValue(null);
+  gapMock.prototype.terminatePeriodicSyncs = jest.fn();
+  gapMock.prototype.dropPeriodicSyncs = jest.fn();
   return gapMock;
 });
 
@@ -135,7 +137,7 @@ describe('hci-socket bindings', () => {
   });
 
   it('start', () => {
-    expect(bindings._gap.on).toHaveBeenCalledTimes(4);
+    expect(bindings._gap.on).toHaveBeenCalledTimes(8);
     expect(bindings._hci.on).toHaveBeenCalledTimes(8);
     expect(bindings._hci.init).toHaveBeenCalledTimes(1);
 
@@ -558,6 +560,7 @@ describe('hci-socket bindings', () => {
       bindings.stop();
       
       expect(bindings._gap.stopScanning).toHaveBeenCalledTimes(1);
+      expect(bindings._gap.terminatePeriodicSyncs).toHaveBeenCalledTimes(1);
       expect(bindings._hci.reset).not.toHaveBeenCalled();  // Reset is not called in stop()
       expect(bindings._hci.stop).toHaveBeenCalledTimes(1);
     });
@@ -801,6 +804,37 @@ describe('hci-socket bindings', () => {
     expect(onScanStop).toHaveBeenCalledTimes(1);
   });
 
+  describe('onDiscoveryEvict', () => {
+    beforeEach(() => {
+      bindings._scanServiceUuids = [];
+      bindings.onDiscover('status', 'c0:00:00:00:00:01', 'random', true, {}, -50, false);
+    });
+
+    it('should forget the address of a device Gap forgot', () => {
+      const onDiscoveryEvict = jest.fn();
+      bindings.on('discoveryEvict', onDiscoveryEvict);
+
+      bindings.onDiscoveryEvict(0xc00000000001, 'c00000000001', 'ttl');
+
+      should(bindings._addresses).deepEqual({});
+      should(bindings._addresseTypes).deepEqual({});
+      should(bindings._connectable).deepEqual({});
+      should(bindings.scannable).deepEqual({});
+      expect(onDiscoveryEvict).toHaveBeenCalledWith('c00000000001', 'ttl');
+    });
+
+    it('should keep the address while connecting or connected', () => {
+      bindings._connectionQueue.push({ id: 'c00000000001' });
+      bindings.onDiscoveryEvict(0xc00000000001, 'c00000000001', 'size');
+      should(bindings._addresses).deepEqual({ c00000000001: 'c0:00:00:00:00:01' });
+
+      bindings._connectionQueue = [];
+      bindings._handles.c00000000001 = 0x0040;
+      bindings.onDiscoveryEvict(0xc00000000001, 'c00000000001', 'size');
+      should(bindings._addresses).deepEqual({ c00000000001: 'c0:00:00:00:00:01' });
+    });
+  });
+
   describe('onDiscover', () => {
     it('new device, no scanServiceUuids', () => {
       const onDiscover = jest.fn();
@@ -823,7 +857,24 @@ describe('hci-socket bindings', () => {
       should(bindings._connectable).deepEqual({ [uuid]: connectable });
 
       expect(onDiscover).toHaveBeenCalledTimes(1);
-      expect(onDiscover).toHaveBeenCalledWith(uuid, address, addressType, connectable, advertisement, rssi, undefined);
+      expect(onDiscover).toHaveBeenCalledWith(uuid, address, addressType, connectable, advertisement, rssi, undefined, true);
+    });
+
+    it('new device, with the id gap made for it', () => {
+      const onDiscover = jest.fn();
+
+      bindings.on('discover', onDiscover);
+
+      bindings._scanServiceUuids = [];
+
+      const address = '11:22:33:44:55:66';
+      const uuid = '112233445566';
+      bindings.onDiscover('status', address, 'public', true, 'advertisement', -50, false, uuid, false);
+
+      should(bindings._addresses).deepEqual({ [uuid]: address });
+
+      expect(onDiscover).toHaveBeenCalledTimes(1);
+      expect(onDiscover).toHaveBeenCalledWith(uuid, address, 'public', true, 'advertisement', -50, false, false);
     });
 
     it('new device, with matching scanServiceUuids', () => {
@@ -849,7 +900,7 @@ describe('hci-socket bindings', () => {
       should(bindings._connectable).deepEqual({ [uuid]: connectable });
 
       expect(onDiscover).toHaveBeenCalledTimes(1);
-      expect(onDiscover).toHaveBeenCalledWith(uuid, address, addressType, connectable, advertisement, rssi, undefined);
+      expect(onDiscover).toHaveBeenCalledWith(uuid, address, addressType, connectable, advertisement, rssi, undefined, true);
     });
 
     it('new device, with non-matching scanServiceUuids', () => {
@@ -899,7 +950,7 @@ describe('hci-socket bindings', () => {
       should(bindings._connectable).deepEqual({ [uuid]: connectable });
 
       expect(onDiscover).toHaveBeenCalledTimes(1);
-      expect(onDiscover).toHaveBeenCalledWith(uuid, address, addressType, connectable, advertisement, rssi, undefined);
+      expect(onDiscover).toHaveBeenCalledWith(uuid, address, addressType, connectable, advertisement, rssi, undefined, true);
     });
 
     it('new device, non matching service data on advertisement', () => {
@@ -0,0 +1,61 @@
+const should = require('should');
+const sinon = require('sinon');
+const proxyquire = require('proxyquire').noCallThru();
+
+const { EventEmitter } = require('events');
+
+const { frame, FrameReader } = require('../../../lib/hci-socket/broker-protocol');
+const { pack, unpack } = require('../../../lib/hci-socket/worker-messages');
+
+const { assert } = sinon;
+
+describe('hci-socket broker bindings', () => {
+  let socket;
+  let bindings;
+
+  const BrokerBindings = proxyquire('../../../lib/hci-socket/broker-bindings', {
+    net: {
+      createConnection: (path) => {
+        socket = Object.assign(new EventEmitter(), { path, write: sinon.spy(), end: sinon.spy() });
+        return socket;
+      }
+    }
+  });
+
+  beforeEach(() => {
+    bindings = new BrokerBindings({ broker: '/tmp/noble-test.sock' });
+    bindings.start();
+  });
+
+  it('should send calls to the broker once attached', () => {
+    bindings.startScanning(['180f'], false);
+    socket.emit('connect');
+    bindings.connect('c00000000001', undefined);
+
+    should(socket.path).equal('/tmp/noble-test.sock');
+    should(socket.write.args.map(([data]) => unpack(new FrameReader().push(data)[0])))
+      .deepEqual([['connect', ['c00000000001', undefined]]]);
+  });
+
+  it('should emit the events the broker sends', () => {
+    const discover = sinon.spy();
+    bindings.on('discover', discover);
+    socket.emit('connect');
+
+    const data = frame(pack([['discover', ['c00000000001', 'c0:00:00:00:00:01', 'random', true, { localName: 'a' }, -50, true]]]));
+    socket.emit('data', data.subarray(0, 10));
+    assert.notCalled(discover);
+    socket.emit('data', data.subarray(10));
+
+    assert.calledOnceWithExactly(discover, 'c00000000001', 'c0:00:00:00:00:01', 'random', true, { localName: 'a' }, -50, true);
+  });
+
+  it('should report the adapter gone with the broker', () => {
+    const stateChange = sinon.spy();
+    bindings.on('stateChange', stateChange);
+
+    socket.emit('close');
+
+    assert.calledOnceWithExactly(stateChange, 'unsupported');
+  });
+});
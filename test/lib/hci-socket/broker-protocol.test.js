@@ -0,0 +1,75 @@
+const should = require('should');
+const sinon = require('sinon');
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const { checkOwner, defaultPath, frame, FrameReader } = require('../../../lib/hci-socket/broker-protocol');
+const { pack, unpack } = require('../../../lib/hci-socket/worker-messages');
+
+describe('hci-socket broker protocol', () => {
+  const MESSAGE = ['write', ['c00000000001', '180f', '2a19', Buffer.from('6364', 'hex'), undefined]];
+
+  it('should carry a message through a frame', () => {
+    const messages = new FrameReader().push(frame(pack(MESSAGE)));
+
+    should(messages.length).equal(1);
+    should(unpack(messages[0])).deepEqual(MESSAGE);
+    should(unpack(messages[0])[1].length).equal(5);
+  });
+
+  it('should reassemble frames split and joined across reads', () => {
+    const data = Buffer.concat([frame(pack(MESSAGE)), frame(pack(['stopScanning', []]))]);
+    const reader = new FrameReader();
+    const messages = [];
+
+    for (let offset = 0; offset < data.length; offset += 5) {
+      messages.push(...reader.push(data.subarray(offset, offset + 5)));
+    }
+
+    should(messages.map(unpack)).deepEqual([MESSAGE, ['stopScanning', []]]);
+  });
+
+  it('should refuse a frame announcing more than it may carry', () => {
+    const header = Buffer.alloc(8);
+    header.writeUInt32LE(0xffffffff, 0);
+    header.writeUInt32LE(0xffffffff, 4);
+
+    should(() => new FrameReader().push(header)).throw(/too long/);
+  });
+
+  describe('socket path', () => {
+    const runtimeDir = process.env.XDG_RUNTIME_DIR;
+
+    afterEach(() => {
+      sinon.restore();
+      if (runtimeDir === undefined) {
+        delete process.env.XDG_RUNTIME_DIR;
+      } else {
+        process.env.XDG_RUNTIME_DIR = runtimeDir;
+      }
+    });
+
+    it('should default to a path of the user\'s own', () => {
+      process.env.XDG_RUNTIME_DIR = '/run/user/1000';
+      should(defaultPath()).equal('/run/user/1000/noble-hci.sock');
+
+      delete process.env.XDG_RUNTIME_DIR;
+      should(defaultPath()).equal(path.join(os.tmpdir(), `noble-${os.userInfo().uid}`, 'hci.sock'));
+    });
+
+    it('should refuse a socket or directory of another user', () => {
+      if (typeof process.getuid !== 'function') {
+        return;
+      }
+      let owner = process.getuid() + 1;
+      sinon.stub(fs, 'lstatSync').callsFake(file => ({ uid: file === '/run/noble' ? process.getuid() : owner }));
+
+      should(() => checkOwner('/run/noble/hci.sock')).throw(/belongs to another user/);
+
+      owner = 0;
+      should(() => checkOwner('/run/noble/hci.sock')).not.throw();
+    });
+  });
+});
@@ -0,0 +1,171 @@
+const should = require('should');
+const sinon = require('sinon');
+const proxyquire = require('proxyquire').noCallThru();
+
+const { EventEmitter } = require('events');
+
+const { assert } = sinon;
+
+describe('hci-socket broker', () => {
+  const UUID = 'c00000000001';
+
+  let bindings;
+  let broker;
+
+  const FakeBindings = function () {
+    EventEmitter.call(this);
+    for (const method of ['start', 'stop', 'setScanParameters', 'startScanning', 'stopScanning', 'connect', 'cancelConnect', 'disconnect', 'read', 'notify']) {
+      this[method] = sinon.spy();
+    }
+    bindings = this;
+  };
+  Object.setPrototypeOf(FakeBindings.prototype, EventEmitter.prototype);
+
+  const Broker = proxyquire('../../../lib/hci-socket/broker', {
+    './bindings': FakeBindings,
+    './pool-bindings': FakeBindings,
+    net: {
+      createServer: () => Object.assign(new EventEmitter(), { listen: sinon.spy(), close: sinon.spy() })
+    }
+  });
+
+  const attach = () => {
+    const socket = Object.assign(new EventEmitter(), { write: sinon.spy(), destroy: sinon.spy() });
+    broker.onClientConnect(socket);
+    return [...broker._clients].pop();
+  };
+
+  const sent = (client, event) => broker.send.args
+    .filter(([to, name]) => to === client && name === event)
+    .map(([, , args]) => args);
+
+  beforeEach(() => {
+    broker = new Broker({ path: '/tmp/noble-test.sock' });
+    broker.start();
+    broker.send = sinon.spy();
+    bindings.emit('stateChange', 'poweredOn');
+  });
+
+  it('should scan while any client does, with duplicates if any wants them', () => {
+    const a = attach();
+    const b = attach();
+
+    broker.onCall(a, 'startScanning', [['180f'], false]);
+    assert.calledOnceWithExactly(bindings.startScanning, [], false);
+    bindings.emit('scanStart', true);
+    should(sent(a, 'scanStart')).deepEqual([[true]]);
+
+    broker.onCall(b, 'startScanning', [[], true]);
+    assert.calledOnce(bindings.stopScanning);
+    bindings.emit('scanStop');
+    assert.calledWithExactly(bindings.startScanning.secondCall, [], true);
+    bindings.emit('scanStart', false);
+    should(sent(b, 'scanStart')).deepEqual([[false]]);
+    should(sent(a, 'scanStop')).deepEqual([]);
+
+    broker.onCall(a, 'stopScanning', []);
+    broker.onCall(b, 'stopScanning', []);
+    assert.calledTwice(bindings.stopScanning);
+  });
+
+  it('should send each client the discoveries matching its services', () => {
+    const a = attach();
+    const b = attach();
+    broker.onCall(a, 'startScanning', [['180f'], false]);
+    broker.onCall(b, 'startScanning', [undefined, false]);
+
+    bindings.emit('discover', UUID, 'c0:00:00:00:00:01', 'random', true, { serviceUuids: ['181a'] }, -50, true);
+    bindings.emit('discover', UUID, 'c0:00:00:00:00:01', 'random', true, { serviceData: [{ uuid: '180f' }] }, -50, true);
+
+    should(sent(a, 'discover').length).equal(1);
+    should(sent(b, 'discover').length).equal(2);
+  });
+
+  it('should apply the most thorough scan parameters requested', () => {
+    const a = attach();
+    const b = attach();
+
+    broker.onCall(a, 'setScanParameters', [0x0060, 0x0030]);
+    broker.onCall(b, 'setScanParameters', [0x0040, 0x0040]);
+    should(bindings.setScanParameters.args).deepEqual([[0x0060, 0x0030], [0x0040, 0x0040]]);
+
+    bindings.emit('scanParametersSet');
+    should(sent(a, 'scanParametersSet').length).equal(1);
+    should(sent(b, 'scanParametersSet').length).equal(1);
+
+    b.socket.emit('close');
+    should(bindings.setScanParameters.args[2]).deepEqual([0x0060, 0x0030]);
+  });
+
+  it('should share a link until its last client lets go', () => {
+    const a = attach();
+    const b = attach();
+
+    broker.onCall(a, 'connect', [UUID, undefined]);
+    broker.onCall(b, 'connect', [UUID, undefined]);
+    assert.calledOnce(bindings.connect);
+
+    bindings.emit('connect', UUID, null);
+    should(sent(a, 'connect')).deepEqual([[UUID, null]]);
+    should(sent(b, 'connect')).deepEqual([[UUID, null]]);
+
+    broker.onCall(a, 'disconnect', [UUID]);
+    should(sent(a, 'disconnect')).deepEqual([[UUID, 0x16]]);
+    assert.notCalled(bindings.disconnect);
+
+    broker.onCall(b, 'disconnect', [UUID]);
+    assert.calledOnceWithExactly(bindings.disconnect, UUID);
+  });
+
+  it('should answer each call to the client that made it', () => {
+    const a = attach();
+    const b = attach();
+    broker.onCall(a, 'connect', [UUID]);
+    broker.onCall(b, 'connect', [UUID]);
+    bindings.emit('connect', UUID, null);
+
+    broker.onCall(b, 'read', [UUID, '180f', '2a19']);
+    broker.onCall(a, 'read', [UUID, '180f', '2a19']);
+    assert.calledTwice(bindings.read);
+
+    bindings.emit('read', UUID, '180f', '2a19', Buffer.from('01', 'hex'), false);
+    bindings.emit('read', UUID, '180f', '2a19', Buffer.from('02', 'hex'), false);
+
+    should(sent(b, 'read')).deepEqual([[UUID, '180f', '2a19', Buffer.from('01', 'hex'), false]]);
+    should(sent(a, 'read')).deepEqual([[UUID, '180f', '2a19', Buffer.from('02', 'hex'), false]]);
+  });
+
+  it('should keep notifications on while any sharer wants them', () => {
+    const a = attach();
+    const b = attach();
+    broker.onCall(a, 'connect', [UUID]);
+    broker.onCall(b, 'connect', [UUID]);
+    bindings.emit('connect', UUID, null);
+
+    broker.onCall(a, 'notify', [UUID, '180f', '2a19', true]);
+    broker.onCall(b, 'notify', [UUID, '180f', '2a19', true]);
+    assert.calledOnceWithExactly(bindings.notify, UUID, '180f', '2a19', true);
+    should(sent(b, 'notify')).deepEqual([[UUID, '180f', '2a19', true]]);
+
+    bindings.emit('notify', UUID, '180f', '2a19', true);
+    should(sent(a, 'notify')).deepEqual([[UUID, '180f', '2a19', true]]);
+
+    broker.onCall(a, 'notify', [UUID, '180f', '2a19', false]);
+    bindings.emit('read', UUID, '180f', '2a19', Buffer.from('03', 'hex'), true);
+    should(sent(a, 'read')).deepEqual([]);
+    should(sent(b, 'read').length).equal(1);
+
+    b.socket.emit('close');
+    assert.calledWithExactly(bindings.notify.secondCall, UUID, '180f', '2a19', false);
+  });
+
+  it('should cancel an attempt when its client goes away', () => {
+    const a = attach();
+    broker.onCall(a, 'connect', [UUID]);
+
+    a.socket.emit('close');
+
+    assert.calledOnceWithExactly(bindings.cancelConnect, UUID);
+    should(broker._peripherals.size).equal(0);
+  });
+});
@@ -0,0 +1,137 @@
+const should = require('should');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const Btsnoop = require('../../../lib/hci-socket/btsnoop');
+
+const readRecords = (file) => {
+  const data = fs.readFileSync(file);
+  const records = [];
+  let offset = 16;
+
+  while (offset < data.length) {
+    const length = data.readUInt32BE(offset + 4);
+    records.push({
+      flags: data.readUInt32BE(offset + 8),
+      packet: data.slice(offset + 24, offset + 24 + length)
+    });
+    offset += 24 + length;
+  }
+
+  return records;
+};
+
+describe('hci-socket btsnoop', () => {
+  let dir;
+  let file;
+
+  beforeEach(() => {
+    dir = fs.mkdtempSync(path.join(os.tmpdir(), 'noble-btsnoop-'));
+    file = path.join(dir, 'hci.btsnoop');
+  });
+
+  afterEach(() => {
+    fs.rmSync(dir, { recursive: true, force: true });
+  });
+
+  it('writes the btsnoop header for the H4 datalink', () => {
+    const btsnoop = new Btsnoop(file);
+
+    btsnoop.open();
+    btsnoop.close();
+
+    const data = fs.readFileSync(file);
+    should(data.slice(0, 8).toString('latin1')).equal('btsnoop\0');
+    should(data.readUInt32BE(8)).equal(1);
+    should(data.readUInt32BE(12)).equal(1002);
+    should(data.length).equal(16);
+  });
+
+  it('records direction and packet kind flags', () => {
+    const btsnoop = new Btsnoop(file);
+
+    btsnoop.open();
+    btsnoop.write(Buffer.from('01030c00', 'hex'), false);
+    btsnoop.write(Buffer.from('040e0401030c00', 'hex'), true);
+    btsnoop.write(Buffer.from('0240000500010004000b', 'hex'), false);
+    btsnoop.write(Buffer.from('0240200500010004001b', 'hex'), true);
+    btsnoop.close();
+
+    const records = readRecords(file);
+    should(records.map(r => r.flags)).deepEqual([0x02, 0x03, 0x00, 0x01]);
+    should(records[1].packet).deepEqual(Buffer.from('040e0401030c00', 'hex'));
+  });
+
+  it('ignores writes before open and after close', () => {
+    const btsnoop = new Btsnoop(file);
+
+    btsnoop.write(Buffer.from('01030c00', 'hex'), false);
+    btsnoop.open();
+    btsnoop.close();
+    btsnoop.write(Buffer.from('01030c00', 'hex'), false);
+
+    should(readRecords(file)).have.length(0);
+  });
+
+  it('keeps only the most recent records in ring buffer mode', () => {
+    // Each record is 24 + 4 bytes, so the ring holds two of them.
+    const btsnoop = new Btsnoop(file, 60);
+
+    btsnoop.open();
+    for (let i = 0; i < 5; i++) {
+      btsnoop.write(Buffer.from([0x01, i, 0x0c, 0x00]), false);
+    }
+    btsnoop.close();
+
+    should(readRecords(file).map(r => r.packet[1])).deepEqual([3, 4]);
+  });
+
+  it('rewrites the ring on every flush', () => {
+    const btsnoop = new Btsnoop(file, 60);
+
+    btsnoop.open();
+    btsnoop.write(Buffer.from('01010c00', 'hex'), false);
+    btsnoop.flush();
+    btsnoop.write(Buffer.from('01020c00', 'hex'), false);
+    btsnoop.write(Buffer.from('01030c00', 'hex'), false);
+    btsnoop.flush();
+
+    should(readRecords(file).map(r => r.packet[1])).deepEqual([2, 3]);
+
+    btsnoop.close();
+  });
+
+  it('parses its own captures back into records', () => {
+    const btsnoop = new Btsnoop(file);
+
+    btsnoop.open();
+    btsnoop.write(Buffer.from('01030c00', 'hex'), false);
+    btsnoop.write(Buffer.from('040e0401030c00', 'hex'), true);
+    btsnoop.close();
+
+    const records = Btsnoop.parse(fs.readFileSync(file));
+    should(records.map(r => [r.received, r.packet.toString('hex')])).deepEqual([
+      [false, '01030c00'],
+      [true, '040e0401030c00']
+    ]);
+    should(Math.abs(records[0].timestamp / 1000 - Date.now())).be.below(60000);
+  });
+
+  it('restores the packet type of unencapsulated HCI captures', () => {
+    const header = Btsnoop.header();
+    header.writeUInt32BE(1001, 12);
+    const record = Buffer.alloc(24 + 3);
+    record.writeUInt32BE(3, 0);
+    record.writeUInt32BE(3, 4);
+    record.writeUInt32BE(0x00, 8); // sent ACL data
+    Buffer.from('aabbcc', 'hex').copy(record, 24);
+
+    const records = Btsnoop.parse(Buffer.concat([header, record]));
+    should(records[0].packet.toString('hex')).equal('02aabbcc');
+  });
+
+  it('rejects files that are not btsnoop captures', () => {
+    should(() => Btsnoop.parse(Buffer.from('not a capture!!!!'))).throw('Not a btsnoop capture');
+  });
+});
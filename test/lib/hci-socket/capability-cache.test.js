@@ -0,0 +1,94 @@
+const should = require('should');
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const CapabilityCache = require('../../../lib/hci-socket/capability-cache');
+
+describe('hci-socket capability cache', () => {
+  const LOCAL_VERSION = Buffer.from([0x0b, 0x00, 0x00, 0x0b, 0xf1, 0x05, 0x00, 0x00]);
+  const ENTRY = {
+    key: 'a/01',
+    leFeatures: '2000000000000000',
+    aclBuffers: { length: 251, num: 8 },
+    maxDataLength: null,
+    clean: true
+  };
+
+  let directory;
+  let file;
+
+  beforeEach(() => {
+    directory = fs.mkdtempSync(path.join(os.tmpdir(), 'noble-capabilities-'));
+    file = path.join(directory, 'capabilities.json');
+  });
+
+  afterEach(() => {
+    fs.rmSync(directory, { recursive: true, force: true });
+  });
+
+  it('keys entries by address and firmware', () => {
+    should(CapabilityCache.key('00:00:5e:00:53:00', LOCAL_VERSION)).equal('00:00:5e:00:53:00/0b00000bf1050000');
+  });
+
+  it('remembers the entry each device used last across instances', () => {
+    new CapabilityCache(file).set(0, ENTRY);
+
+    const cache = new CapabilityCache(file);
+
+    should(cache.expected(0)).deepEqual(ENTRY);
+    should(cache.expected(1)).be.null();
+    should(cache.get('a/01')).deepEqual(ENTRY);
+    should(cache.get('a/02')).be.null();
+    should(fs.readdirSync(directory)).deepEqual(['capabilities.json']);
+  });
+
+  it('starts empty when the file is missing or unreadable', () => {
+    should(new CapabilityCache(file).expected(0)).be.null();
+
+    fs.writeFileSync(file, '{"format":');
+    const cache = new CapabilityCache(file);
+    should(cache.expected(0)).be.null();
+
+    cache.set(0, ENTRY);
+    should(new CapabilityCache(file).get('a/01')).deepEqual(ENTRY);
+  });
+
+  it('drops entries that do not hold what fast start cached', () => {
+    const entries = {
+      'a/01': ENTRY,
+      'a/02': { ...ENTRY, key: 'a/02', leFeatures: 'not hex' },
+      'a/03': { ...ENTRY, key: 'a/03', aclBuffers: { length: 0, num: 8 } },
+      'a/04': { ...ENTRY, key: 'a/04', maxDataLength: { txOctets: 251 } },
+      'a/05': { ...ENTRY, key: 'a/01' }
+    };
+    fs.writeFileSync(file, JSON.stringify({ format: 1, entries, devices: { 0: 'a/02', 1: 'constructor' } }));
+
+    const cache = new CapabilityCache(file);
+
+    should(cache.get('a/01')).deepEqual(ENTRY);
+    ['a/02', 'a/03', 'a/04', 'a/05', 'constructor'].forEach(key => should(cache.get(key)).be.null());
+    should(cache.expected(0)).be.null();
+    should(cache.expected(1)).be.null();
+  });
+
+  it('keeps its file private to the user by default', () => {
+    const cacheHome = process.env.XDG_CACHE_HOME;
+    process.env.XDG_CACHE_HOME = directory;
+    try {
+      new CapabilityCache().set(0, ENTRY);
+    } finally {
+      if (cacheHome === undefined) {
+        delete process.env.XDG_CACHE_HOME;
+      } else {
+        process.env.XDG_CACHE_HOME = cacheHome;
+      }
+    }
+
+    const cached = path.join(directory, 'noble', 'hci-capabilities.json');
+    should(new CapabilityCache(cached).expected(0)).deepEqual(ENTRY);
+    should(fs.statSync(cached).mode & 0o777).equal(0o600);
+    should(fs.statSync(path.dirname(cached)).mode & 0o777).equal(0o700);
+  });
+});
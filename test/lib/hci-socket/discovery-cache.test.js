@@ -0,0 +1,75 @@
+const should = require('should');
+const sinon = require('sinon');
+
+const { assert } = sinon;
+
+const DiscoveryCache = require('../../../lib/hci-socket/discovery-cache');
+
+describe('hci-socket discovery cache', () => {
+  let now;
+  let onEvict;
+
+  const clock = () => now;
+
+  beforeEach(() => {
+    now = 0;
+    onEvict = sinon.spy();
+  });
+
+  it('uses the defaults unless given a positive size and ttl', () => {
+    const cache = new DiscoveryCache({ maxSize: 0, ttl: -1 });
+
+    should(cache.maxSize).equal(4096);
+    should(cache.ttl).equal(300000);
+    should(cache.size).equal(0);
+  });
+
+  it('evicts the least recently seen entry when full', () => {
+    const cache = new DiscoveryCache({ maxSize: 2, now: clock }, onEvict);
+
+    cache.set(1, 'a');
+    cache.set(2, 'b');
+    cache.set(1, 'a2'); // seen again, so 2 is now the oldest
+    cache.set(3, 'c');
+
+    should(cache.size).equal(2);
+    should(cache.get(1)).equal('a2');
+    should(cache.get(2)).be.undefined();
+    should(cache.get(3)).equal('c');
+    should(cache.evictions).equal(1);
+    assert.calledOnceWithExactly(onEvict, 2, 'b', DiscoveryCache.REASON_SIZE);
+  });
+
+  it('drops entries idle for longer than the ttl', () => {
+    const cache = new DiscoveryCache({ ttl: 1000, now: clock }, onEvict);
+
+    cache.set(1, 'a');
+    now = 500;
+    cache.set(2, 'b');
+    now = 1000;
+
+    should(cache.get(1)).equal('a');
+
+    now = 1001;
+    should(cache.get(1)).be.undefined();
+    should(cache.get(2)).equal('b');
+    should(cache.size).equal(1);
+    should(cache.expirations).equal(1);
+    assert.calledOnceWithExactly(onEvict, 1, 'a', DiscoveryCache.REASON_TTL);
+
+    now = 1600;
+    cache.expire();
+    should(cache.size).equal(0);
+    should(cache.expirations).equal(2);
+  });
+
+  it('keeps entries forever with an infinite ttl', () => {
+    const cache = new DiscoveryCache({ ttl: Infinity, now: clock }, onEvict);
+
+    cache.set(1, 'a');
+    now = Number.MAX_SAFE_INTEGER;
+
+    should(cache.get(1)).equal('a');
+    assert.notCalled(onEvict);
+  });
+});
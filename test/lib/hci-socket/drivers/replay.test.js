@@ -0,0 +1,111 @@
+const should = require('should');
+
+const ReplaySocket = require('../../../../lib/hci-socket/drivers/replay');
+
+const sent = (hex, timestamp = 0) => ({ received: false, timestamp, packet: Buffer.from(hex, 'hex') });
+const received = (hex, timestamp = 0) => ({ received: true, timestamp, packet: Buffer.from(hex, 'hex') });
+
+const RESET = '01030c00';
+const RESET_COMPLETE = '040e0401030c00';
+const READ_BD_ADDR = '01091000';
+const READ_BD_ADDR_COMPLETE = '040e0a01091000112233445566';
+
+const play = (socket) => new Promise((resolve) => socket.once('end', resolve));
+
+describe('hci-socket replay driver', () => {
+  let socket;
+
+  beforeEach(() => {
+    socket = new ReplaySocket();
+  });
+
+  afterEach(() => {
+    socket.stop();
+  });
+
+  it('requires a capture', () => {
+    should(() => socket.bindRaw(0, {})).throw('The replay driver needs bindParams.replay.path');
+  });
+
+  it('is always up and ignores filters', () => {
+    should(socket.isDevUp()).be.true();
+    should(() => socket.setFilter(Buffer.alloc(14))).not.throw();
+  });
+
+  it('holds received packets until the host writes the recorded command', async () => {
+    const data = [];
+
+    socket.bindUser(0, { replay: { records: [sent(RESET), received(RESET_COMPLETE)] } });
+    socket.on('data', (packet) => data.push(packet.toString('hex')));
+    socket.start();
+
+    await new Promise(resolve => setImmediate(resolve));
+    should(data).deepEqual([]);
+
+    const done = play(socket);
+    socket.write(Buffer.from(RESET, 'hex'));
+    const stats = await done;
+
+    should(data).deepEqual([RESET_COMPLETE]);
+    should(stats).deepEqual({ received: 1, matched: 1, missed: 0, unexpected: 0 });
+  });
+
+  it('matches a write that arrived before playback reached it', async () => {
+    socket.bindRaw(0, {
+      replay: {
+        records: [sent(RESET), received(RESET_COMPLETE), sent(READ_BD_ADDR), received(READ_BD_ADDR_COMPLETE)]
+      }
+    });
+    socket.write(Buffer.from(RESET, 'hex'));
+    socket.write(Buffer.from(READ_BD_ADDR, 'hex'));
+
+    const done = play(socket);
+    socket.start();
+    const stats = await done;
+
+    should(stats).deepEqual({ received: 2, matched: 2, missed: 0, unexpected: 0 });
+  });
+
+  it('reports writes that differ from the recording', async () => {
+    const mismatches = [];
+
+    socket.bindRaw(0, {
+      replay: { records: [sent(RESET), received(RESET_COMPLETE), sent(READ_BD_ADDR)], stallTimeout: 5 }
+    });
+    socket.on('mismatch', (expected, actual) => mismatches.push([expected && expected.toString('hex'), actual && actual.toString('hex')]));
+    socket.write(Buffer.from('01010c00', 'hex'));
+    socket.write(Buffer.from(RESET, 'hex'));
+
+    const done = play(socket);
+    socket.start();
+    const stats = await done;
+
+    should(stats).deepEqual({ received: 1, matched: 1, missed: 1, unexpected: 1 });
+    should(mismatches).deepEqual([[null, '01010c00'], [READ_BD_ADDR, null]]);
+  });
+
+  it('keeps the recorded spacing with original timing', async () => {
+    socket.bindRaw(0, {
+      replay: { records: [received(RESET_COMPLETE, 0), received(RESET_COMPLETE, 40000)], timing: 'original', speed: 2 }
+    });
+
+    const started = Date.now();
+    const done = play(socket);
+    socket.start();
+    await done;
+
+    should(Date.now() - started).be.aboveOrEqual(18);
+  });
+
+  it('does not emit after stop', async () => {
+    const data = [];
+
+    socket.bindRaw(0, { replay: { records: [received(RESET_COMPLETE)] } });
+    socket.on('data', (packet) => data.push(packet));
+    socket.start();
+    socket.stop();
+
+    await new Promise(resolve => setImmediate(resolve));
+    should(data).have.length(0);
+  });
+});
@@ -0,0 +1,95 @@
+const should = require('should');
+
+const VirtualGatt = require('../../../../lib/hci-socket/drivers/virtual-gatt');
+
+const SERVICES = [
+  {
+    uuid: '180f',
+    characteristics: [
+      { uuid: '2a19', properties: ['read', 'notify'], value: Buffer.from([0x63]) }
+    ]
+  },
+  {
+    uuid: '6e400001b5a3f393e0a9e50e24dcca9e',
+    characteristics: [
+      { uuid: '6e400002b5a3f393e0a9e50e24dcca9e', properties: ['writeWithoutResponse'] },
+      {
+        uuid: '6e400003b5a3f393e0a9e50e24dcca9e',
+        properties: ['read', 'write'],
+        value: Buffer.alloc(40, 0x01),
+        descriptors: [{ uuid: '2901', value: Buffer.from('rx') }]
+      }
+    ]
+  }
+];
+
+const request = (gatt, hex) => {
+  const response = gatt.handleRequest(Buffer.from(hex, 'hex'));
+  return response && response.toString('hex');
+};
+
+describe('hci-socket virtual gatt', () => {
+  let gatt;
+
+  beforeEach(() => {
+    gatt = new VirtualGatt(SERVICES);
+  });
+
+  it('exchanges mtu', () => {
+    should(request(gatt, '020002')).equal('03f700');
+    should(gatt._mtu).equal(247);
+  });
+
+  it('discovers primary services one uuid size at a time', () => {
+    should(request(gatt, '100100ffff0028')).equal('1106' + '010004000f18');
+    should(request(gatt, '100500ffff0028')).equal('1114' + '05000a00' + '9ecadc240ee5a9e093f3a3b50100406e');
+    should(request(gatt, '100b00ffff0028')).equal('01100b000a');
+  });
+
+  it('discovers characteristics with their value handles', () => {
+    should(request(gatt, '08010004000328')).equal('0907' + '0200120300192a');
+  });
+
+  it('discovers descriptors', () => {
+    should(request(gatt, '040400040000')).equal('0501' + '04000229');
+    should(request(gatt, '040a000a00')).equal('0501' + '0a000129');
+  });
+
+  it('reads long values with read blob', () => {
+    gatt.handleRequest(Buffer.from('021700', 'hex'));
+
+    should(request(gatt, '0a0900')).equal('0b' + '01'.repeat(22));
+    should(request(gatt, '0c09001600')).equal('0d' + '01'.repeat(18));
+    should(request(gatt, '0c09002900')).equal('010c090007');
+  });
+
+  it('writes values and enables notifications through the cccd', () => {
+    should(request(gatt, '120900aabb')).equal('13');
+    should(request(gatt, '0a0900')).equal('0baabb');
+
+    should(gatt.subscriptions()).be.empty();
+    should(request(gatt, '1204000100')).equal('13');
+    should(gatt.subscriptions().map(attribute => attribute.handle)).deepEqual([3]);
+    should(gatt.notification(3).toString('hex')).equal('1b030063');
+  });
+
+  it('answers write commands with nothing, and enforces permissions', () => {
+    should(request(gatt, '520700ff')).be.null();
+    should(request(gatt, '520300ff')).be.null();
+    should(request(gatt, '120300ff')).equal('01120300' + '03');
+    should(request(gatt, '0a0700')).equal('010a0700' + '02');
+    should(request(gatt, '0a3000')).equal('010a3000' + '01');
+  });
+
+  it('applies queued writes on execute', () => {
+    should(request(gatt, '1609000000aaaa')).equal('1709000000aaaa');
+    should(request(gatt, '1609000200bbbb')).equal('1709000200bbbb');
+    should(request(gatt, '1801')).equal('19');
+    should(request(gatt, '0a0900').slice(0, 12)).equal('0baaaabbbb01');
+  });
+
+  it('rejects unsupported requests but never answers commands', () => {
+    should(request(gatt, '20')).equal('0120000006');
+    should(request(gatt, 'd2')).be.null();
+  });
+});
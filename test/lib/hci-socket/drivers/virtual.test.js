@@ -0,0 +1,292 @@
+const should = require('should');
+const sinon = require('sinon');
+
+const VirtualSocket = require('../../../../lib/hci-socket/drivers/virtual');
+
+const ADDRESS = 'c0:00:00:00:00:01';
+
+const SERVICES = [{
+  uuid: '180f',
+  characteristics: [{ uuid: '2a19', properties: ['read', 'notify'], value: Buffer.from([0x63]) }]
+}];
+
+const tick = () => new Promise(resolve => setImmediate(resolve));
+const wait = (ms) => new Promise(resolve => setTimeout(resolve, ms));
+
+const command = (opcode, params = '') => {
+  const data = Buffer.from(params, 'hex');
+  const packet = Buffer.alloc(4 + data.length);
+  packet.writeUInt8(0x01, 0);
+  packet.writeUInt16LE(opcode, 1);
+  packet.writeUInt8(data.length, 3);
+  data.copy(packet, 4);
+  return packet;
+};
+
+const attRequest = (handle, pdu) => {
+  const packet = Buffer.alloc(9 + pdu.length);
+  packet.writeUInt8(0x02, 0);
+  packet.writeUInt16LE(handle | (0x02 << 12), 1);
+  packet.writeUInt16LE(4 + pdu.length, 3);
+  packet.writeUInt16LE(pdu.length, 5);
+  packet.writeUInt16LE(0x0004, 7);
+  pdu.copy(packet, 9);
+  return packet;
+};
+
+// LE Create Connection to ADDRESS with its random address type
+const CREATE_CONN = '6000300000010100000000c0000600120000002a0004000600';
+
+// LE Periodic Advertising Create Sync with ADDRESS on SID 2, with a 1 s sync timeout
+const CREATE_SYNC = '0002010100000000c00000640000';
+
+describe('hci-socket virtual driver', () => {
+  let socket;
+  let packets;
+
+  const connect = async () => {
+    socket.write(command(0x200d, CREATE_CONN));
+    await wait(30);
+    const complete = packets.find(p => p[1] === 0x3e && p[3] === 0x01);
+    return complete.readUInt16LE(5);
+  };
+
+  beforeEach(() => {
+    socket = new VirtualSocket();
+    packets = [];
+    socket.on('data', (packet) => packets.push(packet));
+  });
+
+  afterEach(() => {
+    socket.stop();
+  });
+
+  it('is always up and ignores filters', () => {
+    should(socket.isDevUp()).be.true();
+    should(() => socket.setFilter(Buffer.alloc(14))).not.throw();
+  });
+
+  it('answers commands asynchronously with command complete', async () => {
+    socket.bindUser(0, { virtual: { address: '11:22:33:44:55:66', aclLength: 27, aclNum: 4 } });
+    socket.start();
+
+    socket.write(command(0x1009));
+    socket.write(command(0x2002));
+    should(packets).be.empty();
+
+    await tick();
+    should(packets.map(p => p.toString('hex'))).deepEqual([
+      '040e0a01091000665544332211',
+      '040e07010220001b0004'
+    ]);
+  });
+
+  it('reports the configured le features', async () => {
+    socket.bindRaw(0, { virtual: { extended: true, codedPhy: true, dataLengthExtension: false } });
+    socket.start();
+
+    socket.write(command(0x2003));
+    await tick();
+
+    const features = packets[0].slice(7);
+    should(features[0] & (1 << 5)).equal(0);
+    should(features[1] & (1 << 3)).not.equal(0);
+    should(features[1] & (1 << 4)).not.equal(0);
+  });
+
+  it('rejects unknown commands', async () => {
+    socket.bindRaw(0, {});
+    socket.start();
+
+    socket.write(command(0xfc01));
+    await tick();
+
+    should(packets[0].toString('hex')).equal('040e040101fc01');
+  });
+
+  it('reports advertisers while scanning, once with duplicate filtering', async () => {
+    socket.bindRaw(0, { virtual: { advertisers: [{ address: ADDRESS, localName: 'test', interval: 20 }] } });
+    socket.start();
+
+    socket.write(command(0x200c, '0101'));
+    await wait(100);
+    socket.write(command(0x200c, '0000'));
+    await tick();
+
+    const reports = packets.filter(p => p[1] === 0x3e && p[3] === 0x02);
+    should(reports).have.length(1);
+    should(reports[0][5]).equal(0x00); // ADV_IND
+    should(reports[0][6]).equal(0x01); // random address
+    should(reports[0].slice(7, 13).toString('hex')).equal('0100000000c0');
+
+    packets = [];
+    socket.write(command(0x200c, '0100'));
+    await wait(100);
+    socket.write(command(0x200c, '0000'));
+    await tick();
+
+    should(packets.filter(p => p[1] === 0x3e && p[3] === 0x02).length).be.above(2);
+  });
+
+  it('reports only advertisers on the filter accept list with that filter policy', async () => {
+    socket.bindRaw(0, {
+      virtual: {
+        acceptListSize: 1,
+        advertisers: [{ address: ADDRESS, interval: 20 }, { address: 'c0:00:00:00:00:02', interval: 20 }]
+      }
+    });
+    socket.start();
+
+    socket.write(command(0x200f));
+    socket.write(command(0x2011, '010100000000c0'));
+    socket.write(command(0x2011, '010200000000c0'));
+    socket.write(command(0x200b, '00120012000001'));
+    socket.write(command(0x200c, '0101'));
+    socket.write(command(0x2010));
+    await wait(100);
+    socket.write(command(0x200c, '0000'));
+    await tick();
+
+    const completes = packets.filter(p => p[1] === 0x0e).map(p => p.toString('hex'));
+    should(completes.slice(0, 3)).deepEqual(['040e05010f200001', '040e0401112000', '040e0401112007']);
+    should(completes[5]).equal('040e040110200c'); // not while scanning with it
+
+    const reports = packets.filter(p => p[1] === 0x3e && p[3] === 0x02);
+    should(reports).have.length(1);
+    should(reports[0].slice(7, 13).toString('hex')).equal('0100000000c0');
+  });
+
+  it('reports advertisers again every period with the duplicate filter reset', async () => {
+    socket.bindRaw(0, { virtual: { extended: true, advertisers: [{ address: ADDRESS, interval: 20 }] } });
+    socket.start();
+
+    const now = Date.now();
+    const clock = sinon.stub(Date, 'now').returns(now);
+    try {
+      socket.write(command(0x2042, '01027f000100'));
+      await tick();
+      socket._scanTick();
+      clock.returns(now + 640);
+      socket._scanTick();
+      clock.returns(now + 1280);
+      socket._scanTick();
+    } finally {
+      clock.restore();
+    }
+    await tick();
+
+    should(packets.filter(p => p[1] === 0x3e && p[3] === 0x0d)).have.length(2);
+  });
+
+  it('chains long extended advertising data', async () => {
+    socket.bindRaw(0, { virtual: { advertisers: [{ address: ADDRESS, advertisement: Buffer.alloc(300, 0xaa) }] } });
+    socket.start();
+
+    socket.write(command(0x2042, '010100000000'));
+    await wait(50);
+
+    const reports = packets.filter(p => p[1] === 0x3e && p[3] === 0x0d);
+    should(reports).have.length(2);
+    should(reports[0].readUInt16LE(5) & 0x60).equal(0x20);
+    should(reports[0][28]).equal(229);
+    should(reports[1].readUInt16LE(5) & 0x60).equal(0x00);
+    should(reports[1][28]).equal(71);
+  });
+
+  it('syncs to periodic advertising and reports it without scanning', async () => {
+    socket.bindRaw(0, { virtual: { advertisers: [{ address: ADDRESS, interval: 20, sid: 2, periodic: { interval: 20, data: 'aabb' } }] } });
+    socket.start();
+
+    socket.write(command(0x2044, CREATE_SYNC));
+    socket.write(command(0x2042, '010000000000'));
+    await wait(30);
+    socket.write(command(0x2042, '000000000000'));
+    packets = [];
+    await wait(70);
+
+    const reports = packets.filter(p => p[1] === 0x3e && p[3] === 0x0f);
+    should(reports.length).be.above(1);
+    should(reports[0].slice(11).toString('hex')).equal('aabb');
+
+    socket.stopPeriodicAdvertising(ADDRESS);
+    await tick();
+    should(packets.filter(p => p[1] === 0x3e && p[3] === 0x10)).have.length(1);
+  });
+
+  it('connects to connectable advertisers', async () => {
+    socket.bindRaw(0, { virtual: { advertisers: [{ address: ADDRESS }] } });
+    socket.start();
+
+    const handle = await connect();
+
+    should(packets[0].toString('hex')).equal('040f0400010d20');
+    should(handle).equal(0x0040);
+  });
+
+  it('cancels connections to unknown peers', async () => {
+    socket.bindRaw(0, {});
+    socket.start();
+
+    socket.write(command(0x200d, CREATE_CONN));
+    await wait(30);
+    socket.write(command(0x200e));
+    await tick();
+
+    should(packets.map(p => p.slice(0, 5).toString('hex'))).deepEqual([
+      '040f040001',
+      '040e04010e',
+      '043e140102'
+    ]);
+  });
+
+  it('serves the gatt database and paces acl data by connection events', async () => {
+    socket.bindRaw(0, {
+      virtual: { advertisers: [{ address: ADDRESS, services: SERVICES }], connectionInterval: 50 }
+    });
+    socket.start();
+
+    const handle = await connect();
+    packets = [];
+
+    socket.write(attRequest(handle, Buffer.from('0a0300', 'hex'))); // read 0x0003
+    await tick();
+    should(packets).be.empty();
+
+    await wait(60);
+    should(packets.map(p => p.toString('hex'))).deepEqual([
+      '0413050140000100',
+      '0240200600020004000b63'
+    ]);
+  });
+
+  it('pushes notifications to subscribed clients', async () => {
+    socket.bindRaw(0, { virtual: { advertisers: [{ address: ADDRESS, services: SERVICES }], connectionInterval: 5 } });
+    socket.start();
+
+    const handle = await connect();
+
+    should(socket.notify(ADDRESS, '2a19', Buffer.from([0x01]))).be.false();
+
+    socket.write(attRequest(handle, Buffer.from('1204000100', 'hex'))); // enable notifications
+    should(socket.notify(ADDRESS, '2a19', Buffer.from([0x01]))).be.true();
+    await wait(30);
+
+    should(packets.map(p => p.toString('hex'))).containEql('02402005000100040013');
+    should(packets.map(p => p.toString('hex'))).containEql('0240200800040004001b030001');
+  });
+
+  it('disconnects and stops pacing the connection', async () => {
+    socket.bindRaw(0, { virtual: { advertisers: [{ address: ADDRESS }] } });
+    socket.start();
+
+    const handle = await connect();
+    socket.write(command(0x0406, '400013'));
+    await tick();
+
+    should(packets.slice(-2).map(p => p.toString('hex'))).deepEqual([
+      '040f0400010604',
+      '04050400400016'
+    ]);
+    should(socket._connections.has(handle)).be.false();
+  });
+});
@@ -16,15 +16,18 @@ describe('hci-socket gap', () => {
     should(gap._hci).equal(hci);
     should(gap._scanState).equal(null);
     should(gap._scanFilterDuplicates).equal(null);
-    should(gap._discoveries).deepEqual({});
+    should(gap._discoveries.size).equal(0);
 
-    assert.callCount(hci.on, 6);
+    assert.callCount(hci.on, 9);
     assert.calledWithMatch(hci.on, 'error', sinon.match.func);
     assert.calledWithMatch(hci.on, 'leScanParametersSet', sinon.match.func);
     assert.calledWithMatch(hci.on, 'leScanEnableSet', sinon.match.func);
     assert.calledWithMatch(hci.on, 'leAdvertisingReport', sinon.match.func);
     assert.calledWithMatch(hci.on, 'leScanEnableSetCmd', sinon.match.func);
     assert.calledWithMatch(hci.on, 'leExtendedAdvertisingReport', sinon.match.func);
+    assert.calledWithMatch(hci.on, 'lePeriodicSyncEstablished', sinon.match.func);
+    assert.calledWithMatch(hci.on, 'lePeriodicAdvertisingReport', sinon.match.func);
+    assert.calledWithMatch(hci.on, 'lePeriodicSyncLost', sinon.match.func);
   });
 
   it('setScanParameters', () => {
@@ -58,10 +61,81 @@ describe('hci-socket gap', () => {
 
     assert.callCount(hci.setScanEnabled, 2);
     assert.calledWithExactly(hci.setScanEnabled, false, true);
-    assert.calledWithExactly(hci.setScanEnabled, true, false);
+    assert.calledWithExactly(hci.setScanEnabled, true, false, 0);
     assert.calledOnceWithExactly(hci.setScanParameters);
   });
 
+  it('startScanning - keeps the scan parameters set before', () => {
+    const hci = {
+      on: sinon.spy(),
+      setScanEnabled: sinon.spy(),
+      setScanParameters: sinon.spy()
+    };
+
+    const gap = new Gap(hci);
+    gap.setScanParameters(0x0060, 0x0030);
+    gap.startScanning(true);
+
+    assert.calledTwice(hci.setScanParameters);
+    assert.calledWithExactly(hci.setScanParameters.secondCall, 0x0060, 0x0030);
+  });
+
+  describe('with a duplicates refresh', () => {
+    let clock;
+    let hci;
+    let gap;
+
+    beforeEach(() => {
+      clock = sinon.useFakeTimers();
+      hci = {
+        on: sinon.spy(),
+        setScanEnabled: sinon.spy(),
+        setScanParameters: sinon.spy(),
+        canRefreshScanDuplicates: sinon.stub().returns(false),
+        refreshScanDuplicates: sinon.spy()
+      };
+      gap = new Gap(hci, { duplicatesRefresh: 500 });
+    });
+
+    afterEach(() => {
+      clock.restore();
+    });
+
+    it('should enable scanning again to empty the duplicate filter', () => {
+      gap.startScanning(false);
+      gap._scanState = 'started';
+      hci.setScanEnabled.resetHistory();
+
+      clock.tick(500);
+      assert.calledOnce(hci.refreshScanDuplicates);
+      assert.notCalled(hci.setScanEnabled);
+
+      gap.stopScanning();
+      clock.tick(1000);
+      assert.calledOnce(hci.refreshScanDuplicates);
+    });
+
+    it('should leave the refresh to a controller that resets its filter periodically', () => {
+      hci.canRefreshScanDuplicates.returns(true);
+
+      gap.startScanning(false);
+      gap._scanState = 'started';
+
+      assert.calledWithExactly(hci.setScanEnabled.lastCall, true, true, 500);
+      clock.tick(1000);
+      assert.calledTwice(hci.setScanEnabled);
+    });
+
+    it('should not refresh a scan that allows duplicates', () => {
+      gap.startScanning(true);
+      gap._scanState = 'started';
+
+      assert.calledWithExactly(hci.setScanEnabled.lastCall, true, false, 0);
+      clock.tick(1000);
+      assert.calledTwice(hci.setScanEnabled);
+    });
+  });
+
   it('stopScanning', () => {
     const hci = {
       on: sinon.spy(),
@@ -324,7 +398,7 @@ describe('hci-socket gap', () => {
 
       const status = 'status';
       const type = 0x04;
-      const address = 'a:d:d:r:e:s:s';
+      const address = 0x112233445566;
       const addressType = 'addressType';
       const eir = [];
       const rssi = 'rssi';
@@ -336,7 +410,8 @@ describe('hci-socket gap', () => {
       gap.onHciLeAdvertisingReport(status, type, address, addressType, eir, rssi);
 
       const expectedDiscovery = {
-        address,
+        address: '11:22:33:44:55:66',
+        id: '112233445566',
         addressType,
         connectable: true,
         advertisement: {
@@ -349,11 +424,12 @@ describe('hci-socket gap', () => {
         },
         rssi,
         count: 1,
-        hasScanResponse: true
+        hasScanResponse: true,
+        eirs: { [type]: Buffer.from(eir) }
       };
-      should(gap._discoveries[address]).deepEqual(expectedDiscovery);
+      should(gap._discoveries.get(address)).deepEqual(expectedDiscovery);
 
-      assert.calledOnceWithExactly(discoverCallback, status, address, addressType, expectedDiscovery.connectable, expectedDiscovery.advertisement, rssi, false);
+      assert.calledOnceWithExactly(discoverCallback, status, '11:22:33:44:55:66', addressType, expectedDiscovery.connectable, expectedDiscovery.advertisement, rssi, false, '112233445566', true);
     });
 
     it('type === 0x04 / no eir / previously discovered', () => {
@@ -363,7 +439,7 @@ describe('hci-socket gap', () => {
 
       const status = 'status';
       const type = 0x04;
-      const address = 'a:d:d:r:e:s:s';
+      const address = 0x112233445566;
       const addressType = 'addressType';
       const eir = [];
       const rssi = 'rssi';
@@ -383,22 +459,24 @@ describe('hci-socket gap', () => {
       const connectable = false;
 
       const gap = new Gap(hci);
-      gap._discoveries[address] = { advertisement, count, hasScanResponse, connectable };
+      gap._discoveries.set(address, { address: '11:22:33:44:55:66', id: '112233445566', advertisement, count, hasScanResponse, connectable, eirs: {} });
       gap.on('discover', discoverCallback);
       gap.onHciLeAdvertisingReport(status, type, address, addressType, eir, rssi);
 
       const expectedDiscovery = {
-        address,
+        address: '11:22:33:44:55:66',
+        id: '112233445566',
         addressType,
         connectable,
         advertisement,
         rssi,
         count: count + 1,
-        hasScanResponse
+        hasScanResponse,
+        eirs: { [type]: Buffer.from(eir) }
       };
-      should(gap._discoveries[address]).deepEqual(expectedDiscovery);
+      should(gap._discoveries.get(address)).deepEqual(expectedDiscovery);
 
-      assert.calledOnceWithExactly(discoverCallback, status, address, addressType, expectedDiscovery.connectable, expectedDiscovery.advertisement, rssi, false);
+      assert.calledOnceWithExactly(discoverCallback, status, '11:22:33:44:55:66', addressType, expectedDiscovery.connectable, expectedDiscovery.advertisement, rssi, false, '112233445566', true);
     });
 
     it('type === 0x06 / scannable', () => {
@@ -408,7 +486,7 @@ describe('hci-socket gap', () => {
 
       const status = 'status';
       const type = 0x06;
-      const address = 'a:d:d:r:e:s:s';
+      const address = 0x112233445566;
       const addressType = 'addressType';
       const eir = [];
       const rssi = 'rssi';
@@ -428,22 +506,24 @@ describe('hci-socket gap', () => {
       const connectable = false;
 
       const gap = new Gap(hci);
-      gap._discoveries[address] = { advertisement, count, hasScanResponse, connectable };
+      gap._discoveries.set(address, { address: '11:22:33:44:55:66', id: '112233445566', advertisement, count, hasScanResponse, connectable, eirs: {} });
       gap.on('discover', discoverCallback);
       gap.onHciLeAdvertisingReport(status, type, address, addressType, eir, rssi);
 
       const expectedDiscovery = {
-        address,
+        address: '11:22:33:44:55:66',
+        id: '112233445566',
         addressType,
         connectable: true,
         advertisement,
         rssi,
         count: count + 1,
-        hasScanResponse
+        hasScanResponse,
+        eirs: { [type]: Buffer.from(eir) }
       };
-      should(gap._discoveries[address]).deepEqual(expectedDiscovery);
+      should(gap._discoveries.get(address)).deepEqual(expectedDiscovery);
 
-      assert.calledOnceWithExactly(discoverCallback, status, address, addressType, expectedDiscovery.connectable, expectedDiscovery.advertisement, rssi, true);
+      assert.calledOnceWithExactly(discoverCallback, status, '11:22:33:44:55:66', addressType, expectedDiscovery.connectable, expectedDiscovery.advertisement, rssi, true, '112233445566', true);
     });
 
     it('type !== 0x04 / no eir', () => {
@@ -453,7 +533,7 @@ describe('hci-socket gap', () => {
 
       const status = 'status';
       const type = 0x01;
-      const address = 'a:d:d:r:e:s:s';
+      const address = 0x112233445566;
       const addressType = 'addressType';
       const eir = [];
       const rssi = 'rssi';
@@ -465,7 +545,8 @@ describe('hci-socket gap', () => {
       gap.onHciLeAdvertisingReport(status, type, address, addressType, eir, rssi);
 
       const expectedDiscovery = {
-        address,
+        address: '11:22:33:44:55:66',
+        id: '112233445566',
         addressType,
         connectable: true,
         advertisement: {
@@ -478,9 +559,10 @@ describe('hci-socket gap', () => {
         },
         rssi,
         count: 1,
-        hasScanResponse: false
+        hasScanResponse: false,
+        eirs: { [type]: Buffer.from(eir) }
       };
-      should(gap._discoveries[address]).deepEqual(expectedDiscovery);
+      should(gap._discoveries.get(address)).deepEqual(expectedDiscovery);
 
       assert.notCalled(discoverCallback);
     });
@@ -492,7 +574,7 @@ describe('hci-socket gap', () => {
 
       const status = 'status';
       const type = 0x01;
-      const address = 'a:d:d:r:e:s:s';
+      const address = 0x112233445566;
       const addressType = 'addressType';
       const eir = Buffer.from([0x00, 0x00]);
       const rssi = 'rssi';
@@ -504,7 +586,8 @@ describe('hci-socket gap', () => {
       gap.onHciLeAdvertisingReport(status, type, address, addressType, eir, rssi);
 
       const expectedDiscovery = {
-        address,
+        address: '11:22:33:44:55:66',
+        id: '112233445566',
         addressType,
         connectable: true,
         advertisement: {
@@ -517,9 +600,10 @@ describe('hci-socket gap', () => {
         },
         rssi,
         count: 1,
-        hasScanResponse: false
+        hasScanResponse: false,
+        eirs: { [type]: Buffer.from(eir) }
       };
-      should(gap._discoveries[address]).deepEqual(expectedDiscovery);
+      should(gap._discoveries.get(address)).deepEqual(expectedDiscovery);
 
       assert.notCalled(discoverCallback);
     });
@@ -531,7 +615,7 @@ describe('hci-socket gap', () => {
 
       const status = 'status';
       const type = 0x01;
-      const address = 'a:d:d:r:e:s:s';
+      const address = 0x112233445566;
       const addressType = 'addressType';
       const eir = Buffer.from([0x03, 0x01, 0x02]);
       const rssi = 'rssi';
@@ -543,7 +627,8 @@ describe('hci-socket gap', () => {
       gap.onHciLeAdvertisingReport(status, type, address, addressType, eir, rssi);
 
       const expectedDiscovery = {
-        address,
+        address: '11:22:33:44:55:66',
+        id: '112233445566',
         addressType,
         connectable: true,
         advertisement: {
@@ -556,9 +641,10 @@ describe('hci-socket gap', () => {
         },
         rssi,
         count: 1,
-        hasScanResponse: false
+        hasScanResponse: false,
+        eirs: { [type]: Buffer.from(eir) }
       };
-      should(gap._discoveries[address]).deepEqual(expectedDiscovery);
+      should(gap._discoveries.get(address)).deepEqual(expectedDiscovery);
 
       assert.notCalled(discoverCallback);
     });
@@ -571,7 +657,7 @@ describe('hci-socket gap', () => {
 
         const status = 'status';
         const type = 0x01;
-        const address = 'a:d:d:r:e:s:s';
+        const address = 0x112233445566;
         const addressType = 'addressType';
         const rssi = 'rssi';
 
@@ -588,7 +674,8 @@ describe('hci-socket gap', () => {
         gap.onHciLeAdvertisingReport(status, type, address, addressType, eir, rssi);
 
         const expectedDiscovery = {
-          address,
+          address: '11:22:33:44:55:66',
+          id: '112233445566',
           addressType,
           connectable: true,
           advertisement: {
@@ -601,9 +688,10 @@ describe('hci-socket gap', () => {
           },
           rssi,
           count: 1,
-          hasScanResponse: false
+          hasScanResponse: false,
+          eirs: { [type]: Buffer.from(eir) }
         };
-        should(gap._discoveries[address]).deepEqual(expectedDiscovery);
+        should(gap._discoveries.get(address)).deepEqual(expectedDiscovery);
 
         assert.notCalled(discoverCallback);
       });
@@ -617,7 +705,7 @@ describe('hci-socket gap', () => {
 
         const status = 'status';
         const type = 0x01;
-        const address = 'a:d:d:r:e:s:s';
+        const address = 0x112233445566;
         const addressType = 'addressType';
         const rssi = 'rssi';
 
@@ -634,7 +722,8 @@ describe('hci-socket gap', () => {
         gap.onHciLeAdvertisingReport(status, type, address, addressType, eir, rssi);
 
         const expectedDiscovery = {
-          address,
+          address: '11:22:33:44:55:66',
+          id: '112233445566',
           addressType,
           connectable: true,
           advertisement: {
@@ -647,9 +736,10 @@ describe('hci-socket gap', () => {
           },
           rssi,
           count: 1,
-          hasScanResponse: false
+          hasScanResponse: false,
+          eirs: { [type]: Buffer.from(eir) }
         };
-        should(gap._discoveries[address]).deepEqual(expectedDiscovery);
+        should(gap._discoveries.get(address)).deepEqual(expectedDiscovery);
 
         assert.notCalled(discoverCallback);
       });
@@ -663,7 +753,7 @@ describe('hci-socket gap', () => {
 
         const status = 'status';
         const type = 0x01;
-        const address = 'a:d:d:r:e:s:s';
+        const address = 0x112233445566;
         const addressType = 'addressType';
         const rssi = 'rssi';
 
@@ -679,7 +769,8 @@ describe('hci-socket gap', () => {
         gap.onHciLeAdvertisingReport(status, type, address, addressType, eir, rssi);
 
         const expectedDiscovery = {
-          address,
+          address: '11:22:33:44:55:66',
+          id: '112233445566',
           addressType,
           connectable: true,
           advertisement: {
@@ -692,9 +783,10 @@ describe('hci-socket gap', () => {
           },
           rssi,
           count: 1,
-          hasScanResponse: false
+          hasScanResponse: false,
+          eirs: { [type]: Buffer.from(eir) }
         };
-        should(gap._discoveries[address]).deepEqual(expectedDiscovery);
+        should(gap._discoveries.get(address)).deepEqual(expectedDiscovery);
 
         assert.notCalled(discoverCallback);
       });
@@ -707,7 +799,7 @@ describe('hci-socket gap', () => {
 
       const status = 'status';
       const type = 0x01;
-      const address = 'a:d:d:r:e:s:s';
+      const address = 0x112233445566;
       const addressType = 'addressType';
       const rssi = 'rssi';
 
@@ -724,7 +816,8 @@ describe('hci-socket gap', () => {
       gap.onHciLeAdvertisingReport(status, type, address, addressType, eir, rssi);
 
       const expectedDiscovery = {
-        address,
+        address: '11:22:33:44:55:66',
+        id: '112233445566',
         addressType,
         connectable: true,
         advertisement: {
@@ -737,9 +830,10 @@ describe('hci-socket gap', () => {
         },
         rssi,
         count: 1,
-        hasScanResponse: false
+        hasScanResponse: false,
+        eirs: { [type]: Buffer.from(eir) }
       };
-      should(gap._discoveries[address]).deepEqual(expectedDiscovery);
+      should(gap._discoveries.get(address)).deepEqual(expectedDiscovery);
 
       assert.notCalled(discoverCallback);
     });
@@ -751,7 +845,7 @@ describe('hci-socket gap', () => {
 
       const status = 'status';
       const type = 0x01;
-      const address = 'a:d:d:r:e:s:s';
+      const address = 0x112233445566;
       const addressType = 'addressType';
       const rssi = 'rssi';
 
@@ -769,7 +863,8 @@ describe('hci-socket gap', () => {
       gap.onHciLeAdvertisingReport(status, type, address, addressType, eir, rssi);
 
       const expectedDiscovery = {
-        address,
+        address: '11:22:33:44:55:66',
+        id: '112233445566',
         addressType,
         connectable: true,
         advertisement: {
@@ -782,9 +877,10 @@ describe('hci-socket gap', () => {
         },
         rssi,
         count: 1,
-        hasScanResponse: false
+        hasScanResponse: false,
+        eirs: { [type]: Buffer.from(eir) }
       };
-      should(gap._discoveries[address]).deepEqual(expectedDiscovery);
+      should(gap._discoveries.get(address)).deepEqual(expectedDiscovery);
 
       assert.notCalled(discoverCallback);
     });
@@ -796,7 +892,7 @@ describe('hci-socket gap', () => {
 
       const status = 'status';
       const type = 0x01;
-      const address = 'a:d:d:r:e:s:s';
+      const address = 0x112233445566;
       const addressType = 'addressType';
       const rssi = 'rssi';
 
@@ -814,7 +910,8 @@ describe('hci-socket gap', () => {
       gap.onHciLeAdvertisingReport(status, type, address, addressType, eir, rssi);
 
       const expectedDiscovery = {
-        address,
+        address: '11:22:33:44:55:66',
+        id: '112233445566',
         addressType,
         connectable: true,
         advertisement: {
@@ -827,9 +924,10 @@ describe('hci-socket gap', () => {
         },
         rssi,
         count: 1,
-        hasScanResponse: false
+        hasScanResponse: false,
+        eirs: { [type]: Buffer.from(eir) }
       };
-      should(gap._discoveries[address]).deepEqual(expectedDiscovery);
+      should(gap._discoveries.get(address)).deepEqual(expectedDiscovery);
 
       assert.notCalled(discoverCallback);
     });
@@ -841,7 +939,7 @@ describe('hci-socket gap', () => {
 
       const status = 'status';
       const type = 0x01;
-      const address = 'a:d:d:r:e:s:s';
+      const address = 0x112233445566;
       const addressType = 'addressType';
       const rssi = 'rssi';
 
@@ -859,7 +957,8 @@ describe('hci-socket gap', () => {
       gap.onHciLeAdvertisingReport(status, type, address, addressType, eir, rssi);
 
       const expectedDiscovery = {
-        address,
+        address: '11:22:33:44:55:66',
+        id: '112233445566',
         addressType,
         connectable: true,
         advertisement: {
@@ -877,9 +976,10 @@ describe('hci-socket gap', () => {
         },
         rssi,
         count: 1,
-        hasScanResponse: false
+        hasScanResponse: false,
+        eirs: { [type]: Buffer.from(eir) }
       };
-      should(gap._discoveries[address]).deepEqual(expectedDiscovery);
+      should(gap._discoveries.get(address)).deepEqual(expectedDiscovery);
 
       assert.notCalled(discoverCallback);
     });
@@ -891,7 +991,7 @@ describe('hci-socket gap', () => {
 
       const status = 'status';
       const type = 0x01;
-      const address = 'a:d:d:r:e:s:s';
+      const address = 0x112233445566;
       const addressType = 'addressType';
       const rssi = 'rssi';
 
@@ -909,7 +1009,8 @@ describe('hci-socket gap', () => {
       gap.onHciLeAdvertisingReport(status, type, address, addressType, eir, rssi);
 
       const expectedDiscovery = {
-        address,
+        address: '11:22:33:44:55:66',
+        id: '112233445566',
         addressType,
         connectable: true,
         advertisement: {
@@ -927,9 +1028,10 @@ describe('hci-socket gap', () => {
         },
         rssi,
         count: 1,
-        hasScanResponse: false
+        hasScanResponse: false,
+        eirs: { [type]: Buffer.from(eir) }
       };
-      should(gap._discoveries[address]).deepEqual(expectedDiscovery);
+      should(gap._discoveries.get(address)).deepEqual(expectedDiscovery);
 
       assert.notCalled(discoverCallback);
     });
@@ -941,7 +1043,7 @@ describe('hci-socket gap', () => {
 
       const status = 'status';
       const type = 0x01;
-      const address = 'a:d:d:r:e:s:s';
+      const address = 0x112233445566;
       const addressType = 'addressType';
       const rssi = 'rssi';
 
@@ -959,7 +1061,8 @@ describe('hci-socket gap', () => {
       gap.onHciLeAdvertisingReport(status, type, address, addressType, eir, rssi);
 
       const expectedDiscovery = {
-        address,
+        address: '11:22:33:44:55:66',
+        id: '112233445566',
         addressType,
         connectable: true,
         advertisement: {
@@ -977,9 +1080,10 @@ describe('hci-socket gap', () => {
         },
         rssi,
         count: 1,
-        hasScanResponse: false
+        hasScanResponse: false,
+        eirs: { [type]: Buffer.from(eir) }
       };
-      should(gap._discoveries[address]).deepEqual(expectedDiscovery);
+      should(gap._discoveries.get(address)).deepEqual(expectedDiscovery);
 
       assert.notCalled(discoverCallback);
     });
@@ -991,7 +1095,7 @@ describe('hci-socket gap', () => {
 
       const status = 'status';
       const type = 0x01;
-      const address = 'a:d:d:r:e:s:s';
+      const address = 0x112233445566;
       const addressType = 'addressType';
       const rssi = 'rssi';
 
@@ -1009,7 +1113,8 @@ describe('hci-socket gap', () => {
       gap.onHciLeAdvertisingReport(status, type, address, addressType, eir, rssi);
 
       const expectedDiscovery = {
-        address,
+        address: '11:22:33:44:55:66',
+        id: '112233445566',
         addressType,
         connectable: true,
         advertisement: {
@@ -1022,9 +1127,10 @@ describe('hci-socket gap', () => {
         },
         rssi,
         count: 1,
-        hasScanResponse: false
+        hasScanResponse: false,
+        eirs: { [type]: Buffer.from(eir) }
       };
-      should(gap._discoveries[address]).deepEqual(expectedDiscovery);
+      should(gap._discoveries.get(address)).deepEqual(expectedDiscovery);
 
       assert.notCalled(discoverCallback);
     });
@@ -1036,7 +1142,7 @@ describe('hci-socket gap', () => {
 
       const status = 'status';
       const type = 0x01;
-      const address = 'a:d:d:r:e:s:s';
+      const address = 0x112233445566;
       const addressType = 'addressType';
       const rssi = 'rssi';
 
@@ -1053,7 +1159,8 @@ describe('hci-socket gap', () => {
       gap.onHciLeAdvertisingReport(status, type, address, addressType, eir, rssi);
 
       const expectedDiscovery = {
-        address,
+        address: '11:22:33:44:55:66',
+        id: '112233445566',
         addressType,
         connectable: true,
         advertisement: {
@@ -1066,9 +1173,10 @@ describe('hci-socket gap', () => {
         },
         rssi,
         count: 1,
-        hasScanResponse: false
+        hasScanResponse: false,
+        eirs: { [type]: Buffer.from(eir) }
       };
-      should(gap._discoveries[address]).deepEqual(expectedDiscovery);
+      should(gap._discoveries.get(address)).deepEqual(expectedDiscovery);
 
       assert.notCalled(discoverCallback);
     });
@@ -1080,7 +1188,7 @@ describe('hci-socket gap', () => {
 
       const status = 'status';
       const type = 0x01;
-      const address = 'a:d:d:r:e:s:s';
+      const address = 0x112233445566;
       const addressType = 'addressType';
       const rssi = 'rssi';
 
@@ -1106,7 +1214,8 @@ describe('hci-socket gap', () => {
       gap.onHciLeAdvertisingReport(status, type, address, addressType, eir2, rssi);
 
       const expectedDiscovery = {
-        address,
+        address: '11:22:33:44:55:66',
+        id: '112233445566',
         addressType,
         connectable: true,
         advertisement: {
@@ -1128,10 +1237,11 @@ describe('hci-socket gap', () => {
         },
         rssi,
         count: 2,
-        hasScanResponse: false
+        hasScanResponse: false,
+        eirs: { [type]: Buffer.from(eir2) }
       };
       
-      should(gap._discoveries[address]).deepEqual(expectedDiscovery);
+      should(gap._discoveries.get(address)).deepEqual(expectedDiscovery);
     });
 
     it('should overwrite service data when receiving same UUID with different data', () => {
@@ -1141,7 +1251,7 @@ describe('hci-socket gap', () => {
 
       const status = 'status';
       const type = 0x01;
-      const address = 'a:d:d:r:e:s:s';
+      const address = 0x112233445566;
       const addressType = 'addressType';
       const rssi = 'rssi';
 
@@ -1158,7 +1268,8 @@ describe('hci-socket gap', () => {
 
       // Verify first state
       const expectedDiscovery1 = {
-        address,
+        address: '11:22:33:44:55:66',
+        id: '112233445566',
         addressType,
         connectable: true,
         advertisement: {
@@ -1176,10 +1287,11 @@ describe('hci-socket gap', () => {
         },
         rssi,
         count: 1,
-        hasScanResponse: false
+        hasScanResponse: false,
+        eirs: { [type]: eir1 }
       };
       
-      should(gap._discoveries[address]).deepEqual(expectedDiscovery1);
+      should(gap._discoveries.get(address)).deepEqual(expectedDiscovery1);
 
       // Second report with same UUID but different data
       const serviceData2 = Buffer.from([0x05, 0x06]);
@@ -1191,7 +1303,8 @@ describe('hci-socket gap', () => {
 
       // Verify data was overwritten
       const expectedDiscovery2 = {
-        address,
+        address: '11:22:33:44:55:66',
+        id: '112233445566',
         addressType,
         connectable: true,
         advertisement: {
@@ -1209,10 +1322,11 @@ describe('hci-socket gap', () => {
         },
         rssi,
         count: 2,
-        hasScanResponse: false
+        hasScanResponse: false,
+        eirs: { [type]: eir2 }
       };
       
-      should(gap._discoveries[address]).deepEqual(expectedDiscovery2);
+      should(gap._discoveries.get(address)).deepEqual(expectedDiscovery2);
     });
   });
 
@@ -1222,7 +1336,7 @@ describe('hci-socket gap', () => {
     };
 
     const status = 'status';
-    const address = 'a:d:d:r:e:s:s';
+    const address = 0x112233445566;
     const addressType = 'addressType';
     const rssi = 'rssi';
 
@@ -1246,12 +1360,612 @@ describe('hci-socket gap', () => {
       }
     ];
 
-    should(gap._discoveries[address].advertisement.serviceData).deepEqual(expectedServiceData);
+    should(gap._discoveries.get(address).advertisement.serviceData).deepEqual(expectedServiceData);
 
     gap.onHciLeAdvertisingReport(status, 0x01, address, addressType, eir, rssi);
 
-    should(gap._discoveries[address].advertisement.serviceData).deepEqual(expectedServiceData);
+    should(gap._discoveries.get(address).advertisement.serviceData).deepEqual(expectedServiceData);
 
     assert.calledOnce(discoverCallback);
   });
+
+  it('should only refresh the rssi when a report repeats the last one of its type', () => {
+    const hci = {
+      on: sinon.spy()
+    };
+
+    const address = 0x112233445566;
+    const eir = Buffer.from([0x05, 0x09, 0x61, 0x62, 0x63, 0x64]);
+    const scanResponse = Buffer.from([0x03, 0x03, 0x0f, 0x18]);
+
+    const discoverCallback = sinon.spy();
+
+    const gap = new Gap(hci);
+    const parseServices = sinon.spy(gap, 'parseServices');
+    gap.on('discover', discoverCallback);
+
+    gap.onHciLeAdvertisingReport('status', 0x03, address, 'public', eir, -50);
+    gap.onHciLeAdvertisingReport('status', 0x04, address, 'public', scanResponse, -51);
+    gap.onHciLeAdvertisingReport('status', 0x03, address, 'public', Buffer.from(eir), -52);
+    gap.onHciLeAdvertisingReport('status', 0x04, address, 'public', scanResponse, -53);
+
+    assert.calledTwice(parseServices);
+    should(discoverCallback.args.map(args => [args[5], args[8]])).deepEqual([[-50, true], [-51, true], [-52, false], [-53, false]]);
+    should(gap._discoveries.get(address).rssi).equal(-53);
+    should(gap._discoveries.get(address).count).equal(4);
+    should(gap._discoveries.get(address).advertisement).containDeep({ localName: 'abcd', serviceUuids: ['180f'] });
+
+    // The copy is what is compared, not the buffer the report came in
+    eir[2] = 0x7a;
+    gap.onHciLeAdvertisingReport('status', 0x03, address, 'public', eir, -54);
+
+    assert.calledThrice(parseServices);
+    should(discoverCallback.lastCall.args[8]).be.true();
+    should(gap._discoveries.get(address).advertisement.localName).equal('zbcd');
+  });
+
+  it('should drop reports from new devices that do not match the scan filter, before parsing them', () => {
+    const hci = {
+      on: sinon.spy()
+    };
+
+    const discoverCallback = sinon.spy();
+
+    const gap = new Gap(hci, { scanFilter: { localName: 'Tag-' } });
+    const parseServices = sinon.spy(gap, 'parseServices');
+    gap.on('discover', discoverCallback);
+
+    gap.onHciLeAdvertisingReport('status', 0x00, 0xaabbccddeeff, 'public', Buffer.from([0x04, 0x09, 0x61, 0x62, 0x63]), -50);
+    gap.onHciLeAdvertisingReport('status', 0x00, 0x112233445566, 'public', Buffer.from([0x05, 0x09, 0x54, 0x61, 0x67, 0x2d]), -50);
+    // The scan response of a device that matched is merged even though it has no name
+    gap.onHciLeAdvertisingReport('status', 0x04, 0x112233445566, 'public', Buffer.from([0x03, 0x03, 0x0f, 0x18]), -50);
+
+    assert.calledTwice(parseServices);
+    should(gap._discoveries.get(0xaabbccddeeff)).be.undefined();
+    should(gap.getScanFilterStats()).deepEqual({ rejected: 1, acceptListRejected: 0 });
+    assert.calledOnce(discoverCallback);
+    should(discoverCallback.firstCall.args[4]).containDeep({ localName: 'Tag-', serviceUuids: ['180f'] });
+  });
+
+  describe('setAcceptList', () => {
+    const A = { address: '11:22:33:44:55:66', addressType: 'public' };
+    const B = { address: 'c0:ff:ee:00:00:01', addressType: 'random' };
+    const C = { address: 'AABBCCDDEEFF' };
+
+    let hci;
+    let gap;
+
+    beforeEach(() => {
+      hci = {
+        on: sinon.spy(),
+        readAcceptListSize: sinon.stub().resolves(2),
+        loadAcceptList: sinon.stub().resolves([]),
+        setScanFilterPolicy: sinon.spy(),
+        setScanParameters: sinon.spy(),
+        setScanEnabled: sinon.spy()
+      };
+      gap = new Gap(hci);
+    });
+
+    it('should let the controller filter a list that fits', async () => {
+      should(await gap.setAcceptList([A, B])).deepEqual({ mode: 'controller', size: 2, capacity: 2 });
+
+      assert.calledOnceWithExactly(hci.loadAcceptList, [
+        { value: 0x112233445566, address: '11:22:33:44:55:66', addressType: 'public' },
+        { value: 0xc0ffee000001, address: 'c0:ff:ee:00:00:01', addressType: 'random' }
+      ]);
+      assert.calledOnceWithExactly(hci.setScanFilterPolicy, true);
+      assert.notCalled(hci.setScanEnabled);
+
+      // The capacity is read once
+      should(await gap.setAcceptList([])).deepEqual({ mode: 'off', size: 0, capacity: 2 });
+      assert.calledOnce(hci.readAcceptListSize);
+      assert.calledWithExactly(hci.loadAcceptList.secondCall, []);
+      assert.calledWithExactly(hci.setScanFilterPolicy.secondCall, false);
+    });
+
+    it('should filter on the host when the list does not fit', async () => {
+      const discoverCallback = sinon.spy();
+      gap.on('discover', discoverCallback);
+
+      should(await gap.setAcceptList([A, B, C])).deepEqual({ mode: 'host', size: 3, capacity: 2 });
+      assert.notCalled(hci.loadAcceptList);
+
+      const eir = Buffer.from([0x02, 0x01, 0x06]);
+      gap.onHciLeAdvertisingReport('status', 0x03, 0x112233445566, 'public', eir, -50);
+      gap.onHciLeAdvertisingReport('status', 0x03, 0x112233445566, 'random', eir, -50);
+      gap.onHciLeAdvertisingReport('status', 0x03, 0x010203040506, 'public', eir, -50);
+      gap.onHciLeExtendedAdvertisingReport('status', 0x00, 0xaabbccddeeff, 'public', 0x7f, -50, eir);
+
+      should(discoverCallback.args.map(args => args[1])).deepEqual(['11:22:33:44:55:66', 'aa:bb:cc:dd:ee:ff']);
+      should(gap.getScanFilterStats().acceptListRejected).equal(2);
+    });
+
+    it('should fall back to the host when the controller has no room left', async () => {
+      const full = Object.assign(new Error('Memory Capacity Exceeded'), { status: 0x07 });
+      hci.loadAcceptList.onFirstCall().rejects(full);
+
+      should(await gap.setAcceptList([A])).deepEqual({ mode: 'host', size: 1, capacity: 2 });
+      assert.calledWithExactly(hci.loadAcceptList.secondCall, []);
+      assert.calledWithExactly(hci.setScanFilterPolicy.secondCall, false);
+    });
+
+    it('should stop a running scan around changes to the controller list', async () => {
+      gap.setScanParameters(0x10, 0x10);
+      gap.startScanning(true);
+      gap._scanState = 'started';
+      hci.setScanEnabled.resetHistory();
+      hci.setScanParameters.resetHistory();
+
+      await gap.setAcceptList([A]);
+
+      assert.callOrder(
+        hci.setScanEnabled.firstCall,
+        hci.loadAcceptList.firstCall,
+        hci.setScanParameters.firstCall,
+        hci.setScanEnabled.secondCall
+      );
+      assert.calledWithExactly(hci.setScanEnabled.firstCall, false, true);
+      assert.calledWithExactly(hci.setScanParameters, 0x10, 0x10);
+      assert.calledWithExactly(hci.setScanEnabled.secondCall, true, false, 0);
+    });
+
+    it('should reject entries that are not addresses', async () => {
+      await should(gap.setAcceptList([{ address: '11:22:33' }])).be.rejectedWith(/BD_ADDR/);
+      await should(gap.setAcceptList([{ address: '11:22:33:44:55:66', addressType: 'static' }])).be.rejectedWith(/addressType/);
+    });
+  });
+
+  describe('with chained extended reports', () => {
+    const ADDRESS = 0x112233445566;
+    const NON_CONNECTABLE = 0x00;
+    const MORE = 0x20;
+    const TRUNCATED = 0x40;
+
+    // Complete local name "Tag-01", then manufacturer data for company 0x0059
+    const NAME = Buffer.from([0x07, 0x09, 0x54, 0x61, 0x67, 0x2d, 0x30, 0x31]);
+    const DATA = Buffer.from([0x05, 0xff, 0x59, 0x00, 0xa1, 0xb2]);
+
+    let gap;
+    let discoverCallback;
+
+    beforeEach(() => {
+      gap = new Gap({ on: sinon.spy() });
+      discoverCallback = sinon.spy();
+      gap.on('discover', discoverCallback);
+    });
+
+    it('should parse and report the advertising data once its last report is in', () => {
+      gap.onHciLeExtendedAdvertisingReport('status', NON_CONNECTABLE | MORE, ADDRESS, 'random', 0x7f, -50, NAME.subarray(0, 5), 0x03);
+      gap.onHciLeExtendedAdvertisingReport('status', NON_CONNECTABLE | MORE, ADDRESS, 'random', 0x7f, -51, NAME.subarray(5), 0x03);
+      assert.notCalled(discoverCallback);
+
+      gap.onHciLeExtendedAdvertisingReport('status', NON_CONNECTABLE, ADDRESS, 'random', 0x7f, -52, DATA, 0x03);
+
+      assert.calledOnce(discoverCallback);
+      const advertisement = discoverCallback.firstCall.args[4];
+      should(advertisement.localName).equal('Tag-01');
+      should(advertisement.manufacturerData).deepEqual(Buffer.from([0x59, 0x00, 0xa1, 0xb2]));
+      should(advertisement.truncated).be.undefined();
+      should(discoverCallback.firstCall.args[5]).equal(-52);
+      should(gap.getReportReassemblyStats()).deepEqual({ pending: 0, joined: 1, dropped: 0 });
+    });
+
+    it('should run the scan filter on the whole advertising data', () => {
+      gap = new Gap({ on: sinon.spy() }, { scanFilter: { manufacturerData: { companyId: 0x0059 } } });
+      gap.on('discover', discoverCallback);
+
+      gap.onHciLeExtendedAdvertisingReport('status', NON_CONNECTABLE | MORE, ADDRESS, 'random', 0x7f, -50, NAME, 0x03);
+      gap.onHciLeExtendedAdvertisingReport('status', NON_CONNECTABLE, ADDRESS, 'random', 0x7f, -50, DATA, 0x03);
+
+      assert.calledOnce(discoverCallback);
+      should(gap.getScanFilterStats().rejected).equal(0);
+    });
+
+    it('should flag advertising data the controller truncated until it arrives whole', () => {
+      gap.onHciLeExtendedAdvertisingReport('status', NON_CONNECTABLE | MORE, ADDRESS, 'random', 0x7f, -50, NAME, 0x03);
+      gap.onHciLeExtendedAdvertisingReport('status', NON_CONNECTABLE | TRUNCATED, ADDRESS, 'random', 0x7f, -50, Buffer.alloc(0), 0x03);
+
+      const advertisement = discoverCallback.firstCall.args[4];
+      should(advertisement.localName).equal('Tag-01');
+      should(advertisement.truncated).be.true();
+
+      gap.onHciLeExtendedAdvertisingReport('status', NON_CONNECTABLE | MORE, ADDRESS, 'random', 0x7f, -50, NAME, 0x03);
+      gap.onHciLeExtendedAdvertisingReport('status', NON_CONNECTABLE, ADDRESS, 'random', 0x7f, -50, DATA, 0x03);
+
+      assert.calledTwice(discoverCallback);
+      should(discoverCallback.secondCall.args[4].truncated).be.false();
+    });
+
+    it('should keep the chains of one advertiser\'s advertising sets apart by SID', () => {
+      const interleave = (sids) => {
+        gap.onHciLeExtendedAdvertisingReport('status', NON_CONNECTABLE | MORE, ADDRESS, 'random', 0x7f, -50, NAME.subarray(0, 5), sids[0]);
+        gap.onHciLeExtendedAdvertisingReport('status', NON_CONNECTABLE | MORE, ADDRESS, 'random', 0x7f, -50, DATA.subarray(0, 3), sids[1]);
+        gap.onHciLeExtendedAdvertisingReport('status', NON_CONNECTABLE, ADDRESS, 'random', 0x7f, -50, NAME.subarray(5), sids[0]);
+        gap.onHciLeExtendedAdvertisingReport('status', NON_CONNECTABLE, ADDRESS, 'random', 0x7f, -50, DATA.subarray(3), sids[1]);
+      };
+
+      interleave([0x01, 0x02]);
+
+      assert.calledTwice(discoverCallback);
+      should(discoverCallback.firstCall.args[4].localName).equal('Tag-01');
+      should(discoverCallback.secondCall.args[4].manufacturerData).deepEqual(Buffer.from([0x59, 0x00, 0xa1, 0xb2]));
+      should(gap.getReportReassemblyStats().joined).equal(2);
+
+      // Without SIDs the two chains are one chain, so the SID has to reach Gap from every driver
+      interleave([undefined, undefined]);
+
+      should(gap.getReportReassemblyStats().joined).equal(3);
+    });
+
+    it('should forget chains when scanning stops', () => {
+      gap._hci.setScanEnabled = sinon.spy();
+      gap.onHciLeExtendedAdvertisingReport('status', NON_CONNECTABLE | MORE, ADDRESS, 'random', 0x7f, -50, NAME, 0x03);
+      gap.stopScanning();
+
+      should(gap.getReportReassemblyStats().pending).equal(0);
+    });
+  });
+
+  describe('with periodic syncs', () => {
+    const ADDRESS = 0x112233445566;
+    const OTHER = 0xaabbccddeeff;
+    const SENSOR_DATA = Buffer.from([0x05, 0xff, 0x59, 0x00, 0x01, 0x02]);
+
+    let clock;
+    let hci;
+    let gap;
+    let established;
+    let report;
+    let lost;
+
+    // An extended advertiser with a periodic train every 100 ms on SID 3
+    const discover = (address) => {
+      gap.onHciLeExtendedAdvertisingReport('status', 0x00, address, 'random', 0x7f, -50, Buffer.alloc(0), 0x03, 100);
+    };
+
+    beforeEach(() => {
+      clock = sinon.useFakeTimers();
+      hci = {
+        on: sinon.spy(),
+        createPeriodicSync: sinon.spy(),
+        cancelPeriodicSync: sinon.spy(),
+        terminatePeriodicSync: sinon.spy()
+      };
+      gap = new Gap(hci, { maxPeriodicSyncs: 2 });
+      established = sinon.spy();
+      report = sinon.spy();
+      lost = sinon.spy();
+      gap.on('periodicSyncEstablished', established);
+      gap.on('periodicAdvertisingReport', report);
+      gap.on('periodicSyncLost', lost);
+      discover(ADDRESS);
+      discover(OTHER);
+    });
+
+    afterEach(() => {
+      clock.restore();
+    });
+
+    it('should sync with the SID its advertisements carry and report its data', () => {
+      gap.createPeriodicSync('112233445566', { timeout: 2000 });
+      assert.calledOnceWithExactly(hci.createPeriodicSync, ADDRESS, 'random', 0x03, 0, 2000);
+
+      gap.onHciLePeriodicSyncEstablished(0x00, 0x0001, ADDRESS, 'random', 0x03, 0x01, 100);
+      assert.calledOnceWithExactly(established, '112233445566', null, { sid: 0x03, phy: 0x01, interval: 100 });
+
+      gap.onHciLePeriodicAdvertisingReport(0x0001, 0x7f, -60, 0x01, SENSOR_DATA.subarray(0, 4));
+      gap.onHciLePeriodicAdvertisingReport(0x0001, 0x7f, -61, 0x00, SENSOR_DATA.subarray(4));
+      gap.onHciLePeriodicAdvertisingReport(0x0002, 0x7f, -61, 0x00, SENSOR_DATA);
+
+      assert.calledOnceWithExactly(report, '112233445566', SENSOR_DATA, -61, 0x7f, false);
+    });
+
+    it('should refuse advertisers without periodic advertising and syncs past the cap', () => {
+      gap.onHciLeExtendedAdvertisingReport('status', 0x00, 0x010203040506, 'random', 0x7f, -50, Buffer.alloc(0), 0xff, 0);
+      gap.createPeriodicSync('010203040506');
+      gap.createPeriodicSync('112233445566');
+      gap.createPeriodicSync('aabbccddeeff');
+      gap.createPeriodicSync('aabbccddeeff');
+
+      assert.calledTwice(established);
+      should(established.firstCall.args[1].message).match(/no periodic advertising/);
+      should(established.secondCall.args[1].message).match(/already exists/);
+
+      gap.createPeriodicSync('c00000000000');
+      should(established.thirdCall.args[1].message).match(/2 periodic syncs already exist/);
+    });
+
+    it('should create one sync at a time', () => {
+      gap.createPeriodicSync('112233445566');
+      gap.createPeriodicSync('aabbccddeeff');
+      assert.calledOnce(hci.createPeriodicSync);
+
+      gap.onHciLePeriodicSyncEstablished(0x3e, undefined, ADDRESS, 'random', 0x03, undefined, undefined);
+
+      should(established.firstCall.args[1].status).equal(0x3e);
+      assert.calledTwice(hci.createPeriodicSync);
+      assert.calledWith(hci.createPeriodicSync.secondCall, OTHER, 'random', 0x03);
+    });
+
+    it('should cancel a sync that is not established in time', () => {
+      gap.createPeriodicSync('112233445566', { establishTimeout: 5000 });
+      clock.tick(5000);
+      assert.calledOnce(hci.cancelPeriodicSync);
+
+      gap.onHciLePeriodicSyncEstablished(0x44, 0x0000, ADDRESS, 'random', 0x03, 0, 0);
+
+      should(established.firstCall.args[1].message).equal('Periodic sync with 112233445566 timed out');
+      should(gap._periodicSyncs.size).equal(0);
+    });
+
+    it('should terminate a sync that was established as it was cancelled', () => {
+      gap.createPeriodicSync('112233445566');
+      gap.terminatePeriodicSync('112233445566');
+      gap.onHciLePeriodicSyncEstablished(0x00, 0x0001, ADDRESS, 'random', 0x03, 0x01, 100);
+
+      assert.calledOnceWithExactly(hci.terminatePeriodicSync, 0x0001);
+      should(established.firstCall.args[1].message).match(/terminated before it was established/);
+    });
+
+    it('should report syncs that are terminated or lost', () => {
+      gap.createPeriodicSync('112233445566');
+      gap.onHciLePeriodicSyncEstablished(0x00, 0x0001, ADDRESS, 'random', 0x03, 0x01, 100);
+      gap.createPeriodicSync('aabbccddeeff');
+      gap.onHciLePeriodicSyncEstablished(0x00, 0x0002, OTHER, 'random', 0x03, 0x01, 100);
+
+      gap.terminatePeriodicSync('112233445566');
+      gap.onHciLePeriodicSyncLost(0x0002);
+      gap.onHciLePeriodicAdvertisingReport(0x0001, 0x7f, -60, 0x00, SENSOR_DATA);
+
+      assert.calledOnceWithExactly(hci.terminatePeriodicSync, 0x0001);
+      assert.calledWithExactly(lost.firstCall, '112233445566', 'terminated');
+      assert.calledWithExactly(lost.secondCall, 'aabbccddeeff', 'timeout');
+      assert.notCalled(report);
+    });
+
+    it('should drop every sync when the adapter goes away', () => {
+      gap.createPeriodicSync('112233445566');
+      gap.onHciLePeriodicSyncEstablished(0x00, 0x0001, ADDRESS, 'random', 0x03, 0x01, 100);
+      gap.createPeriodicSync('aabbccddeeff');
+
+      gap.dropPeriodicSyncs('poweredOff');
+
+      assert.calledOnceWithExactly(lost, '112233445566', 'poweredOff');
+      should(established.secondCall.args[1].message).equal('Periodic sync with aabbccddeeff failed: poweredOff');
+      should(gap._periodicSyncs.size).equal(0);
+    });
+  });
+
+  describe('with scan profiles', () => {
+    let hci;
+
+    beforeEach(() => {
+      hci = {
+        on: sinon.spy(),
+        setScanType: sinon.spy(),
+        setScanPhys: sinon.spy(),
+        setScanParameters: sinon.spy(),
+        setScanEnabled: sinon.spy()
+      };
+    });
+
+    it('should scan with the profile given as option', () => {
+      const gap = new Gap(hci, { scanProfile: 'lowPower' });
+      gap.startScanning(true);
+
+      assert.calledOnceWithExactly(hci.setScanType, false);
+      assert.calledOnceWithExactly(hci.setScanPhys, ['1m', 'coded']);
+      assert.calledOnceWithExactly(hci.setScanParameters, 0x0800, 0x0030);
+    });
+
+    it('should take a new profile without restarting a stopped scan', () => {
+      const gap = new Gap(hci, { scanProfiles: { tags: { phys: ['coded'] } } });
+
+      should(gap.setScanProfile('tags')).equal('tags');
+      assert.calledOnceWithExactly(hci.setScanPhys, ['coded']);
+      assert.notCalled(hci.setScanParameters);
+      assert.notCalled(hci.setScanEnabled);
+      should(() => gap.setScanProfile('unknown')).throw(/Unknown scan profile/);
+    });
+
+    it('should set the parameters of a running scan with it disabled', () => {
+      const gap = new Gap(hci);
+      gap.startScanning(false);
+      gap._scanState = 'started';
+      hci.setScanEnabled.resetHistory();
+      hci.setScanParameters.resetHistory();
+
+      gap.setScanProfile('passive');
+
+      should(hci.setScanEnabled.args).deepEqual([[false, true], [true, true, 0]]);
+      assert.calledOnceWithExactly(hci.setScanParameters, 0x0012, 0x0012);
+      assert.callOrder(hci.setScanEnabled.firstCall, hci.setScanParameters.firstCall, hci.setScanEnabled.secondCall);
+    });
+
+    it('should change only the duplicate filtering of a running scan without stopping it', () => {
+      const gap = new Gap(hci, { scanProfiles: { all: { allowDuplicates: true } } });
+      gap.startScanning(false);
+      gap._scanState = 'started';
+      hci.setScanEnabled.resetHistory();
+      hci.setScanParameters.resetHistory();
+
+      gap.setScanProfile('all');
+
+      assert.calledOnceWithExactly(hci.setScanEnabled, true, false, 0);
+      assert.notCalled(hci.setScanParameters);
+
+      // Nothing changes, so nothing is sent
+      gap.setScanProfile({ name: 'all again', allowDuplicates: true });
+      assert.calledOnce(hci.setScanEnabled);
+    });
+  });
+
+  describe('with a scan scheduler', () => {
+    let clock;
+    let hci;
+    let gap;
+
+    beforeEach(() => {
+      clock = sinon.useFakeTimers();
+      hci = {
+        on: sinon.spy(),
+        setScanType: sinon.spy(),
+        setScanPhys: sinon.spy(),
+        setScanParameters: sinon.spy(),
+        setScanEnabled: sinon.spy()
+      };
+      gap = new Gap(hci, {
+        scanProfile: { interval: 0x0100, window: 0x0100 },
+        scanScheduler: { maxReportRate: 10, slowDiscovery: 2500 }
+      });
+      gap.startScanning(true);
+      gap.onHciLeScanEnableSet(0);
+      hci.setScanEnabled.resetHistory();
+      hci.setScanParameters.resetHistory();
+    });
+
+    afterEach(() => {
+      gap.stopScanning();
+      clock.restore();
+    });
+
+    const reports = (count) => {
+      const eir = Buffer.from([0x02, 0x01, 0x06]);
+      for (let i = 0; i < count; i++) {
+        gap.onHciLeAdvertisingReport('status', 0x03, 0x112233445566 + i, 'public', eir, -50);
+      }
+    };
+
+    it('should narrow the scan window while reports arrive too fast, and widen it once discovery is slow', () => {
+      reports(20);
+      clock.tick(1000);
+
+      assert.calledOnceWithExactly(hci.setScanParameters, 0x0100, 0x0080);
+      should(hci.setScanEnabled.args).deepEqual([[false, true], [true, false, 0]]);
+      should(gap.getScanStats()).deepEqual({ profile: 'custom', duty: 0.5, scanTime: 1000, scanOnTime: 1000 });
+
+      clock.tick(1000);
+      assert.calledOnce(hci.setScanParameters);
+
+      clock.tick(1000);
+      assert.calledWithExactly(hci.setScanParameters.secondCall, 0x0100, 0x0100);
+      should(gap.getScanStats()).deepEqual({ profile: 'custom', duty: 1, scanTime: 3000, scanOnTime: 2000 });
+    });
+
+    it('should stop with the scan', () => {
+      gap.stopScanning();
+      gap.onHciLeScanEnableSet(0);
+      reports(20);
+      clock.tick(5000);
+
+      assert.notCalled(hci.setScanParameters);
+      should(gap.getScanStats().scanTime).equal(0);
+    });
+  });
+
+  describe('with a scan response window', () => {
+    let clock;
+    let gap;
+    let discoverCallback;
+
+    beforeEach(() => {
+      clock = sinon.useFakeTimers();
+      gap = new Gap({ on: sinon.spy() }, { scanResponseWindow: 100 });
+      discoverCallback = sinon.spy();
+      gap.on('discover', discoverCallback);
+    });
+
+    afterEach(() => {
+      clock.restore();
+    });
+
+    it('should report a scannable advertisement once, merged with its scan response', () => {
+      gap.onHciLeAdvertisingReport('status', 0x00, 0x112233445566, 'public', Buffer.from([0x03, 0x03, 0x0f, 0x18]), -50);
+      gap.onHciLeAdvertisingReport('status', 0x00, 0x112233445566, 'public', Buffer.from([0x03, 0x03, 0x0f, 0x18]), -52);
+      assert.notCalled(discoverCallback);
+
+      gap.onHciLeAdvertisingReport('status', 0x04, 0x112233445566, 'public', Buffer.from([0x04, 0x09, 0x61, 0x62, 0x63]), -51);
+
+      assert.calledOnce(discoverCallback);
+      should(discoverCallback.firstCall.args[4]).containDeep({ localName: 'abc', serviceUuids: ['180f'] });
+      should(discoverCallback.firstCall.args[5]).equal(-51);
+
+      clock.tick(100);
+      assert.calledOnce(discoverCallback);
+    });
+
+    it('should report an advertisement without a scan response when the window ends', () => {
+      gap.onHciLeAdvertisingReport('status', 0x00, 0x112233445566, 'public', Buffer.from([0x03, 0x03, 0x0f, 0x18]), -50);
+      clock.tick(50);
+      gap.onHciLeAdvertisingReport('status', 0x02, 0xaabbccddeeff, 'random', Buffer.alloc(0), -60);
+
+      clock.tick(50);
+      assert.calledOnceWithMatch(discoverCallback, 'status', '11:22:33:44:55:66', 'public', true, { serviceUuids: ['180f'] }, -50);
+
+      clock.tick(50);
+      assert.calledTwice(discoverCallback);
+      assert.calledWithMatch(discoverCallback.secondCall, 'status', 'aa:bb:cc:dd:ee:ff', 'random');
+    });
+
+    it('should report what cannot have a scan response at once', () => {
+      gap.onHciLeAdvertisingReport('status', 0x03, 0x112233445566, 'public', Buffer.alloc(0), -50);
+      gap.onHciLeAdvertisingReport('status', 0x01, 0xaabbccddeeff, 'public', Buffer.alloc(0), -50);
+
+      assert.calledTwice(discoverCallback);
+    });
+
+    it('should not wait for scan responses under a passive scan', () => {
+      gap._hci.setScanType = sinon.spy();
+      gap._hci.setScanPhys = sinon.spy();
+      gap.setScanProfile('passive');
+
+      gap.onHciLeAdvertisingReport('status', 0x00, 0x112233445566, 'public', Buffer.from([0x03, 0x03, 0x0f, 0x18]), -50);
+      gap.onHciLeExtendedAdvertisingReport('status', 0x13, 0xaabbccddeeff, 'random', 0x7f, -60, Buffer.alloc(0));
+
+      assert.calledTwice(discoverCallback);
+      should(gap._heldTimer).be.null();
+    });
+
+    it('should report what it holds when scanning stops', () => {
+      gap._scanState = 'stopping';
+      gap.onHciLeAdvertisingReport('status', 0x00, 0x112233445566, 'public', Buffer.alloc(0), -50);
+      gap.onHciLeScanEnableSet(0);
+
+      assert.calledOnce(discoverCallback);
+      should(gap._heldTimer).be.null();
+    });
+  });
+
+  it('should evict the least recently seen device and treat it as new when heard again', () => {
+    const hci = {
+      on: sinon.spy()
+    };
+
+    const discoverCallback = sinon.spy();
+    const evictCallback = sinon.spy();
+
+    const gap = new Gap(hci, { discoveryCacheSize: 1 });
+    gap.on('discover', discoverCallback);
+    gap.on('discoveryEvict', evictCallback);
+
+    gap.onHciLeAdvertisingReport('status', 0x00, 0x112233445566, 'public', Buffer.alloc(0), -50);
+    gap.onHciLeAdvertisingReport('status', 0x00, 0xaabbccddeeff, 'public', Buffer.alloc(0), -50);
+
+    assert.calledOnceWithExactly(evictCallback, '11:22:33:44:55:66', '112233445566', 'size');
+    should(gap._discoveries.get(0x112233445566)).be.undefined();
+
+    // A connectable device is reported on its second report; the first one was forgotten
+    gap.onHciLeAdvertisingReport('status', 0x00, 0x112233445566, 'public', Buffer.alloc(0), -50);
+    should(gap._discoveries.get(0x112233445566).count).equal(1);
+    assert.notCalled(discoverCallback);
+
+    should(gap.getDiscoveryCacheStats()).deepEqual({
+      size: 1,
+      maxSize: 1,
+      ttl: 300000,
+      evictions: 2,
+      expirations: 0
+    });
+  });
 });
@@ -0,0 +1,104 @@
+const should = require('should');
+
+const {
+  addressAt,
+  addressString,
+  addressTypeAt,
+  addressValueAt,
+  uuidAt,
+  AdvertisingReport,
+  ExtendedAdvertisingReport
+} = require('../../../lib/hci-socket/hci-events');
+
+describe('hci-socket hci events', () => {
+  it('formats a bd addr most significant octet first', () => {
+    const buffer = Buffer.from([0xff, 0x01, 0x02, 0x03, 0x0a, 0xb0, 0xfe]);
+
+    should(addressAt(buffer, 1)).equal('fe:b0:0a:03:02:01');
+    should(addressTypeAt(Buffer.from([0x01]), 0)).equal('random');
+    should(addressTypeAt(Buffer.from([0x00]), 0)).equal('public');
+  });
+
+  it('reads a bd addr as a 48-bit value and formats it back', () => {
+    const buffer = Buffer.from([0xff, 0x01, 0x02, 0x03, 0x0a, 0xb0, 0xfe]);
+    const value = addressValueAt(buffer, 1);
+
+    should(value).equal(0xfeb00a030201);
+    should(addressString(value)).equal(addressAt(buffer, 1));
+    should(addressString(value, '')).equal('feb00a030201');
+    should(addressString(0x000000000001)).equal('00:00:00:00:00:01');
+  });
+
+  it('formats little endian uuids last octet first', () => {
+    const buffer = Buffer.from([0xff, 0x0f, 0x18, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f]);
+
+    should(uuidAt(buffer, 1, 2)).equal('180f');
+    should(uuidAt(buffer, 3, 16)).equal('0f0e0d0c0b0a09080706050403020100');
+    should(uuidAt(buffer, 3, 0)).equal('');
+  });
+
+  it('decodes consecutive advertising reports in place', () => {
+    const data = Buffer.from([
+      0x00, 0x01, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x02, 0xaa, 0xbb, 0xc4,
+      0x04, 0x00, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x00, 0xb0
+    ]);
+    const report = new AdvertisingReport(data, 0);
+
+    should(report.isComplete()).be.true();
+    should(report.type).equal(0);
+    should(report.addressType).equal('random');
+    should(report.address).equal('01:02:03:04:05:06');
+    should(report.addressValue).equal(0x010203040506);
+    should(report.eir).deepEqual(Buffer.from([0xaa, 0xbb]));
+    should(report.rssi).equal(-60);
+    should(report.length).equal(12);
+
+    // The eir is a view, not a copy
+    should(report.eir.buffer).equal(data.buffer);
+
+    report.offset += report.length;
+
+    should(report.isComplete()).be.true();
+    should(report.type).equal(4);
+    should(report.addressType).equal('public');
+    should(report.address).equal('16:15:14:13:12:11');
+    should(report.eir.length).equal(0);
+    should(report.rssi).equal(-80);
+  });
+
+  it('reports a truncated advertising report as incomplete', () => {
+    should(new AdvertisingReport(Buffer.alloc(9), 0).isComplete()).be.false();
+
+    const data = Buffer.from([0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x05, 0xaa, 0xbb]);
+    should(new AdvertisingReport(data, 0).isComplete()).be.false();
+  });
+
+  it('decodes an extended advertising report', () => {
+    const data = Buffer.from([
+      0x13, 0x00, // event type
+      0x01, // address type
+      0x06, 0x05, 0x04, 0x03, 0x02, 0x01, // address
+      0x01, 0x03, 0x02, // primary phy, secondary phy, sid
+      0x7f, 0xc4, // tx power, rssi
+      0x20, 0x00, // periodic advertising interval
+      0x00, 0x16, 0x15, 0x14, 0x13, 0x12, 0x11, // direct address type, direct address
+      0x03, 0x02, 0x01, 0x06 // eir length, eir
+    ]);
+    const report = new ExtendedAdvertisingReport(data, 0);
+
+    should(report.type).equal(0x13);
+    should(report.addressType).equal('random');
+    should(report.address).equal('01:02:03:04:05:06');
+    should(report.addressValue).equal(0x010203040506);
+    should(report.primaryPhy).equal(1);
+    should(report.secondaryPhy).equal(3);
+    should(report.sid).equal(2);
+    should(report.txPower).equal(0x7f);
+    should(report.rssi).equal(-60);
+    should(report.periodicAdvInterval).equal(0x20);
+    should(report.directAddressType).equal('public');
+    should(report.directAddress).equal('11:12:13:14:15:16');
+    should(report.eir).deepEqual(Buffer.from([0x02, 0x01, 0x06]));
+    should(report.length).equal(27);
+  });
+});
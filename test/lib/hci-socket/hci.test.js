@@ -77,6 +77,61 @@ describe('hci-socket hci', () => {
     });
   });
 
+  describe('hci driver', () => {
+    it('loads bluetooth-hci-socket drivers by default', () => {
+      should(hci._socket).be.instanceOf(mockSocket);
+    });
+
+    it('plays a btsnoop capture back with the replay driver', () => {
+      const ReplaySocket = require('../../../lib/hci-socket/drivers/replay');
+
+      should(new Hci({ hciDriver: 'replay' })._socket).be.instanceOf(ReplaySocket);
+    });
+
+    it('emulates a controller with the virtual driver', () => {
+      const VirtualSocket = require('../../../lib/hci-socket/drivers/virtual');
+
+      should(new Hci({ hciDriver: 'virtual' })._socket).be.instanceOf(VirtualSocket);
+    });
+  });
+
+  describe('btsnoop capture', () => {
+    it('is off by default', () => {
+      should(hci._btsnoop).be.null();
+    });
+
+    it('records written and received packets', () => {
+      const capturingHci = new Hci({ btsnoop: '/tmp/noble.btsnoop' });
+      capturingHci._btsnoop = { write: sinon.spy() };
+
+      const command = Buffer.from('01030c00', 'hex');
+      const event = Buffer.from('0413050100000000', 'hex');
+
+      capturingHci.writePacket(command);
+      capturingHci.onSocketData(event);
+
+      assert.calledWithExactly(capturingHci._socket.write, command);
+      assert.calledTwice(capturingHci._btsnoop.write);
+      assert.calledWithExactly(capturingHci._btsnoop.write.firstCall, command, false);
+      assert.calledWithExactly(capturingHci._btsnoop.write.secondCall, event, true);
+    });
+
+    it('converts the ring buffer size from megabytes', () => {
+      const capturingHci = new Hci({ btsnoop: '/tmp/noble.btsnoop', btsnoopMaxSize: 2 });
+
+      should(capturingHci._btsnoop._maxSize).equal(2 * 1024 * 1024);
+    });
+
+    it('closes the capture on stop', () => {
+      hci._btsnoop = { close: sinon.spy() };
+      hci._socket.stop = sinon.spy();
+
+      hci.stop();
+
+      assert.calledOnce(hci._btsnoop.close);
+    });
+  });
+
   describe('coded phy configuration', () => {
     let originalCodedPhy;
 
@@ -424,7 +479,9 @@ describe('hci-socket hci', () => {
 
       hci.pollIsDevUp();
 
-      should(sinon.clock.countTimers()).equal(1);
+      // The poll, and the watchdog of the HCI_Reset that init() wrote
+      should(sinon.clock.countTimers()).equal(2);
+      should(hci._commandWatchdog).not.be.null();
     });
 
     it('should still leave a pending poll timer when init() throws during recovery', () => {
@@ -532,18 +589,128 @@ describe('hci-socket hci', () => {
     it('should clear ACL bookkeeping so a subsequent reset() is not left permanently refused', () => {
       hci._socket.stop = sinon.spy();
       hci._aclConnections.set(4404, { pending: 0 });
-      hci._aclQueue.push({ handle: 4404, packet: Buffer.from([0x00]) });
+      hci._aclScheduler.push(4404, [Buffer.from([0x00])]);
 
       hci.stop();
 
       should(hci._aclConnections.size).equal(0);
-      should(hci._aclQueue).be.empty();
+      should(hci._aclScheduler.length).equal(0);
 
       hci.reset();
       assert.calledOnceWithExactly(hci._socket.write, Buffer.from([1, 3, 0x0c, 0]));
     });
   });
 
+  describe('command flow control', () => {
+    const READ_RSSI = Buffer.from([0x01, 0x05, 0x14, 0x02, 0x34, 0x12]);
+    const DISCONNECT = Buffer.from([0x01, 0x06, 0x04, 0x03, 0x34, 0x12, 0x13]);
+
+    const cmdComplete = (cmd, status, result, credits = 1) => {
+      const event = Buffer.alloc(7 + result.length);
+      event.writeUInt8(0x04, 0); // HCI_EVENT_PKT
+      event.writeUInt8(0x0e, 1); // EVT_CMD_COMPLETE
+      event.writeUInt8(4 + result.length, 2);
+      event.writeUInt8(credits, 3);
+      event.writeUInt16LE(cmd, 4);
+      event.writeUInt8(status, 6);
+      result.copy(event, 7);
+      return event;
+    };
+
+    const cmdStatus = (cmd, status, credits = 1) => {
+      const event = Buffer.from([0x04, 0x0f, 0x04, status, credits, 0x00, 0x00]);
+      event.writeUInt16LE(cmd, 5);
+      return event;
+    };
+
+    it('should resolve with the command complete return parameters', async () => {
+      const pending = hci.readRssi(0x1234);
+
+      hci.onSocketData(cmdComplete(0x1405, 0, Buffer.from([0x34, 0x12, 0xc4])));
+
+      should((await pending).toString('hex')).equal('3412c4');
+    });
+
+    it('should reject with the status when the command fails', async () => {
+      const pending = hci.disconnect(0x1234);
+
+      hci.onSocketData(cmdStatus(0x0406, 0x02));
+
+      await should(pending).be.rejectedWith({ status: 0x02, opcode: 0x0406 });
+    });
+
+    it('should hold commands on the user channel until the controller returns a credit', () => {
+      hci._userChannel = true;
+
+      hci.readRssi(0x1234);
+      hci.disconnect(0x1234);
+      assert.calledOnceWithExactly(hci._socket.write, READ_RSSI);
+
+      hci.onSocketData(cmdComplete(0x1405, 0, Buffer.from([0x34, 0x12, 0xc4]), 0));
+      assert.calledOnce(hci._socket.write);
+
+      hci.onSocketData(cmdComplete(0x0000, 0, Buffer.alloc(0), 1));
+      assert.calledTwice(hci._socket.write);
+      assert.calledWithExactly(hci._socket.write.secondCall, DISCONNECT);
+    });
+
+    it('should leave raw socket commands to the kernel', () => {
+      hci.readRssi(0x1234);
+      hci.disconnect(0x1234);
+
+      assert.calledTwice(hci._socket.write);
+      should(hci._commandQueue).be.empty();
+    });
+
+    it('should time out a lost command and restore the credit', async () => {
+      const clock = sinon.useFakeTimers();
+      try {
+        hci = new Hci({ userChannel: true, commandTimeout: 100 });
+
+        const lost = hci.readRssi(0x1234);
+        hci.disconnect(0x1234);
+        assert.calledOnce(hci._socket.write);
+
+        clock.tick(100);
+
+        await should(lost).be.rejectedWith(/timed out/);
+        assert.calledTwice(hci._socket.write);
+        assert.calledWithExactly(hci._socket.write.secondCall, DISCONNECT);
+      } finally {
+        clock.restore();
+      }
+    });
+
+    it('should time out a command the kernel dropped on a raw socket', async () => {
+      const clock = sinon.useFakeTimers();
+      try {
+        hci = new Hci({ commandTimeout: 100 });
+
+        const lost = hci.readRssi(0x1234);
+        clock.tick(100);
+
+        await should(lost).be.rejectedWith(/timed out/);
+        should(hci._pendingCommands.size).equal(0);
+        should(hci._commandWatchdog).be.null();
+      } finally {
+        clock.restore();
+      }
+    });
+
+    it('should reject queued and pending commands on stop', async () => {
+      hci._userChannel = true;
+      hci._socket.stop = sinon.spy();
+
+      const written = hci.readRssi(0x1234);
+      const queued = hci.disconnect(0x1234);
+      hci.stop();
+
+      await should(written).be.rejectedWith('HCI stopped');
+      await should(queued).be.rejectedWith('HCI stopped');
+      should(hci._commandCredits).equal(1);
+    });
+  });
+
   it('should readSupportedCommands', () => {
     hci.readSupportedCommands();
     assert.calledOnceWithExactly(hci._socket.write, Buffer.from([0x01, 0x02, 0x10, 0x00]));
@@ -631,6 +798,280 @@ describe('hci-socket hci', () => {
     });
   });
 
+  describe('adaptive event filter', () => {
+    const LE_SET_EVENT_MASK = 0x2001;
+    const leEventMasks = () => hci._socket.write.args
+      .map(([packet]) => packet)
+      .filter(packet => packet.readUInt16LE(1) === LE_SET_EVENT_MASK)
+      .map(packet => packet.readUInt32LE(4));
+    const lastSocketFilter = () => hci._socket.setFilter.lastCall.args[0];
+    const advertisingReport = Buffer.from([
+      0x04, 0x3e, 0x0c, 0x02, 0x01,
+      0x00, 0x00, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x00, 0xc4
+    ]);
+
+    it('should only enable advertising reports on the controller while scanning', () => {
+      hci = new Hci({ userChannel: true, commandFlowControl: false });
+      hci.setLeEventMask();
+
+      hci.setScanEnabled(true, false);
+      hci.setScanEnabled(false, true);
+
+      should(leEventMasks()).deepEqual([0x5f, 0x03, 0x01]);
+    });
+
+    it('should enable link events once a connection is attempted and until the last one closes', () => {
+      hci = new Hci({ userChannel: true, commandFlowControl: false });
+      hci.setLeEventMask();
+      hci.setScanEnabled(false, true);
+
+      hci.createLeConn('11:22:33:44:55:66', 'random', {}, false);
+      hci._pendingLeConn = null;
+      hci._aclConnections.set(0x40, { pending: 0 });
+      hci.updateEventFilters();
+      hci.onSocketData(Buffer.from([0x04, 0x05, 0x04, 0x00, 0x40, 0x00, 0x13]));
+
+      should(leEventMasks()).deepEqual([0x5f, 0x01, 0x5d, 0x01]);
+    });
+
+    it('should leave the shared controller alone and drop le meta events in the kernel on a raw socket', () => {
+      hci.setLeEventMask();
+      hci.setSocketFilter();
+      should(lastSocketFilter().readUInt32LE(8)).equal(0x40000000);
+
+      hci.setScanEnabled(false, true);
+      should(lastSocketFilter().readUInt32LE(8)).equal(0);
+
+      hci.setScanEnabled(true, false);
+      should(lastSocketFilter().readUInt32LE(8)).equal(0x40000000);
+
+      should(leEventMasks()).deepEqual([0x5f]);
+    });
+
+    it('should count and drop reports that arrive while they are masked', () => {
+      const leAdvertisingReport = sinon.spy();
+      hci.on('leAdvertisingReport', leAdvertisingReport);
+
+      hci.setScanEnabled(false, true);
+      hci.onSocketData(advertisingReport);
+      hci.onSocketData(advertisingReport);
+
+      assert.notCalled(leAdvertisingReport);
+      should(hci.getEventFilterStats()).containEql({ updates: 1, suppressed: 2, suppressedSinceUpdate: 2 });
+
+      hci.setScanEnabled(true, false);
+      hci.onSocketData(advertisingReport);
+
+      assert.calledOnce(leAdvertisingReport);
+      should(hci.getEventFilterStats()).containEql({ updates: 2, suppressed: 2, suppressedSinceUpdate: 0 });
+    });
+
+    it('should follow scans started by another user of the adapter', () => {
+      hci.setScanEnabled(false, true);
+      hci.onSocketData(Buffer.from([0x01, 0x0c, 0x20, 0x02, 0x01, 0x00]));
+
+      should(hci._leEventsSuppressed & 0x02).equal(0);
+    });
+
+    it('should keep the full mask when the adaptive filter is off', () => {
+      hci = new Hci({ userChannel: true, commandFlowControl: false, adaptiveEventFilter: false });
+      hci.setLeEventMask();
+      hci.setScanEnabled(false, true);
+
+      should(leEventMasks()).deepEqual([0x5f]);
+      should(hci.getEventFilterStats().updates).equal(0);
+    });
+  });
+
+  describe('decoding drivers', () => {
+    beforeEach(() => {
+      hci._socket.setDecoding = sinon.stub();
+      hci.pollIsDevUp = sinon.spy();
+      hci._bound = true;
+    });
+
+    it('should take decoded reports and PDUs from drivers that offer them', () => {
+      hci._maxSduLength = 1024;
+      hci.init();
+
+      assert.calledOnceWithExactly(hci._socket.setDecoding, true, 1024);
+      assert.calledWithMatch(hci._socket.on, 'advertisingReport', sinon.match.func);
+      assert.calledWithMatch(hci._socket.on, 'extendedAdvertisingReport', sinon.match.func);
+      assert.calledWithMatch(hci._socket.on, 'aclData', sinon.match.func);
+      assert.calledWithMatch(hci._socket.on, 'aclDataDropped', sinon.match.func);
+    });
+
+    it('should ask for raw packets while capturing', () => {
+      hci._btsnoop = { open: sinon.spy(), write: sinon.spy() };
+      hci.init();
+
+      assert.calledOnceWithExactly(hci._socket.setDecoding, false, 4096);
+    });
+
+    it('should emit decoded reports like parsed ones, unless they are masked', () => {
+      const eir = Buffer.from([0x02, 0x01, 0x06]);
+      const leAdvertisingReport = sinon.spy();
+      const leExtendedAdvertisingReport = sinon.spy();
+      hci.on('leAdvertisingReport', leAdvertisingReport);
+      hci.on('leExtendedAdvertisingReport', leExtendedAdvertisingReport);
+
+      hci.onDecodedAdvertisingReport(0x00, 0x010203040506, 'random', -60, eir);
+      hci.onDecodedExtendedAdvertisingReport(0x13, 0x010203040506, 'public', 0x7f, -61, eir, 0x03, 0x0050);
+
+      assert.calledOnceWithExactly(leAdvertisingReport, 0, 0x00, 0x010203040506, 'random', eir, -60);
+      assert.calledOnceWithExactly(leExtendedAdvertisingReport, 0, 0x13, 0x010203040506, 'public', 0x7f, -61, eir, 0x03, 100);
+
+      hci.setScanEnabled(false, true);
+      hci.onDecodedAdvertisingReport(0x00, 0x010203040506, 'random', -60, eir);
+
+      assert.calledOnce(leAdvertisingReport);
+      should(hci.getEventFilterStats().suppressed).equal(1);
+    });
+
+    it('should emit decoded PDUs as aclDataPkt', () => {
+      const aclDataPkt = sinon.spy();
+      hci.on('aclDataPkt', aclDataPkt);
+
+      hci.onDecodedAclData(0x40, 0x04, Buffer.from([0x1b]));
+
+      assert.calledOnceWithExactly(aclDataPkt, 0x40, 0x04, Buffer.from([0x1b]));
+    });
+  });
+
+  describe('fast start', () => {
+    const LOCAL_VERSION = Buffer.from([0x0b, 0x00, 0x00, 0x0b, 0xf1, 0x05, 0x00, 0x00]);
+    const BD_ADDR = Buffer.from([0x00, 0x53, 0x00, 0x5e, 0x00, 0x00]);
+    const KEY = '00:00:5e:00:53:00/0b00000bf1050000';
+
+    const cmdComplete = (cmd, result = Buffer.alloc(0)) => {
+      const event = Buffer.alloc(7 + result.length);
+      event.writeUInt8(0x04, 0); // HCI_EVENT_PKT
+      event.writeUInt8(0x0e, 1); // EVT_CMD_COMPLETE
+      event.writeUInt8(4 + result.length, 2);
+      event.writeUInt8(1, 3);
+      event.writeUInt16LE(cmd, 4);
+      event.writeUInt8(0, 6);
+      result.copy(event, 7);
+      return event;
+    };
+    const written = () => hci._socket.write.args.map(([packet]) => packet.readUInt16LE(1));
+    const settle = () => new Promise(resolve => setImmediate(resolve));
+
+    let cache;
+    let stateChange;
+
+    beforeEach(() => {
+      cache = { expected: sinon.stub().returns(null), get: sinon.stub().returns(null), set: sinon.spy() };
+      stateChange = sinon.spy();
+      hci = new Hci({ fastStart: true, skipReset: true, capabilityCache: false });
+      hci._capabilityCache = cache;
+      hci.on('stateChange', stateChange);
+    });
+
+    const configure = async () => {
+      hci.onSocketData(cmdComplete(0x0c01));
+      hci.onSocketData(cmdComplete(0x2001));
+      hci.onSocketData(cmdComplete(0x0c6d));
+      hci.onSocketData(cmdComplete(0x200c));
+      hci.onSocketData(cmdComplete(0x200b));
+      await settle();
+    };
+
+    it('should send every read together on a cold start and cache what it read', async () => {
+      const started = hci.fastStart();
+      hci.onSocketData(cmdComplete(0x0c03));
+      await settle();
+
+      should(written()).deepEqual([0x0c03, 0x1001, 0x1009, 0x2003, 0x2002]);
+
+      hci.onSocketData(cmdComplete(0x1001, LOCAL_VERSION));
+      hci.onSocketData(cmdComplete(0x1009, BD_ADDR));
+      hci.onSocketData(cmdComplete(0x2003, Buffer.from([0x00, 0x08, 0, 0, 0, 0, 0, 0])));
+      hci.onSocketData(cmdComplete(0x2002, Buffer.from([0xfb, 0x00, 0x08])));
+      await settle();
+
+      should(written().slice(5)).deepEqual([0x0c01, 0x2001, 0x0c6d, 0x200c, 0x200b]);
+      should(hci._supportsCodedPhy).be.true();
+
+      await configure();
+      await started;
+
+      assert.calledWith(stateChange, 'poweredOn');
+      assert.calledOnceWithExactly(cache.set, 0, {
+        key: KEY,
+        leFeatures: '0008000000000000',
+        aclBuffers: { length: 251, num: 8 },
+        maxDataLength: null,
+        clean: false
+      });
+    });
+
+    it('should skip the reset and the capability reads when the controller is known', async () => {
+      const entry = {
+        key: KEY,
+        leFeatures: '2000000000000000',
+        aclBuffers: { length: 251, num: 8 },
+        maxDataLength: { txOctets: 251, txTime: 2120 },
+        clean: true
+      };
+      cache.expected.returns(entry);
+      cache.get.returns(entry);
+
+      const started = hci.fastStart();
+      await settle();
+
+      should(written()).deepEqual([0x1001, 0x1009]);
+
+      hci.onSocketData(cmdComplete(0x1001, LOCAL_VERSION));
+      hci.onSocketData(cmdComplete(0x1009, BD_ADDR));
+      await settle();
+      await configure();
+      await started;
+
+      should(written().slice(2)).deepEqual([0x0c01, 0x2001, 0x0c6d, 0x200c, 0x200b]);
+      should(hci._supportsDataLengthExtension).be.true();
+      should(hci._aclBuffers).deepEqual({ length: 251, num: 8 });
+      should(hci._maxDataLength).deepEqual({ txOctets: 251, txTime: 2120 });
+      assert.calledWith(stateChange, 'poweredOn');
+      should(cache.set.lastCall.args[1].clean).be.false();
+    });
+
+    it('should read the capabilities when the firmware changed', async () => {
+      cache.expected.returns({ key: '00:00:5e:00:53:00/0a00000bf1050000', clean: true });
+
+      const started = hci.fastStart();
+      await settle();
+      hci.onSocketData(cmdComplete(0x1001, LOCAL_VERSION));
+      hci.onSocketData(cmdComplete(0x1009, BD_ADDR));
+      await settle();
+
+      should(written()).deepEqual([0x1001, 0x1009, 0x2003, 0x2002]);
+
+      hci.onSocketData(cmdComplete(0x2003, Buffer.alloc(8)));
+      hci.onSocketData(cmdComplete(0x2002, Buffer.from([0xfb, 0x00, 0x08])));
+      await settle();
+      await configure();
+      await started;
+
+      should(cache.set.lastCall.args[1].key).equal(KEY);
+    });
+
+    it('should remember whether the controller was left idle', () => {
+      hci._socket.stop = sinon.spy();
+      hci._capabilities = { key: KEY, clean: false };
+      hci._aclConnections.set(0x40, { pending: 0 });
+
+      hci.stop();
+
+      assert.calledOnceWithExactly(cache.set, 0, { key: KEY, clean: false });
+
+      hci._capabilities = { key: KEY, clean: false };
+      hci.stop();
+
+      should(cache.set.lastCall.args[1].clean).be.true();
+    });
+  });
+
   describe('data length extension', () => {
     const LE_READ_LOCAL_SUPPORTED_FEATURES = 0x2003;
     const LE_READ_MAX_DATA_LENGTH_CMD = 0x202f;
@@ -878,6 +1319,206 @@ describe('hci-socket hci', () => {
       hci.setScanParameters(0x2222, 0x3333);
       assert.calledOnceWithExactly(hci._socket.write, Buffer.from([1, 0x41, 0x20, 0x0d, 0x00, 0x00, 0x05, 0x01, 0x22, 0x22, 0x33, 0x33, 0x01, 0x22, 0x22, 0x33, 0x33]));
     });
+
+    it('should scan passively', () => {
+      hci.setScanType(false);
+      hci.setScanParameters();
+      assert.calledOnceWithExactly(hci._socket.write, Buffer.from([1, 0x0b, 0x20, 7, 0, 0x12, 0, 0x12, 0, 0, 0]));
+    });
+
+    it('should scan only the phys asked for (extended with coded phy support)', () => {
+      hci._isExtended = true;
+      hci._supportsCodedPhy = true;
+      hci.setScanType(false);
+      hci.setScanPhys(['coded']);
+      hci.setScanParameters(0x0020, 0x0010);
+      assert.calledOnceWithExactly(hci._socket.write, Buffer.from([1, 0x41, 0x20, 0x08, 0x00, 0x00, 0x04, 0x00, 0x20, 0x00, 0x10, 0x00]));
+    });
+
+    it('should fall back to 1m when only coded is asked for but not supported', () => {
+      hci._isExtended = true;
+      hci._supportsCodedPhy = false;
+      hci.setScanType(false);
+      hci.setScanPhys(['coded']);
+      hci.setScanParameters(0x0020, 0x0010);
+      assert.calledOnceWithExactly(hci._socket.write, Buffer.from([1, 0x41, 0x20, 0x08, 0x00, 0x00, 0x01, 0x00, 0x20, 0x00, 0x10, 0x00]));
+    });
+  });
+
+  describe('filter accept list', () => {
+    it('should scan with the accept list as filter policy', () => {
+      hci.setScanFilterPolicy(true);
+      hci.setScanParameters();
+      assert.calledOnceWithExactly(hci._socket.write, Buffer.from([1, 0x0b, 0x20, 7, 1, 0x12, 0, 0x12, 0, 0, 1]));
+    });
+
+    it('should scan with the accept list as filter policy (extended)', () => {
+      hci._isExtended = true;
+      hci.setScanFilterPolicy(true);
+      hci.setScanParameters();
+      assert.calledOnceWithExactly(hci._socket.write, Buffer.from([1, 0x41, 0x20, 0x08, 0x00, 0x01, 0x01, 0x01, 0x12, 0x00, 0x12, 0x00]));
+    });
+
+    it('should read the accept list size', async () => {
+      const size = hci.readAcceptListSize();
+      assert.calledOnceWithExactly(hci._socket.write, Buffer.from([1, 0x0f, 0x20, 0]));
+
+      hci.completeCommand(0x200f, 1, 0, Buffer.from([0x08]));
+      should(await size).equal(8);
+    });
+
+    it('should add and remove devices', () => {
+      hci.addToAcceptList('11:22:33:44:55:66', 'random');
+      hci.removeFromAcceptList('aa:bb:cc:dd:ee:ff', 'public');
+      hci.clearAcceptList();
+
+      should(hci._socket.write.args.map(args => args[0])).deepEqual([
+        Buffer.from([1, 0x11, 0x20, 7, 1, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11]),
+        Buffer.from([1, 0x12, 0x20, 7, 0, 0xff, 0xee, 0xdd, 0xcc, 0xbb, 0xaa]),
+        Buffer.from([1, 0x10, 0x20, 0])
+      ]);
+    });
+
+    it('should only send the difference when loading a list', () => {
+      const a = { address: '11:22:33:44:55:66', addressType: 'public' };
+      const b = { address: '11:22:33:44:55:77', addressType: 'random' };
+      const c = { address: '11:22:33:44:55:88', addressType: 'public' };
+
+      hci.loadAcceptList([a, b]);
+      hci._socket.write.resetHistory();
+      hci.loadAcceptList([b, c]);
+
+      should(hci._socket.write.args.map(args => args[0])).deepEqual([
+        Buffer.from([1, 0x12, 0x20, 7, 0, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11]),
+        Buffer.from([1, 0x11, 0x20, 7, 0, 0x88, 0x55, 0x44, 0x33, 0x22, 0x11])
+      ]);
+      should([...hci._acceptList.values()]).deepEqual([b, c]);
+    });
+
+    it('should clear what an earlier run may have left before the first load after a start', () => {
+      const a = { address: '11:22:33:44:55:66', addressType: 'public' };
+      const add = Buffer.from([1, 0x11, 0x20, 7, 0, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11]);
+      const clear = Buffer.from([1, 0x10, 0x20, 0]);
+      hci._socket.stop = sinon.spy();
+
+      // Stopping rejects the commands still pending
+      hci.loadAcceptList([a]).catch(() => {});
+      hci.stop();
+      hci.loadAcceptList([a]);
+
+      should(hci._socket.write.args.map(args => args[0])).deepEqual([clear, add, clear, add]);
+    });
+
+    it('should not clear a list HCI_Reset emptied', () => {
+      hci.reset();
+      hci._socket.write.resetHistory();
+      hci.loadAcceptList([{ address: '11:22:33:44:55:66', addressType: 'public' }]);
+
+      should(hci._socket.write.args.map(args => args[0])).deepEqual([
+        Buffer.from([1, 0x11, 0x20, 7, 0, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11])
+      ]);
+    });
+  });
+
+  describe('periodic advertising sync', () => {
+    const ADDRESS = 0x112233445566;
+    // Sync handle 1 with 11:22:33:44:55:66 (random), SID 3, on LE 1M, every 100 ms
+    const established = Buffer.from([0x01, 0x00, 0x03, 0x01, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11, 0x01, 0x50, 0x00, 0x00]);
+
+    const establish = () => {
+      hci.createPeriodicSync(ADDRESS, 'random', 0x03);
+      hci.processLeMetaEvent(0x0e, 0x00, established);
+    };
+
+    it('should create, cancel and terminate syncs', () => {
+      hci.createPeriodicSync(ADDRESS, 'random', 0x03, 1, 2000);
+      hci.cancelPeriodicSync();
+      hci.terminatePeriodicSync(0x0001);
+
+      should(hci._socket.write.args.map(args => args[0])).deepEqual([
+        Buffer.from([1, 0x44, 0x20, 0x0e, 0x00, 0x03, 0x01, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11, 0x01, 0x00, 0xc8, 0x00, 0x00]),
+        Buffer.from([1, 0x45, 0x20, 0]),
+        Buffer.from([1, 0x46, 0x20, 0x02, 0x01, 0x00])
+      ]);
+    });
+
+    it('should keep the sync timeout within what the controller takes', () => {
+      hci.createPeriodicSync(ADDRESS, 'public', 0x00, 0, 50);
+      hci.createPeriodicSync(ADDRESS, 'public', 0x00, 0, 1000000);
+
+      should(hci._socket.write.firstCall.args[0].readUInt16LE(15)).equal(0x000a);
+      should(hci._socket.write.secondCall.args[0].readUInt16LE(15)).equal(0x4000);
+    });
+
+    it('should emit the syncs it asked for once established', () => {
+      const callback = sinon.spy();
+      hci.on('lePeriodicSyncEstablished', callback);
+
+      hci.processLeMetaEvent(0x0e, 0x00, established);
+      assert.notCalled(callback);
+
+      establish();
+
+      assert.calledOnceWithExactly(callback, 0x00, 0x0001, ADDRESS, 'random', 0x03, 0x01, 100);
+      should(hci._periodicSyncs.has(0x0001)).be.true();
+      should(hci._pendingPeriodicSync).equal(null);
+    });
+
+    it('should report a sync the controller refused as failed', () => {
+      const callback = sinon.spy();
+      hci.on('lePeriodicSyncEstablished', callback);
+
+      hci.createPeriodicSync(ADDRESS, 'random', 0x03);
+      hci.processCmdStatusEvent(0x2044, 0x07);
+
+      assert.calledOnceWithExactly(callback, 0x07, undefined, ADDRESS, 'random', 0x03, undefined, undefined);
+      should(hci._pendingPeriodicSync).equal(null);
+    });
+
+    it('should emit periodic advertising reports and lost syncs', () => {
+      const report = sinon.spy();
+      const lost = sinon.spy();
+      hci.on('lePeriodicAdvertisingReport', report);
+      hci.on('lePeriodicSyncLost', lost);
+      establish();
+
+      hci.processLeMetaEvent(0x0f, 0x01, Buffer.from([0x00, 0x7f, 0xc4, 0xff, 0x01, 0x02, 0xaa, 0xbb]));
+      hci.processLeMetaEvent(0x0f, 0x02, Buffer.from([0x00, 0x7f, 0xc4, 0xff, 0x00, 0x00]));
+      hci.processLeMetaEvent(0x10, 0x01, Buffer.from([0x00]));
+      hci.processLeMetaEvent(0x0f, 0x01, Buffer.from([0x00, 0x7f, 0xc4, 0xff, 0x00, 0x00]));
+
+      assert.calledOnceWithExactly(report, 0x0001, 127, -60, 0x01, Buffer.from([0xaa, 0xbb]));
+      assert.calledOnceWithExactly(lost, 0x0001);
+      should(hci._periodicSyncs.size).equal(0);
+    });
+
+    it('should not reset the controller while a sync is kept', () => {
+      hci.setEventMask = sinon.spy();
+      hci.setLeEventMask = sinon.spy();
+      hci.readLocalVersion = sinon.spy();
+      hci.readBdAddr = sinon.spy();
+      establish();
+      hci._socket.write.resetHistory();
+
+      hci.reset();
+
+      assert.notCalled(hci._socket.write);
+      assert.calledOnceWithExactly(hci.setEventMask);
+    });
+
+    it('should enable periodic events on the controller only while syncs are wanted', () => {
+      const LE_SET_EVENT_MASK = 0x2001;
+      hci = new Hci({ userChannel: true, commandFlowControl: false, extended: true });
+      hci.setLeEventMask();
+
+      establish();
+      hci.processLeMetaEvent(0x10, 0x01, Buffer.from([0x00]));
+
+      should(hci._socket.write.args
+        .map(([packet]) => packet)
+        .filter(packet => packet.readUInt16LE(1) === LE_SET_EVENT_MASK)
+        .map(packet => packet.readUInt32LE(4))).deepEqual([0xff5f, 0xe301, 0x0301]);
+    });
   });
 
   describe('setScanEnabled', () => {
@@ -902,6 +1543,38 @@ describe('hci-socket hci', () => {
       hci.setScanEnabled(true, true);
       assert.calledOnceWithExactly(hci._socket.write, Buffer.from([1, 0x42, 0x20, 0x06, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00]));
     });
+
+    it('should reset the duplicate filter every period (extended)', () => {
+      hci._isExtended = true;
+      should(hci.canRefreshScanDuplicates(1000)).be.false();
+      should(hci.canRefreshScanDuplicates(2560)).be.true();
+
+      hci.setScanEnabled(true, true, 2560);
+      // 2 periods of 1.28 s, scanning for 2.55 s of them
+      assert.calledOnceWithExactly(hci._socket.write, Buffer.from([1, 0x42, 0x20, 0x06, 0x01, 0x02, 0xff, 0x00, 0x02, 0x00]));
+    });
+
+    it('should leave the duplicate filter refresh to the host (legacy)', () => {
+      should(hci.canRefreshScanDuplicates(2560)).be.false();
+
+      hci.setScanEnabled(true, true, 2560);
+      assert.calledOnceWithExactly(hci._socket.write, Buffer.from([1, 0x0c, 0x20, 2, 1, 1]));
+    });
+
+    it('should toggle scanning to empty the duplicate filter without touching the event filters', () => {
+      hci = new Hci({ userChannel: true, commandFlowControl: false });
+      hci.setLeEventMask();
+      hci.setScanEnabled(true, true);
+      hci._socket.write.resetHistory();
+
+      hci.refreshScanDuplicates();
+
+      should(hci._socket.write.args).deepEqual([
+        [Buffer.from([1, 0x0c, 0x20, 2, 0, 1])],
+        [Buffer.from([1, 0x0c, 0x20, 2, 1, 1])]
+      ]);
+      should(hci._scanEnabled).be.true();
+    });
   });
 
   describe('createLeConn', () => {
@@ -1012,7 +1685,7 @@ describe('hci-socket hci', () => {
     assert.calledOnceWithExactly(hci._socket.write, Buffer.from([0x01, 0x05, 0x14, 0x02, 0x34, 0x12]));
   });
 
-  it('should writeAclDataPkt - push in aclQueue and flushAcl', async () => {
+  it('should writeAclDataPkt - push in aclScheduler and flushAcl', async () => {
     hci.flushAcl = sinon.spy();
     hci._aclBuffers = [1, 2, 3, 4, 5, 6, 7, 8];
 
@@ -1023,16 +1696,48 @@ describe('hci-socket hci', () => {
 
     assert.calledOnceWithExactly(hci.flushAcl);
 
-    should(hci._aclQueue).deepEqual([
-      {
-        handle: 4660,
-        packet: Buffer.from([0x02, 0x34, 0x12, 0x08, 0x00, 0x07, 0x00, 0x59, 0x01, 0x05, 0x06, 0x07, 0x08])
-      },
-      {
-        handle: 4660,
-        packet: Buffer.from([0x02, 0x34, 0x12, 0x03, 0x00, 0x09, 0x0a, 0x0b])
-      }
-    ]);
+    should(hci._aclScheduler.queued(4660)).equal(2);
+    should(hci._aclScheduler.shift()).deepEqual({
+      handle: 4660,
+      packet: Buffer.from([0x02, 0x34, 0x12, 0x08, 0x00, 0x07, 0x00, 0x59, 0x01, 0x05, 0x06, 0x07, 0x08])
+    });
+    should(hci._aclScheduler.shift()).deepEqual({
+      handle: 4660,
+      packet: Buffer.from([0x02, 0x34, 0x12, 0x03, 0x00, 0x09, 0x0a, 0x0b])
+    });
+  });
+
+  it('should writeAclDataPkt - fragment a long pdu into views of one buffer', async () => {
+    hci.flushAcl = sinon.spy();
+    hci.setAclBuffers(27, 4);
+
+    const data = Buffer.alloc(60);
+    for (let i = 0; i < data.length; i++) {
+      data[i] = i;
+    }
+    await hci.writeAclDataPkt(0x0040, 0x0004, data);
+
+    const packets = [hci._aclScheduler.shift(), hci._aclScheduler.shift(), hci._aclScheduler.shift()].map(({ packet }) => packet);
+    should(hci._aclScheduler.length).equal(0);
+
+    should(packets.map(packet => packet.subarray(0, 5).toString('hex'))).deepEqual(['0240001b00', '0240101b00', '0240100a00']);
+    should(packets[0].subarray(5, 9).toString('hex')).equal('3c000400');
+    should(Buffer.concat([packets[0].subarray(9), packets[1].subarray(5), packets[2].subarray(5)])).deepEqual(data);
+    should(packets[1].buffer).equal(packets[0].buffer);
+    should(packets[2].buffer).equal(packets[0].buffer);
+  });
+
+  it('should hand a flushed batch to drivers that take one', async () => {
+    hci._socket.writev = sinon.spy();
+    hci._aclConnections.set(0x0040, { pending: 0 });
+    hci.setAclBuffers(27, 4);
+
+    await hci.writeAclDataPkt(0x0040, 0x0004, Buffer.alloc(60));
+
+    assert.notCalled(hci._socket.write);
+    assert.calledOnce(hci._socket.writev);
+    should(hci._socket.writev.firstCall.args[0]).have.length(3);
+    should(hci._aclPending).equal(3);
   });
 
   it('should not produce an unhandled rejection when stop() clears _aclConnections while writeAclDataPkt is in flight', async () => {
@@ -1115,6 +1820,13 @@ describe('hci-socket hci', () => {
       return Buffer.concat([header, cmdBuf, Buffer.from([status]), result]);
     };
     const wroteCmd = (cmd) => hci._socket.write.args.some(([buf]) => buf.readUInt16LE(1) === cmd);
+    // The user channel holds commands until the controller returns a credit; a NOP
+    // Command Complete hands one back without completing any command.
+    const grantCreditsUntil = (cmd) => {
+      for (let i = 0; i < 32 && !wroteCmd(cmd); i++) {
+        hci.onSocketData(buildCmdCompleteEvent(0x0000, 0, Buffer.alloc(0)));
+      }
+    };
     const RESET_CMD = 3075;
     const LE_READ_LOCAL_SUPPORTED_FEATURES = 8195;
     const LE_READ_BUFFER_SIZE_CMD = 8194;
@@ -1125,9 +1837,11 @@ describe('hci-socket hci', () => {
     should(wroteCmd(LE_READ_LOCAL_SUPPORTED_FEATURES)).be.false();
     hci.onSocketData(buildCmdCompleteEvent(RESET_CMD, 0, Buffer.alloc(0)));
 
+    grantCreditsUntil(LE_READ_LOCAL_SUPPORTED_FEATURES);
     should(wroteCmd(LE_READ_LOCAL_SUPPORTED_FEATURES)).be.true();
     hci.onSocketData(buildCmdCompleteEvent(LE_READ_LOCAL_SUPPORTED_FEATURES, 0, Buffer.alloc(8)));
 
+    grantCreditsUntil(LE_READ_BUFFER_SIZE_CMD);
     should(wroteCmd(LE_READ_BUFFER_SIZE_CMD)).be.true();
     hci.onSocketData(buildCmdCompleteEvent(LE_READ_BUFFER_SIZE_CMD, 0, Buffer.from([0x10, 0x00, 5])));
 
@@ -1148,6 +1862,8 @@ describe('hci-socket hci', () => {
   });
 
   describe('flushAcl', () => {
+    const enqueue = (queue) => queue.forEach(({ handle, packet }) => hci._aclScheduler.push(handle, [packet]));
+
     it('should not write flush on no pending connections', () => {
       const queue = [
         {
@@ -1159,25 +1875,25 @@ describe('hci-socket hci', () => {
           packet: Buffer.from([0x02, 0x34, 0x12, 0x03, 0x00, 0x09, 0x0a, 0x0b])
         }
       ];
-      hci._aclQueue = [...queue];
+      enqueue(queue);
 
       hci.flushAcl();
 
       assert.notCalled(hci._socket.write);
-      should(hci._aclQueue).deepEqual(queue);
+      should(hci._aclScheduler.length).equal(queue.length);
     });
 
     it('should not write flush on empty queue', () => {
-      hci._aclQueue = [];
       hci._aclConnections.set(4660, { pending: 3 });
       hci._aclConnections.set(4661, { pending: 2 });
+      hci._aclPending = 5;
       hci._aclBuffers = { num: 12 };
 
       hci.flushAcl();
 
       assert.notCalled(hci._socket.write);
 
-      should(hci._aclQueue).be.empty();
+      should(hci._aclScheduler.length).equal(0);
     });
 
     it('should not write flush on not enough pending connections', () => {
@@ -1191,15 +1907,16 @@ describe('hci-socket hci', () => {
           packet: Buffer.from([0x02, 0x34, 0x12, 0x03, 0x00, 0x09, 0x0a, 0x0b])
         }
       ];
-      hci._aclQueue = [...queue];
+      enqueue(queue);
       hci._aclConnections.set(4660, { pending: 3 });
       hci._aclConnections.set(4661, { pending: 2 });
+      hci._aclPending = 5;
       hci._aclBuffers = { num: 1 };
 
       hci.flushAcl();
 
       assert.notCalled(hci._socket.write);
-      should(hci._aclQueue).deepEqual(queue);
+      should(hci._aclScheduler.length).equal(queue.length);
     });
 
     it('should write flush', async () => {
@@ -1217,9 +1934,10 @@ describe('hci-socket hci', () => {
           packet: Buffer.from([0x02])
         }
       ];
-      hci._aclQueue = [...queue];
+      enqueue(queue);
       hci._aclConnections.set(4660, { pending: 3 });
       hci._aclConnections.set(4661, { pending: 2 });
+      hci._aclPending = 5;
       hci._aclBuffers = { num: 12 };
 
       await hci.flushAcl();
@@ -1229,9 +1947,10 @@ describe('hci-socket hci', () => {
       assert.calledWithExactly(hci._socket.write, Buffer.from([0x02, 0x34, 0x12, 0x03, 0x00, 0x09, 0x0a, 0x0b]));
       assert.calledWithExactly(hci._socket.write, Buffer.from([0x02]));
 
-      should(hci._aclQueue).be.empty();
+      should(hci._aclScheduler.length).equal(0);
       should(hci._aclConnections.get(4660).pending).equal(5);
       should(hci._aclConnections.get(4661).pending).equal(3);
+      should(hci._aclPending).equal(8);
     });
 
     it('should skip a queued packet whose connection is gone, without throwing, and keep flushing the rest', async () => {
@@ -1239,14 +1958,14 @@ describe('hci-socket hci', () => {
         { handle: 4660, packet: Buffer.from([0x02, 0xaa]) },
         { handle: 4661, packet: Buffer.from([0x02, 0xbb]) }
       ];
-      hci._aclQueue = [...queue];
+      enqueue(queue);
       hci._aclConnections.set(4661, { pending: 0 });
       hci._aclBuffers = { num: 12 };
 
       await hci.flushAcl();
 
       assert.calledOnceWithExactly(hci._socket.write, Buffer.from([0x02, 0xbb]));
-      should(hci._aclQueue).be.empty();
+      should(hci._aclScheduler.length).equal(0);
       should(hci._aclConnections.get(4661).pending).equal(1);
     });
 
@@ -1275,6 +1994,27 @@ describe('hci-socket hci', () => {
       should(hci._aclConnections.has(4660)).be.false();
     });
 
+    it('should let an ATT request on another connection overtake a write without response backlog', async () => {
+      hci._aclConnections.set(0x0001, { pending: 0 });
+      hci._aclConnections.set(0x0002, { pending: 0 });
+      hci.setAclBuffers(27, 1);
+
+      for (let i = 0; i < 4; i++) {
+        await hci.writeAclDataPkt(0x0001, 0x0004, Buffer.from([0x52, 0x03, 0x00, i]));
+      }
+      await hci.writeAclDataPkt(0x0002, 0x0004, Buffer.from([0x0a, 0x03, 0x00]));
+      assert.calledOnce(hci._socket.write);
+
+      // EVT_NUMBER_OF_COMPLETED_PACKETS: one packet of handle 0x0001
+      hci.onSocketData(Buffer.from([0x04, 0x13, 0x05, 0x01, 0x01, 0x00, 0x01, 0x00]));
+      await new Promise(resolve => setImmediate(resolve));
+
+      assert.calledTwice(hci._socket.write);
+      should(hci._socket.write.secondCall.args[0].readUInt16LE(1) & 0x0fff).equal(0x0002);
+      should(hci._aclScheduler.queued(0x0001)).equal(3);
+      should(hci._aclPending).equal(1);
+    });
+
     it('should skip a queued packet whose connection is gone, without throwing, and keep draining the rest', async () => {
       const queue = [
         {
@@ -1286,14 +2026,14 @@ describe('hci-socket hci', () => {
           packet: Buffer.from([0x02, 0x34, 0x12, 0x08, 0x00, 0x07, 0x00, 0x59, 0x01, 0x05, 0x06, 0x07, 0x08])
         }
       ];
-      hci._aclQueue = [...queue];
+      enqueue(queue);
       hci._aclConnections.set(4660, { pending: 0 });
       hci._aclBuffers = { num: 12 };
 
       await hci.flushAcl();
 
       assert.calledOnceWithExactly(hci._socket.write, Buffer.from([0x02, 0x34, 0x12, 0x08, 0x00, 0x07, 0x00, 0x59, 0x01, 0x05, 0x06, 0x07, 0x08]));
-      should(hci._aclQueue).be.empty();
+      should(hci._aclScheduler.length).equal(0);
     });
   });
 
@@ -1332,11 +2072,12 @@ describe('hci-socket hci', () => {
       jest.spyOn(console, 'warn').mockImplementation(() => {});
       
       // Setup HCI's internal state for testing
-      hci._aclQueue = [...aclQueue];
+      aclQueue.forEach(({ handle, packet }) => hci._aclScheduler.push(handle, [packet]));
       hci._aclConnections = new Map();
       hci._aclConnections.set(4660, { pending: 3 });
       hci._aclConnections.set(4661, { pending: 2 });
-      hci._handleBuffers = {};
+      hci._aclPending = 5;
+      hci._handleBuffers = new Map();
   
       // Setup event listener callbacks as mocks
       disconnCompleteCallback = jest.fn();
@@ -1375,12 +2116,9 @@ describe('hci-socket hci', () => {
       expect(leScanEnableSetCmdCallback).not.toHaveBeenCalled();
   
       // HCI state checks
-      expect(hci._aclQueue).toEqual([
-        {
-          handle: 4661,
-          packet: Buffer.from([0x02])
-        }
-      ]);
+      expect(hci._aclScheduler.length).toEqual(1);
+      expect(hci._aclScheduler.queued(4661)).toEqual(1);
+      expect(hci._aclPending).toEqual(2);
       expect(Array.from(hci._aclConnections.keys())).toEqual([4661]);
       expect(hci._aclConnections.get(4661)).toEqual({ pending: 2 });
     });
@@ -1403,7 +2141,7 @@ describe('hci-socket hci', () => {
       expect(leScanEnableSetCmdCallback).not.toHaveBeenCalled();
   
       // HCI state checks
-      expect(hci._aclQueue).toEqual(aclQueue);
+      expect(hci._aclScheduler.length).toEqual(aclQueue.length);
       expect(Array.from(hci._aclConnections.keys())).toEqual(expect.arrayContaining([4660, 4661]));
       expect(hci._aclConnections.get(4660)).toEqual({ pending: 3 });
       expect(hci._aclConnections.get(4661)).toEqual({ pending: 2 });
@@ -1428,7 +2166,7 @@ describe('hci-socket hci', () => {
       expect(leScanEnableSetCmdCallback).not.toHaveBeenCalled();
   
       // HCI state checks
-      expect(hci._aclQueue).toEqual(aclQueue);
+      expect(hci._aclScheduler.length).toEqual(aclQueue.length);
       expect(Array.from(hci._aclConnections.keys())).toEqual(expect.arrayContaining([4660, 4661]));
       expect(hci._aclConnections.get(4660)).toEqual({ pending: 3 });
       expect(hci._aclConnections.get(4661)).toEqual({ pending: 2 });
@@ -1453,7 +2191,7 @@ describe('hci-socket hci', () => {
       expect(leScanEnableSetCmdCallback).not.toHaveBeenCalled();
   
       // HCI state checks
-      expect(hci._aclQueue).toEqual(aclQueue);
+      expect(hci._aclScheduler.length).toEqual(aclQueue.length);
       expect(Array.from(hci._aclConnections.keys())).toEqual(expect.arrayContaining([4660, 4661]));
       expect(hci._aclConnections.get(4660)).toEqual({ pending: 3 });
       expect(hci._aclConnections.get(4661)).toEqual({ pending: 2 });
@@ -1478,7 +2216,7 @@ describe('hci-socket hci', () => {
       expect(leScanEnableSetCmdCallback).not.toHaveBeenCalled();
   
       // HCI state checks
-      expect(hci._aclQueue).toEqual(aclQueue);
+      expect(hci._aclScheduler.length).toEqual(aclQueue.length);
       expect(Array.from(hci._aclConnections.keys())).toEqual(expect.arrayContaining([4660, 4661]));
       expect(hci._aclConnections.get(4660)).toEqual({ pending: 3 });
       expect(hci._aclConnections.get(4661)).toEqual({ pending: 2 });
@@ -1502,10 +2240,11 @@ describe('hci-socket hci', () => {
       expect(leScanEnableSetCmdCallback).not.toHaveBeenCalled();
   
       // HCI state checks
-      expect(hci._aclQueue).toEqual(aclQueue);
+      expect(hci._aclScheduler.length).toEqual(aclQueue.length);
       expect(Array.from(hci._aclConnections.keys())).toEqual(expect.arrayContaining([4660, 4661]));
       expect(hci._aclConnections.get(4660)).toEqual({ pending: 0 });
       expect(hci._aclConnections.get(4661)).toEqual({ pending: 2 });
+      expect(hci._aclPending).toEqual(2);
     });
   
     test('should do nothing - HCI_EVENT_PKT / unknown subEventType', () => {
@@ -1524,7 +2263,7 @@ describe('hci-socket hci', () => {
       expect(leScanEnableSetCmdCallback).not.toHaveBeenCalled();
   
       // HCI state checks
-      expect(hci._aclQueue).toEqual(aclQueue);
+      expect(hci._aclScheduler.length).toEqual(aclQueue.length);
       expect(Array.from(hci._aclConnections.keys())).toEqual(expect.arrayContaining([4660, 4661]));
       expect(hci._aclConnections.get(4660)).toEqual({ pending: 3 });
       expect(hci._aclConnections.get(4661)).toEqual({ pending: 2 });
@@ -1549,11 +2288,11 @@ describe('hci-socket hci', () => {
       expect(leScanEnableSetCmdCallback).not.toHaveBeenCalled();
   
       // HCI state checks
-      expect(hci._aclQueue).toEqual(aclQueue);
+      expect(hci._aclScheduler.length).toEqual(aclQueue.length);
       expect(Array.from(hci._aclConnections.keys())).toEqual(expect.arrayContaining([4660, 4661]));
       expect(hci._aclConnections.get(4660)).toEqual({ pending: 3 });
       expect(hci._aclConnections.get(4661)).toEqual({ pending: 2 });
-      expect(hci._handleBuffers).toEqual({});
+      expect(hci._handleBuffers.size).toEqual(0);
     });
   
     test('should register handle buffer - HCI_ACLDATA_PKT / ACL_START with incomplete data', () => {
@@ -1573,26 +2312,33 @@ describe('hci-socket hci', () => {
       expect(leScanEnableSetCmdCallback).not.toHaveBeenCalled();
   
       // HCI state checks
-      expect(hci._aclQueue).toEqual(aclQueue);
+      expect(hci._aclScheduler.length).toEqual(aclQueue.length);
       expect(Array.from(hci._aclConnections.keys())).toEqual(expect.arrayContaining([4660, 4661]));
       expect(hci._aclConnections.get(4660)).toEqual({ pending: 3 });
       expect(hci._aclConnections.get(4661)).toEqual({ pending: 2 });
       
       // Check buffer was created properly
-      expect(hci._handleBuffers[1266]).toEqual({
+      expect(hci._handleBuffers.get(1266)).toEqual({
         length: 3,
         cid: 2307,
-        data: expect.any(Buffer)
+        data: expect.any(Buffer),
+        offset: 2
       });
-      expect(Buffer.from(hci._handleBuffers[1266].data)).toEqual(Buffer.from([9, 8]));
+      expect(hci._handleBuffers.get(1266).data.length).toEqual(3);
+      expect(Buffer.from(hci._handleBuffers.get(1266).data.subarray(0, 2))).toEqual(Buffer.from([9, 8]));
     });
   
-    test('should do nothing - HCI_ACLDATA_PKT / ACL_CONT without existing buffer', () => {
+    test('should only report a drop - HCI_ACLDATA_PKT / ACL_CONT without existing buffer', () => {
       const eventType = 2;
       const subEventTypeP1 = 0xf2;
       const subEventTypeP2 = 0x14;
       const data = Buffer.from([eventType, subEventTypeP1, subEventTypeP2, 0x34, 0x12, 0x03, 0x00, 3, 9, 9, 8]);
+      const aclDataDroppedCallback = jest.fn();
+      hci.on('aclDataDropped', aclDataDroppedCallback);
+
       hci.onSocketData(data);
+
+      expect(aclDataDroppedCallback).toHaveBeenCalledWith(1266, 'continuation without start');
   
       // Not called
       expect(aclDataPktCallback).not.toHaveBeenCalled();
@@ -1604,11 +2350,11 @@ describe('hci-socket hci', () => {
       expect(leScanEnableSetCmdCallback).not.toHaveBeenCalled();
   
       // HCI state checks
-      expect(hci._aclQueue).toEqual(aclQueue);
+      expect(hci._aclScheduler.length).toEqual(aclQueue.length);
       expect(Array.from(hci._aclConnections.keys())).toEqual(expect.arrayContaining([4660, 4661]));
       expect(hci._aclConnections.get(4660)).toEqual({ pending: 3 });
       expect(hci._aclConnections.get(4661)).toEqual({ pending: 2 });
-      expect(hci._handleBuffers).toEqual({});
+      expect(hci._handleBuffers.size).toEqual(0);
     });
   
     test('should concat data - HCI_ACLDATA_PKT / ACL_CONT with existing buffer', () => {
@@ -1618,13 +2364,12 @@ describe('hci-socket hci', () => {
       const data = Buffer.from([eventType, subEventTypeP1, subEventTypeP2, 0x34, 0x12, 0x03, 0x00, 3, 9, 9, 8]);
   
       // Setup pre-existing buffer
-      hci._handleBuffers = {
-        1266: {
-          length: 3,
-          cid: 2307,
-          data: Buffer.from([3, 4])
-        }
-      };
+      hci._handleBuffers.set(1266, {
+        length: 10,
+        cid: 2307,
+        data: Buffer.from([3, 4, 0, 0, 0, 0, 0, 0, 0, 0]),
+        offset: 2
+      });
   
       hci.onSocketData(data);
   
@@ -1638,23 +2383,17 @@ describe('hci-socket hci', () => {
       expect(leScanEnableSetCmdCallback).not.toHaveBeenCalled();
   
       // HCI state checks
-      expect(hci._aclQueue).toEqual(aclQueue);
+      expect(hci._aclScheduler.length).toEqual(aclQueue.length);
       expect(Array.from(hci._aclConnections.keys())).toEqual(expect.arrayContaining([4660, 4661]));
       expect(hci._aclConnections.get(4660)).toEqual({ pending: 3 });
       expect(hci._aclConnections.get(4661)).toEqual({ pending: 2 });
       
       // Check buffer was updated properly
-      expect(hci._handleBuffers).toEqual({
-        1266: {
-          length: 3,
-          cid: 2307,
-          data: expect.any(Buffer)
-        }
-      });
+      expect(hci._handleBuffers.get(1266).offset).toEqual(8);
       
       // Check buffer contents
-      const bufferData = hci._handleBuffers[1266].data;
-      expect(Buffer.from(bufferData)).toEqual(Buffer.from([3, 4, 3, 0, 3, 9, 9, 8]));
+      const bufferData = hci._handleBuffers.get(1266).data;
+      expect(Buffer.from(bufferData.subarray(0, 8))).toEqual(Buffer.from([3, 4, 3, 0, 3, 9, 9, 8]));
     });
   
     test('should concat data and emit aclDataPkt - HCI_ACLDATA_PKT / ACL_CONT when complete', () => {
@@ -1664,13 +2403,12 @@ describe('hci-socket hci', () => {
       const data = Buffer.from([eventType, subEventTypeP1, subEventTypeP2, 0x34, 0x12, 0x03, 0x00, 3, 9, 9, 8]);
   
       // Setup pre-existing buffer with enough expected length to trigger completion
-      hci._handleBuffers = {
-        1266: {
-          length: 8,
-          cid: 2307,
-          data: Buffer.from([3, 4])
-        }
-      };
+      hci._handleBuffers.set(1266, {
+        length: 8,
+        cid: 2307,
+        data: Buffer.from([3, 4, 0, 0, 0, 0, 0, 0]),
+        offset: 2
+      });
   
       hci.onSocketData(data);
   
@@ -1694,15 +2432,61 @@ describe('hci-socket hci', () => {
       expect(leScanEnableSetCmdCallback).not.toHaveBeenCalled();
   
       // HCI state checks
-      expect(hci._aclQueue).toEqual(aclQueue);
+      expect(hci._aclScheduler.length).toEqual(aclQueue.length);
       expect(Array.from(hci._aclConnections.keys())).toEqual(expect.arrayContaining([4660, 4661]));
       expect(hci._aclConnections.get(4660)).toEqual({ pending: 3 });
       expect(hci._aclConnections.get(4661)).toEqual({ pending: 2 });
       
       // Buffer should be emptied after processing
-      expect(hci._handleBuffers).toEqual({});
+      expect(hci._handleBuffers.size).toEqual(0);
     });
   
+    test('should drop and report a continuation that overruns the pdu length - HCI_ACLDATA_PKT / ACL_CONT', () => {
+      const aclDataDroppedCallback = jest.fn();
+      hci.on('aclDataDropped', aclDataDroppedCallback);
+
+      // start of a 4 byte pdu with 2 bytes, then 3 more
+      hci.onSocketData(Buffer.from([0x02, 0xf2, 0x24, 0x06, 0x00, 0x04, 0x00, 0x04, 0x00, 1, 2]));
+      hci.onSocketData(Buffer.from([0x02, 0xf2, 0x14, 0x03, 0x00, 3, 4, 5]));
+
+      expect(aclDataPktCallback).not.toHaveBeenCalled();
+      expect(aclDataDroppedCallback).toHaveBeenCalledWith(1266, 'pdu overrun');
+      expect(hci._handleBuffers.size).toEqual(0);
+    });
+
+    test('should drop an incomplete pdu when a new one starts - HCI_ACLDATA_PKT / ACL_START', () => {
+      const aclDataDroppedCallback = jest.fn();
+      hci.on('aclDataDropped', aclDataDroppedCallback);
+
+      hci.onSocketData(Buffer.from([0x02, 0xf2, 0x24, 0x06, 0x00, 0x04, 0x00, 0x04, 0x00, 1, 2]));
+      hci.onSocketData(Buffer.from([0x02, 0xf2, 0x24, 0x06, 0x00, 0x02, 0x00, 0x04, 0x00, 7, 8]));
+
+      expect(aclDataDroppedCallback).toHaveBeenCalledWith(1266, 'incomplete pdu');
+      expect(aclDataPktCallback).toHaveBeenCalledWith(1266, 4, Buffer.from([7, 8]));
+    });
+
+    test('should drop a pdu above the maximum sdu length along with its continuations - HCI_ACLDATA_PKT / ACL_START', () => {
+      const aclDataDroppedCallback = jest.fn();
+      hci.on('aclDataDropped', aclDataDroppedCallback);
+      hci._maxSduLength = 16;
+
+      hci.onSocketData(Buffer.from([0x02, 0xf2, 0x24, 0x06, 0x00, 0x20, 0x00, 0x04, 0x00, 1, 2]));
+      hci.onSocketData(Buffer.from([0x02, 0xf2, 0x14, 0x03, 0x00, 3, 4, 5]));
+
+      expect(aclDataDroppedCallback).toHaveBeenCalledTimes(1);
+      expect(aclDataDroppedCallback).toHaveBeenCalledWith(1266, 'pdu length 32');
+      expect(aclDataPktCallback).not.toHaveBeenCalled();
+    });
+
+    test('should reassemble a pdu written at offsets into one buffer - HCI_ACLDATA_PKT / ACL_START + ACL_CONT', () => {
+      hci.onSocketData(Buffer.from([0x02, 0xf2, 0x24, 0x06, 0x00, 0x06, 0x00, 0x04, 0x00, 1, 2]));
+      hci.onSocketData(Buffer.from([0x02, 0xf2, 0x14, 0x02, 0x00, 3, 4]));
+      hci.onSocketData(Buffer.from([0x02, 0xf2, 0x14, 0x02, 0x00, 5, 6]));
+
+      expect(aclDataPktCallback).toHaveBeenCalledWith(1266, 4, Buffer.from([1, 2, 3, 4, 5, 6]));
+      expect(hci._handleBuffers.size).toEqual(0);
+    });
+
     test('should emit leScanEnableSetCmd - HCI_COMMAND_PKT / LE_SET_SCAN_ENABLE_CMD', () => {
       const eventType = 1;
       const subEventTypeP1 = 0x0c;
@@ -1723,7 +2507,7 @@ describe('hci-socket hci', () => {
       expect(aclDataPktCallback).not.toHaveBeenCalled();
   
       // HCI state checks
-      expect(hci._aclQueue).toEqual(aclQueue);
+      expect(hci._aclScheduler.length).toEqual(aclQueue.length);
       expect(Array.from(hci._aclConnections.keys())).toEqual(expect.arrayContaining([4660, 4661]));
     });
   
@@ -1745,7 +2529,7 @@ describe('hci-socket hci', () => {
       expect(aclDataPktCallback).not.toHaveBeenCalled();
   
       // HCI state checks
-      expect(hci._aclQueue).toEqual(aclQueue);
+      expect(hci._aclScheduler.length).toEqual(aclQueue.length);
       expect(Array.from(hci._aclConnections.keys())).toEqual(expect.arrayContaining([4660, 4661]));
     });
   
@@ -1767,7 +2551,7 @@ describe('hci-socket hci', () => {
       expect(aclDataPktCallback).not.toHaveBeenCalled();
   
       // HCI state checks
-      expect(hci._aclQueue).toEqual(aclQueue);
+      expect(hci._aclScheduler.length).toEqual(aclQueue.length);
       expect(Array.from(hci._aclConnections.keys())).toEqual(expect.arrayContaining([4660, 4661]));
     });
   });
@@ -2311,7 +3095,7 @@ describe('hci-socket hci', () => {
       hci.processCmdCompleteEvent(cmd, status, result);
 
       // called
-      assert.calledOnceWithExactly(addressChangeCallback, '07:06:05:04:03:02:01:09');
+      assert.calledOnceWithExactly(addressChangeCallback, '05:04:03:02:01:09');
 
       // not called
       assert.notCalled(hci.setEventMask);
@@ -2332,7 +3116,7 @@ describe('hci-socket hci', () => {
       should(hci._aclBuffers).deepEqual(aclBuffers);
       should(hci._isExtended).equal(false);
       should(hci.addressType).equal('public');
-      should(hci.address).equal('07:06:05:04:03:02:01:09');
+      should(hci.address).equal('05:04:03:02:01:09');
     });
 
     [8203, 8257].forEach((cmd) => {
@@ -2867,7 +3651,7 @@ describe('hci-socket hci', () => {
       hci.on('leAdvertisingReport', callback);
       hci.processLeAdvertisingReport(count, data);
 
-      assert.calledOnceWithExactly(callback, 0, 0, 'ff:ee:dd:cc:bb:aa', 'random', Buffer.from([0x03, 0x04]), 0);
+      assert.calledOnceWithExactly(callback, 0, 0, 0xffeeddccbbaa, 'random', Buffer.from([0x03, 0x04]), 0);
     });
 
     it('should emit only once with public address', () => {
@@ -2878,7 +3662,7 @@ describe('hci-socket hci', () => {
       hci.on('leAdvertisingReport', callback);
       hci.processLeAdvertisingReport(count, data);
 
-      assert.calledOnceWithExactly(callback, 0, 1, 'aa:bb:cc:dd:ee:ff', 'public', Buffer.from([0x03, 0x04, 0x05, 0x06]), 7);
+      assert.calledOnceWithExactly(callback, 0, 1, 0xaabbccddeeff, 'public', Buffer.from([0x03, 0x04, 0x05, 0x06]), 7);
     });
 
     it('should catch error', () => {
@@ -2925,7 +3709,7 @@ describe('hci-socket hci', () => {
       hci.on('leExtendedAdvertisingReport', callback);
       hci.processLeExtendedAdvertisingReport(count, data);
 
-      assert.calledOnceWithExactly(callback, 0, 256, 'ff:ee:dd:cc:bb:aa', 'random', 5, 6, Buffer.from([0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17]));
+      assert.calledOnceWithExactly(callback, 0, 256, 0xffeeddccbbaa, 'random', 5, 6, Buffer.from([0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17]), 4, 2568.75);
     });
 
     it('should emit only once with public address', () => {
@@ -2938,7 +3722,7 @@ describe('hci-socket hci', () => {
       hci.on('leExtendedAdvertisingReport', callback);
       hci.processLeExtendedAdvertisingReport(count, data);
 
-      assert.calledOnceWithExactly(callback, 0, 256, 'aa:bb:cc:dd:ee:ff', 'public', 5, 6, Buffer.from([0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17]));
+      assert.calledOnceWithExactly(callback, 0, 256, 0xaabbccddeeff, 'public', 5, 6, Buffer.from([0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17]), 4, 2568.75);
     });
 
     it('should catch error', () => {
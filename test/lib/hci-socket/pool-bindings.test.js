@@ -0,0 +1,199 @@
+const should = require('should');
+const sinon = require('sinon');
+const proxyquire = require('proxyquire').noCallThru();
+
+const { EventEmitter } = require('events');
+
+const { assert } = sinon;
+
+describe('hci-socket pool bindings', () => {
+  let adapters;
+  let bindings;
+  let clock;
+
+  const FakeBindings = function (options) {
+    EventEmitter.call(this);
+    this.options = options;
+    this.free = 8;
+    this.start = sinon.spy();
+    this.stop = sinon.spy();
+    this.startScanning = sinon.spy();
+    this.stopScanning = sinon.spy();
+    this.setScanParameters = sinon.spy();
+    this.connect = sinon.spy();
+    this.cancelConnect = sinon.spy();
+    this.read = sinon.spy();
+    this.freeAclBuffers = () => this.free;
+    adapters.push(this);
+  };
+  Object.setPrototypeOf(FakeBindings.prototype, EventEmitter.prototype);
+
+  const PoolBindings = proxyquire('../../../lib/hci-socket/pool-bindings', {
+    './bindings': FakeBindings
+  });
+
+  const powerOn = () => adapters.forEach(adapter => adapter.emit('stateChange', 'poweredOn'));
+
+  beforeEach(() => {
+    clock = sinon.useFakeTimers();
+    adapters = [];
+    bindings = new PoolBindings({ adapters: [0, { deviceId: 2, userChannel: true }], hciDriver: 'virtual' });
+    bindings.start();
+  });
+
+  afterEach(() => {
+    bindings.stop();
+    clock.restore();
+  });
+
+  it('should open every adapter with the shared options', () => {
+    should(adapters.map(adapter => adapter.options)).deepEqual([
+      { hciDriver: 'virtual', deviceId: 0 },
+      { hciDriver: 'virtual', deviceId: 2, userChannel: true }
+    ]);
+    adapters.forEach(adapter => assert.calledOnce(adapter.start));
+  });
+
+  it('should be poweredOn while any adapter is', () => {
+    const stateChange = sinon.spy();
+    bindings.on('stateChange', stateChange);
+
+    adapters[0].emit('stateChange', 'poweredOff');
+    adapters[1].emit('stateChange', 'poweredOn');
+    adapters[0].emit('stateChange', 'poweredOn');
+    adapters[1].emit('stateChange', 'poweredOff');
+    adapters[0].emit('stateChange', 'poweredOff');
+
+    should(stateChange.args).deepEqual([['poweredOff'], ['poweredOn'], ['poweredOff']]);
+  });
+
+  it('should report the strongest copy of a discovery once per merge window', () => {
+    const discover = sinon.spy();
+    bindings.on('discover', discover);
+
+    adapters[0].emit('discover', 'c00000000001', 'c0:00:00:00:00:01', 'random', true, { localName: 'a' }, -70, true);
+    adapters[1].emit('discover', 'c00000000001', 'c0:00:00:00:00:01', 'random', true, { localName: 'b' }, -50, true);
+    adapters[0].emit('discover', 'c00000000001', 'c0:00:00:00:00:01', 'random', true, { localName: 'c' }, -60, true);
+    assert.notCalled(discover);
+
+    clock.tick(10);
+    assert.calledOnceWithExactly(discover, 'c00000000001', 'c0:00:00:00:00:01', 'random', true, { localName: 'b' }, -50, true, true);
+  });
+
+  it('should scan while any adapter scans', () => {
+    const scanStart = sinon.spy();
+    const scanStop = sinon.spy();
+    bindings.on('scanStart', scanStart);
+    bindings.on('scanStop', scanStop);
+
+    bindings.startScanning(['180f'], false);
+    adapters.forEach(adapter => assert.calledOnceWithExactly(adapter.startScanning, ['180f'], false));
+    adapters.forEach(adapter => adapter.emit('scanStart', true));
+    assert.calledOnceWithExactly(scanStart, true);
+
+    adapters[0].emit('scanStop');
+    assert.notCalled(scanStop);
+
+    bindings.stopScanning();
+    adapters.forEach(adapter => assert.calledOnce(adapter.stopScanning));
+    adapters[1].emit('scanStop');
+    assert.calledOnce(scanStop);
+  });
+
+  it('should connect on the least loaded adapter that heard the peripheral', () => {
+    powerOn();
+    adapters[0].emit('discover', 'c00000000001', 'c0:00:00:00:00:01', 'random', true, {}, -70, true);
+    adapters[1].emit('discover', 'c00000000001', 'c0:00:00:00:00:01', 'random', true, {}, -50, true);
+    adapters[0].emit('discover', 'c00000000002', 'c0:00:00:00:00:02', 'random', true, {}, -80, true);
+    adapters[1].emit('discover', 'c00000000002', 'c0:00:00:00:00:02', 'random', true, {}, -40, true);
+
+    // Equal load: the better RSSI decides.
+    bindings.connect('c00000000001');
+    assert.calledOnceWithExactly(adapters[1].connect, 'c00000000001', {});
+
+    // Fewer links first
+    bindings.connect('c00000000002');
+    assert.calledOnceWithExactly(adapters[0].connect, 'c00000000002', {});
+  });
+
+  it('should prefer the adapter with more free ACL buffers on equal links', () => {
+    powerOn();
+    adapters[0].emit('discover', 'c00000000001', 'c0:00:00:00:00:01', 'random', true, {}, -40, true);
+    adapters[1].emit('discover', 'c00000000001', 'c0:00:00:00:00:01', 'random', true, {}, -90, true);
+    adapters[0].free = 2;
+
+    bindings.connect('c00000000001');
+
+    assert.calledOnce(adapters[1].connect);
+  });
+
+  it('should route calls and count links per peripheral', () => {
+    const connect = sinon.spy();
+    bindings.on('connect', connect);
+    powerOn();
+    adapters[1].emit('discover', 'c00000000001', 'c0:00:00:00:00:01', 'random', true, {}, -40, true);
+
+    bindings.connect('c00000000001');
+    adapters[1].emit('connect', 'c00000000001', null);
+    bindings.read('c00000000001', '180f', '2a19');
+
+    assert.calledOnceWithExactly(adapters[1].read, 'c00000000001', '180f', '2a19');
+    assert.calledOnceWithExactly(connect, 'c00000000001', null);
+    should(bindings._links).deepEqual([0, 1]);
+
+    adapters[1].emit('disconnect', 'c00000000001', 0x13);
+    should(bindings._links).deepEqual([0, 0]);
+    should(bindings._owners.size).equal(0);
+  });
+
+  it('should fail attempts on an adapter that powers off', () => {
+    const connect = sinon.spy();
+    bindings.on('connect', connect);
+    powerOn();
+
+    bindings.connect('c00000000001');
+    adapters[0].emit('stateChange', 'poweredOff');
+
+    assert.calledOnce(connect);
+    should(connect.firstCall.args[1].message).equal('Adapter 0 is poweredOff');
+    should(bindings._links).deepEqual([0, 0]);
+  });
+
+  it('should forget a peripheral once no adapter knows it and it has no link', () => {
+    powerOn();
+    adapters[0].emit('discover', 'c00000000001', 'c0:00:00:00:00:01', 'random', true, {}, -70, true);
+    adapters[1].emit('discover', 'c00000000001', 'c0:00:00:00:00:01', 'random', true, {}, -50, true);
+    bindings.connect('c00000000001');
+    adapters[1].emit('connect', 'c00000000001', null);
+
+    adapters[0].emit('discoveryEvict', 'c00000000001', 'ttl');
+    adapters[1].emit('discoveryEvict', 'c00000000001', 'size');
+    should(bindings._sightings.has('c00000000001')).be.true();
+
+    adapters[1].emit('disconnect', 'c00000000001', 0x13);
+    should(bindings._sightings.size).equal(0);
+
+    adapters[0].emit('discover', 'c00000000002', 'c0:00:00:00:00:02', 'random', true, {}, -70, true);
+    bindings.stop();
+    should(bindings._sightings.size).equal(0);
+  });
+
+  it('should sum the scan time of every adapter', () => {
+    const scanStatsRead = sinon.spy();
+    bindings.on('scanStatsRead', scanStatsRead);
+    adapters[0].getScanStats = () => ({ profile: 'lowPower', duty: 0.25, scanTime: 1000, scanOnTime: 250 });
+    adapters[1].getScanStats = () => ({ profile: 'lowPower', duty: 0.75, scanTime: 1000, scanOnTime: 750 });
+
+    bindings.readScanStats();
+
+    assert.calledOnce(scanStatsRead);
+    should(scanStatsRead.firstCall.args[0]).equal(null);
+    should(scanStatsRead.firstCall.args[1]).deepEqual({
+      profile: 'lowPower',
+      duty: 0.5,
+      scanTime: 2000,
+      scanOnTime: 1000,
+      adapters: [adapters[0].getScanStats(), adapters[1].getScanStats()]
+    });
+  });
+});
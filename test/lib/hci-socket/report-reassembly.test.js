@@ -0,0 +1,97 @@
+const should = require('should');
+
+const ReportReassembly = require('../../../lib/hci-socket/report-reassembly');
+
+describe('hci-socket report reassembly', () => {
+  const CONNECTABLE = 0x01;
+  const SCAN_RESPONSE = 0x08;
+  const MORE = 0x20;
+  const TRUNCATED = 0x40;
+
+  const KEY = ReportReassembly.key(0x112233445566, 0x03);
+
+  let now;
+  let reassembly;
+
+  beforeEach(() => {
+    now = 0;
+    reassembly = new ReportReassembly({ maxLength: 8, maxPending: 2, timeout: 100, now: () => now });
+  });
+
+  it('uses the defaults unless given positive limits', () => {
+    should(new ReportReassembly({ maxLength: 0, timeout: -1 })).containEql({ maxLength: 1650, maxPending: 64, timeout: 1000 });
+  });
+
+  it('keys chains by advertiser and SID', () => {
+    should(ReportReassembly.key(0xffffffffffff, 0x0f)).be.below(Number.MAX_SAFE_INTEGER);
+    should(ReportReassembly.key(0x112233445566, 0x00)).not.equal(ReportReassembly.key(0x112233445566, 0x01));
+    should(ReportReassembly.key(0x112233445566, 0xff)).equal(ReportReassembly.key(0x112233445566, undefined));
+    should(ReportReassembly.key(0x112233445566, 0xff)).not.equal(ReportReassembly.key(0x112233445567, 0x00));
+  });
+
+  it('passes a report that is not part of a chain through as it is', () => {
+    const eir = Buffer.from([0x02, 0x01, 0x06]);
+
+    should(reassembly.push(KEY, CONNECTABLE, eir)).equal(eir);
+    should(reassembly.truncated).be.false();
+    should(reassembly.push(KEY, CONNECTABLE | TRUNCATED, eir)).equal(eir);
+    should(reassembly.truncated).be.true();
+  });
+
+  it('joins a chain once its last report is in', () => {
+    const first = Buffer.from([0x01, 0x02, 0x03]);
+
+    should(reassembly.push(KEY, CONNECTABLE | MORE, first)).be.null();
+    first.fill(0); // the socket buffer is reused
+    should(reassembly.push(KEY, CONNECTABLE | MORE, Buffer.from([0x04, 0x05]))).be.null();
+    should(reassembly.size).equal(1);
+
+    should(reassembly.push(KEY, CONNECTABLE, Buffer.from([0x06]))).deepEqual(Buffer.from([0x01, 0x02, 0x03, 0x04, 0x05, 0x06]));
+    should(reassembly.truncated).be.false();
+    should(reassembly.size).equal(0);
+    should(reassembly.joined).equal(1);
+  });
+
+  it('marks data truncated by the controller or past the longest advertising data', () => {
+    reassembly.push(KEY, MORE, Buffer.from([0x01, 0x02]));
+    should(reassembly.push(KEY, TRUNCATED, Buffer.alloc(0))).deepEqual(Buffer.from([0x01, 0x02]));
+    should(reassembly.truncated).be.true();
+
+    reassembly.push(KEY, MORE, Buffer.alloc(6, 0x01));
+    reassembly.push(KEY, MORE, Buffer.alloc(6, 0x02));
+    reassembly.push(KEY, MORE, Buffer.alloc(6, 0x03));
+    should(reassembly.push(KEY, 0x00, Buffer.alloc(6, 0x04))).deepEqual(Buffer.from([1, 1, 1, 1, 1, 1, 2, 2]));
+    should(reassembly.truncated).be.true();
+  });
+
+  it('keeps chains of different advertisers and SIDs apart', () => {
+    const other = ReportReassembly.key(0x112233445566, 0x04);
+
+    reassembly.push(KEY, MORE, Buffer.from([0x01]));
+    reassembly.push(other, MORE, Buffer.from([0x0a]));
+
+    should(reassembly.push(other, 0x00, Buffer.from([0x0b]))).deepEqual(Buffer.from([0x0a, 0x0b]));
+    should(reassembly.push(KEY, 0x00, Buffer.from([0x02]))).deepEqual(Buffer.from([0x01, 0x02]));
+  });
+
+  it('drops chains cut short, too old or too many', () => {
+    reassembly.push(KEY, CONNECTABLE | MORE, Buffer.from([0x01]));
+    should(reassembly.push(KEY, CONNECTABLE | SCAN_RESPONSE, Buffer.from([0x02]))).deepEqual(Buffer.from([0x02]));
+    should(reassembly.dropped).equal(1);
+
+    reassembly.push(KEY, MORE, Buffer.from([0x01]));
+    now = 101;
+    should(reassembly.push(KEY, 0x00, Buffer.from([0x02]))).deepEqual(Buffer.from([0x02]));
+    should(reassembly.dropped).equal(2);
+
+    reassembly.push(1, MORE, Buffer.from([0x01]));
+    reassembly.push(2, MORE, Buffer.from([0x02]));
+    reassembly.push(3, MORE, Buffer.from([0x03]));
+    should(reassembly.size).equal(2);
+    should(reassembly.dropped).equal(3);
+    should(reassembly.push(1, 0x00, Buffer.from([0x04]))).deepEqual(Buffer.from([0x04]));
+
+    reassembly.clear();
+    should(reassembly.size).equal(0);
+  });
+});
@@ -0,0 +1,77 @@
+const should = require('should');
+
+const compileScanFilter = require('../../../lib/hci-socket/scan-filter');
+
+describe('hci-socket scan filter', () => {
+  const ADDRESS = 0x112233445566;
+
+  // Flags, complete local name "Tag-01", manufacturer data for company 0x0059, 16-bit service data for 180f
+  const EIR = Buffer.from([
+    0x02, 0x01, 0x06,
+    0x07, 0x09, 0x54, 0x61, 0x67, 0x2d, 0x30, 0x31,
+    0x05, 0xff, 0x59, 0x00, 0xa1, 0xb2,
+    0x04, 0x16, 0x0f, 0x18, 0x64
+  ]);
+
+  const matches = (spec, eir = EIR, address = ADDRESS, addressType = 'random', rssi = -60) =>
+    compileScanFilter(spec)(eir, address, addressType, rssi);
+
+  it('compiles no filter to null', () => {
+    should(compileScanFilter(undefined)).be.null();
+    should(compileScanFilter(null)).be.null();
+  });
+
+  it('matches manufacturer data by company id and masked prefix', () => {
+    should(matches({ manufacturerData: { companyId: 0x0059 } })).be.true();
+    should(matches({ manufacturerData: { companyId: 0x004c } })).be.false();
+    should(matches({ manufacturerData: { companyId: 0x0059, prefix: 'a1b2' } })).be.true();
+    should(matches({ manufacturerData: { companyId: 0x0059, prefix: [0xa1, 0xb3] } })).be.false();
+    should(matches({ manufacturerData: { companyId: 0x0059, prefix: 'a0b0', mask: 'f0f0' } })).be.true();
+    should(matches({ manufacturerData: { prefix: '5900a1b2c3' } })).be.false();
+  });
+
+  it('matches service data by uuid', () => {
+    should(matches({ serviceData: '180f' })).be.true();
+    should(matches({ serviceData: ['180a', '180f'] })).be.true();
+    should(matches({ serviceData: '0000180f' })).be.false();
+    should(matches({ serviceData: '0000180f-0000-1000-8000-00805f9b34fb' })).be.false();
+  });
+
+  it('matches a local name prefix', () => {
+    should(matches({ localName: 'Tag-' })).be.true();
+    should(matches({ localName: 'Tag-01' })).be.true();
+    should(matches({ localName: 'Tag-012' })).be.false();
+    should(matches({ localName: 'tag' })).be.false();
+  });
+
+  it('matches the report fields', () => {
+    should(matches({ rssi: -60 })).be.true();
+    should(matches({ rssi: -59 })).be.false();
+    should(matches({ addressType: 'random' })).be.true();
+    should(matches({ addressType: ['public'] })).be.false();
+    should(matches({ address: '11:22:33:44:55:66' })).be.true();
+    should(matches({ address: ['AA:BB:CC:DD:EE:FF', '112233445566'] })).be.true();
+    should(matches({ address: 'aa:bb:cc:dd:ee:ff' })).be.false();
+  });
+
+  it('combines keys with and, and lists with all and any', () => {
+    should(matches({ localName: 'Tag-', rssi: -50 })).be.false();
+    should(matches({ localName: 'Tag-', rssi: -70 })).be.true();
+    should(matches({ any: [{ localName: 'Beacon' }, { serviceData: '180f' }] })).be.true();
+    should(matches({ all: [{ localName: 'Tag-' }, { any: [{ rssi: -50 }, { addressType: 'public' }] }] })).be.false();
+  });
+
+  it('stops at malformed eir data', () => {
+    const eir = Buffer.from([0x00, 0x05, 0xff, 0x59, 0x00, 0xa1, 0xb2]);
+    should(matches({ manufacturerData: { companyId: 0x0059 } }, eir)).be.false();
+    should(matches({ localName: 'T' }, Buffer.from([0x07, 0x09, 0x54]))).be.false();
+  });
+
+  it('rejects filters it cannot compile', () => {
+    should(() => compileScanFilter({ name: 'Tag' })).throw(/unknown key name/);
+    should(() => compileScanFilter({ serviceData: '18f' })).throw(/serviceData/);
+    should(() => compileScanFilter({ manufacturerData: { prefix: 'a1', mask: 'ffff' } })).throw(/mask/);
+    should(() => compileScanFilter({ address: '11:22:33' })).throw(/address/);
+    should(() => compileScanFilter({ any: [] })).throw(/any/);
+  });
+});
@@ -0,0 +1,37 @@
+const should = require('should');
+
+const resolveScanProfile = require('../../../lib/hci-socket/scan-profiles');
+
+describe('hci-socket scan profiles', () => {
+  it('resolves built-in profiles over the defaults', () => {
+    should(resolveScanProfile('default')).deepEqual({
+      name: 'default',
+      active: true,
+      interval: 0x0012,
+      window: 0x0012,
+      phys: ['1m', 'coded'],
+      allowDuplicates: undefined,
+      duplicatesRefresh: undefined
+    });
+    should(resolveScanProfile('lowPower')).containEql({ name: 'lowPower', active: false, interval: 0x0800, window: 0x0030 });
+  });
+
+  it('looks names up in the given profiles first', () => {
+    const profiles = { passive: { active: false, window: 0x0010 }, tags: { phys: ['coded'], allowDuplicates: true } };
+
+    should(resolveScanProfile('passive', profiles)).containEql({ name: 'passive', active: false, window: 0x0010 });
+    should(resolveScanProfile('tags', profiles)).containEql({ name: 'tags', active: true, phys: ['coded'], allowDuplicates: true });
+    should(resolveScanProfile({ name: 'inline', interval: 0x0100 })).containEql({ name: 'inline', interval: 0x0100 });
+    should(resolveScanProfile({ interval: 0x0100 }).name).equal('custom');
+  });
+
+  it('rejects profiles it cannot scan with', () => {
+    should(() => resolveScanProfile('unknown')).throw('Unknown scan profile unknown');
+    should(() => resolveScanProfile('toString')).throw(/Unknown/);
+    should(() => resolveScanProfile(42)).throw(/Unknown/);
+    should(() => resolveScanProfile({ active: 'yes' })).throw(/active/);
+    should(() => resolveScanProfile({ interval: 0x0002 })).throw(/interval/);
+    should(() => resolveScanProfile({ interval: 0x0020, window: 0x0040 })).throw(/window/);
+    should(() => resolveScanProfile({ phys: ['2m'] })).throw(/phys/);
+  });
+});
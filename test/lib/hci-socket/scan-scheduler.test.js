@@ -0,0 +1,51 @@
+const should = require('should');
+
+const ScanScheduler = require('../../../lib/hci-socket/scan-scheduler');
+
+describe('hci-socket scan scheduler', () => {
+  let now;
+  let scheduler;
+
+  const reports = (count, isNewDevice = false) => {
+    for (let i = 0; i < count; i++) {
+      scheduler.onReport(isNewDevice);
+    }
+  };
+
+  beforeEach(() => {
+    now = 0;
+    scheduler = new ScanScheduler({ maxReportRate: 100, maxLag: 20, slowDiscovery: 5000, minDuty: 0.1 }, () => now);
+    scheduler.reset(0.5);
+  });
+
+  it('uses the defaults unless given positive settings', () => {
+    const defaults = new ScanScheduler({ period: 0, maxDuty: -1 });
+
+    should(defaults).containEql({ period: 1000, maxReportRate: 1000, maxLag: 50, slowDiscovery: 10000, minDuty: 0.05, maxDuty: 1 });
+  });
+
+  it('halves the duty cycle over the report rate or lag budget, down to its minimum', () => {
+    reports(101);
+    should(scheduler.update(1000, 0)).equal(0.25);
+
+    should(scheduler.update(1000, 21)).equal(0.125);
+    should(scheduler.update(1000, 30)).equal(0.1);
+  });
+
+  it('doubles the duty cycle while discovery is slow and the load low, up to its maximum', () => {
+    reports(10, true);
+    now = 4000;
+    should(scheduler.update(1000, 0)).equal(0.5);
+
+    now = 5000;
+    should(scheduler.update(1000, 0)).equal(1);
+    should(scheduler.update(1000, 0)).equal(1);
+  });
+
+  it('holds the duty cycle between half the budget and the budget', () => {
+    now = 5000;
+    reports(60);
+    should(scheduler.update(1000, 0)).equal(0.5);
+    should(scheduler.update(1000, 15)).equal(0.5);
+  });
+});
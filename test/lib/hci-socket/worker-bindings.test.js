@@ -0,0 +1,96 @@
+const should = require('should');
+const sinon = require('sinon');
+const proxyquire = require('proxyquire').noCallThru();
+
+const { EventEmitter } = require('events');
+const path = require('path');
+
+const { pack, unpack } = require('../../../lib/hci-socket/worker-messages');
+
+const { assert } = sinon;
+
+describe('hci-socket worker bindings', () => {
+  let worker;
+  let bindings;
+
+  const FakeWorker = function (file, options) {
+    EventEmitter.call(this);
+    this.file = file;
+    this.options = options;
+    this.postMessage = sinon.spy((message) => {
+      // The worker acknowledges stop through the shared flag.
+      if (unpack(message)[0] === 'stop') {
+        Atomics.store(options.workerData.stopped, 0, 1);
+      }
+    });
+    this.terminate = sinon.spy();
+    worker = this;
+  };
+  Object.setPrototypeOf(FakeWorker.prototype, EventEmitter.prototype);
+
+  const WorkerBindings = proxyquire('../../../lib/hci-socket/worker-bindings', {
+    worker_threads: { Worker: FakeWorker }
+  });
+
+  const posted = () => worker.postMessage.args.map(([message]) => unpack(message));
+
+  beforeEach(() => {
+    bindings = new WorkerBindings({ deviceId: 1, bindParams: { key: Buffer.from('01', 'hex') } });
+    bindings.start();
+  });
+
+  afterEach(() => {
+    bindings.stop();
+  });
+
+  it('should start the worker with the options', () => {
+    should(path.basename(worker.file)).equal('worker.js');
+    should(unpack(worker.options.workerData.options)).deepEqual({ deviceId: 1, bindParams: { key: Buffer.from('01', 'hex') } });
+    should(worker.options.transferList).deepEqual([worker.options.workerData.options.buffer]);
+  });
+
+  it('should post calls to the worker', () => {
+    bindings.startScanning(['180f'], true);
+    bindings.write('c00000000001', '180f', '2a19', Buffer.from('63', 'hex'), false);
+
+    should(posted()).deepEqual([
+      ['startScanning', [['180f'], true]],
+      ['write', ['c00000000001', '180f', '2a19', Buffer.from('63', 'hex'), false]]
+    ]);
+  });
+
+  it('should emit every event of a batch in order', () => {
+    const events = [];
+    bindings.on('stateChange', state => events.push(['stateChange', state]));
+    bindings.on('read', (uuid, service, characteristic, data, isNotification) => events.push(['read', data, isNotification]));
+
+    worker.emit('message', pack([
+      ['stateChange', ['poweredOn']],
+      ['read', ['c00000000001', '180f', '2a19', Buffer.from('63', 'hex'), true]]
+    ]));
+
+    should(events).deepEqual([['stateChange', 'poweredOn'], ['read', Buffer.from('63', 'hex'), true]]);
+  });
+
+  it('should report the adapter unsupported when the worker fails', () => {
+    const stateChange = sinon.spy();
+    bindings.on('stateChange', stateChange);
+
+    worker.emit('error', new Error('bind failed'));
+
+    assert.calledOnceWithExactly(stateChange, 'unsupported');
+  });
+
+  it('should stop the worker and wait for it', () => {
+    const stopped = worker;
+
+    bindings.stop();
+
+    should(posted().pop()).deepEqual(['stop', []]);
+    assert.calledOnce(stopped.terminate);
+  });
+
+  it('should convert addresses to ids without the worker', () => {
+    should(bindings.addressToId('C0:00:00:00:00:01')).equal('c00000000001');
+  });
+});
@@ -0,0 +1,44 @@
+const should = require('should');
+
+const { EVENTS, pack, unpack } = require('../../../lib/hci-socket/worker-messages');
+
+describe('hci-socket worker messages', () => {
+  it('carries every buffer of a message in one transferable array buffer', () => {
+    const data = Buffer.from('0102', 'hex');
+    const advertisement = {
+      localName: 'Thermo',
+      manufacturerData: Buffer.from('4c00', 'hex'),
+      serviceData: [{ uuid: '180f', data: Buffer.from('63', 'hex') }],
+      serviceUuids: ['180f']
+    };
+
+    const message = pack([['discover', ['c00000000001', advertisement, -60]], ['read', ['uuid', data, true]]]);
+
+    should(message.buffer).be.instanceOf(ArrayBuffer);
+    should(message.buffer.byteLength).equal(5);
+
+    const [[discover, discoverArgs], [read, readArgs]] = unpack(message);
+    should(discover).equal('discover');
+    should(discoverArgs).deepEqual(['c00000000001', advertisement, -60]);
+    should(Buffer.isBuffer(discoverArgs[1].manufacturerData)).be.true();
+    should(discoverArgs[1].serviceData[0].data.buffer).equal(message.buffer);
+    should(read).equal('read');
+    should(readArgs).deepEqual(['uuid', data, true]);
+  });
+
+  it('keeps the name, message and properties of errors', () => {
+    const error = new Error('Connection Failed to be Established');
+    error.status = 0x3e;
+
+    const [decoded] = unpack(pack([error]));
+
+    should(decoded).be.instanceOf(Error);
+    should(decoded.message).equal('Connection Failed to be Established');
+    should(decoded.status).equal(0x3e);
+  });
+
+  it('leaves plain values alone', () => {
+    should(unpack(pack([null, undefined, 1, 'a', { b: [true] }]))).deepEqual([null, undefined, 1, 'a', { b: [true] }]);
+    should(EVENTS).containEql('discover');
+  });
+});
@@ -0,0 +1,134 @@
+const should = require('should');
+
+const { once } = require('events');
+const fs = require('fs');
+
+// Only built on Linux; elsewhere the package's addon has no NobleLinux in it.
+let NobleLinux = null;
+try {
+  NobleLinux = require('../../../lib/linux/bindings');
+} catch (error) {
+  NobleLinux = null;
+}
+
+const describeLinux = NobleLinux ? describe : describe.skip;
+
+const ADVERTISING_REPORT = Buffer.from([
+  0x04, 0x3e, 0x11, 0x02, 0x01,
+  0x00, 0x01, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x03, 0x02, 0x01, 0x06, 0xc4
+]);
+
+describeLinux('linux hci socket', () => {
+  let socket;
+  let controller;
+  let fds;
+
+  beforeEach(() => {
+    fds = NobleLinux.socketPair();
+    controller = fds[1];
+    socket = new NobleLinux();
+    socket.bindRaw(undefined, { linux: { fd: fds[0] } });
+    socket.start();
+  });
+
+  afterEach(() => {
+    socket.stop();
+    fds.forEach(fd => fs.closeSync(fd));
+  });
+
+  it('should report an injected descriptor as up', () => {
+    should(socket.isDevUp()).be.true();
+  });
+
+  it('should decode advertising reports on its reader thread', async () => {
+    fs.writeSync(controller, ADVERTISING_REPORT);
+
+    const [type, address, addressType, rssi, eir] = await once(socket, 'advertisingReport');
+
+    should(type).equal(0x00);
+    should(address).equal(0x010203040506);
+    should(addressType).equal('random');
+    should(rssi).equal(-60);
+    should(eir).deepEqual(Buffer.from([0x02, 0x01, 0x06]));
+  });
+
+  it('should decode extended advertising reports', async () => {
+    const report = Buffer.alloc(24 + 3);
+    report.writeUInt16LE(0x0013, 0);
+    report.writeUInt8(0x00, 2);
+    Buffer.from([0x06, 0x05, 0x04, 0x03, 0x02, 0x01]).copy(report, 3);
+    report.writeUInt8(0x7f, 12);
+    report.writeInt8(-70, 13);
+    report.writeUInt8(3, 23);
+    Buffer.from([0x02, 0x01, 0x06]).copy(report, 24);
+    fs.writeSync(controller, Buffer.concat([Buffer.from([0x04, 0x3e, 2 + report.length, 0x0d, 0x01]), report]));
+
+    const [type, address, addressType, txPower, rssi, eir] = await once(socket, 'extendedAdvertisingReport');
+
+    should(type).equal(0x13);
+    should(address).equal(0x010203040506);
+    should(addressType).equal('public');
+    should(txPower).equal(0x7f);
+    should(rssi).equal(-70);
+    should(eir).deepEqual(Buffer.from([0x02, 0x01, 0x06]));
+  });
+
+  it('should pass on the advertising set and periodic advertising interval', async () => {
+    const report = Buffer.alloc(24);
+    report.writeUInt16LE(0x0000, 0);
+    Buffer.from([0x06, 0x05, 0x04, 0x03, 0x02, 0x01]).copy(report, 3);
+    report.writeUInt8(0x03, 11);
+    report.writeUInt16LE(0x0050, 14);
+    fs.writeSync(controller, Buffer.concat([Buffer.from([0x04, 0x3e, 2 + report.length, 0x0d, 0x01]), report]));
+
+    const args = await once(socket, 'extendedAdvertisingReport');
+
+    should(args.slice(6)).deepEqual([0x03, 0x0050]);
+  });
+
+  it('should pass malformed reports and other events on as they came in', async () => {
+    const truncated = ADVERTISING_REPORT.subarray(0, 12);
+    fs.writeSync(controller, truncated);
+
+    const [data] = await once(socket, 'data');
+
+    should(data).deepEqual(truncated);
+  });
+
+  it('should pass everything on as it came in with decoding off', async () => {
+    socket.setDecoding(false);
+    fs.writeSync(controller, ADVERTISING_REPORT);
+
+    const [data] = await once(socket, 'data');
+
+    should(data).deepEqual(ADVERTISING_REPORT);
+  });
+
+  it('should reassemble fragmented pdus', async () => {
+    fs.writeSync(controller, Buffer.from([0x02, 0x40, 0x20, 0x06, 0x00, 0x05, 0x00, 0x04, 0x00, 0x0b, 0x01]));
+    fs.writeSync(controller, Buffer.from([0x02, 0x40, 0x10, 0x03, 0x00, 0x02, 0x03, 0x04]));
+
+    const [handle, cid, data] = await once(socket, 'aclData');
+
+    should(handle).equal(0x40);
+    should(cid).equal(0x04);
+    should(data).deepEqual(Buffer.from([0x0b, 0x01, 0x02, 0x03, 0x04]));
+  });
+
+  it('should drop continuations without a start', async () => {
+    fs.writeSync(controller, Buffer.from([0x02, 0x40, 0x10, 0x01, 0x00, 0x01]));
+
+    const [handle, reason] = await once(socket, 'aclDataDropped');
+
+    should(handle).equal(0x40);
+    should(reason).equal('continuation without start');
+  });
+
+  it('should write each packet to the descriptor', () => {
+    socket.writev([Buffer.from([0x01, 0x03, 0x0c, 0x00]), Buffer.from([0x01, 0x01, 0x10, 0x00])]);
+
+    const packet = Buffer.alloc(16);
+    should(packet.subarray(0, fs.readSync(controller, packet))).deepEqual(Buffer.from([0x01, 0x03, 0x0c, 0x00]));
+    should(packet.subarray(0, fs.readSync(controller, packet))).deepEqual(Buffer.from([0x01, 0x01, 0x10, 0x00]));
+  });
+});
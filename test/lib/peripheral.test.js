@@ -26,6 +26,7 @@ describe('peripheral', () => {
             });
         });
       },
+      _adoptPeripheral: jest.fn(() => false),
       connect: jest.fn(),
       pair: jest.fn(),
       cancelConnect: jest.fn(),
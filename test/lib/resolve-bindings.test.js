@@ -4,6 +4,13 @@ const { EventEmitter } = require('events');
 // Mock classes
 class MockNoble extends EventEmitter {}
 class MockHciBindings extends EventEmitter {}
+class MockHciWorkerBindings extends EventEmitter {}
+class MockHciBrokerBindings extends EventEmitter {
+  constructor(options) {
+    super();
+    this.options = options;
+  }
+}
 class MockMacBindings extends EventEmitter {}
 class MockWinBindings extends EventEmitter {}
 class MockNobleClass {
@@ -24,6 +31,8 @@ jest.mock('os', () => ({
 
 // Mock the various binding modules
 jest.mock('../../lib/hci-socket/bindings', () => MockHciBindings, { virtual: true });
+jest.mock('../../lib/hci-socket/worker-bindings', () => MockHciWorkerBindings, { virtual: true });
+jest.mock('../../lib/hci-socket/broker-bindings', () => MockHciBrokerBindings, { virtual: true });
 jest.mock('../../lib/mac/bindings', () => MockMacBindings, { virtual: true });
 jest.mock('../../lib/win/bindings', () => MockWinBindings, { virtual: true });
 jest.mock('../../lib/noble', () => MockNobleClass, { virtual: true });
@@ -152,6 +161,22 @@ describe('resolve-bindings', () => {
       expect(noble.bindings).toBeInstanceOf(MockHciBindings);
     });
 
+    test('should run HCI bindings in a worker when asked to', () => {
+      expect(resolver('hci', { worker: true }).bindings).toBeInstanceOf(MockHciWorkerBindings);
+
+      process.env.NOBLE_HCI_WORKER = '1';
+      expect(resolver('hci').bindings).toBeInstanceOf(MockHciWorkerBindings);
+      expect(resolver('hci', { worker: false }).bindings).toBeInstanceOf(MockHciBindings);
+    });
+
+    test('should attach to an HCI broker when asked to', () => {
+      expect(resolver('hci', { broker: '/run/noble.sock' }).bindings.options.broker).toBe('/run/noble.sock');
+
+      process.env.NOBLE_HCI_BROKER = '1';
+      expect(resolver('hci').bindings.options.broker).toBe(true);
+      expect(resolver('hci', { broker: false }).bindings).toBeInstanceOf(MockHciBindings);
+    });
+
     test('should load Mac bindings when explicitly specified', () => {
       const noble = resolver('mac');
       expect(noble).toBeInstanceOf(MockNobleClass);
@@ -453,6 +453,104 @@ describe('noble', () => {
     });
   });
 
+  describe('setScanAcceptListAsync', () => {
+    test('should resolve with what the binding reports', async () => {
+      const devices = [{ address: '11:22:33:44:55:66', addressType: 'public' }];
+      const result = { mode: 'controller', size: 1, capacity: 8 };
+      mockBindings.setScanAcceptList = jest.fn(() => noble.emit('scanAcceptListSet', null, result));
+
+      await expect(noble.setScanAcceptListAsync(devices)).resolves.toEqual(result);
+      expect(mockBindings.setScanAcceptList).toHaveBeenCalledWith(devices);
+    });
+
+    test('should reject where the binding cannot set it', async () => {
+      await expect(noble.setScanAcceptListAsync([])).rejects.toThrow('does not implement setScanAcceptList');
+    });
+  });
+
+  describe('setScanProfileAsync', () => {
+    test('should resolve with the name of the profile set', async () => {
+      mockBindings.setScanProfile = jest.fn(() => noble.emit('scanProfileSet', null, 'lowPower'));
+
+      await expect(noble.setScanProfileAsync('lowPower')).resolves.toEqual('lowPower');
+      expect(mockBindings.setScanProfile).toHaveBeenCalledWith('lowPower');
+    });
+
+    test('should reject a profile the binding refuses', async () => {
+      mockBindings.setScanProfile = jest.fn(() => noble.emit('scanProfileSet', new Error('Unknown scan profile fast')));
+
+      await expect(noble.setScanProfileAsync('fast')).rejects.toThrow('Unknown scan profile fast');
+    });
+
+    test('should reject where the binding cannot set it', async () => {
+      await expect(noble.setScanProfileAsync('passive')).rejects.toThrow('does not implement setScanProfile');
+    });
+  });
+
+  describe('getScanStatsAsync', () => {
+    test('should resolve with what the binding reports', async () => {
+      const stats = { profile: 'default', duty: 1, scanTime: 1000, scanOnTime: 1000 };
+      mockBindings.readScanStats = jest.fn(() => noble._onScanStatsRead(null, stats));
+
+      await expect(noble.getScanStatsAsync()).resolves.toEqual(stats);
+    });
+
+    test('should reject where the binding cannot read them', async () => {
+      await expect(noble.getScanStatsAsync()).rejects.toThrow('does not implement readScanStats');
+    });
+  });
+
+  describe('createPeriodicSyncAsync', () => {
+    const peripheralId = '112233445566';
+
+    test('should resolve with a sync that reports data until it is lost', async () => {
+      mockBindings.createPeriodicSync = jest.fn(() =>
+        noble._onPeriodicSyncEstablished(peripheralId, null, { sid: 3, phy: 1, interval: 100 }));
+
+      const sync = await noble.createPeriodicSyncAsync(peripheralId, { skip: 1 });
+      expect(mockBindings.createPeriodicSync).toHaveBeenCalledWith(peripheralId, { skip: 1 });
+      expect(sync.sid).toEqual(3);
+      expect(sync.interval).toEqual(100);
+
+      const onData = jest.fn();
+      const onLost = jest.fn();
+      sync.on('data', onData);
+      sync.on('lost', onLost);
+
+      noble._onPeriodicAdvertisingReport(peripheralId, Buffer.from([0xaa]), -60, 4, false);
+      noble._onPeriodicSyncLost(peripheralId, 'timeout');
+      noble._onPeriodicAdvertisingReport(peripheralId, Buffer.from([0xbb]), -60, 4, false);
+
+      expect(onData).toHaveBeenCalledTimes(1);
+      expect(onData).toHaveBeenCalledWith(Buffer.from([0xaa]), -60, 4, false);
+      expect(onLost).toHaveBeenCalledWith('timeout');
+      expect(sync.state).toEqual('lost');
+    });
+
+    test('should reject a sync the binding could not establish', async () => {
+      mockBindings.createPeriodicSync = jest.fn(() =>
+        noble._onPeriodicSyncEstablished(peripheralId, new Error('refused: the advertiser has not been discovered')));
+
+      await expect(noble.createPeriodicSyncAsync(peripheralId)).rejects.toThrow('has not been discovered');
+    });
+
+    test('should terminate the sync through the binding', async () => {
+      mockBindings.createPeriodicSync = jest.fn(() =>
+        noble._onPeriodicSyncEstablished(peripheralId, null, { sid: 3, phy: 1, interval: 100 }));
+      mockBindings.terminatePeriodicSync = jest.fn(() => noble._onPeriodicSyncLost(peripheralId, 'terminated'));
+
+      const sync = await noble.createPeriodicSyncAsync(peripheralId);
+      await sync.terminateAsync();
+
+      expect(mockBindings.terminatePeriodicSync).toHaveBeenCalledWith(peripheralId);
+      expect(sync.state).toEqual('terminated');
+    });
+
+    test('should reject where the binding cannot sync', async () => {
+      await expect(noble.createPeriodicSyncAsync(peripheralId)).rejects.toThrow('does not implement createPeriodicSync');
+    });
+  });
+
   describe('cancelConnect', () => {
     test('should delegate to binding', () => {
       const peripheralUuid = 'peripheral-uuid';
@@ -1116,6 +1214,27 @@ describe('noble', () => {
       expect(eventCallback).toHaveBeenCalledTimes(1);
     });
 
+    test('should only update rssi when the advertisement is unchanged', () => {
+      const uuid = 'uuid';
+
+      noble._peripherals.set(uuid, new Peripheral(
+        noble,
+        uuid,
+        'address',
+        'addressType',
+        true,
+        { localName: 'name' },
+        -50
+      ));
+
+      noble._onDiscover(uuid, 'address', 'addressType', true, { localName: 'other' }, -60, false, false);
+
+      const peripheral = noble._peripherals.get(uuid);
+      expect(peripheral.advertisement).toEqual({ localName: 'name' });
+      expect(peripheral.advertisementChanged).toBe(false);
+      expect(peripheral.rssi).toBe(-60);
+    });
+
     test('should emit on duplicate', () => {
       const uuid = 'uuid';
       const address = 'address';
@@ -1196,6 +1315,61 @@ describe('noble', () => {
     });
   });
 
+  describe('onDiscoveryEvict', () => {
+    beforeEach(() => {
+      noble._onDiscover('c00000000001', 'address', 'random', true, {}, -50);
+    });
+
+    test('should forget a peripheral that is not in use', () => {
+      noble._onDiscoveryEvict('c00000000001');
+
+      expect(noble._peripherals.has('c00000000001')).toBe(false);
+      expect(noble._discoveredPeripherals.has('c00000000001')).toBe(false);
+      expect(noble._services.c00000000001).toBeUndefined();
+    });
+
+    test('should keep a peripheral that is connected or synced', () => {
+      noble._peripherals.get('c00000000001').state = 'connected';
+      noble._onDiscoveryEvict('c00000000001');
+      expect(noble._peripherals.has('c00000000001')).toBe(true);
+
+      noble._peripherals.get('c00000000001').state = 'disconnected';
+      noble._periodicSyncs.set('c00000000001', {});
+      noble._onDiscoveryEvict('c00000000001');
+      expect(noble._peripherals.has('c00000000001')).toBe(true);
+    });
+
+    test('should forget a peripheral evicted while connected once it disconnects', () => {
+      noble._peripherals.get('c00000000001').state = 'connected';
+      noble._onDiscoveryEvict('c00000000001');
+
+      noble._onDisconnect('c00000000001', 'reason');
+
+      expect(noble._peripherals.has('c00000000001')).toBe(false);
+      expect(noble._evictedPeripherals.size).toBe(0);
+    });
+
+    test('should keep a peripheral discovered again before it disconnects', () => {
+      noble._peripherals.get('c00000000001').state = 'connected';
+      noble._onDiscoveryEvict('c00000000001');
+      noble._onDiscover('c00000000001', 'address', 'random', true, {}, -50);
+
+      noble._onDisconnect('c00000000001', 'reason');
+
+      expect(noble._peripherals.has('c00000000001')).toBe(true);
+    });
+
+    test('should take a forgotten peripheral back when it connects', () => {
+      const peripheral = noble._peripherals.get('c00000000001');
+      noble._onDiscoveryEvict('c00000000001');
+
+      peripheral.connect();
+
+      expect(noble._peripherals.get('c00000000001')).toBe(peripheral);
+      expect(mockBindings.connect).toHaveBeenCalledWith('c00000000001', { addressType: 'random' });
+    });
+  });
+
   describe('updateRssi', () => {
     test('should updateRssi', () => {
       noble.updateRssi('peripheralUuid');